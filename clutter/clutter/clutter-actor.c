@@ -7591,6 +7591,9 @@ _clutter_actor_queue_redraw_full (ClutterActor             *self,
   if (CLUTTER_ACTOR_IN_DESTRUCTION (stage))
     return;
 
+  /* whatever changed may also change what gets picked */
+  clutter_stage_invalidate_pick (CLUTTER_STAGE (stage));
+
   if (priv->needs_redraw && priv->next_redraw_clips->len == 0)
     {
       /* priv->needs_redraw is TRUE while priv->next_redraw_clips->len is 0, this
@@ -11875,6 +11878,14 @@ clutter_actor_set_reactive (ClutterActor *actor,
 
   g_object_notify_by_pspec (G_OBJECT (actor), obj_props[PROP_REACTIVE]);
 
+  if (clutter_actor_is_mapped (actor))
+    {
+      ClutterActor *stage = _clutter_actor_get_stage_internal (actor);
+
+      if (stage)
+        clutter_stage_invalidate_pick (CLUTTER_STAGE (stage));
+    }
+
   if (!clutter_actor_get_reactive (actor) && priv->n_pointers > 0)
     {
       ClutterActor *stage = _clutter_actor_get_stage_internal (actor);
@@ -6,6 +6,8 @@ G_BEGIN_DECLS
 
 typedef struct _ClutterModifierSet ClutterModifierSet;
 
+typedef struct _ClutterEventRing ClutterEventRing;
+
 struct _ClutterModifierSet
 {
   ClutterModifierType pressed;
@@ -178,6 +180,23 @@ CLUTTER_EXPORT
 void            _clutter_event_push                     (const ClutterEvent *event,
                                                          gboolean            do_copy);
 
+/* Events from a dedicated input thread go through a lock free ring, and
+ * are allocated from a pool, see clutter-event.c */
+ClutterEventRing * _clutter_event_ring_new              (void);
+
+void            _clutter_event_ring_free                (ClutterEventRing *ring);
+
+void            _clutter_event_ring_clear               (ClutterEventRing *ring);
+
+CLUTTER_EXPORT
+void            _clutter_event_register_input_thread    (void);
+
+CLUTTER_EXPORT
+void            _clutter_event_unregister_input_thread  (void);
+
+CLUTTER_EXPORT
+void            _clutter_event_push_from_input_thread   (ClutterEvent *event);
+
 CLUTTER_EXPORT
 const char * clutter_event_get_name (const ClutterEvent *event);
 
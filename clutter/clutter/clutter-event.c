@@ -808,6 +808,249 @@ clutter_event_get_device_tool (const ClutterEvent *event)
     }
 }
 
+/* Must be a power of two */
+#define EVENT_RING_SIZE 512
+#define EVENT_RING_MASK (EVENT_RING_SIZE - 1)
+
+/*
+ * ClutterEventRing:
+ *
+ * Events from the input thread are passed to the main thread through a
+ * single producer, single consumer ring, so that neither side has to
+ * take a lock for each event. The main thread is only woken up for the
+ * first event of a batch, i.e. when it had consumed all previous ones.
+ *
+ * Events created on the input thread are also taken from a pool, and
+ * handed back to the input thread through a second ring once the main
+ * thread frees them, so high frequency devices don't cause an
+ * allocation per event either.
+ *
+ * Indices only ever increase, and wrap around naturally. The input
+ * thread writes events_head and free_tail, the main thread writes
+ * events_tail and free_head.
+ */
+struct _ClutterEventRing
+{
+  /* Thread allowed to push to the ring and take events from the pool */
+  GThread *input_thread;
+
+  ClutterEvent *events[EVENT_RING_SIZE];
+  unsigned int events_head;
+  unsigned int events_tail;
+
+  /* Events pushed while the ring was full, or while older events are
+   * still in here, to keep them ordered */
+  GMutex overflow_lock;
+  GQueue overflow;
+  int n_overflow;
+
+  ClutterEvent pool[EVENT_RING_SIZE];
+
+  /* Pooled events freed by the main thread */
+  ClutterEvent *free_events[EVENT_RING_SIZE];
+  unsigned int free_head;
+  unsigned int free_tail;
+
+  /* Pooled events freed by the input thread itself */
+  ClutterEvent *local_free_events[EVENT_RING_SIZE];
+  int n_local_free_events;
+
+  /* Pooled events still alive after the ring was freed */
+  int n_orphaned_events;
+};
+
+/* Rings freed while some of their pooled events were still alive, kept
+ * around until the last of them is freed */
+G_LOCK_DEFINE_STATIC (orphaned_rings);
+static GList *orphaned_rings;
+
+ClutterEventRing *
+_clutter_event_ring_new (void)
+{
+  ClutterEventRing *ring;
+  int i;
+
+  ring = g_new0 (ClutterEventRing, 1);
+  g_mutex_init (&ring->overflow_lock);
+  g_queue_init (&ring->overflow);
+
+  for (i = 0; i < EVENT_RING_SIZE; i++)
+    ring->free_events[i] = &ring->pool[i];
+  ring->free_head = EVENT_RING_SIZE;
+
+  return ring;
+}
+
+static gboolean
+event_ring_owns_event (ClutterEventRing *ring,
+                       ClutterEvent     *event)
+{
+  uintptr_t address = (uintptr_t) event;
+
+  return (address >= (uintptr_t) ring->pool &&
+          address < (uintptr_t) (ring->pool + EVENT_RING_SIZE));
+}
+
+void
+_clutter_event_ring_free (ClutterEventRing *ring)
+{
+  unsigned int n_free_events;
+
+  g_warn_if_fail (ring->events_head == ring->events_tail);
+  g_warn_if_fail (g_queue_is_empty (&ring->overflow));
+  g_warn_if_fail (g_atomic_pointer_get (&ring->input_thread) == NULL);
+
+  g_mutex_clear (&ring->overflow_lock);
+
+  n_free_events = (g_atomic_int_get (&ring->free_head) - ring->free_tail +
+                   ring->n_local_free_events);
+  if (n_free_events < EVENT_RING_SIZE)
+    {
+      ring->n_orphaned_events = EVENT_RING_SIZE - n_free_events;
+
+      G_LOCK (orphaned_rings);
+      orphaned_rings = g_list_prepend (orphaned_rings, ring);
+      G_UNLOCK (orphaned_rings);
+      return;
+    }
+
+  g_free (ring);
+}
+
+static gboolean
+release_orphaned_event (ClutterEvent *event)
+{
+  gboolean found = FALSE;
+  GList *l;
+
+  G_LOCK (orphaned_rings);
+
+  for (l = orphaned_rings; l; l = l->next)
+    {
+      ClutterEventRing *ring = l->data;
+
+      if (!event_ring_owns_event (ring, event))
+        continue;
+
+      found = TRUE;
+
+      if (--ring->n_orphaned_events == 0)
+        {
+          orphaned_rings = g_list_delete_link (orphaned_rings, l);
+          g_free (ring);
+        }
+      break;
+    }
+
+  G_UNLOCK (orphaned_rings);
+
+  return found;
+}
+
+static ClutterEventRing *
+get_input_event_ring (void)
+{
+  if (!_clutter_context_is_initialized ())
+    return NULL;
+
+  return _clutter_context_get_default ()->input_events;
+}
+
+static gboolean
+is_input_thread (ClutterEventRing *ring)
+{
+  return g_atomic_pointer_get (&ring->input_thread) == g_thread_self ();
+}
+
+static ClutterEvent *
+event_ring_alloc_event (ClutterEventRing *ring)
+{
+  unsigned int tail;
+  ClutterEvent *event;
+
+  if (!is_input_thread (ring))
+    return NULL;
+
+  if (ring->n_local_free_events > 0)
+    return ring->local_free_events[--ring->n_local_free_events];
+
+  tail = ring->free_tail;
+  if (tail == (unsigned int) g_atomic_int_get (&ring->free_head))
+    return NULL;
+
+  event = ring->free_events[tail & EVENT_RING_MASK];
+  g_atomic_int_set (&ring->free_tail, tail + 1);
+
+  return event;
+}
+
+static gboolean
+event_ring_release_event (ClutterEventRing *ring,
+                          ClutterEvent     *event)
+{
+  unsigned int head;
+
+  if (!event_ring_owns_event (ring, event))
+    return FALSE;
+
+  if (is_input_thread (ring))
+    {
+      ring->local_free_events[ring->n_local_free_events++] = event;
+      return TRUE;
+    }
+
+  /* There are only as many pooled events as slots, so this can't be
+   * full */
+  head = ring->free_head;
+  ring->free_events[head & EVENT_RING_MASK] = event;
+  g_atomic_int_set (&ring->free_head, head + 1);
+
+  return TRUE;
+}
+
+static ClutterEvent *
+event_ring_pop (ClutterEventRing *ring)
+{
+  ClutterEvent *event = NULL;
+  unsigned int tail;
+
+  tail = ring->events_tail;
+  if (tail != (unsigned int) g_atomic_int_get (&ring->events_head))
+    {
+      event = ring->events[tail & EVENT_RING_MASK];
+      g_atomic_int_set (&ring->events_tail, tail + 1);
+      return event;
+    }
+
+  if (g_atomic_int_get (&ring->n_overflow) > 0)
+    {
+      g_mutex_lock (&ring->overflow_lock);
+      event = g_queue_pop_head (&ring->overflow);
+      if (event)
+        g_atomic_int_add (&ring->n_overflow, -1);
+      g_mutex_unlock (&ring->overflow_lock);
+    }
+
+  return event;
+}
+
+void
+_clutter_event_ring_clear (ClutterEventRing *ring)
+{
+  ClutterEvent *event;
+
+  while ((event = event_ring_pop (ring)))
+    clutter_event_free (event);
+}
+
+static gboolean
+event_ring_is_empty (ClutterEventRing *ring)
+{
+  return (ring->events_tail ==
+          (unsigned int) g_atomic_int_get (&ring->events_head) &&
+          g_atomic_int_get (&ring->n_overflow) == 0);
+}
+
 /**
  * clutter_event_new:
  * @type: The type of event.
@@ -819,9 +1062,17 @@ clutter_event_get_device_tool (const ClutterEvent *event)
 ClutterEvent *
 clutter_event_new (ClutterEventType type)
 {
-  ClutterEvent *new_event;
+  ClutterEventRing *ring = get_input_event_ring ();
+  ClutterEvent *new_event = NULL;
+
+  if (ring)
+    new_event = event_ring_alloc_event (ring);
+
+  if (new_event)
+    memset (new_event, 0, sizeof (ClutterEvent));
+  else
+    new_event = g_new0 (ClutterEvent, 1);
 
-  new_event = g_new0 (ClutterEvent, 1);
   new_event->any.type = type;
 
   return new_event;
@@ -913,6 +1164,8 @@ clutter_event_free (ClutterEvent *event)
 {
   if (G_LIKELY (event != NULL))
     {
+      ClutterEventRing *ring;
+
       g_clear_object (&event->any.device);
       g_clear_object (&event->any.source_device);
 
@@ -947,6 +1200,14 @@ clutter_event_free (ClutterEvent *event)
           break;
         }
 
+      ring = get_input_event_ring ();
+      if (ring && event_ring_release_event (ring, event))
+        return;
+
+      if (g_atomic_pointer_get (&orphaned_rings) &&
+          release_orphaned_event (event))
+        return;
+
       g_free (event);
     }
 }
@@ -965,7 +1226,12 @@ clutter_event_get (void)
   ClutterMainContext *context = _clutter_context_get_default ();
   ClutterEvent *event;
 
+  /* Events put on the main thread are usually a reaction to events
+   * already handled, e.g. keys forwarded by an input method, so let
+   * them go first */
   event = g_async_queue_try_pop (context->events_queue);
+  if (!event && context->input_events)
+    event = event_ring_pop (context->input_events);
 
   return event;
 }
@@ -990,6 +1256,70 @@ _clutter_event_push (const ClutterEvent *event,
   g_main_context_wakeup (NULL);
 }
 
+/*
+ * Makes the calling thread the input thread, whose events can be pushed
+ * with _clutter_event_push_from_input_thread(). There can only be one
+ * at a time.
+ */
+void
+_clutter_event_register_input_thread (void)
+{
+  ClutterMainContext *context = _clutter_context_get_default ();
+
+  if (!g_atomic_pointer_compare_and_exchange (&context->input_events->input_thread,
+                                              NULL, g_thread_self ()))
+    g_warning ("An input thread is already registered");
+}
+
+void
+_clutter_event_unregister_input_thread (void)
+{
+  ClutterMainContext *context = _clutter_context_get_default ();
+
+  g_atomic_pointer_compare_and_exchange (&context->input_events->input_thread,
+                                         g_thread_self (), NULL);
+}
+
+/*
+ * Queues @event, created on the input thread, taking ownership of it.
+ */
+void
+_clutter_event_push_from_input_thread (ClutterEvent *event)
+{
+  ClutterMainContext *context = _clutter_context_get_default ();
+  ClutterEventRing *ring = context->input_events;
+  unsigned int head;
+
+  if (G_UNLIKELY (!is_input_thread (ring)))
+    {
+      _clutter_event_push (event, FALSE);
+      return;
+    }
+
+  head = ring->events_head;
+
+  if (g_atomic_int_get (&ring->n_overflow) > 0 ||
+      head - (unsigned int) g_atomic_int_get (&ring->events_tail) ==
+      EVENT_RING_SIZE)
+    {
+      g_mutex_lock (&ring->overflow_lock);
+      g_queue_push_tail (&ring->overflow, event);
+      g_atomic_int_inc (&ring->n_overflow);
+      g_mutex_unlock (&ring->overflow_lock);
+
+      g_main_context_wakeup (NULL);
+      return;
+    }
+
+  ring->events[head & EVENT_RING_MASK] = event;
+  g_atomic_int_set (&ring->events_head, head + 1);
+
+  /* If the main thread hadn't consumed all events yet, it will see
+   * this one before going back to sleep */
+  if (head == (unsigned int) g_atomic_int_get (&ring->events_tail))
+    g_main_context_wakeup (NULL);
+}
+
 /**
  * clutter_event_put:
  * @event: a #ClutterEvent
@@ -1020,6 +1350,9 @@ clutter_events_pending (void)
 
   g_return_val_if_fail (context != NULL, FALSE);
 
+  if (context->input_events && !event_ring_is_empty (context->input_events))
+    return TRUE;
+
   return g_async_queue_length (context->events_queue) > 0;
 }
 
@@ -37,6 +37,8 @@ static guint signals[N_SIGNALS];
 
 #define SYNC_DELAY_FALLBACK_FRACTION 0.875
 
+#define FRAME_TIMING_HISTORY_LENGTH 512
+
 typedef struct _ClutterFrameListener
 {
   const ClutterFrameListenerIface *iface;
@@ -50,6 +52,13 @@ typedef struct _ClutterClockSource
   ClutterFrameClock *frame_clock;
 } ClutterClockSource;
 
+typedef struct _ClutterFrameTimingHistory
+{
+  int64_t samples[FRAME_TIMING_HISTORY_LENGTH];
+  unsigned int next_sample;
+  unsigned int n_samples;
+} ClutterFrameTimingHistory;
+
 typedef enum _ClutterFrameClockState
 {
   CLUTTER_FRAME_CLOCK_STATE_INIT,
@@ -67,6 +76,8 @@ struct _ClutterFrameClock
   int64_t refresh_interval_us;
   ClutterFrameListener listener;
 
+  ClutterFrameClockMode mode;
+
   GSource *source;
 
   int64_t frame_count;
@@ -110,11 +121,113 @@ struct _ClutterFrameClock
   int64_t missed_frame_report_time_us;
 
   int64_t last_dispatch_interval_us;
+
+  ClutterFrameTimingHistory timings[CLUTTER_N_FRAME_TIMINGS];
 };
 
 G_DEFINE_TYPE (ClutterFrameClock, clutter_frame_clock,
                G_TYPE_OBJECT)
 
+static void
+record_frame_timing (ClutterFrameClock  *frame_clock,
+                     ClutterFrameTiming  timing,
+                     int64_t             value)
+{
+  ClutterFrameTimingHistory *history = &frame_clock->timings[timing];
+
+  history->samples[history->next_sample] = value;
+  history->next_sample =
+    (history->next_sample + 1) % FRAME_TIMING_HISTORY_LENGTH;
+  history->n_samples = MIN (history->n_samples + 1,
+                            FRAME_TIMING_HISTORY_LENGTH);
+}
+
+static int
+compare_timing_samples (const void *a,
+                        const void *b)
+{
+  int64_t sample_a = *(const int64_t *) a;
+  int64_t sample_b = *(const int64_t *) b;
+
+  return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+static int
+bucket_from_timing_sample (int64_t sample)
+{
+  int bucket;
+
+  if (sample < 1)
+    return 0;
+
+  bucket = g_bit_storage ((uint64_t) sample);
+
+  return MIN (bucket, CLUTTER_FRAME_TIMING_N_BUCKETS - 1);
+}
+
+/**
+ * clutter_frame_clock_get_timing_stats: (skip)
+ * @frame_clock: a #ClutterFrameClock
+ * @timing: the frame timing to get statistics for
+ * @stats: (out): return location for the statistics
+ *
+ * Summarizes the most recently recorded samples of @timing.
+ */
+void
+clutter_frame_clock_get_timing_stats (ClutterFrameClock       *frame_clock,
+                                      ClutterFrameTiming       timing,
+                                      ClutterFrameTimingStats *stats)
+{
+  ClutterFrameTimingHistory *history;
+  int64_t sorted_samples[FRAME_TIMING_HISTORY_LENGTH];
+  unsigned int n_samples;
+  int64_t sum = 0;
+  unsigned int i;
+
+  g_return_if_fail (CLUTTER_IS_FRAME_CLOCK (frame_clock));
+  g_return_if_fail (timing < CLUTTER_N_FRAME_TIMINGS);
+
+  history = &frame_clock->timings[timing];
+  n_samples = history->n_samples;
+
+  *stats = (ClutterFrameTimingStats) {
+    .n_samples = n_samples,
+  };
+
+  if (n_samples == 0)
+    return;
+
+  memcpy (sorted_samples, history->samples, n_samples * sizeof (int64_t));
+  qsort (sorted_samples, n_samples, sizeof (int64_t), compare_timing_samples);
+
+  for (i = 0; i < n_samples; i++)
+    {
+      sum += sorted_samples[i];
+      stats->buckets[bucket_from_timing_sample (sorted_samples[i])]++;
+    }
+
+  stats->min = sorted_samples[0];
+  stats->max = sorted_samples[n_samples - 1];
+  stats->mean = sum / n_samples;
+  stats->p50 = sorted_samples[(n_samples - 1) * 50 / 100];
+  stats->p90 = sorted_samples[(n_samples - 1) * 90 / 100];
+  stats->p99 = sorted_samples[(n_samples - 1) * 99 / 100];
+}
+
+/**
+ * clutter_frame_clock_reset_timing_stats: (skip)
+ * @frame_clock: a #ClutterFrameClock
+ *
+ * Drops all recorded frame timing samples.
+ */
+void
+clutter_frame_clock_reset_timing_stats (ClutterFrameClock *frame_clock)
+{
+  g_return_if_fail (CLUTTER_IS_FRAME_CLOCK (frame_clock));
+
+  memset (frame_clock->timings, 0, sizeof (frame_clock->timings));
+}
+
 float
 clutter_frame_clock_get_refresh_rate (ClutterFrameClock *frame_clock)
 {
@@ -324,13 +437,42 @@ clutter_frame_clock_notify_presented (ClutterFrameClock *frame_clock,
 #endif
 
   if (frame_info->presentation_time > 0)
-    frame_clock->last_presentation_time_us = frame_info->presentation_time;
+    {
+      if (frame_clock->last_presentation_time_us > 0)
+        {
+          record_frame_timing (frame_clock,
+                               CLUTTER_FRAME_TIMING_PRESENTATION_DELTA,
+                               frame_info->presentation_time -
+                               frame_clock->last_presentation_time_us);
+        }
+
+      /* With a variable refresh rate there is no fixed refresh cycle to
+       * miss, so only count missed vblanks in fixed mode. */
+      if (frame_clock->mode == CLUTTER_FRAME_CLOCK_MODE_FIXED &&
+          frame_clock->is_next_presentation_time_valid)
+        {
+          int64_t delay_us;
+          int64_t n_missed_vblanks;
+
+          delay_us = (frame_info->presentation_time -
+                      frame_clock->next_presentation_time_us);
+          n_missed_vblanks =
+            (delay_us + frame_clock->refresh_interval_us / 2) /
+            frame_clock->refresh_interval_us;
+          record_frame_timing (frame_clock,
+                               CLUTTER_FRAME_TIMING_MISSED_VBLANKS,
+                               MAX (n_missed_vblanks, 0));
+        }
+
+      frame_clock->last_presentation_time_us = frame_info->presentation_time;
+    }
 
   frame_clock->got_measurements_last_frame = FALSE;
 
   if (frame_info->cpu_time_before_buffer_swap_us != 0)
     {
       int64_t dispatch_to_swap_us, swap_to_rendering_done_us, swap_to_flip_us;
+      int64_t update_duration_us;
 
       dispatch_to_swap_us =
         frame_info->cpu_time_before_buffer_swap_us -
@@ -348,9 +490,22 @@ clutter_frame_clock_notify_presented (ClutterFrameClock *frame_clock,
                     swap_to_rendering_done_us,
                     swap_to_flip_us);
 
+      update_duration_us =
+        frame_clock->last_dispatch_lateness_us + dispatch_to_swap_us +
+        MAX (swap_to_rendering_done_us, swap_to_flip_us);
+
+      record_frame_timing (frame_clock,
+                           CLUTTER_FRAME_TIMING_UPDATE_DURATION,
+                           update_duration_us);
+      if (frame_info->gpu_rendering_duration_ns != 0)
+        {
+          record_frame_timing (frame_clock,
+                               CLUTTER_FRAME_TIMING_GPU_RENDER_TIME,
+                               frame_info->gpu_rendering_duration_ns / 1000);
+        }
+
       frame_clock->shortterm_max_update_duration_us =
-        CLAMP (frame_clock->last_dispatch_lateness_us + dispatch_to_swap_us +
-               MAX (swap_to_rendering_done_us, swap_to_flip_us),
+        CLAMP (update_duration_us,
                frame_clock->shortterm_max_update_duration_us,
                frame_clock->refresh_interval_us);
 
@@ -591,6 +746,101 @@ calculate_next_update_time_us (ClutterFrameClock *frame_clock,
   *out_min_render_time_allowed_us = min_render_time_allowed_us;
 }
 
+static void
+calculate_next_variable_update_time_us (ClutterFrameClock *frame_clock,
+                                        int64_t           *out_next_update_time_us,
+                                        int64_t           *out_next_presentation_time_us,
+                                        int64_t           *out_min_render_time_allowed_us)
+{
+  int64_t now_us;
+  int64_t refresh_interval_us;
+  int64_t max_render_time_allowed_us;
+  int64_t earliest_presentation_time_us;
+  int64_t next_presentation_time_us;
+  int64_t next_update_time_us;
+
+  now_us = g_get_monotonic_time ();
+
+  refresh_interval_us = frame_clock->refresh_interval_us;
+
+  if (frame_clock->last_presentation_time_us == 0)
+    {
+      *out_next_update_time_us = now_us;
+      *out_next_presentation_time_us = 0;
+      *out_min_render_time_allowed_us = 0;
+      return;
+    }
+
+  max_render_time_allowed_us =
+    clutter_frame_clock_compute_max_render_time_us (frame_clock);
+
+  /*
+   * With a variable refresh rate the display doesn't scan out on a fixed
+   * grid of presentation times; it waits for the next flip, as long as it
+   * doesn't come sooner than one refresh interval at the maximum refresh rate
+   * after the last one. Content that is ready should thus be dispatched right
+   * away, only delaying it if it would otherwise hit the display before the
+   * panel is able to start a new refresh cycle:
+   *
+   *        last_presentation_time_us
+   *       /       earliest_presentation_time_us
+   *      /       /
+   * |---|---o---|-------> presentation times
+   *     |       *     |     now_us
+   *     \______/
+   *  refresh_interval_us
+   *
+   * Frames arriving after the panel's minimum refresh rate has lapsed are
+   * taken care of by the driver repeating the last frame.
+   */
+  earliest_presentation_time_us =
+    frame_clock->last_presentation_time_us + refresh_interval_us;
+
+  next_presentation_time_us = now_us + max_render_time_allowed_us;
+  if (next_presentation_time_us < earliest_presentation_time_us)
+    next_presentation_time_us = earliest_presentation_time_us;
+
+  next_update_time_us = next_presentation_time_us - max_render_time_allowed_us;
+  if (next_update_time_us < now_us)
+    next_update_time_us = now_us;
+
+  *out_next_update_time_us = next_update_time_us;
+  *out_next_presentation_time_us = next_presentation_time_us;
+  *out_min_render_time_allowed_us = 0;
+}
+
+void
+clutter_frame_clock_set_mode (ClutterFrameClock     *frame_clock,
+                              ClutterFrameClockMode  mode)
+{
+  if (frame_clock->mode == mode)
+    return;
+
+  frame_clock->mode = mode;
+  frame_clock->is_next_presentation_time_valid = FALSE;
+
+  switch (frame_clock->state)
+    {
+    case CLUTTER_FRAME_CLOCK_STATE_INIT:
+    case CLUTTER_FRAME_CLOCK_STATE_IDLE:
+    case CLUTTER_FRAME_CLOCK_STATE_DISPATCHING:
+    case CLUTTER_FRAME_CLOCK_STATE_PENDING_PRESENTED:
+      break;
+    case CLUTTER_FRAME_CLOCK_STATE_SCHEDULED:
+      frame_clock->pending_reschedule = TRUE;
+      frame_clock->state = CLUTTER_FRAME_CLOCK_STATE_IDLE;
+      g_source_set_ready_time (frame_clock->source, -1);
+      maybe_reschedule_update (frame_clock);
+      break;
+    }
+}
+
+ClutterFrameClockMode
+clutter_frame_clock_get_mode (ClutterFrameClock *frame_clock)
+{
+  return frame_clock->mode;
+}
+
 void
 clutter_frame_clock_inhibit (ClutterFrameClock *frame_clock)
 {
@@ -678,10 +928,21 @@ clutter_frame_clock_schedule_update (ClutterFrameClock *frame_clock)
       next_update_time_us = g_get_monotonic_time ();
       break;
     case CLUTTER_FRAME_CLOCK_STATE_IDLE:
-      calculate_next_update_time_us (frame_clock,
-                                     &next_update_time_us,
-                                     &frame_clock->next_presentation_time_us,
-                                     &frame_clock->min_render_time_allowed_us);
+      switch (frame_clock->mode)
+        {
+        case CLUTTER_FRAME_CLOCK_MODE_FIXED:
+          calculate_next_update_time_us (frame_clock,
+                                         &next_update_time_us,
+                                         &frame_clock->next_presentation_time_us,
+                                         &frame_clock->min_render_time_allowed_us);
+          break;
+        case CLUTTER_FRAME_CLOCK_MODE_VARIABLE:
+          calculate_next_variable_update_time_us (frame_clock,
+                                                  &next_update_time_us,
+                                                  &frame_clock->next_presentation_time_us,
+                                                  &frame_clock->min_render_time_allowed_us);
+          break;
+        }
       frame_clock->is_next_presentation_time_valid =
         (frame_clock->next_presentation_time_us != 0);
       break;
@@ -728,6 +989,9 @@ clutter_frame_clock_dispatch (ClutterFrameClock *frame_clock,
                              frame_clock->refresh_interval_us;
 
   lateness_us = time_us - ideal_dispatch_time_us;
+  record_frame_timing (frame_clock,
+                       CLUTTER_FRAME_TIMING_DISPATCH_LATENESS,
+                       lateness_us);
   if (lateness_us < 0 || lateness_us >= frame_clock->refresh_interval_us)
     frame_clock->last_dispatch_lateness_us = 0;
   else
@@ -33,6 +33,49 @@ typedef enum _ClutterFrameResult
   CLUTTER_FRAME_RESULT_IDLE,
 } ClutterFrameResult;
 
+typedef enum _ClutterFrameClockMode
+{
+  CLUTTER_FRAME_CLOCK_MODE_FIXED,
+  CLUTTER_FRAME_CLOCK_MODE_VARIABLE,
+} ClutterFrameClockMode;
+
+typedef enum _ClutterFrameTiming
+{
+  CLUTTER_FRAME_TIMING_DISPATCH_LATENESS,
+  CLUTTER_FRAME_TIMING_UPDATE_DURATION,
+  CLUTTER_FRAME_TIMING_GPU_RENDER_TIME,
+  CLUTTER_FRAME_TIMING_PRESENTATION_DELTA,
+  CLUTTER_FRAME_TIMING_MISSED_VBLANKS,
+
+  CLUTTER_N_FRAME_TIMINGS
+} ClutterFrameTiming;
+
+#define CLUTTER_FRAME_TIMING_N_BUCKETS 24
+
+/**
+ * ClutterFrameTimingStats: (skip)
+ *
+ * Statistics over the most recent samples of a frame timing. All values are
+ * in microseconds, except for missed vblanks, which are counted in refresh
+ * cycles.
+ *
+ * Bucket 0 counts values less than 1, bucket N counts values in the range
+ * [2^(N-1), 2^N), and the last bucket also counts anything larger.
+ */
+typedef struct _ClutterFrameTimingStats
+{
+  unsigned int n_samples;
+
+  int64_t min;
+  int64_t max;
+  int64_t mean;
+  int64_t p50;
+  int64_t p90;
+  int64_t p99;
+
+  unsigned int buckets[CLUTTER_FRAME_TIMING_N_BUCKETS];
+} ClutterFrameTimingStats;
+
 #define CLUTTER_TYPE_FRAME_CLOCK (clutter_frame_clock_get_type ())
 CLUTTER_EXPORT
 G_DECLARE_FINAL_TYPE (ClutterFrameClock, clutter_frame_clock,
@@ -88,10 +131,25 @@ void clutter_frame_clock_add_timeline (ClutterFrameClock *frame_clock,
 void clutter_frame_clock_remove_timeline (ClutterFrameClock *frame_clock,
                                           ClutterTimeline   *timeline);
 
+CLUTTER_EXPORT
+void clutter_frame_clock_set_mode (ClutterFrameClock     *frame_clock,
+                                  ClutterFrameClockMode  mode);
+
+CLUTTER_EXPORT
+ClutterFrameClockMode clutter_frame_clock_get_mode (ClutterFrameClock *frame_clock);
+
 CLUTTER_EXPORT
 float clutter_frame_clock_get_refresh_rate (ClutterFrameClock *frame_clock);
 
 void clutter_frame_clock_record_flip_time (ClutterFrameClock *frame_clock,
                                            int64_t            flip_time_us);
 
+CLUTTER_EXPORT
+void clutter_frame_clock_get_timing_stats (ClutterFrameClock       *frame_clock,
+                                           ClutterFrameTiming       timing,
+                                           ClutterFrameTimingStats *stats);
+
+CLUTTER_EXPORT
+void clutter_frame_clock_reset_timing_stats (ClutterFrameClock *frame_clock);
+
 GString * clutter_frame_clock_get_max_render_time_debug_info (ClutterFrameClock *frame_clock);
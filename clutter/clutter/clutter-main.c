@@ -137,6 +137,7 @@ static const GDebugKey clutter_paint_debug_keys[] = {
   { "damage-region", CLUTTER_DEBUG_PAINT_DAMAGE_REGION },
   { "disable-dynamic-max-render-time", CLUTTER_DEBUG_DISABLE_DYNAMIC_MAX_RENDER_TIME },
   { "max-render-time", CLUTTER_DEBUG_PAINT_MAX_RENDER_TIME },
+  { "disable-threaded-damage-scan", CLUTTER_DEBUG_DISABLE_THREADED_DAMAGE_SCAN },
 };
 
 gboolean
@@ -618,10 +619,13 @@ clutter_context_new (ClutterBackendConstructor   backend_constructor,
 
   clutter_context->events_queue =
       g_async_queue_new_full ((GDestroyNotify) clutter_event_free);
+  clutter_context->input_events = _clutter_event_ring_new ();
   clutter_context->last_repaint_id = 1;
 
   if (!clutter_init_real (clutter_context, error))
     {
+      g_clear_pointer (&clutter_context->input_events,
+                       _clutter_event_ring_free);
       g_free (clutter_context);
       return NULL;
     }
@@ -636,6 +640,7 @@ clutter_context_free (ClutterMainContext *clutter_context)
 {
   g_clear_pointer (&clutter_context->events_queue, g_async_queue_unref);
   g_clear_pointer (&clutter_context->backend, clutter_backend_destroy);
+  g_clear_pointer (&clutter_context->input_events, _clutter_event_ring_free);
   ClutterCntx = NULL;
   g_free (clutter_context);
 }
@@ -1191,6 +1196,9 @@ _clutter_clear_events_queue (void)
   ClutterEvent *event;
   GAsyncQueue *events_queue;
 
+  if (context->input_events)
+    _clutter_event_ring_clear (context->input_events);
+
   if (!context->events_queue)
     return;
 
@@ -36,6 +36,7 @@
 #include "clutter/clutter-stage-private.h"
 #include "clutter/clutter-stage-view.h"
 #include "clutter/clutter-stage-view-private.h"
+#include "clutter/clutter-tile-compare.h"
 #include "clutter/clutter.h"
 #include "mtk/mtk.h"
 
@@ -87,6 +88,21 @@ void clutter_stage_capture_view_into (ClutterStage     *stage,
                                       uint8_t          *data,
                                       int               stride);
 
+CLUTTER_EXPORT
+void clutter_stage_capture_view_async (ClutterStage        *stage,
+                                       ClutterStageView    *view,
+                                       const MtkRectangle  *rect,
+                                       CoglPixelFormat      format,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data);
+
+CLUTTER_EXPORT
+GBytes * clutter_stage_capture_view_finish (ClutterStage  *stage,
+                                            GAsyncResult  *result,
+                                            int           *out_stride,
+                                            GError       **error);
+
 CLUTTER_EXPORT
 void clutter_stage_clear_stage_views (ClutterStage *stage);
 
@@ -127,6 +143,24 @@ CLUTTER_EXPORT
 void clutter_stage_repick_device (ClutterStage       *stage,
                                   ClutterInputDevice *device);
 
+CLUTTER_EXPORT
+void clutter_stage_invalidate_pick (ClutterStage *stage);
+
+CLUTTER_EXPORT
+void clutter_stage_get_actors_at_pos (ClutterStage            *stage,
+                                      ClutterPickMode          pick_mode,
+                                      int                      n_points,
+                                      const graphene_point_t  *points,
+                                      ClutterActor           **actors);
+
+CLUTTER_EXPORT
+void clutter_stage_paint_region_to_framebuffer (ClutterStage       *stage,
+                                                CoglFramebuffer    *framebuffer,
+                                                const MtkRectangle *rect,
+                                                float               scale,
+                                                const MtkRegion    *region,
+                                                ClutterPaintFlag    paint_flags);
+
 CLUTTER_EXPORT
 void clutter_get_debug_flags (ClutterDebugFlag     *debug_flags,
                               ClutterDrawDebugFlag *draw_flags,
@@ -20,6 +20,10 @@
 #include "clutter/clutter-pick-context.h"
 #include "clutter/clutter-pick-stack-private.h"
 
+/*
+ * If @point and @ray are NULL, actors are not culled against them and
+ * the resulting pick stack can be searched for any point in the view.
+ */
 ClutterPickContext *
 clutter_pick_context_new_for_view (ClutterStageView         *view,
                                    ClutterPickMode           mode,
@@ -27,6 +27,7 @@ struct _ClutterPickContext
   ClutterPickMode mode;
   ClutterPickStack *pick_stack;
 
+  gboolean has_point;
   graphene_ray_t ray;
   graphene_point3d_t point;
 };
@@ -47,8 +48,13 @@ clutter_pick_context_new_for_view (ClutterStageView         *view,
   pick_context = g_new0 (ClutterPickContext, 1);
   g_ref_count_init (&pick_context->ref_count);
   pick_context->mode = mode;
-  graphene_ray_init_from_ray (&pick_context->ray, ray);
-  graphene_point3d_init_from_point (&pick_context->point, point);
+
+  if (point)
+    {
+      pick_context->has_point = TRUE;
+      graphene_ray_init_from_ray (&pick_context->ray, ray);
+      graphene_point3d_init_from_point (&pick_context->point, point);
+    }
 
   context = clutter_backend_get_cogl_context (clutter_get_default_backend ());
   pick_context->pick_stack = clutter_pick_stack_new (context);
@@ -208,6 +214,10 @@ gboolean
 clutter_pick_context_intersects_box (ClutterPickContext   *pick_context,
                                      const graphene_box_t *box)
 {
+  /* Without a point, the whole scene is being picked */
+  if (!pick_context->has_point)
+    return TRUE;
+
   return graphene_box_contains_point (box, &pick_context->point) ||
          graphene_ray_intersects_box (&pick_context->ray, box);
 }
@@ -63,6 +63,14 @@ clutter_pick_stack_search_actor (ClutterPickStack          *pick_stack,
                                  const graphene_ray_t      *ray,
                                  MtkRegion                **clear_area);
 
+void
+clutter_pick_stack_search_actors (ClutterPickStack          *pick_stack,
+                                  int                        n_points,
+                                  const graphene_point3d_t  *points,
+                                  const graphene_ray_t      *rays,
+                                  ClutterActor             **actors,
+                                  MtkRegion                **clear_areas);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (ClutterPickStack, clutter_pick_stack_unref)
 
 G_END_DECLS
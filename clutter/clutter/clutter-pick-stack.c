@@ -41,6 +41,42 @@ typedef struct
   int prev;
 } PickClipRecord;
 
+/* Stacks searched more than once with at least this many records get a
+ * spatial index */
+#define PICK_INDEX_MIN_RECORDS 32
+#define PICK_INDEX_GRID_SIZE 16
+
+/* Margin around the projected bounds of each record, making up for
+ * differences in precision with the exact intersection tests.
+ */
+#define PICK_INDEX_MARGIN 1.f
+
+typedef struct
+{
+  float x1, y1, x2, y2;
+} PickIndexBounds;
+
+/*
+ * Uniform grid over the bounds of the pick records, projected onto the
+ * plane the picked points lie on. Each cell lists, in stacking order,
+ * the records whose projected bounds overlap it. Records that can't be
+ * projected are kept in a separate list and are tested for every point.
+ */
+typedef struct
+{
+  float z;
+
+  PickIndexBounds bounds;
+  float cell_width;
+  float cell_height;
+
+  int *cell_offsets;
+  int *cell_records;
+
+  int *unindexed;
+  int n_unindexed;
+} PickIndex;
+
 struct _ClutterPickStack
 {
   grefcount ref_count;
@@ -50,6 +86,9 @@ struct _ClutterPickStack
   GArray *clip_stack;
   int current_clip_stack_top;
 
+  PickIndex *index;
+  int n_searches;
+
   gboolean sealed : 1;
 };
 
@@ -243,10 +282,20 @@ remove_pick_stack_weak_refs (ClutterPickStack *pick_stack)
     }
 }
 
+static void
+pick_index_free (PickIndex *index)
+{
+  g_free (index->cell_offsets);
+  g_free (index->cell_records);
+  g_free (index->unindexed);
+  g_free (index);
+}
+
 static void
 clutter_pick_stack_dispose (ClutterPickStack *pick_stack)
 {
   remove_pick_stack_weak_refs (pick_stack);
+  g_clear_pointer (&pick_stack->index, pick_index_free);
   g_clear_object (&pick_stack->matrix_stack);
   g_clear_pointer (&pick_stack->vertices_stack, g_array_unref);
   g_clear_pointer (&pick_stack->clip_stack, g_array_unref);
@@ -507,6 +556,257 @@ calculate_clear_area (ClutterPickStack  *pick_stack,
   g_clear_pointer (&area, mtk_region_unref);
 }
 
+static gboolean
+get_projected_bounds (Record          *rec,
+                      float            z,
+                      PickIndexBounds *bounds)
+{
+  int i;
+
+  maybe_project_record (rec);
+
+  bounds->x1 = bounds->y1 = FLT_MAX;
+  bounds->x2 = bounds->y2 = -FLT_MAX;
+
+  for (i = 0; i < 4; i++)
+    {
+      const graphene_point3d_t *vertex = &rec->vertices[i];
+      float scale;
+      float x, y;
+
+      /* Only vertices on the same side of the camera as the picked
+       * points can be projected onto their plane */
+      if (vertex->z == 0.f || signbit (vertex->z) != signbit (z))
+        return FALSE;
+
+      scale = z / vertex->z;
+      x = vertex->x * scale;
+      y = vertex->y * scale;
+
+      if (!isfinite (x) || !isfinite (y))
+        return FALSE;
+
+      bounds->x1 = MIN (bounds->x1, x);
+      bounds->y1 = MIN (bounds->y1, y);
+      bounds->x2 = MAX (bounds->x2, x);
+      bounds->y2 = MAX (bounds->y2, y);
+    }
+
+  bounds->x1 -= PICK_INDEX_MARGIN;
+  bounds->y1 -= PICK_INDEX_MARGIN;
+  bounds->x2 += PICK_INDEX_MARGIN;
+  bounds->y2 += PICK_INDEX_MARGIN;
+
+  return TRUE;
+}
+
+static inline int
+get_cell_column (PickIndex *index,
+                 float      x)
+{
+  int column = (int) floorf ((x - index->bounds.x1) / index->cell_width);
+
+  return CLAMP (column, 0, PICK_INDEX_GRID_SIZE - 1);
+}
+
+static inline int
+get_cell_row (PickIndex *index,
+              float      y)
+{
+  int row = (int) floorf ((y - index->bounds.y1) / index->cell_height);
+
+  return CLAMP (row, 0, PICK_INDEX_GRID_SIZE - 1);
+}
+
+static PickIndex *
+pick_index_new (ClutterPickStack *pick_stack,
+                float             z)
+{
+  g_autofree PickIndexBounds *record_bounds = NULL;
+  g_autofree gboolean *indexed = NULL;
+  PickIndex *index;
+  int n_records = pick_stack->vertices_stack->len;
+  int n_cells = PICK_INDEX_GRID_SIZE * PICK_INDEX_GRID_SIZE;
+  int n_indexed = 0;
+  int i;
+
+  index = g_new0 (PickIndex, 1);
+  index->z = z;
+  index->bounds = (PickIndexBounds) { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+  index->cell_offsets = g_new0 (int, n_cells + 1);
+  index->unindexed = g_new (int, n_records);
+
+  record_bounds = g_new (PickIndexBounds, n_records);
+  indexed = g_new0 (gboolean, n_records);
+
+  for (i = 0; i < n_records; i++)
+    {
+      PickRecord *rec =
+        &g_array_index (pick_stack->vertices_stack, PickRecord, i);
+      PickIndexBounds *bounds = &record_bounds[i];
+
+      if (rec->is_overlap)
+        continue;
+
+      if (!get_projected_bounds (&rec->base, z, bounds))
+        {
+          index->unindexed[index->n_unindexed++] = i;
+          continue;
+        }
+
+      index->bounds.x1 = MIN (index->bounds.x1, bounds->x1);
+      index->bounds.y1 = MIN (index->bounds.y1, bounds->y1);
+      index->bounds.x2 = MAX (index->bounds.x2, bounds->x2);
+      index->bounds.y2 = MAX (index->bounds.y2, bounds->y2);
+
+      indexed[i] = TRUE;
+      n_indexed++;
+    }
+
+  /* Leaves the bounds empty, so no point hits the grid */
+  if (n_indexed == 0)
+    return index;
+
+  index->cell_width =
+    (index->bounds.x2 - index->bounds.x1) / PICK_INDEX_GRID_SIZE;
+  index->cell_height =
+    (index->bounds.y2 - index->bounds.y1) / PICK_INDEX_GRID_SIZE;
+
+  /* Count the records of each cell, then turn the counts into offsets
+   * and fill in the records in stacking order.
+   */
+  for (i = 0; i < n_records; i++)
+    {
+      int column1, column2, row1, row2;
+      int row;
+
+      if (!indexed[i])
+        continue;
+
+      column1 = get_cell_column (index, record_bounds[i].x1);
+      column2 = get_cell_column (index, record_bounds[i].x2);
+      row1 = get_cell_row (index, record_bounds[i].y1);
+      row2 = get_cell_row (index, record_bounds[i].y2);
+
+      for (row = row1; row <= row2; row++)
+        {
+          int column;
+
+          for (column = column1; column <= column2; column++)
+            index->cell_offsets[row * PICK_INDEX_GRID_SIZE + column + 1]++;
+        }
+    }
+
+  for (i = 0; i < n_cells; i++)
+    index->cell_offsets[i + 1] += index->cell_offsets[i];
+
+  index->cell_records = g_new (int, index->cell_offsets[n_cells]);
+
+  for (i = 0; i < n_records; i++)
+    {
+      int column1, column2, row1, row2;
+      int row;
+
+      if (!indexed[i])
+        continue;
+
+      column1 = get_cell_column (index, record_bounds[i].x1);
+      column2 = get_cell_column (index, record_bounds[i].x2);
+      row1 = get_cell_row (index, record_bounds[i].y1);
+      row2 = get_cell_row (index, record_bounds[i].y2);
+
+      for (row = row1; row <= row2; row++)
+        {
+          int column;
+
+          for (column = column1; column <= column2; column++)
+            {
+              int cell = row * PICK_INDEX_GRID_SIZE + column;
+
+              index->cell_records[index->cell_offsets[cell]++] = i;
+            }
+        }
+    }
+
+  /* Filling in moved each offset to the start of the next cell */
+  for (i = n_cells; i > 0; i--)
+    index->cell_offsets[i] = index->cell_offsets[i - 1];
+  index->cell_offsets[0] = 0;
+
+  return index;
+}
+
+static void
+ensure_pick_index (ClutterPickStack *pick_stack,
+                   float             z)
+{
+  if (pick_stack->index && pick_stack->index->z == z)
+    return;
+
+  g_clear_pointer (&pick_stack->index, pick_index_free);
+  pick_stack->index = pick_index_new (pick_stack, z);
+}
+
+static gboolean
+pick_record (ClutterPickStack          *pick_stack,
+             int                        elem,
+             const graphene_point3d_t  *point,
+             const graphene_ray_t      *ray,
+             MtkRegion                **clear_area)
+{
+  PickRecord *rec =
+    &g_array_index (pick_stack->vertices_stack, PickRecord, elem);
+
+  if (rec->is_overlap || !rec->actor ||
+      !ray_intersects_record (pick_stack, rec, point, ray))
+    return FALSE;
+
+  if (clear_area)
+    calculate_clear_area (pick_stack, rec, elem, clear_area);
+
+  return TRUE;
+}
+
+static int
+search_pick_index (ClutterPickStack          *pick_stack,
+                   const graphene_point3d_t  *point,
+                   const graphene_ray_t      *ray,
+                   MtkRegion                **clear_area)
+{
+  PickIndex *index = pick_stack->index;
+  const int *candidates = NULL;
+  int n_candidates = 0;
+  int i, j;
+
+  if (point->x >= index->bounds.x1 && point->x <= index->bounds.x2 &&
+      point->y >= index->bounds.y1 && point->y <= index->bounds.y2)
+    {
+      int cell = get_cell_row (index, point->y) * PICK_INDEX_GRID_SIZE +
+                 get_cell_column (index, point->x);
+
+      candidates = &index->cell_records[index->cell_offsets[cell]];
+      n_candidates = index->cell_offsets[cell + 1] - index->cell_offsets[cell];
+    }
+
+  /* Both lists are in stacking order, merge them from front to back */
+  i = n_candidates - 1;
+  j = index->n_unindexed - 1;
+  while (i >= 0 || j >= 0)
+    {
+      int elem;
+
+      if (j < 0 || (i >= 0 && candidates[i] > index->unindexed[j]))
+        elem = candidates[i--];
+      else
+        elem = index->unindexed[j--];
+
+      if (pick_record (pick_stack, elem, point, ray, clear_area))
+        return elem;
+    }
+
+  return -1;
+}
+
 ClutterActor *
 clutter_pick_stack_search_actor (ClutterPickStack          *pick_stack,
                                  const graphene_point3d_t  *point,
@@ -515,23 +815,98 @@ clutter_pick_stack_search_actor (ClutterPickStack          *pick_stack,
 {
   int i;
 
-  /* Search all "painted" pickable actors from front to back. A linear search
-   * is required, and also performs fine since there is typically only
-   * on the order of dozens of actors in the list (on screen) at a time.
+  /* Stacks that are searched repeatedly, such as the ones kept around by
+   * the stage while the scene doesn't change, can be large enough for an
+   * index to be worth it.
    */
-  for (i = pick_stack->vertices_stack->len - 1; i >= 0; i--)
+  if (pick_stack->sealed &&
+      pick_stack->n_searches++ > 0 &&
+      pick_stack->vertices_stack->len >= PICK_INDEX_MIN_RECORDS)
     {
-      PickRecord *rec =
-        &g_array_index (pick_stack->vertices_stack, PickRecord, i);
+      PickRecord *rec;
 
-      if (!rec->is_overlap && rec->actor &&
-          ray_intersects_record (pick_stack, rec, point, ray))
+      ensure_pick_index (pick_stack, point->z);
+
+      i = search_pick_index (pick_stack, point, ray, clear_area);
+      if (i < 0)
+        return NULL;
+
+      rec = &g_array_index (pick_stack->vertices_stack, PickRecord, i);
+      return rec->actor;
+    }
+
+  /* Otherwise search all "painted" pickable actors from front to back. A
+   * linear search performs fine since there is typically only on the order
+   * of dozens of actors in the list (on screen) at a time.
+   */
+  for (i = pick_stack->vertices_stack->len - 1; i >= 0; i--)
+    {
+      if (pick_record (pick_stack, i, point, ray, clear_area))
         {
-          if (clear_area)
-            calculate_clear_area (pick_stack, rec, i, clear_area);
+          PickRecord *rec =
+            &g_array_index (pick_stack->vertices_stack, PickRecord, i);
+
           return rec->actor;
         }
     }
 
   return NULL;
 }
+
+/*
+ * Searches the actor at each of @points. Small stacks are walked only
+ * once, testing all points not resolved yet against each record, while
+ * large ones are searched point by point through their index.
+ */
+void
+clutter_pick_stack_search_actors (ClutterPickStack          *pick_stack,
+                                  int                        n_points,
+                                  const graphene_point3d_t  *points,
+                                  const graphene_ray_t      *rays,
+                                  ClutterActor             **actors,
+                                  MtkRegion                **clear_areas)
+{
+  int n_unresolved = n_points;
+  int i, j;
+
+  if (pick_stack->sealed &&
+      pick_stack->vertices_stack->len >= PICK_INDEX_MIN_RECORDS)
+    {
+      for (j = 0; j < n_points; j++)
+        {
+          actors[j] =
+            clutter_pick_stack_search_actor (pick_stack,
+                                             &points[j], &rays[j],
+                                             clear_areas ? &clear_areas[j] : NULL);
+        }
+      return;
+    }
+
+  for (j = 0; j < n_points; j++)
+    {
+      actors[j] = NULL;
+      if (clear_areas)
+        clear_areas[j] = NULL;
+    }
+
+  for (i = pick_stack->vertices_stack->len - 1;
+       i >= 0 && n_unresolved > 0;
+       i--)
+    {
+      for (j = 0; j < n_points; j++)
+        {
+          if (actors[j])
+            continue;
+
+          if (pick_record (pick_stack, i, &points[j], &rays[j],
+                           clear_areas ? &clear_areas[j] : NULL))
+            {
+              PickRecord *rec =
+                &g_array_index (pick_stack->vertices_stack, PickRecord, i);
+
+              actors[j] = rec->actor;
+              n_unresolved--;
+            }
+        }
+    }
+}
@@ -33,6 +33,7 @@
 #include "clutter/clutter-backend.h"
 #include "clutter/clutter-effect.h"
 #include "clutter/clutter-event.h"
+#include "clutter/clutter-event-private.h"
 #include "clutter/clutter-layout-manager.h"
 #include "clutter/clutter-settings.h"
 #include "clutter/clutter-stage-manager.h"
@@ -123,6 +124,9 @@ struct _ClutterMainContext
   /* the main event queue */
   GAsyncQueue *events_queue;
 
+  /* events from the input thread, if any */
+  ClutterEventRing *input_events;
+
   /* the event filters added via clutter_event_add_filter. these are
    * ordered from least recently added to most recently added */
   GList *event_filters;
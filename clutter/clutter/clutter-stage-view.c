@@ -23,11 +23,13 @@
 #include <math.h>
 
 #include "clutter/clutter-damage-history.h"
+#include "clutter/clutter-debug.h"
 #include "clutter/clutter-frame-clock.h"
 #include "clutter/clutter-frame-private.h"
 #include "clutter/clutter-private.h"
 #include "clutter/clutter-mutter.h"
 #include "clutter/clutter-stage-private.h"
+#include "clutter/clutter-tile-compare.h"
 #include "cogl/cogl.h"
 
 enum
@@ -76,6 +78,7 @@ typedef struct _ClutterStageViewPrivate
       CoglDmaBufHandle *handles[2];
       int current_idx;
       ClutterDamageHistory *damage_history;
+      gboolean uses_tile_scan_pool;
     } dma_buf;
 
     CoglOffscreen *framebuffer;
@@ -492,30 +495,239 @@ clutter_stage_view_after_paint (ClutterStageView *view,
     }
 }
 
-static gboolean
-is_tile_dirty (MtkRectangle *tile,
-               uint8_t      *current_data,
-               uint8_t      *prev_data,
-               int           bpp,
-               int           stride)
+#define TILE_SIZE 16
+#define MIN_TILE_ROWS_PER_BAND 8
+#define MAX_TILE_SCAN_THREADS 8
+
+typedef struct _TileScan
+{
+  const uint8_t *current_data;
+  const uint8_t *prev_data;
+  int stride;
+  int bpp;
+  const MtkRegion *damage_region;
+  MtkRectangle fb_rect;
+  int tile_x_min;
+  int tile_x_max;
+
+  GMutex mutex;
+  GCond cond;
+  int n_pending_bands;
+} TileScan;
+
+typedef struct _TileScanBand
 {
-  int y;
+  TileScan *scan;
+  int tile_y_min;
+  int tile_y_max;
+  MtkRegion *tile_damage_region;
+} TileScanBand;
+
+/* Shared by all views scanning for damage, and freed with the last one */
+static GThreadPool *tile_scan_pool;
+static int tile_scan_pool_users;
 
-  for (y = tile->y; y < tile->y + tile->height; y++)
+static int
+flip_dma_buf_idx (int idx)
+{
+  return (idx + 1) % 2;
+}
+
+static void
+scan_tile_band (TileScanBand *band)
+{
+  TileScan *scan = band->scan;
+  int n_tiles_per_row = scan->tile_x_max - scan->tile_x_min + 1;
+  g_autofree MtkRectangle *tiles = NULL;
+  g_autofree gboolean *dirty_tiles = NULL;
+  int tile_x, tile_y;
+  int i;
+
+  tiles = g_new (MtkRectangle, n_tiles_per_row);
+  dirty_tiles = g_new (gboolean, n_tiles_per_row);
+
+  for (tile_y = band->tile_y_min; tile_y <= band->tile_y_max; tile_y++)
     {
-      if (memcmp (prev_data + y * stride + tile->x * bpp,
-                  current_data + y * stride + tile->x * bpp,
-                  tile->width * bpp) != 0)
-        return TRUE;
+      int n_tiles = 0;
+
+      for (tile_x = scan->tile_x_min; tile_x <= scan->tile_x_max; tile_x++)
+        {
+          MtkRectangle tile = {
+            .x = tile_x * TILE_SIZE,
+            .y = tile_y * TILE_SIZE,
+            .width = TILE_SIZE,
+            .height = TILE_SIZE,
+          };
+
+          if (mtk_region_contains_rectangle (scan->damage_region, &tile) ==
+              MTK_REGION_OVERLAP_OUT)
+            continue;
+
+          if (!mtk_rectangle_intersect (&tile, &scan->fb_rect, &tile))
+            continue;
+
+          tiles[n_tiles++] = tile;
+        }
+
+      clutter_tile_compare_find_dirty (scan->current_data, scan->prev_data,
+                                       scan->stride, scan->bpp,
+                                       tiles, n_tiles,
+                                       dirty_tiles);
+
+      for (i = 0; i < n_tiles; i++)
+        {
+          if (dirty_tiles[i])
+            mtk_region_union_rectangle (band->tile_damage_region, &tiles[i]);
+        }
     }
+}
 
-  return FALSE;
+static void
+scan_tile_band_in_thread (gpointer data,
+                          gpointer user_data)
+{
+  TileScanBand *band = data;
+  TileScan *scan = band->scan;
+
+  scan_tile_band (band);
+
+  g_mutex_lock (&scan->mutex);
+  scan->n_pending_bands--;
+  g_cond_signal (&scan->cond);
+  g_mutex_unlock (&scan->mutex);
 }
 
 static int
-flip_dma_buf_idx (int idx)
+get_n_tile_scan_threads (void)
 {
-  return (idx + 1) % 2;
+  return CLAMP ((int) g_get_num_processors (), 1, MAX_TILE_SCAN_THREADS);
+}
+
+static GThreadPool *
+acquire_tile_scan_pool (ClutterStageView *view)
+{
+  ClutterStageViewPrivate *priv =
+    clutter_stage_view_get_instance_private (view);
+
+  if (priv->shadow.dma_buf.uses_tile_scan_pool)
+    return tile_scan_pool;
+
+  /* The compositor thread scans one of the bands itself. The pool is not
+   * exclusive, so its threads are shared with other pools and exit after
+   * being idle for a while. */
+  if (!tile_scan_pool)
+    {
+      tile_scan_pool = g_thread_pool_new (scan_tile_band_in_thread, NULL,
+                                          get_n_tile_scan_threads () - 1,
+                                          FALSE,
+                                          NULL);
+    }
+
+  tile_scan_pool_users++;
+  priv->shadow.dma_buf.uses_tile_scan_pool = TRUE;
+
+  return tile_scan_pool;
+}
+
+static void
+release_tile_scan_pool (ClutterStageView *view)
+{
+  ClutterStageViewPrivate *priv =
+    clutter_stage_view_get_instance_private (view);
+
+  if (!priv->shadow.dma_buf.uses_tile_scan_pool)
+    return;
+
+  priv->shadow.dma_buf.uses_tile_scan_pool = FALSE;
+
+  if (--tile_scan_pool_users == 0)
+    {
+      g_thread_pool_free (tile_scan_pool, FALSE, TRUE);
+      tile_scan_pool = NULL;
+    }
+}
+
+static void
+scan_tiles (ClutterStageView *view,
+            TileScan         *scan,
+            int               tile_y_min,
+            int               tile_y_max,
+            MtkRegion        *tile_damage_region)
+{
+  GThreadPool *pool = NULL;
+  int n_tile_rows = tile_y_max - tile_y_min + 1;
+  g_autofree TileScanBand *bands = NULL;
+  int n_bands;
+  int n_rows_per_band;
+  int i;
+
+  n_bands = MIN (get_n_tile_scan_threads (),
+                 n_tile_rows / MIN_TILE_ROWS_PER_BAND);
+
+  if (n_bands > 1 &&
+      !G_UNLIKELY (clutter_paint_debug_flags &
+                   CLUTTER_DEBUG_DISABLE_THREADED_DAMAGE_SCAN))
+    pool = acquire_tile_scan_pool (view);
+
+  if (!pool)
+    {
+      TileScanBand band = {
+        .scan = scan,
+        .tile_y_min = tile_y_min,
+        .tile_y_max = tile_y_max,
+        .tile_damage_region = tile_damage_region,
+      };
+
+      scan_tile_band (&band);
+      return;
+    }
+
+  n_rows_per_band = (n_tile_rows + n_bands - 1) / n_bands;
+
+  bands = g_new0 (TileScanBand, n_bands);
+  for (i = 0; i < n_bands; i++)
+    {
+      bands[i] = (TileScanBand) {
+        .scan = scan,
+        .tile_y_min = tile_y_min + i * n_rows_per_band,
+        .tile_y_max = MIN (tile_y_min + (i + 1) * n_rows_per_band - 1,
+                           tile_y_max),
+        .tile_damage_region = (i == 0 ? tile_damage_region
+                                      : mtk_region_create ()),
+      };
+    }
+
+  g_mutex_init (&scan->mutex);
+  g_cond_init (&scan->cond);
+  scan->n_pending_bands = n_bands - 1;
+
+  for (i = 1; i < n_bands; i++)
+    {
+      g_autoptr (GError) error = NULL;
+
+      if (!g_thread_pool_push (pool, &bands[i], &error))
+        {
+          g_warning_once ("Failed to scan for damage on a thread: %s",
+                          error->message);
+          scan_tile_band_in_thread (&bands[i], NULL);
+        }
+    }
+
+  scan_tile_band (&bands[0]);
+
+  g_mutex_lock (&scan->mutex);
+  while (scan->n_pending_bands > 0)
+    g_cond_wait (&scan->cond, &scan->mutex);
+  g_mutex_unlock (&scan->mutex);
+
+  g_cond_clear (&scan->cond);
+  g_mutex_clear (&scan->mutex);
+
+  for (i = 1; i < n_bands; i++)
+    {
+      mtk_region_union (tile_damage_region, bands[i].tile_damage_region);
+      mtk_region_unref (bands[i].tile_damage_region);
+    }
 }
 
 static MtkRegion *
@@ -527,7 +739,6 @@ find_damaged_tiles (ClutterStageView  *view,
     clutter_stage_view_get_instance_private (view);
   MtkRegion *tile_damage_region;
   MtkRectangle damage_extents;
-  MtkRectangle fb_rect;
   int prev_dma_buf_idx;
   CoglDmaBufHandle *prev_dma_buf_handle;
   uint8_t *prev_data;
@@ -535,10 +746,8 @@ find_damaged_tiles (ClutterStageView  *view,
   CoglDmaBufHandle *current_dma_buf_handle;
   uint8_t *current_data;
   int width, height, stride, bpp;
-  int tile_x_min, tile_x_max;
   int tile_y_min, tile_y_max;
-  int tile_x, tile_y;
-  const int tile_size = 16;
+  TileScan scan;
 
   prev_dma_buf_idx = flip_dma_buf_idx (priv->shadow.dma_buf.current_idx);
   prev_dma_buf_handle = priv->shadow.dma_buf.handles[prev_dma_buf_idx];
@@ -566,43 +775,29 @@ find_damaged_tiles (ClutterStageView  *view,
   if (!current_data)
     goto err_mmap_current;
 
-  fb_rect = (MtkRectangle) {
-    .width = width,
-    .height = height,
-  };
-
   damage_extents = mtk_region_get_extents (damage_region);
 
-  tile_x_min = damage_extents.x / tile_size;
-  tile_x_max = ((damage_extents.x + damage_extents.width + tile_size - 1) /
-                tile_size);
-  tile_y_min = damage_extents.y / tile_size;
-  tile_y_max = ((damage_extents.y + damage_extents.height + tile_size - 1) /
-                tile_size);
-
-  tile_damage_region = mtk_region_create ();
-
-  for (tile_y = tile_y_min; tile_y <= tile_y_max; tile_y++)
-    {
-      for (tile_x = tile_x_min; tile_x <= tile_x_max; tile_x++)
-        {
-          MtkRectangle tile = {
-            .x = tile_x * tile_size,
-            .y = tile_y * tile_size,
-            .width = tile_size,
-            .height = tile_size,
-          };
-
-          if (mtk_region_contains_rectangle (damage_region, &tile) ==
-              MTK_REGION_OVERLAP_OUT)
-            continue;
+  scan = (TileScan) {
+    .current_data = current_data,
+    .prev_data = prev_data,
+    .stride = stride,
+    .bpp = bpp,
+    .damage_region = damage_region,
+    .fb_rect = (MtkRectangle) {
+      .width = width,
+      .height = height,
+    },
+    .tile_x_min = damage_extents.x / TILE_SIZE,
+    .tile_x_max = ((damage_extents.x + damage_extents.width + TILE_SIZE - 1) /
+                   TILE_SIZE),
+  };
 
-          mtk_rectangle_intersect (&tile, &fb_rect, &tile);
+  tile_y_min = damage_extents.y / TILE_SIZE;
+  tile_y_max = ((damage_extents.y + damage_extents.height + TILE_SIZE - 1) /
+                TILE_SIZE);
 
-          if (is_tile_dirty (&tile, current_data, prev_data, bpp, stride))
-            mtk_region_union_rectangle (tile_damage_region, &tile);
-        }
-    }
+  tile_damage_region = mtk_region_create ();
+  scan_tiles (view, &scan, tile_y_min, tile_y_max, tile_damage_region);
 
   if (!cogl_dma_buf_handle_sync_read_end (prev_dma_buf_handle, error))
     {
@@ -1467,6 +1662,7 @@ clutter_stage_view_dispose (GObject *object)
   g_clear_pointer (&priv->name, g_free);
 
   g_clear_object (&priv->shadow.framebuffer);
+  release_tile_scan_pool (view);
   for (i = 0; i < G_N_ELEMENTS (priv->shadow.dma_buf.handles); i++)
     {
       g_clear_pointer (&priv->shadow.dma_buf.handles[i],
@@ -140,6 +140,13 @@ struct _ClutterStagePrivate
   GHashTable *pointer_devices;
   GHashTable *touch_sequences;
 
+  /* Unculled pick stack of the last picked view, searched by every pick
+   * until the scene changes */
+  ClutterPickStack *retained_pick_stack;
+  ClutterStageView *retained_pick_view;
+  ClutterPickMode retained_pick_mode;
+  gboolean picked_since_invalidation;
+
   guint actor_needs_immediate_relayout : 1;
 };
 
@@ -196,6 +203,12 @@ static void clutter_stage_update_view_perspective (ClutterStage *stage);
 static void clutter_stage_set_viewport (ClutterStage *stage,
                                         float         width,
                                         float         height);
+static void _clutter_stage_do_pick_points (ClutterStage            *stage,
+                                           ClutterPickMode          mode,
+                                           int                      n_points,
+                                           const graphene_point_t  *points,
+                                           ClutterActor           **actors,
+                                           MtkRegion              **clear_areas);
 
 G_DEFINE_TYPE_WITH_PRIVATE (ClutterStage, clutter_stage, CLUTTER_TYPE_ACTOR)
 
@@ -801,6 +814,15 @@ _clutter_stage_process_queued_events (ClutterStage *stage)
 
       clutter_stage_process_event (stage, event);
 
+      if (!(clutter_event_get_flags (event) & CLUTTER_EVENT_FLAG_SYNTHETIC) &&
+          clutter_event_get_time_us (event) > 0)
+        {
+          COGL_TRACE_MARK ("Input (to processed)",
+                           clutter_event_get_time_us (event),
+                           g_get_monotonic_time (),
+                           clutter_event_get_name (event));
+        }
+
     next_event:
       clutter_event_free (event);
     }
@@ -904,7 +926,10 @@ clutter_stage_maybe_relayout (ClutterActor *actor)
   CLUTTER_NOTE (ACTOR, "<<< Completed recomputing layout of %d subtrees", count);
 
   if (count)
-    clutter_stage_invalidate_views_devices (stage);
+    {
+      clutter_stage_invalidate_pick (stage);
+      clutter_stage_invalidate_views_devices (stage);
+    }
 }
 
 GSList *
@@ -975,11 +1000,24 @@ clutter_stage_update_devices (ClutterStage *stage,
                               GSList       *devices)
 {
   ClutterStagePrivate *priv = stage->priv;
+  g_autofree graphene_point_t *coords = NULL;
+  g_autofree ClutterActor **actors = NULL;
+  g_autofree MtkRegion **clear_areas = NULL;
+  int n_devices;
   GSList *l;
+  int i;
 
   COGL_TRACE_BEGIN_SCOPED (ClutterStageUpdateDevices, "UpdateDevices");
 
-  for (l = devices; l; l = l->next)
+  n_devices = g_slist_length (devices);
+  if (n_devices == 0)
+    return;
+
+  coords = g_new (graphene_point_t, n_devices);
+  actors = g_new (ClutterActor *, n_devices);
+  clear_areas = g_new (MtkRegion *, n_devices);
+
+  for (l = devices, i = 0; l; l = l->next, i++)
     {
       ClutterInputDevice *device = l->data;
       PointerDeviceEntry *entry = NULL;
@@ -987,13 +1025,48 @@ clutter_stage_update_devices (ClutterStage *stage,
       entry = g_hash_table_lookup (priv->pointer_devices, device);
       g_assert (entry != NULL);
 
-      clutter_stage_pick_and_update_device (stage,
-                                            device,
-                                            NULL, NULL,
-                                            CLUTTER_DEVICE_UPDATE_IGNORE_CACHE |
-                                            CLUTTER_DEVICE_UPDATE_EMIT_CROSSING,
-                                            entry->coords,
-                                            CLUTTER_CURRENT_TIME);
+      coords[i] = entry->coords;
+    }
+
+  /* Pick all devices against the same pick of the scene, rather than
+   * picking the scene again for each of them */
+  _clutter_stage_do_pick_points (stage, CLUTTER_PICK_REACTIVE,
+                                 n_devices, coords,
+                                 actors, clear_areas);
+
+  /* Crossing events emitted for one device may destroy actors picked
+   * for the others, keep them alive until all devices are updated.
+   */
+  for (i = 0; i < n_devices; i++)
+    g_object_ref (actors[i]);
+
+  for (l = devices, i = 0; l; l = l->next, i++)
+    {
+      ClutterInputDevice *device = l->data;
+
+      if (clutter_actor_get_stage (actors[i]) == CLUTTER_ACTOR (stage))
+        {
+          clutter_stage_update_device (stage,
+                                       device, NULL, NULL,
+                                       coords[i],
+                                       CLUTTER_CURRENT_TIME,
+                                       actors[i],
+                                       clear_areas[i],
+                                       TRUE);
+        }
+      else
+        {
+          /* The picked actor went away in the meantime, pick again */
+          clutter_stage_pick_and_update_device (stage,
+                                                device, NULL, NULL,
+                                                CLUTTER_DEVICE_UPDATE_IGNORE_CACHE |
+                                                CLUTTER_DEVICE_UPDATE_EMIT_CROSSING,
+                                                coords[i],
+                                                CLUTTER_CURRENT_TIME);
+        }
+
+      g_clear_pointer (&clear_areas[i], mtk_region_unref);
+      g_object_unref (actors[i]);
     }
 }
 
@@ -1066,6 +1139,73 @@ setup_ray_for_coordinates (ClutterStage       *stage,
   graphene_point3d_init_from_point (point, &p);
 }
 
+/**
+ * clutter_stage_invalidate_pick: (skip)
+ *
+ * Drops what is kept around to speed up picking. Anything that changes
+ * what is picked without queuing a redraw or a relayout of the changed
+ * actor must call this.
+ */
+void
+clutter_stage_invalidate_pick (ClutterStage *stage)
+{
+  ClutterStagePrivate *priv = stage->priv;
+
+  priv->picked_since_invalidation = FALSE;
+  g_clear_pointer (&priv->retained_pick_stack, clutter_pick_stack_unref);
+}
+
+static ClutterPickStack *
+clutter_stage_get_pick_stack (ClutterStage             *stage,
+                              ClutterStageView         *view,
+                              ClutterPickMode           mode,
+                              const graphene_point3d_t *point,
+                              const graphene_ray_t     *ray)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  ClutterPickContext *pick_context;
+  ClutterPickStack *pick_stack;
+
+  if (priv->retained_pick_stack &&
+      priv->retained_pick_view == view &&
+      priv->retained_pick_mode == mode)
+    {
+      pick_stack = clutter_pick_stack_ref (priv->retained_pick_stack);
+    }
+  else if (!point || priv->picked_since_invalidation)
+    {
+      /* Either several points are being picked at once, or the scene
+       * didn't change since the last pick, so more are likely to follow
+       * before it does. Pick the whole view once and keep the result
+       * around rather than picking each point.
+       */
+      pick_context = clutter_pick_context_new_for_view (view, mode,
+                                                        NULL, NULL);
+
+      clutter_actor_pick (CLUTTER_ACTOR (stage), pick_context);
+      pick_stack = clutter_pick_context_steal_stack (pick_context);
+      clutter_pick_context_destroy (pick_context);
+
+      g_clear_pointer (&priv->retained_pick_stack, clutter_pick_stack_unref);
+      priv->retained_pick_stack = clutter_pick_stack_ref (pick_stack);
+      priv->retained_pick_view = view;
+      priv->retained_pick_mode = mode;
+    }
+  else
+    {
+      pick_context = clutter_pick_context_new_for_view (view, mode,
+                                                        point, ray);
+
+      clutter_actor_pick (CLUTTER_ACTOR (stage), pick_context);
+      pick_stack = clutter_pick_context_steal_stack (pick_context);
+      clutter_pick_context_destroy (pick_context);
+    }
+
+  priv->picked_since_invalidation = TRUE;
+
+  return pick_stack;
+}
+
 static ClutterActor *
 _clutter_stage_do_pick_on_view (ClutterStage      *stage,
                                 float              x,
@@ -1075,7 +1215,6 @@ _clutter_stage_do_pick_on_view (ClutterStage      *stage,
                                 MtkRegion        **clear_area)
 {
   g_autoptr (ClutterPickStack) pick_stack = NULL;
-  ClutterPickContext *pick_context;
   graphene_point3d_t p;
   graphene_ray_t ray;
   ClutterActor *actor;
@@ -1084,16 +1223,47 @@ _clutter_stage_do_pick_on_view (ClutterStage      *stage,
 
   setup_ray_for_coordinates (stage, x, y, &p, &ray);
 
-  pick_context = clutter_pick_context_new_for_view (view, mode, &p, &ray);
-
-  clutter_actor_pick (CLUTTER_ACTOR (stage), pick_context);
-  pick_stack = clutter_pick_context_steal_stack (pick_context);
-  clutter_pick_context_destroy (pick_context);
+  pick_stack = clutter_stage_get_pick_stack (stage, view, mode, &p, &ray);
 
   actor = clutter_pick_stack_search_actor (pick_stack, &p, &ray, clear_area);
   return actor ? actor : CLUTTER_ACTOR (stage);
 }
 
+static void
+_clutter_stage_do_pick_points_on_view (ClutterStage            *stage,
+                                       ClutterStageView        *view,
+                                       ClutterPickMode          mode,
+                                       int                      n_points,
+                                       const graphene_point_t  *points,
+                                       ClutterActor           **actors,
+                                       MtkRegion              **clear_areas)
+{
+  g_autoptr (ClutterPickStack) pick_stack = NULL;
+  g_autofree graphene_point3d_t *p = NULL;
+  g_autofree graphene_ray_t *rays = NULL;
+  int i;
+
+  COGL_TRACE_BEGIN_SCOPED (ClutterStagePickPointsView,
+                           "Pick points (view)");
+
+  p = g_new (graphene_point3d_t, n_points);
+  rays = g_new (graphene_ray_t, n_points);
+
+  for (i = 0; i < n_points; i++)
+    setup_ray_for_coordinates (stage, points[i].x, points[i].y, &p[i], &rays[i]);
+
+  pick_stack = clutter_stage_get_pick_stack (stage, view, mode, NULL, NULL);
+
+  clutter_pick_stack_search_actors (pick_stack, n_points, p, rays,
+                                    actors, clear_areas);
+
+  for (i = 0; i < n_points; i++)
+    {
+      if (!actors[i])
+        actors[i] = CLUTTER_ACTOR (stage);
+    }
+}
+
 /**
  * clutter_stage_get_view_at: (skip)
  */
@@ -1121,40 +1291,129 @@ clutter_stage_get_view_at (ClutterStage *stage,
   return NULL;
 }
 
-static ClutterActor *
-_clutter_stage_do_pick (ClutterStage     *stage,
-                        float             x,
-                        float             y,
-                        ClutterPickMode   mode,
-                        MtkRegion       **clear_area)
+static gboolean
+clutter_stage_can_pick (ClutterStage *stage)
 {
-  ClutterActor *actor = CLUTTER_ACTOR (stage);
   ClutterStagePrivate *priv = stage->priv;
-  float stage_width, stage_height;
-  ClutterStageView *view = NULL;
-
-  priv = stage->priv;
 
   if (CLUTTER_ACTOR_IN_DESTRUCTION (stage))
-    return actor;
+    return FALSE;
 
   if (G_UNLIKELY (clutter_pick_debug_flags & CLUTTER_DEBUG_NOP_PICKING))
-    return actor;
+    return FALSE;
 
   if (G_UNLIKELY (priv->impl == NULL))
-    return actor;
+    return FALSE;
+
+  return TRUE;
+}
+
+static ClutterStageView *
+clutter_stage_get_pick_view (ClutterStage *stage,
+                             float         x,
+                             float         y)
+{
+  float stage_width, stage_height;
 
   clutter_actor_get_size (CLUTTER_ACTOR (stage), &stage_width, &stage_height);
   if (x < 0 || x >= stage_width || y < 0 || y >= stage_height)
+    return NULL;
+
+  return clutter_stage_get_view_at (stage, x, y);
+}
+
+static ClutterActor *
+_clutter_stage_do_pick (ClutterStage     *stage,
+                        float             x,
+                        float             y,
+                        ClutterPickMode   mode,
+                        MtkRegion       **clear_area)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (stage);
+  ClutterStageView *view = NULL;
+
+  if (!clutter_stage_can_pick (stage))
     return actor;
 
-  view = clutter_stage_get_view_at (stage, x, y);
+  view = clutter_stage_get_pick_view (stage, x, y);
   if (view)
     return _clutter_stage_do_pick_on_view (stage, x, y, mode, view, clear_area);
 
   return actor;
 }
 
+/*
+ * Picks all of @points, sharing a single pick of the scene between the
+ * points on the same stage view. @clear_areas may be NULL.
+ */
+static void
+_clutter_stage_do_pick_points (ClutterStage            *stage,
+                               ClutterPickMode          mode,
+                               int                      n_points,
+                               const graphene_point_t  *points,
+                               ClutterActor           **actors,
+                               MtkRegion              **clear_areas)
+{
+  g_autofree ClutterStageView **views = NULL;
+  g_autofree graphene_point_t *view_points = NULL;
+  g_autofree ClutterActor **view_actors = NULL;
+  g_autofree MtkRegion **view_clear_areas = NULL;
+  g_autofree int *view_indices = NULL;
+  int i, j;
+
+  for (i = 0; i < n_points; i++)
+    {
+      actors[i] = CLUTTER_ACTOR (stage);
+      if (clear_areas)
+        clear_areas[i] = NULL;
+    }
+
+  if (!clutter_stage_can_pick (stage))
+    return;
+
+  views = g_new (ClutterStageView *, n_points);
+  for (i = 0; i < n_points; i++)
+    views[i] = clutter_stage_get_pick_view (stage, points[i].x, points[i].y);
+
+  view_points = g_new (graphene_point_t, n_points);
+  view_actors = g_new (ClutterActor *, n_points);
+  view_indices = g_new (int, n_points);
+  if (clear_areas)
+    view_clear_areas = g_new (MtkRegion *, n_points);
+
+  for (i = 0; i < n_points; i++)
+    {
+      ClutterStageView *view = views[i];
+      int n_view_points = 0;
+
+      if (!view)
+        continue;
+
+      for (j = i; j < n_points; j++)
+        {
+          if (views[j] != view)
+            continue;
+
+          view_points[n_view_points] = points[j];
+          view_indices[n_view_points] = j;
+          n_view_points++;
+
+          views[j] = NULL;
+        }
+
+      _clutter_stage_do_pick_points_on_view (stage, view, mode,
+                                             n_view_points, view_points,
+                                             view_actors, view_clear_areas);
+
+      for (j = 0; j < n_view_points; j++)
+        {
+          actors[view_indices[j]] = view_actors[j];
+          if (clear_areas)
+            clear_areas[view_indices[j]] = view_clear_areas[j];
+        }
+    }
+}
+
 static void
 clutter_stage_real_apply_transform (ClutterActor      *stage,
                                     graphene_matrix_t *matrix)
@@ -1264,6 +1523,8 @@ clutter_stage_dispose (GObject *object)
                      (GDestroyNotify) g_object_unref);
   priv->pending_relayouts = NULL;
 
+  g_clear_pointer (&priv->retained_pick_stack, clutter_pick_stack_unref);
+
   /* this will release the reference on the stage */
   stage_manager = clutter_stage_manager_get_default ();
   _clutter_stage_manager_remove_stage (stage_manager, stage);
@@ -2033,6 +2294,33 @@ clutter_stage_get_actor_at_pos (ClutterStage    *stage,
   return _clutter_stage_do_pick (stage, x, y, pick_mode, NULL);
 }
 
+/**
+ * clutter_stage_get_actors_at_pos: (skip)
+ * @stage: a #ClutterStage
+ * @pick_mode: how the scene graph should be painted
+ * @n_points: the number of points to check
+ * @points: (array length=n_points): the coordinates to check
+ * @actors: (array length=n_points) (out caller-allocates): return location
+ *   for the actor at each of @points
+ *
+ * Like [method@Clutter.Stage.get_actor_at_pos], but for several points at
+ * once. This is cheaper than checking the points one by one, as the scene
+ * is only picked once for all of them.
+ */
+void
+clutter_stage_get_actors_at_pos (ClutterStage            *stage,
+                                 ClutterPickMode          pick_mode,
+                                 int                      n_points,
+                                 const graphene_point_t  *points,
+                                 ClutterActor           **actors)
+{
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+  g_return_if_fail (n_points >= 0);
+
+  _clutter_stage_do_pick_points (stage, pick_mode, n_points, points,
+                                 actors, NULL);
+}
+
 /**
  * clutter_stage_set_title:
  * @stage: A #ClutterStage
@@ -2418,6 +2706,7 @@ clutter_stage_update_view_perspective (ClutterStage *stage)
                           priv->viewport[3]);
 
   clutter_actor_invalidate_transform (CLUTTER_ACTOR (stage));
+  clutter_stage_invalidate_pick (stage);
 }
 
 void
@@ -2705,26 +2994,17 @@ clutter_stage_get_capture_final_size (ClutterStage *stage,
   return TRUE;
 }
 
-void
-clutter_stage_paint_to_framebuffer (ClutterStage                *stage,
-                                    CoglFramebuffer             *framebuffer,
-                                    const MtkRectangle          *rect,
-                                    float                        scale,
-                                    ClutterPaintFlag             paint_flags)
+static void
+paint_stage_to_framebuffer (ClutterStage       *stage,
+                            CoglFramebuffer    *framebuffer,
+                            const MtkRectangle *rect,
+                            float               scale,
+                            const MtkRegion    *redraw_clip,
+                            ClutterPaintFlag    paint_flags)
 {
   ClutterStagePrivate *priv = stage->priv;
   ClutterPaintContext *paint_context;
-  g_autoptr (MtkRegion) redraw_clip = NULL;
 
-  if (paint_flags & CLUTTER_PAINT_FLAG_CLEAR)
-    {
-      CoglColor clear_color;
-
-      cogl_color_init_from_4ub (&clear_color, 0, 0, 0, 0);
-      cogl_framebuffer_clear (framebuffer, COGL_BUFFER_BIT_COLOR, &clear_color);
-    }
-
-  redraw_clip = mtk_region_create_rectangle (rect);
   paint_context =
     clutter_paint_context_new_for_framebuffer (framebuffer,
                                                redraw_clip,
@@ -2743,6 +3023,104 @@ clutter_stage_paint_to_framebuffer (ClutterStage                *stage,
   clutter_paint_context_destroy (paint_context);
 }
 
+void
+clutter_stage_paint_to_framebuffer (ClutterStage                *stage,
+                                    CoglFramebuffer             *framebuffer,
+                                    const MtkRectangle          *rect,
+                                    float                        scale,
+                                    ClutterPaintFlag             paint_flags)
+{
+  g_autoptr (MtkRegion) redraw_clip = NULL;
+
+  if (paint_flags & CLUTTER_PAINT_FLAG_CLEAR)
+    {
+      CoglColor clear_color;
+
+      cogl_color_init_from_4ub (&clear_color, 0, 0, 0, 0);
+      cogl_framebuffer_clear (framebuffer, COGL_BUFFER_BIT_COLOR, &clear_color);
+    }
+
+  redraw_clip = mtk_region_create_rectangle (rect);
+  paint_stage_to_framebuffer (stage, framebuffer, rect, scale, redraw_clip,
+                              paint_flags);
+}
+
+/**
+ * clutter_stage_paint_region_to_framebuffer: (skip)
+ * @stage: a #ClutterStage
+ * @framebuffer: the framebuffer to paint into
+ * @rect: the stage area @framebuffer maps to
+ * @scale: the scale
+ * @region: the area of @framebuffer to update, in framebuffer pixels
+ * @paint_flags: the #ClutterPaintFlag
+ *
+ * Like clutter_stage_paint_to_framebuffer(), but only repaints @region,
+ * leaving the rest of @framebuffer untouched. This is used to bring a
+ * framebuffer holding an earlier paint of @rect up to date.
+ */
+void
+clutter_stage_paint_region_to_framebuffer (ClutterStage       *stage,
+                                           CoglFramebuffer    *framebuffer,
+                                           const MtkRectangle *rect,
+                                           float               scale,
+                                           const MtkRegion    *region,
+                                           ClutterPaintFlag    paint_flags)
+{
+  g_autoptr (MtkRegion) redraw_clip = NULL;
+  int n_rects;
+  int i;
+
+  n_rects = mtk_region_num_rectangles (region);
+  if (n_rects == 0)
+    return;
+
+  redraw_clip = mtk_region_create ();
+
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle fb_rect = mtk_region_get_rectangle (region, i);
+      MtkRectangle stage_rect;
+      int x1, y1, x2, y2;
+
+      /* Clearing only honours the scissor bounds of the clip, so clear
+       * each rectangle separately instead of the extents of the region.
+       */
+      if (paint_flags & CLUTTER_PAINT_FLAG_CLEAR)
+        {
+          g_autoptr (MtkRegion) clear_region = NULL;
+          CoglColor clear_color;
+
+          clear_region = mtk_region_create_rectangle (&fb_rect);
+          cogl_color_init_from_4ub (&clear_color, 0, 0, 0, 0);
+
+          cogl_framebuffer_push_region_clip (framebuffer, clear_region);
+          cogl_framebuffer_clear (framebuffer, COGL_BUFFER_BIT_COLOR,
+                                  &clear_color);
+          cogl_framebuffer_pop_clip (framebuffer);
+        }
+
+      x1 = (int) floorf (fb_rect.x / scale);
+      y1 = (int) floorf (fb_rect.y / scale);
+      x2 = (int) ceilf ((fb_rect.x + fb_rect.width) / scale);
+      y2 = (int) ceilf ((fb_rect.y + fb_rect.height) / scale);
+
+      stage_rect = (MtkRectangle) {
+        .x = rect->x + x1,
+        .y = rect->y + y1,
+        .width = x2 - x1,
+        .height = y2 - y1,
+      };
+      mtk_region_union_rectangle (redraw_clip, &stage_rect);
+    }
+
+  mtk_region_intersect_rectangle (redraw_clip, rect);
+
+  cogl_framebuffer_push_region_clip (framebuffer, (MtkRegion *) region);
+  paint_stage_to_framebuffer (stage, framebuffer, rect, scale, redraw_clip,
+                              paint_flags);
+  cogl_framebuffer_pop_clip (framebuffer);
+}
+
 /**
  * clutter_stage_paint_to_buffer:
  * @stage: a #ClutterStage actor
@@ -2919,6 +3297,231 @@ clutter_stage_capture_view_into (ClutterStage     *stage,
   g_object_unref (bitmap);
 }
 
+typedef struct _CaptureViewData
+{
+  CoglFramebuffer *framebuffer;
+  uint8_t *data;
+  int stride;
+  int height;
+
+  CoglReadPixelsClosure *read_closure;
+  GSource *cancelled_source;
+} CaptureViewData;
+
+static void
+clear_cancelled_source (CaptureViewData *capture_data)
+{
+  if (!capture_data->cancelled_source)
+    return;
+
+  g_source_destroy (capture_data->cancelled_source);
+  g_clear_pointer (&capture_data->cancelled_source, g_source_unref);
+}
+
+static void
+capture_view_data_free (CaptureViewData *capture_data)
+{
+  clear_cancelled_source (capture_data);
+  g_clear_object (&capture_data->framebuffer);
+  g_free (capture_data->data);
+  g_free (capture_data);
+}
+
+static gboolean
+capture_view_cancelled_cb (GCancellable *cancellable,
+                           gpointer      user_data)
+{
+  GTask *task = user_data;
+  CaptureViewData *capture_data = g_task_get_task_data (task);
+
+  /* Release the pixel buffer and fence right away rather than once the
+   * GPU is done; the read back callback won't be called anymore, so its
+   * reference on the task is dropped here. */
+  cogl_framebuffer_cancel_read_pixels (capture_data->framebuffer,
+                                       capture_data->read_closure);
+  capture_data->read_closure = NULL;
+  clear_cancelled_source (capture_data);
+
+  g_task_return_error_if_cancelled (task);
+  g_object_unref (task);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+capture_view_read_pixels_cb (CoglFramebuffer *framebuffer,
+                             gboolean         success,
+                             void            *user_data)
+{
+  g_autoptr (GTask) task = user_data;
+  CaptureViewData *capture_data = g_task_get_task_data (task);
+  GBytes *bytes;
+
+  capture_data->read_closure = NULL;
+  clear_cancelled_source (capture_data);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  if (!success)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               "Failed to read back view");
+      return;
+    }
+
+  bytes = g_bytes_new_take (g_steal_pointer (&capture_data->data),
+                            (size_t) capture_data->stride *
+                            capture_data->height);
+  g_task_return_pointer (task, bytes, (GDestroyNotify) g_bytes_unref);
+}
+
+/**
+ * clutter_stage_capture_view_async: (skip)
+ * @stage: a #ClutterStage
+ * @view: the #ClutterStageView to capture
+ * @rect: (nullable): the area of @view to capture, in stage coordinates,
+ *   or %NULL for the whole view
+ * @format: the pixel format of the captured pixels
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: the callback to call once the capture is done
+ * @user_data: data for @callback
+ *
+ * Like clutter_stage_capture_view_into(), but without blocking until the
+ * GPU is done rendering the view. The pixels are read back into a pixel
+ * buffer, and @callback is called once a fence signals that they are
+ * available. Use clutter_stage_capture_view_finish() to get them.
+ *
+ * If the driver can't read back asynchronously, the view is read
+ * synchronously instead, and @callback is still called from the main
+ * loop.
+ */
+void
+clutter_stage_capture_view_async (ClutterStage        *stage,
+                                  ClutterStageView    *view,
+                                  const MtkRectangle  *rect,
+                                  CoglPixelFormat      format,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  g_autoptr (GError) error = NULL;
+  CoglFramebuffer *framebuffer;
+  CaptureViewData *capture_data;
+  MtkRectangle view_layout;
+  float view_scale;
+  int x, y;
+  int width, height;
+  int bpp;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+  g_return_if_fail (cogl_pixel_format_get_n_planes (format) == 1);
+
+  COGL_TRACE_BEGIN_SCOPED (ClutterStageCaptureViewAsync,
+                           "Capture view (async)");
+
+  task = g_task_new (stage, cancellable, callback, user_data);
+  g_task_set_source_tag (task, clutter_stage_capture_view_async);
+
+  framebuffer = clutter_stage_view_get_framebuffer (view);
+
+  clutter_stage_view_get_layout (view, &view_layout);
+
+  if (!rect)
+    rect = &view_layout;
+
+  view_scale = clutter_stage_view_get_scale (view);
+  x = roundf ((rect->x - view_layout.x) * view_scale);
+  y = roundf ((rect->y - view_layout.y) * view_scale);
+  width = roundf (rect->width * view_scale);
+  height = roundf (rect->height * view_scale);
+  bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+
+  capture_data = g_new0 (CaptureViewData, 1);
+  capture_data->framebuffer = g_object_ref (framebuffer);
+  capture_data->stride = width * bpp;
+  capture_data->height = height;
+  capture_data->data = g_malloc ((size_t) capture_data->stride * height);
+  g_task_set_task_data (task, capture_data,
+                        (GDestroyNotify) capture_view_data_free);
+
+  capture_data->read_closure =
+    cogl_framebuffer_read_pixels_async (framebuffer,
+                                        x, y,
+                                        width, height,
+                                        format,
+                                        capture_data->data,
+                                        capture_data->stride,
+                                        capture_view_read_pixels_cb,
+                                        g_object_ref (task),
+                                        &error);
+  if (capture_data->read_closure)
+    {
+      if (cancellable)
+        {
+          capture_data->cancelled_source =
+            g_cancellable_source_new (cancellable);
+          g_task_attach_source (task, capture_data->cancelled_source,
+                                (GSourceFunc) capture_view_cancelled_cb);
+        }
+      return;
+    }
+
+  g_object_unref (task);
+
+  if (!g_error_matches (error, COGL_SYSTEM_ERROR,
+                        COGL_SYSTEM_ERROR_UNSUPPORTED))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  if (!cogl_framebuffer_read_pixels (framebuffer,
+                                     x, y,
+                                     width, height,
+                                     format,
+                                     capture_data->data))
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               "Failed to read back view");
+      return;
+    }
+
+  capture_view_read_pixels_cb (framebuffer, TRUE, g_object_ref (task));
+}
+
+/**
+ * clutter_stage_capture_view_finish: (skip)
+ * @stage: a #ClutterStage
+ * @result: the #GAsyncResult passed to the callback
+ * @out_stride: (out): return location for the stride of the pixels
+ * @error: return location for a #GError
+ *
+ * Finishes capturing a view started with
+ * clutter_stage_capture_view_async().
+ *
+ * Returns: (transfer full): the captured pixels, or %NULL on error
+ */
+GBytes *
+clutter_stage_capture_view_finish (ClutterStage  *stage,
+                                   GAsyncResult  *result,
+                                   int           *out_stride,
+                                   GError       **error)
+{
+  CaptureViewData *capture_data;
+
+  g_return_val_if_fail (g_task_is_valid (result, stage), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) ==
+                        clutter_stage_capture_view_async, NULL);
+
+  capture_data = g_task_get_task_data (G_TASK (result));
+  if (out_stride)
+    *out_stride = capture_data->stride;
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * clutter_stage_peek_stage_views: (skip)
  */
@@ -2934,6 +3537,7 @@ void
 clutter_stage_clear_stage_views (ClutterStage *stage)
 {
   clutter_actor_clear_stage_views_recursive (CLUTTER_ACTOR (stage), FALSE);
+  clutter_stage_invalidate_pick (stage);
 }
 
 GList *
@@ -0,0 +1,406 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tile comparison used for detecting the actual damage between two
+ * consecutive shadow framebuffer contents.
+ *
+ * A row of tiles is compared one scanline at a time, instead of one tile
+ * at a time, so that memory is walked linearly. Tiles that are already known
+ * to be dirty are skipped, and the scan ends as soon as all tiles in the row
+ * are dirty. The per scanline kernel is selected at runtime depending on what
+ * the CPU supports.
+ */
+
+#include "clutter/clutter-build-config.h"
+
+#include "clutter/clutter-tile-compare.h"
+
+#include <string.h>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define HAVE_TILE_COMPARE_X86
+#include <immintrin.h>
+#endif
+
+#if defined (__ARM_NEON) || defined (__ARM_NEON__)
+#define HAVE_TILE_COMPARE_NEON
+#include <arm_neon.h>
+#endif
+
+typedef int (* CompareScanlineFunc) (const uint8_t      *current_row,
+                                     const uint8_t      *prev_row,
+                                     const MtkRectangle *tiles,
+                                     int                 n_tiles,
+                                     int                 bpp,
+                                     gboolean           *dirty);
+
+/*
+ * Compares the part of a scanline covered by each tile that is not yet dirty,
+ * marks the tiles that differ as dirty, and returns the number of newly
+ * dirtied tiles.
+ */
+#define DEFINE_COMPARE_SCANLINE(impl, attributes) \
+attributes static int \
+compare_scanline_##impl (const uint8_t      *current_row, \
+                         const uint8_t      *prev_row, \
+                         const MtkRectangle *tiles, \
+                         int                 n_tiles, \
+                         int                 bpp, \
+                         gboolean           *dirty) \
+{ \
+  int n_dirtied = 0; \
+  int i; \
+\
+  for (i = 0; i < n_tiles; i++) \
+    { \
+      size_t offset; \
+      size_t length; \
+\
+      if (dirty[i]) \
+        continue; \
+\
+      offset = (size_t) tiles[i].x * bpp; \
+      length = (size_t) tiles[i].width * bpp; \
+      if (span_differs_##impl (current_row + offset, \
+                               prev_row + offset, \
+                               length)) \
+        { \
+          dirty[i] = TRUE; \
+          n_dirtied++; \
+        } \
+    } \
+\
+  return n_dirtied; \
+}
+
+static inline gboolean
+span_differs_scalar (const uint8_t *a,
+                     const uint8_t *b,
+                     size_t         length)
+{
+  return memcmp (a, b, length) != 0;
+}
+
+DEFINE_COMPARE_SCANLINE (scalar, )
+
+#ifdef HAVE_TILE_COMPARE_X86
+
+#define XOR_128(a, b, i) \
+  _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) ((a) + (i))), \
+                 _mm_loadu_si128 ((const __m128i *) ((b) + (i))))
+
+__attribute__ ((target ("sse2")))
+static inline gboolean
+span_differs_sse2 (const uint8_t *a,
+                   const uint8_t *b,
+                   size_t         length)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  size_t i = 0;
+
+  /* A 16 pixel wide tile of 32 bit pixels is 64 bytes wide. */
+  for (; i + 64 <= length; i += 64)
+    {
+      __m128i diff;
+
+      diff = _mm_or_si128 (_mm_or_si128 (XOR_128 (a, b, i),
+                                         XOR_128 (a, b, i + 16)),
+                           _mm_or_si128 (XOR_128 (a, b, i + 32),
+                                         XOR_128 (a, b, i + 48)));
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (diff, zero)) != 0xffff)
+        return TRUE;
+    }
+
+  for (; i + 16 <= length; i += 16)
+    {
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (XOR_128 (a, b, i), zero)) !=
+          0xffff)
+        return TRUE;
+    }
+
+  return memcmp (a + i, b + i, length - i) != 0;
+}
+
+#undef XOR_128
+
+DEFINE_COMPARE_SCANLINE (sse2, __attribute__ ((target ("sse2"))))
+
+#define XOR_256(a, b, i) \
+  _mm256_xor_si256 (_mm256_loadu_si256 ((const __m256i *) ((a) + (i))), \
+                    _mm256_loadu_si256 ((const __m256i *) ((b) + (i))))
+
+__attribute__ ((target ("avx2")))
+static inline gboolean
+span_differs_avx2 (const uint8_t *a,
+                   const uint8_t *b,
+                   size_t         length)
+{
+  size_t i = 0;
+
+  for (; i + 64 <= length; i += 64)
+    {
+      __m256i diff;
+
+      diff = _mm256_or_si256 (XOR_256 (a, b, i),
+                              XOR_256 (a, b, i + 32));
+      if (!_mm256_testz_si256 (diff, diff))
+        return TRUE;
+    }
+
+  for (; i + 32 <= length; i += 32)
+    {
+      __m256i diff;
+
+      diff = XOR_256 (a, b, i);
+      if (!_mm256_testz_si256 (diff, diff))
+        return TRUE;
+    }
+
+  return memcmp (a + i, b + i, length - i) != 0;
+}
+
+#undef XOR_256
+
+DEFINE_COMPARE_SCANLINE (avx2, __attribute__ ((target ("avx2"))))
+
+#endif /* HAVE_TILE_COMPARE_X86 */
+
+#ifdef HAVE_TILE_COMPARE_NEON
+
+#define XOR_128(a, b, i) \
+  veorq_u8 (vld1q_u8 ((a) + (i)), vld1q_u8 ((b) + (i)))
+
+static inline gboolean
+is_zero_neon (uint8x16_t value)
+{
+  uint64x2_t value_64 = vreinterpretq_u64_u8 (value);
+
+  return (vgetq_lane_u64 (value_64, 0) | vgetq_lane_u64 (value_64, 1)) == 0;
+}
+
+static inline gboolean
+span_differs_neon (const uint8_t *a,
+                   const uint8_t *b,
+                   size_t         length)
+{
+  size_t i = 0;
+
+  for (; i + 64 <= length; i += 64)
+    {
+      uint8x16_t diff;
+
+      diff = vorrq_u8 (vorrq_u8 (XOR_128 (a, b, i),
+                                 XOR_128 (a, b, i + 16)),
+                       vorrq_u8 (XOR_128 (a, b, i + 32),
+                                 XOR_128 (a, b, i + 48)));
+      if (!is_zero_neon (diff))
+        return TRUE;
+    }
+
+  for (; i + 16 <= length; i += 16)
+    {
+      if (!is_zero_neon (XOR_128 (a, b, i)))
+        return TRUE;
+    }
+
+  return memcmp (a + i, b + i, length - i) != 0;
+}
+
+#undef XOR_128
+
+DEFINE_COMPARE_SCANLINE (neon, )
+
+#endif /* HAVE_TILE_COMPARE_NEON */
+
+static ClutterTileCompareImpl active_impl;
+static CompareScanlineFunc compare_scanline;
+
+static gboolean
+is_impl_supported (ClutterTileCompareImpl impl)
+{
+  switch (impl)
+    {
+    case CLUTTER_TILE_COMPARE_IMPL_AUTO:
+    case CLUTTER_TILE_COMPARE_IMPL_SCALAR:
+      return TRUE;
+    case CLUTTER_TILE_COMPARE_IMPL_SSE2:
+#ifdef HAVE_TILE_COMPARE_X86
+      return __builtin_cpu_supports ("sse2");
+#else
+      return FALSE;
+#endif
+    case CLUTTER_TILE_COMPARE_IMPL_AVX2:
+#ifdef HAVE_TILE_COMPARE_X86
+      return __builtin_cpu_supports ("avx2");
+#else
+      return FALSE;
+#endif
+    case CLUTTER_TILE_COMPARE_IMPL_NEON:
+#ifdef HAVE_TILE_COMPARE_NEON
+      return TRUE;
+#else
+      return FALSE;
+#endif
+    }
+
+  g_assert_not_reached ();
+}
+
+static ClutterTileCompareImpl
+choose_best_impl (void)
+{
+  if (is_impl_supported (CLUTTER_TILE_COMPARE_IMPL_AVX2))
+    return CLUTTER_TILE_COMPARE_IMPL_AVX2;
+  else if (is_impl_supported (CLUTTER_TILE_COMPARE_IMPL_SSE2))
+    return CLUTTER_TILE_COMPARE_IMPL_SSE2;
+  else if (is_impl_supported (CLUTTER_TILE_COMPARE_IMPL_NEON))
+    return CLUTTER_TILE_COMPARE_IMPL_NEON;
+  else
+    return CLUTTER_TILE_COMPARE_IMPL_SCALAR;
+}
+
+static void
+activate_impl (ClutterTileCompareImpl impl)
+{
+  if (impl == CLUTTER_TILE_COMPARE_IMPL_AUTO)
+    impl = choose_best_impl ();
+
+  switch (impl)
+    {
+    case CLUTTER_TILE_COMPARE_IMPL_AUTO:
+      g_assert_not_reached ();
+      break;
+    case CLUTTER_TILE_COMPARE_IMPL_SCALAR:
+      compare_scanline = compare_scanline_scalar;
+      break;
+    case CLUTTER_TILE_COMPARE_IMPL_SSE2:
+#ifdef HAVE_TILE_COMPARE_X86
+      compare_scanline = compare_scanline_sse2;
+#endif
+      break;
+    case CLUTTER_TILE_COMPARE_IMPL_AVX2:
+#ifdef HAVE_TILE_COMPARE_X86
+      compare_scanline = compare_scanline_avx2;
+#endif
+      break;
+    case CLUTTER_TILE_COMPARE_IMPL_NEON:
+#ifdef HAVE_TILE_COMPARE_NEON
+      compare_scanline = compare_scanline_neon;
+#endif
+      break;
+    }
+
+  active_impl = impl;
+}
+
+static void
+ensure_impl (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      if (!compare_scanline)
+        activate_impl (CLUTTER_TILE_COMPARE_IMPL_AUTO);
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+/*
+ * clutter_tile_compare_set_impl:
+ * @impl: The implementation to use
+ *
+ * Overrides the automatically selected implementation. This is meant for
+ * testing and benchmarking, and must not be called while tiles are being
+ * compared.
+ *
+ * Returns: %FALSE if @impl is not supported on this machine.
+ */
+gboolean
+clutter_tile_compare_set_impl (ClutterTileCompareImpl impl)
+{
+  if (!is_impl_supported (impl))
+    return FALSE;
+
+  ensure_impl ();
+  activate_impl (impl);
+  return TRUE;
+}
+
+const char *
+clutter_tile_compare_get_impl_name (void)
+{
+  ensure_impl ();
+
+  switch (active_impl)
+    {
+    case CLUTTER_TILE_COMPARE_IMPL_AUTO:
+      break;
+    case CLUTTER_TILE_COMPARE_IMPL_SCALAR:
+      return "scalar";
+    case CLUTTER_TILE_COMPARE_IMPL_SSE2:
+      return "sse2";
+    case CLUTTER_TILE_COMPARE_IMPL_AVX2:
+      return "avx2";
+    case CLUTTER_TILE_COMPARE_IMPL_NEON:
+      return "neon";
+    }
+
+  g_assert_not_reached ();
+}
+
+/*
+ * clutter_tile_compare_find_dirty:
+ * @current_data: The current framebuffer contents
+ * @prev_data: The previous framebuffer contents
+ * @stride: The stride of both buffers
+ * @bpp: The number of bytes per pixel of both buffers
+ * @tiles: A row of non-empty tiles, all with the same y and height
+ * @n_tiles: The number of tiles
+ * @dirty: (out caller-allocates): Array of @n_tiles entries, set to %TRUE
+ *   for each tile where the contents of the two buffers differ
+ */
+void
+clutter_tile_compare_find_dirty (const uint8_t      *current_data,
+                                 const uint8_t      *prev_data,
+                                 int                 stride,
+                                 int                 bpp,
+                                 const MtkRectangle *tiles,
+                                 int                 n_tiles,
+                                 gboolean           *dirty)
+{
+  int n_clean;
+  int y;
+
+  if (n_tiles == 0)
+    return;
+
+  ensure_impl ();
+
+  memset (dirty, 0, n_tiles * sizeof (gboolean));
+
+  n_clean = n_tiles;
+  for (y = tiles[0].y; y < tiles[0].y + tiles[0].height && n_clean > 0; y++)
+    {
+      size_t row_offset = (size_t) y * stride;
+
+      n_clean -= compare_scanline (current_data + row_offset,
+                                   prev_data + row_offset,
+                                   tiles, n_tiles,
+                                   bpp,
+                                   dirty);
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdint.h>
+
+#include "clutter/clutter-macros.h"
+#include "mtk/mtk.h"
+
+typedef enum _ClutterTileCompareImpl
+{
+  CLUTTER_TILE_COMPARE_IMPL_AUTO,
+  CLUTTER_TILE_COMPARE_IMPL_SCALAR,
+  CLUTTER_TILE_COMPARE_IMPL_SSE2,
+  CLUTTER_TILE_COMPARE_IMPL_AVX2,
+  CLUTTER_TILE_COMPARE_IMPL_NEON,
+} ClutterTileCompareImpl;
+
+CLUTTER_EXPORT
+gboolean clutter_tile_compare_set_impl (ClutterTileCompareImpl impl);
+
+CLUTTER_EXPORT
+const char * clutter_tile_compare_get_impl_name (void);
+
+CLUTTER_EXPORT
+void clutter_tile_compare_find_dirty (const uint8_t      *current_data,
+                                      const uint8_t      *prev_data,
+                                      int                 stride,
+                                      int                 bpp,
+                                      const MtkRectangle *tiles,
+                                      int                 n_tiles,
+                                      gboolean           *dirty);
@@ -32,6 +32,7 @@
 
 #include "cogl/cogl-private.h"
 #include "cogl/cogl-bitmap-private.h"
+#include "cogl/cogl-bitmap-simd-private.h"
 #include "cogl/cogl-context-private.h"
 #include "cogl/cogl-texture-private.h"
 
@@ -92,152 +93,11 @@ _cogl_unpremult_alpha_first (uint8_t *dst)
   dst[3] = (dst[3] * 255) / alpha;
 }
 
-/* No division form of floor((c*a + 128)/255) (I first encountered
- * this in the RENDER implementation in the X server.) Being exact
- * is important for a == 255 - we want to get exactly c.
- */
-#define MULT(d,a,t)                             \
-  G_STMT_START {                                \
-    t = d * a + 128;                            \
-    d = ((t >> 8) + t) >> 8;                    \
-  } G_STMT_END
-
-inline static void
-_cogl_premult_alpha_last (uint8_t *dst)
-{
-  uint8_t alpha = dst[3];
-  /* Using a separate temporary per component has given slightly better
-   * code generation with GCC in the past; it shouldn't do any worse in
-   * any case.
-   */
-  unsigned int t1, t2, t3;
-  MULT(dst[0], alpha, t1);
-  MULT(dst[1], alpha, t2);
-  MULT(dst[2], alpha, t3);
-}
-
-inline static void
-_cogl_premult_alpha_first (uint8_t *dst)
-{
-  uint8_t alpha = dst[0];
-  unsigned int t1, t2, t3;
-
-  MULT(dst[1], alpha, t1);
-  MULT(dst[2], alpha, t2);
-  MULT(dst[3], alpha, t3);
-}
-
-#undef MULT
-
-/* Use the SSE optimized version to premult four pixels at once when
-   it is available. The same assembler code works for x86 and x86-64
-   because it doesn't refer to any non-SSE registers directly */
-#if defined(__SSE2__) && defined(__GNUC__) \
-  && (defined(__x86_64) || defined(__i386))
-#define COGL_USE_PREMULT_SSE2
-#endif
-
-#ifdef COGL_USE_PREMULT_SSE2
-
-inline static void
-_cogl_premult_alpha_last_four_pixels_sse2 (uint8_t *p)
-{
-  /* 8 copies of 128 used below */
-  static const int16_t eight_halves[8] __attribute__ ((aligned (16))) =
-    { 128, 128, 128, 128, 128, 128, 128, 128 };
-  /* Mask of the rgb components of the four pixels */
-  static const int8_t just_rgb[16] __attribute__ ((aligned (16))) =
-    { 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00,
-      0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00 };
-  /* Each SSE register only holds two pixels because we need to work
-     with 16-bit intermediate values. We still do four pixels by
-     interleaving two registers in the hope that it will pipeline
-     better */
-  asm (/* Load eight_halves into xmm5 for later */
-       "movdqa (%1), %%xmm5\n"
-       /* Clear xmm3 */
-       "pxor %%xmm3, %%xmm3\n"
-       /* Load two pixels from p into the low half of xmm0 */
-       "movlps (%0), %%xmm0\n"
-       /* Load the next set of two pixels from p into the low half of xmm1 */
-       "movlps 8(%0), %%xmm1\n"
-       /* Unpack 8 bytes from the low quad-words in each register to 8
-          16-bit values */
-       "punpcklbw %%xmm3, %%xmm0\n"
-       "punpcklbw %%xmm3, %%xmm1\n"
-       /* Copy alpha values of the first pixel in xmm0 to all
-          components of the first pixel in xmm2 */
-       "pshuflw $255, %%xmm0, %%xmm2\n"
-       /* same for xmm1 and xmm3 */
-       "pshuflw $255, %%xmm1, %%xmm3\n"
-       /* The above also copies the second pixel directly so we now
-          want to replace the RGB components with copies of the alpha
-          components */
-       "pshufhw $255, %%xmm2, %%xmm2\n"
-       "pshufhw $255, %%xmm3, %%xmm3\n"
-       /* Multiply the rgb components by the alpha */
-       "pmullw %%xmm2, %%xmm0\n"
-       "pmullw %%xmm3, %%xmm1\n"
-       /* Add 128 to each component */
-       "paddw %%xmm5, %%xmm0\n"
-       "paddw %%xmm5, %%xmm1\n"
-       /* Copy the results to temporary registers xmm4 and xmm5 */
-       "movdqa %%xmm0, %%xmm4\n"
-       "movdqa %%xmm1, %%xmm5\n"
-       /* Divide the results by 256 */
-       "psrlw $8, %%xmm0\n"
-       "psrlw $8, %%xmm1\n"
-       /* Add the temporaries back in */
-       "paddw %%xmm4, %%xmm0\n"
-       "paddw %%xmm5, %%xmm1\n"
-       /* Divide again */
-       "psrlw $8, %%xmm0\n"
-       "psrlw $8, %%xmm1\n"
-       /* Pack the results back as bytes */
-       "packuswb %%xmm1, %%xmm0\n"
-       /* Load just_rgb into xmm3 for later */
-       "movdqa (%2), %%xmm3\n"
-       /* Reload all four pixels into xmm2 */
-       "movups (%0), %%xmm2\n"
-       /* Mask out the alpha from the results */
-       "andps %%xmm3, %%xmm0\n"
-       /* Mask out the RGB from the original four pixels */
-       "andnps %%xmm2, %%xmm3\n"
-       /* Combine the two to get the right alpha values */
-       "orps %%xmm3, %%xmm0\n"
-       /* Write to memory */
-       "movdqu %%xmm0, (%0)\n"
-       : /* no outputs */
-       : "r" (p), "r" (eight_halves), "r" (just_rgb)
-       : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5");
-}
-
-#endif /* COGL_USE_PREMULT_SSE2 */
-
 static void
 _cogl_bitmap_premult_unpacked_span_8 (uint8_t *data,
                                       int width)
 {
-#ifdef COGL_USE_PREMULT_SSE2
-
-  /* Process 4 pixels at a time */
-  while (width >= 4)
-    {
-      _cogl_premult_alpha_last_four_pixels_sse2 (data);
-      data += 4 * 4;
-      width -= 4;
-    }
-
-  /* If there are any pixels left we will fall through and
-     handle them below */
-
-#endif /* COGL_USE_PREMULT_SSE2 */
-
-  while (width-- > 0)
-    {
-      _cogl_premult_alpha_last (data);
-      data += 4;
-    }
+  _cogl_bitmap_premult_span_8888 (data, width, 3);
 }
 
 static void
@@ -272,6 +132,7 @@ _cogl_bitmap_unpremult_unpacked_span_16 (uint16_t *data,
           data[1] = (data[1] * 65535) / alpha;
           data[2] = (data[2] * 65535) / alpha;
         }
+      data += 4;
     }
 }
 
@@ -286,6 +147,7 @@ _cogl_bitmap_premult_unpacked_span_16 (uint16_t *data,
       data[0] = (data[0] * alpha) / 65535;
       data[1] = (data[1] * alpha) / 65535;
       data[2] = (data[2] * alpha) / 65535;
+      data += 4;
     }
 }
 
@@ -396,6 +258,7 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
   CoglPixelFormat dst_format;
   gboolean use_16;
   gboolean need_premult;
+  CoglBitmapFastConversion fast_conversion;
 
   src_format = cogl_bitmap_get_format (src_bmp);
   src_rowstride = cogl_bitmap_get_rowstride (src_bmp);
@@ -455,6 +318,24 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
       return FALSE;
     }
 
+  /* Common conversions between 32-bit formats are done directly */
+  if (_cogl_bitmap_fast_conversion_init (&fast_conversion,
+                                         src_format, dst_format))
+    {
+      for (y = 0; y < height; y++)
+        {
+          _cogl_bitmap_fast_conversion_run (&fast_conversion,
+                                            src_data + y * src_rowstride,
+                                            dst_data + y * dst_rowstride,
+                                            width);
+        }
+
+      _cogl_bitmap_unmap (src_bmp);
+      _cogl_bitmap_unmap (dst_bmp);
+
+      return TRUE;
+    }
+
   use_16 = _cogl_bitmap_needs_short_temp_buffer (dst_format);
 
   /* Allocate a buffer to hold a temporary RGBA row */
@@ -692,7 +573,7 @@ _cogl_bitmap_premult (CoglBitmap *bmp,
 {
   uint8_t *p, *data;
   uint16_t *tmp_row;
-  int x,y;
+  int y;
   CoglPixelFormat format;
   int width, height;
   int rowstride;
@@ -728,16 +609,8 @@ _cogl_bitmap_premult (CoglBitmap *bmp,
         }
       else
         {
-          if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  _cogl_premult_alpha_first (p);
-                  p += 4;
-                }
-            }
-          else
-            _cogl_bitmap_premult_unpacked_span_8 (p, width);
+          _cogl_bitmap_premult_span_8888 (p, width,
+                                          (format & COGL_AFIRST_BIT) ? 0 : 3);
         }
     }
 
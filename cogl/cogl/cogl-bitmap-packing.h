@@ -646,7 +646,7 @@ G_PASTE (_cogl_pack_bgrx_8888_, component_size) (const component_type *src,
       dst[2] = PACK_BYTE (src[0]);
       dst[1] = PACK_BYTE (src[1]);
       dst[0] = PACK_BYTE (src[2]);
-      dst[3] = PACK_BYTE (255);
+      dst[3] = 0xff;
       src += 4;
       dst += 4;
     }
@@ -678,7 +678,7 @@ G_PASTE (_cogl_pack_xrgb_8888_, component_size) (const component_type *src,
       dst[1] = PACK_BYTE (src[0]);
       dst[2] = PACK_BYTE (src[1]);
       dst[3] = PACK_BYTE (src[2]);
-      dst[0] = PACK_BYTE (255);
+      dst[0] = 0xff;
       src += 4;
       dst += 4;
     }
@@ -710,7 +710,7 @@ G_PASTE (_cogl_pack_xbgr_8888_, component_size) (const component_type *src,
       dst[3] = PACK_BYTE (src[0]);
       dst[2] = PACK_BYTE (src[1]);
       dst[1] = PACK_BYTE (src[2]);
-      dst[0] = PACK_BYTE (255);
+      dst[0] = 0xff;
       src += 4;
       dst += 4;
     }
@@ -742,7 +742,7 @@ G_PASTE (_cogl_pack_rgbx_8888_, component_size) (const component_type *src,
       dst[0] = PACK_BYTE (src[0]);
       dst[1] = PACK_BYTE (src[1]);
       dst[2] = PACK_BYTE (src[2]);
-      dst[3] = PACK_BYTE (255);
+      dst[3] = 0xff;
       src += 4;
       dst += 4;
     }
@@ -111,11 +111,11 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
                                   CoglBitmap *dst_bmp,
                                   GError **error);
 
-gboolean
+COGL_EXPORT_TEST gboolean
 _cogl_bitmap_unpremult (CoglBitmap *dst_bmp,
                         GError **error);
 
-gboolean
+COGL_EXPORT_TEST gboolean
 _cogl_bitmap_premult (CoglBitmap *dst_bmp,
                       GError **error);
 
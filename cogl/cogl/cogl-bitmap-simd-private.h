@@ -0,0 +1,111 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdint.h>
+
+#include "cogl/cogl-macros.h"
+#include "cogl/cogl-pixel-format.h"
+
+G_BEGIN_DECLS
+
+typedef enum _CoglBitmapSimdImpl
+{
+  COGL_BITMAP_SIMD_IMPL_AUTO,
+  COGL_BITMAP_SIMD_IMPL_SCALAR,
+  COGL_BITMAP_SIMD_IMPL_SSE41,
+  COGL_BITMAP_SIMD_IMPL_AVX2,
+  COGL_BITMAP_SIMD_IMPL_NEON,
+} CoglBitmapSimdImpl;
+
+typedef enum _CoglBitmapFastConversionType
+{
+  COGL_BITMAP_FAST_CONVERSION_SWIZZLE_8888,
+  COGL_BITMAP_FAST_CONVERSION_PACK_2101010,
+  COGL_BITMAP_FAST_CONVERSION_UNPACK_2101010,
+  COGL_BITMAP_FAST_CONVERSION_PACK_FP16,
+  COGL_BITMAP_FAST_CONVERSION_UNPACK_FP16,
+} CoglBitmapFastConversionType;
+
+/*
+ * CoglBitmapFastConversion describes a conversion between two pixel
+ * formats that can be done directly, without going through the
+ * generic unpack, premultiply and pack steps of the bitmap conversion
+ * code. It is set up once per bitmap with
+ * _cogl_bitmap_fast_conversion_init() and then run on each row.
+ *
+ * One side of the conversion is always a 32-bit format with 8-bit
+ * components, described by the byte offset of each of the red, green,
+ * blue and alpha components. The other side is described by the bit
+ * shift of each component for 10-bit formats, or by the index of each
+ * component for half float formats.
+ */
+typedef struct _CoglBitmapFastConversion
+{
+  CoglBitmapFastConversionType type;
+
+  int src_offsets[4];
+  gboolean src_has_alpha;
+  int dst_offsets[4];
+  gboolean dst_has_alpha;
+
+  /* Source component of each destination component, for all but the
+   * 10-bit conversions */
+  uint8_t shuffle[4];
+  /* Only used for SWIZZLE_8888 */
+  gboolean premult;
+} CoglBitmapFastConversion;
+
+COGL_EXPORT_TEST gboolean
+_cogl_bitmap_simd_set_impl (CoglBitmapSimdImpl impl);
+
+COGL_EXPORT_TEST const char *
+_cogl_bitmap_simd_get_impl_name (void);
+
+COGL_EXPORT_TEST gboolean
+_cogl_bitmap_fast_conversion_init (CoglBitmapFastConversion *conversion,
+                                   CoglPixelFormat           src_format,
+                                   CoglPixelFormat           dst_format);
+
+COGL_EXPORT_TEST void
+_cogl_bitmap_fast_conversion_run (const CoglBitmapFastConversion *conversion,
+                                  const uint8_t                  *src,
+                                  uint8_t                        *dst,
+                                  int                             width);
+
+/*
+ * Premultiplies a span of 32-bit pixels with 8-bit components in
+ * place. @alpha_offset is the byte offset of the alpha component
+ * within each pixel, either 0 or 3.
+ */
+COGL_EXPORT_TEST void
+_cogl_bitmap_premult_span_8888 (uint8_t *data,
+                                int      width,
+                                int      alpha_offset);
+
+G_END_DECLS
@@ -0,0 +1,1486 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Direct conversions between the most common pixel formats.
+ *
+ * The generic bitmap conversion code unpacks every row into a
+ * temporary RGBA row, premultiplies it and packs it again, one pixel
+ * and one component at a time. For conversions from and to 32-bit
+ * formats with 8-bit components, the whole conversion is instead done
+ * in a single pass by a kernel selected at runtime depending on what
+ * the CPU supports. All kernels give exactly the same results as the
+ * generic code, except for the half float formats, which the generic
+ * code can't convert at all.
+ */
+
+#include "cogl-config.h"
+
+#include "cogl/cogl-bitmap-simd-private.h"
+
+#include <string.h>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define HAVE_BITMAP_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined (__aarch64__) && defined (__ARM_NEON)
+#define HAVE_BITMAP_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* Marks a byte of a shuffle that is not taken from the source, but
+ * set to 0xff, as the alpha of formats without alpha is.
+ */
+#define SHUFFLE_OPAQUE 0x80
+
+typedef void (* ConvertSpanFunc) (const CoglBitmapFastConversion *conversion,
+                                  const uint8_t                  *src,
+                                  uint8_t                        *dst,
+                                  int                             width);
+
+typedef void (* PremultSpanFunc) (uint8_t *data,
+                                  int      width,
+                                  int      alpha_offset);
+
+typedef struct _CoglBitmapSimdFuncs
+{
+  ConvertSpanFunc swizzle_8888;
+  PremultSpanFunc premult_8888;
+  ConvertSpanFunc pack_2101010;
+  ConvertSpanFunc unpack_2101010;
+  ConvertSpanFunc pack_fp16;
+  ConvertSpanFunc unpack_fp16;
+} CoglBitmapSimdFuncs;
+
+/* Exact integer forms of the conversions done by the generic code in
+ * cogl-bitmap-packing.h, going through 16-bit components for 10-bit
+ * formats.
+ */
+#define PACK_8_TO_10(b) (((b) * 1027 + 129) >> 8)
+#define PACK_8_TO_2(b) (((b) * 3 + 129) >> 8)
+#define UNPACK_10_TO_8(b) (((b) * 1021 + 2041) >> 12)
+#define UNPACK_2_TO_8(b) ((b) * 85)
+
+/* Scalar implementation */
+
+static void
+swizzle_8888_scalar (const CoglBitmapFastConversion *conversion,
+                     const uint8_t                  *src,
+                     uint8_t                        *dst,
+                     int                             width)
+{
+  const uint8_t *shuffle = conversion->shuffle;
+  int i, k;
+
+  for (i = 0; i < width; i++)
+    {
+      for (k = 0; k < 4; k++)
+        {
+          dst[k] = (shuffle[k] & SHUFFLE_OPAQUE) ? 0xff : src[shuffle[k]];
+        }
+
+      src += 4;
+      dst += 4;
+    }
+}
+
+/* No division form of floor((c*a + 128)/255), matching
+ * cogl-bitmap-conversion.c
+ */
+static inline uint8_t
+premult_component (unsigned int c,
+                   unsigned int a)
+{
+  unsigned int t = c * a + 128;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static void
+premult_8888_scalar (uint8_t *data,
+                     int      width,
+                     int      alpha_offset)
+{
+  int i, k;
+
+  for (i = 0; i < width; i++)
+    {
+      uint8_t alpha = data[alpha_offset];
+
+      for (k = 0; k < 4; k++)
+        {
+          if (k != alpha_offset)
+            data[k] = premult_component (data[k], alpha);
+        }
+
+      data += 4;
+    }
+}
+
+static void
+pack_2101010_scalar (const CoglBitmapFastConversion *conversion,
+                     const uint8_t                  *src,
+                     uint8_t                        *dst,
+                     int                             width)
+{
+  const int *src_offsets = conversion->src_offsets;
+  const int *dst_shifts = conversion->dst_offsets;
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  int i, k;
+
+  for (i = 0; i < width; i++)
+    {
+      uint32_t v = 0;
+      unsigned int alpha;
+
+      for (k = 0; k < 3; k++)
+        v |= (uint32_t) PACK_8_TO_10 (src[src_offsets[k]]) << dst_shifts[k];
+
+      alpha = copy_alpha ? src[src_offsets[3]] : 255;
+      v |= (uint32_t) PACK_8_TO_2 (alpha) << dst_shifts[3];
+
+      *(uint32_t *) dst = v;
+
+      src += 4;
+      dst += 4;
+    }
+}
+
+static void
+unpack_2101010_scalar (const CoglBitmapFastConversion *conversion,
+                       const uint8_t                  *src,
+                       uint8_t                        *dst,
+                       int                             width)
+{
+  const int *src_shifts = conversion->src_offsets;
+  const int *dst_offsets = conversion->dst_offsets;
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  int i, k;
+
+  for (i = 0; i < width; i++)
+    {
+      uint32_t v = *(const uint32_t *) src;
+
+      for (k = 0; k < 3; k++)
+        dst[dst_offsets[k]] = UNPACK_10_TO_8 ((v >> src_shifts[k]) & 0x3ff);
+
+      /* Padding is set to 0xff, like the generic packers do */
+      if (copy_alpha)
+        dst[dst_offsets[3]] = UNPACK_2_TO_8 ((v >> src_shifts[3]) & 0x3);
+      else
+        dst[dst_offsets[3]] = 0xff;
+
+      src += 4;
+      dst += 4;
+    }
+}
+
+/* Only handles the values in [0, 1] produced from 8-bit components,
+ * rounding to the nearest even like the hardware conversions do.
+ */
+static inline uint16_t
+float_to_half (float f)
+{
+  union { float f; uint32_t u; } v = { .f = f };
+  uint32_t mantissa;
+  uint16_t half;
+  int exponent;
+
+  if (v.u == 0)
+    return 0;
+
+  exponent = (int) ((v.u >> 23) & 0xff) - 127 + 15;
+  mantissa = v.u & 0x7fffff;
+
+  half = (exponent << 10) | (mantissa >> 13);
+  if ((mantissa & 0x1000) && ((mantissa & 0xfff) || (half & 1)))
+    half++;
+
+  return half;
+}
+
+static inline float
+half_to_float (uint16_t half)
+{
+  union { float f; uint32_t u; } v;
+  uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+
+  if (exponent == 0x1f)
+    {
+      v.u = sign | 0x7f800000 | (mantissa << 13);
+    }
+  else if (exponent == 0)
+    {
+      /* Zero or subnormal */
+      v.f = mantissa * (1.0f / (1 << 24));
+      v.u |= sign;
+    }
+  else
+    {
+      v.u = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+  return v.f;
+}
+
+static inline uint8_t
+float_to_byte (float f)
+{
+  /* Written so that NaN turns into 0 */
+  if (!(f > 0.0f))
+    return 0;
+  else if (f >= 1.0f)
+    return 0xff;
+  else
+    return (uint8_t) (f * 255.0f + 0.5f);
+}
+
+static void
+pack_fp16_scalar (const CoglBitmapFastConversion *conversion,
+                  const uint8_t                  *src,
+                  uint8_t                        *dst,
+                  int                             width)
+{
+  const uint8_t *shuffle = conversion->shuffle;
+  uint16_t *dst_components = (uint16_t *) dst;
+  int i, k;
+
+  for (i = 0; i < width; i++)
+    {
+      for (k = 0; k < 4; k++)
+        {
+          uint8_t b;
+
+          b = (shuffle[k] & SHUFFLE_OPAQUE) ? 0xff : src[shuffle[k]];
+          dst_components[k] = float_to_half (b * (1.0f / 255.0f));
+        }
+
+      src += 4;
+      dst_components += 4;
+    }
+}
+
+static void
+unpack_fp16_scalar (const CoglBitmapFastConversion *conversion,
+                    const uint8_t                  *src,
+                    uint8_t                        *dst,
+                    int                             width)
+{
+  const uint8_t *shuffle = conversion->shuffle;
+  const uint16_t *src_components = (const uint16_t *) src;
+  int i, k;
+
+  for (i = 0; i < width; i++)
+    {
+      for (k = 0; k < 4; k++)
+        {
+          if (shuffle[k] & SHUFFLE_OPAQUE)
+            dst[k] = 0xff;
+          else
+            dst[k] = float_to_byte (half_to_float (src_components[shuffle[k]]));
+        }
+
+      src_components += 4;
+      dst += 4;
+    }
+}
+
+static const CoglBitmapSimdFuncs scalar_funcs = {
+  .swizzle_8888 = swizzle_8888_scalar,
+  .premult_8888 = premult_8888_scalar,
+  .pack_2101010 = pack_2101010_scalar,
+  .unpack_2101010 = unpack_2101010_scalar,
+  .pack_fp16 = pack_fp16_scalar,
+  .unpack_fp16 = unpack_fp16_scalar,
+};
+
+/* Shared helpers for the vector implementations */
+
+#if defined (HAVE_BITMAP_SIMD_X86) || defined (HAVE_BITMAP_SIMD_NEON)
+
+/* Expands a per pixel shuffle to a 16 byte one covering four pixels,
+ * and the mask of bytes to be set to 0xff.
+ */
+static void
+expand_shuffle (const uint8_t shuffle[4],
+                uint8_t       indices[16],
+                uint8_t       opaque_mask[16])
+{
+  int i, k;
+
+  for (i = 0; i < 4; i++)
+    {
+      for (k = 0; k < 4; k++)
+        {
+          if (shuffle[k] & SHUFFLE_OPAQUE)
+            {
+              indices[i * 4 + k] = SHUFFLE_OPAQUE;
+              opaque_mask[i * 4 + k] = 0xff;
+            }
+          else
+            {
+              indices[i * 4 + k] = i * 4 + shuffle[k];
+              opaque_mask[i * 4 + k] = 0;
+            }
+        }
+    }
+}
+
+/* A shuffle broadcasting the alpha of each of four pixels to all of its
+ * components, and the mask of the alpha bytes.
+ */
+static void
+get_alpha_shuffle (int     alpha_offset,
+                   uint8_t indices[16],
+                   uint8_t alpha_mask[16])
+{
+  int i;
+
+  for (i = 0; i < 16; i++)
+    {
+      indices[i] = (i & ~3) + alpha_offset;
+      alpha_mask[i] = (i & 3) == alpha_offset ? 0xff : 0;
+    }
+}
+
+#endif
+
+#ifdef HAVE_BITMAP_SIMD_X86
+
+/* SSE4.1 implementation */
+
+__attribute__ ((target ("sse4.1")))
+static void
+swizzle_8888_sse41 (const CoglBitmapFastConversion *conversion,
+                    const uint8_t                  *src,
+                    uint8_t                        *dst,
+                    int                             width)
+{
+  uint8_t indices[16], opaque_mask[16];
+  __m128i shuffle, opaque;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = _mm_loadu_si128 ((const __m128i *) indices);
+  opaque = _mm_loadu_si128 ((const __m128i *) opaque_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) src);
+
+      v = _mm_or_si128 (_mm_shuffle_epi8 (v, shuffle), opaque);
+      _mm_storeu_si128 ((__m128i *) dst, v);
+
+      src += 16;
+      dst += 16;
+    }
+
+  swizzle_8888_scalar (conversion, src, dst, width);
+}
+
+__attribute__ ((target ("sse4.1")))
+static inline __m128i
+premult_components_sse41 (__m128i components,
+                          __m128i alpha)
+{
+  const __m128i half = _mm_set1_epi16 (128);
+  __m128i t;
+
+  t = _mm_add_epi16 (_mm_mullo_epi16 (components, alpha), half);
+
+  return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+__attribute__ ((target ("sse4.1")))
+static void
+premult_8888_sse41 (uint8_t *data,
+                    int      width,
+                    int      alpha_offset)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  uint8_t indices[16], alpha_mask[16];
+  __m128i alpha_shuffle, keep_alpha;
+
+  get_alpha_shuffle (alpha_offset, indices, alpha_mask);
+  alpha_shuffle = _mm_loadu_si128 ((const __m128i *) indices);
+  keep_alpha = _mm_loadu_si128 ((const __m128i *) alpha_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) data);
+      __m128i alpha = _mm_shuffle_epi8 (v, alpha_shuffle);
+      __m128i lo, hi;
+
+      lo = premult_components_sse41 (_mm_unpacklo_epi8 (v, zero),
+                                     _mm_unpacklo_epi8 (alpha, zero));
+      hi = premult_components_sse41 (_mm_unpackhi_epi8 (v, zero),
+                                     _mm_unpackhi_epi8 (alpha, zero));
+
+      v = _mm_blendv_epi8 (_mm_packus_epi16 (lo, hi), v, keep_alpha);
+      _mm_storeu_si128 ((__m128i *) data, v);
+
+      data += 16;
+    }
+
+  premult_8888_scalar (data, width, alpha_offset);
+}
+
+__attribute__ ((target ("sse4.1")))
+static void
+pack_2101010_sse41 (const CoglBitmapFastConversion *conversion,
+                    const uint8_t                  *src,
+                    uint8_t                        *dst,
+                    int                             width)
+{
+  const __m128i byte_mask = _mm_set1_epi32 (0xff);
+  const __m128i mul_10 = _mm_set1_epi32 (1027);
+  const __m128i mul_2 = _mm_set1_epi32 (3);
+  const __m128i bias = _mm_set1_epi32 (129);
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  __m128i alpha_bits = _mm_setzero_si128 ();
+  int k;
+
+  if (!copy_alpha)
+    alpha_bits = _mm_set1_epi32 ((int32_t) (3u << conversion->dst_offsets[3]));
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i out = alpha_bits;
+
+      for (k = 0; k < 4; k++)
+        {
+          __m128i c;
+
+          if (k == 3 && !copy_alpha)
+            break;
+
+          c = _mm_and_si128 (_mm_srl_epi32 (v, _mm_cvtsi32_si128 (conversion->src_offsets[k] * 8)),
+                             byte_mask);
+          c = _mm_mullo_epi32 (c, k == 3 ? mul_2 : mul_10);
+          c = _mm_srli_epi32 (_mm_add_epi32 (c, bias), 8);
+          out = _mm_or_si128 (out,
+                              _mm_sll_epi32 (c, _mm_cvtsi32_si128 (conversion->dst_offsets[k])));
+        }
+
+      _mm_storeu_si128 ((__m128i *) dst, out);
+
+      src += 16;
+      dst += 16;
+    }
+
+  pack_2101010_scalar (conversion, src, dst, width);
+}
+
+__attribute__ ((target ("sse4.1")))
+static void
+unpack_2101010_sse41 (const CoglBitmapFastConversion *conversion,
+                      const uint8_t                  *src,
+                      uint8_t                        *dst,
+                      int                             width)
+{
+  const __m128i mask_10 = _mm_set1_epi32 (0x3ff);
+  const __m128i mask_2 = _mm_set1_epi32 (0x3);
+  const __m128i mul_10 = _mm_set1_epi32 (1021);
+  const __m128i mul_2 = _mm_set1_epi32 (85);
+  const __m128i bias = _mm_set1_epi32 (2041);
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  __m128i alpha_bits = _mm_setzero_si128 ();
+  int k;
+
+  if (!copy_alpha)
+    alpha_bits = _mm_set1_epi32 ((int32_t) (0xffu << (conversion->dst_offsets[3] * 8)));
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i out = alpha_bits;
+
+      for (k = 0; k < 4; k++)
+        {
+          __m128i c;
+
+          if (k == 3 && !copy_alpha)
+            break;
+
+          c = _mm_srl_epi32 (v, _mm_cvtsi32_si128 (conversion->src_offsets[k]));
+          if (k == 3)
+            {
+              c = _mm_mullo_epi32 (_mm_and_si128 (c, mask_2), mul_2);
+            }
+          else
+            {
+              c = _mm_mullo_epi32 (_mm_and_si128 (c, mask_10), mul_10);
+              c = _mm_srli_epi32 (_mm_add_epi32 (c, bias), 12);
+            }
+
+          out = _mm_or_si128 (out,
+                              _mm_sll_epi32 (c, _mm_cvtsi32_si128 (conversion->dst_offsets[k] * 8)));
+        }
+
+      _mm_storeu_si128 ((__m128i *) dst, out);
+
+      src += 16;
+      dst += 16;
+    }
+
+  unpack_2101010_scalar (conversion, src, dst, width);
+}
+
+/* SSE4.1 has no half float conversion instructions */
+static const CoglBitmapSimdFuncs sse41_funcs = {
+  .swizzle_8888 = swizzle_8888_sse41,
+  .premult_8888 = premult_8888_sse41,
+  .pack_2101010 = pack_2101010_sse41,
+  .unpack_2101010 = unpack_2101010_sse41,
+  .pack_fp16 = pack_fp16_scalar,
+  .unpack_fp16 = unpack_fp16_scalar,
+};
+
+/* AVX2 implementation. Every CPU with AVX2 also supports F16C. */
+
+__attribute__ ((target ("avx2")))
+static void
+swizzle_8888_avx2 (const CoglBitmapFastConversion *conversion,
+                   const uint8_t                  *src,
+                   uint8_t                        *dst,
+                   int                             width)
+{
+  uint8_t indices[16], opaque_mask[16];
+  __m256i shuffle, opaque;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) indices));
+  opaque = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) opaque_mask));
+
+  for (; width >= 8; width -= 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) src);
+
+      v = _mm256_or_si256 (_mm256_shuffle_epi8 (v, shuffle), opaque);
+      _mm256_storeu_si256 ((__m256i *) dst, v);
+
+      src += 32;
+      dst += 32;
+    }
+
+  swizzle_8888_sse41 (conversion, src, dst, width);
+}
+
+__attribute__ ((target ("avx2")))
+static inline __m256i
+premult_components_avx2 (__m256i components,
+                         __m256i alpha)
+{
+  const __m256i half = _mm256_set1_epi16 (128);
+  __m256i t;
+
+  t = _mm256_add_epi16 (_mm256_mullo_epi16 (components, alpha), half);
+
+  return _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+premult_8888_avx2 (uint8_t *data,
+                   int      width,
+                   int      alpha_offset)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  uint8_t indices[16], alpha_mask[16];
+  __m256i alpha_shuffle, keep_alpha;
+
+  get_alpha_shuffle (alpha_offset, indices, alpha_mask);
+  alpha_shuffle = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) indices));
+  keep_alpha = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) alpha_mask));
+
+  for (; width >= 8; width -= 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) data);
+      __m256i alpha = _mm256_shuffle_epi8 (v, alpha_shuffle);
+      __m256i lo, hi;
+
+      /* Unpacking and packing both work within 128 bit lanes, so the
+       * pixels end up where they started.
+       */
+      lo = premult_components_avx2 (_mm256_unpacklo_epi8 (v, zero),
+                                    _mm256_unpacklo_epi8 (alpha, zero));
+      hi = premult_components_avx2 (_mm256_unpackhi_epi8 (v, zero),
+                                    _mm256_unpackhi_epi8 (alpha, zero));
+
+      v = _mm256_blendv_epi8 (_mm256_packus_epi16 (lo, hi), v, keep_alpha);
+      _mm256_storeu_si256 ((__m256i *) data, v);
+
+      data += 32;
+    }
+
+  premult_8888_sse41 (data, width, alpha_offset);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+pack_2101010_avx2 (const CoglBitmapFastConversion *conversion,
+                   const uint8_t                  *src,
+                   uint8_t                        *dst,
+                   int                             width)
+{
+  const __m256i byte_mask = _mm256_set1_epi32 (0xff);
+  const __m256i mul_10 = _mm256_set1_epi32 (1027);
+  const __m256i mul_2 = _mm256_set1_epi32 (3);
+  const __m256i bias = _mm256_set1_epi32 (129);
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  __m256i alpha_bits = _mm256_setzero_si256 ();
+  int k;
+
+  if (!copy_alpha)
+    alpha_bits = _mm256_set1_epi32 ((int32_t) (3u << conversion->dst_offsets[3]));
+
+  for (; width >= 8; width -= 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) src);
+      __m256i out = alpha_bits;
+
+      for (k = 0; k < 4; k++)
+        {
+          __m256i c;
+
+          if (k == 3 && !copy_alpha)
+            break;
+
+          c = _mm256_and_si256 (_mm256_srl_epi32 (v, _mm_cvtsi32_si128 (conversion->src_offsets[k] * 8)),
+                                byte_mask);
+          c = _mm256_mullo_epi32 (c, k == 3 ? mul_2 : mul_10);
+          c = _mm256_srli_epi32 (_mm256_add_epi32 (c, bias), 8);
+          out = _mm256_or_si256 (out,
+                                 _mm256_sll_epi32 (c, _mm_cvtsi32_si128 (conversion->dst_offsets[k])));
+        }
+
+      _mm256_storeu_si256 ((__m256i *) dst, out);
+
+      src += 32;
+      dst += 32;
+    }
+
+  pack_2101010_sse41 (conversion, src, dst, width);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+unpack_2101010_avx2 (const CoglBitmapFastConversion *conversion,
+                     const uint8_t                  *src,
+                     uint8_t                        *dst,
+                     int                             width)
+{
+  const __m256i mask_10 = _mm256_set1_epi32 (0x3ff);
+  const __m256i mask_2 = _mm256_set1_epi32 (0x3);
+  const __m256i mul_10 = _mm256_set1_epi32 (1021);
+  const __m256i mul_2 = _mm256_set1_epi32 (85);
+  const __m256i bias = _mm256_set1_epi32 (2041);
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  __m256i alpha_bits = _mm256_setzero_si256 ();
+  int k;
+
+  if (!copy_alpha)
+    alpha_bits = _mm256_set1_epi32 ((int32_t) (0xffu << (conversion->dst_offsets[3] * 8)));
+
+  for (; width >= 8; width -= 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) src);
+      __m256i out = alpha_bits;
+
+      for (k = 0; k < 4; k++)
+        {
+          __m256i c;
+
+          if (k == 3 && !copy_alpha)
+            break;
+
+          c = _mm256_srl_epi32 (v, _mm_cvtsi32_si128 (conversion->src_offsets[k]));
+          if (k == 3)
+            {
+              c = _mm256_mullo_epi32 (_mm256_and_si256 (c, mask_2), mul_2);
+            }
+          else
+            {
+              c = _mm256_mullo_epi32 (_mm256_and_si256 (c, mask_10), mul_10);
+              c = _mm256_srli_epi32 (_mm256_add_epi32 (c, bias), 12);
+            }
+
+          out = _mm256_or_si256 (out,
+                                 _mm256_sll_epi32 (c, _mm_cvtsi32_si128 (conversion->dst_offsets[k] * 8)));
+        }
+
+      _mm256_storeu_si256 ((__m256i *) dst, out);
+
+      src += 32;
+      dst += 32;
+    }
+
+  unpack_2101010_sse41 (conversion, src, dst, width);
+}
+
+__attribute__ ((target ("avx2,f16c")))
+static void
+pack_fp16_avx2 (const CoglBitmapFastConversion *conversion,
+                const uint8_t                  *src,
+                uint8_t                        *dst,
+                int                             width)
+{
+  const __m256 scale = _mm256_set1_ps (1.0f / 255.0f);
+  uint8_t indices[16], opaque_mask[16];
+  __m128i shuffle, opaque;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = _mm_loadu_si128 ((const __m128i *) indices);
+  opaque = _mm_loadu_si128 ((const __m128i *) opaque_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) src);
+      __m256 lo, hi;
+
+      /* Put the components in destination order first */
+      v = _mm_or_si128 (_mm_shuffle_epi8 (v, shuffle), opaque);
+
+      lo = _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (v)),
+                          scale);
+      hi = _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (_mm_srli_si128 (v, 8))),
+                          scale);
+
+      _mm_storeu_si128 ((__m128i *) dst,
+                        _mm256_cvtps_ph (lo, _MM_FROUND_TO_NEAREST_INT));
+      _mm_storeu_si128 ((__m128i *) (dst + 16),
+                        _mm256_cvtps_ph (hi, _MM_FROUND_TO_NEAREST_INT));
+
+      src += 16;
+      dst += 32;
+    }
+
+  pack_fp16_scalar (conversion, src, dst, width);
+}
+
+__attribute__ ((target ("avx2,f16c")))
+static void
+unpack_fp16_avx2 (const CoglBitmapFastConversion *conversion,
+                  const uint8_t                  *src,
+                  uint8_t                        *dst,
+                  int                             width)
+{
+  const __m256 zero = _mm256_setzero_ps ();
+  const __m256 one = _mm256_set1_ps (1.0f);
+  const __m256 scale = _mm256_set1_ps (255.0f);
+  const __m256 half = _mm256_set1_ps (0.5f);
+  uint8_t indices[16], opaque_mask[16];
+  __m128i shuffle, opaque;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = _mm_loadu_si128 ((const __m128i *) indices);
+  opaque = _mm_loadu_si128 ((const __m128i *) opaque_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      __m256 lo, hi;
+      __m256i lo_i, hi_i;
+      __m128i words, v;
+
+      lo = _mm256_cvtph_ps (_mm_loadu_si128 ((const __m128i *) src));
+      hi = _mm256_cvtph_ps (_mm_loadu_si128 ((const __m128i *) (src + 16)));
+
+      /* With a NaN as the first operand, max returns the second one */
+      lo = _mm256_min_ps (_mm256_max_ps (lo, zero), one);
+      hi = _mm256_min_ps (_mm256_max_ps (hi, zero), one);
+
+      lo_i = _mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (lo, scale), half));
+      hi_i = _mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (hi, scale), half));
+
+      /* Packing works within 128 bit lanes, so fix up the order after */
+      words = _mm_packus_epi32 (_mm256_castsi256_si128 (lo_i),
+                                _mm256_extracti128_si256 (lo_i, 1));
+      v = _mm_packus_epi32 (_mm256_castsi256_si128 (hi_i),
+                            _mm256_extracti128_si256 (hi_i, 1));
+      v = _mm_packus_epi16 (words, v);
+
+      v = _mm_or_si128 (_mm_shuffle_epi8 (v, shuffle), opaque);
+      _mm_storeu_si128 ((__m128i *) dst, v);
+
+      src += 32;
+      dst += 16;
+    }
+
+  unpack_fp16_scalar (conversion, src, dst, width);
+}
+
+static const CoglBitmapSimdFuncs avx2_funcs = {
+  .swizzle_8888 = swizzle_8888_avx2,
+  .premult_8888 = premult_8888_avx2,
+  .pack_2101010 = pack_2101010_avx2,
+  .unpack_2101010 = unpack_2101010_avx2,
+  .pack_fp16 = pack_fp16_avx2,
+  .unpack_fp16 = unpack_fp16_avx2,
+};
+
+#endif /* HAVE_BITMAP_SIMD_X86 */
+
+#ifdef HAVE_BITMAP_SIMD_NEON
+
+static void
+swizzle_8888_neon (const CoglBitmapFastConversion *conversion,
+                   const uint8_t                  *src,
+                   uint8_t                        *dst,
+                   int                             width)
+{
+  uint8_t indices[16], opaque_mask[16];
+  uint8x16_t shuffle, opaque;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = vld1q_u8 (indices);
+  opaque = vld1q_u8 (opaque_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      /* Out of range indices give 0 */
+      vst1q_u8 (dst, vorrq_u8 (vqtbl1q_u8 (vld1q_u8 (src), shuffle), opaque));
+
+      src += 16;
+      dst += 16;
+    }
+
+  swizzle_8888_scalar (conversion, src, dst, width);
+}
+
+static void
+premult_8888_neon (uint8_t *data,
+                   int      width,
+                   int      alpha_offset)
+{
+  const uint16x8_t half = vdupq_n_u16 (128);
+  uint8_t indices[16], alpha_mask[16];
+  uint8x16_t alpha_shuffle, keep_alpha;
+
+  get_alpha_shuffle (alpha_offset, indices, alpha_mask);
+  alpha_shuffle = vld1q_u8 (indices);
+  keep_alpha = vld1q_u8 (alpha_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      uint8x16_t v = vld1q_u8 (data);
+      uint8x16_t alpha = vqtbl1q_u8 (v, alpha_shuffle);
+      uint16x8_t lo, hi;
+      uint8x16_t result;
+
+      lo = vmlal_u8 (half, vget_low_u8 (v), vget_low_u8 (alpha));
+      hi = vmlal_high_u8 (half, v, alpha);
+
+      /* ((t >> 8) + t) >> 8, narrowed */
+      result = vcombine_u8 (vaddhn_u16 (lo, vshrq_n_u16 (lo, 8)),
+                            vaddhn_u16 (hi, vshrq_n_u16 (hi, 8)));
+
+      vst1q_u8 (data, vbslq_u8 (keep_alpha, v, result));
+
+      data += 16;
+    }
+
+  premult_8888_scalar (data, width, alpha_offset);
+}
+
+static void
+pack_2101010_neon (const CoglBitmapFastConversion *conversion,
+                   const uint8_t                  *src,
+                   uint8_t                        *dst,
+                   int                             width)
+{
+  const uint32x4_t byte_mask = vdupq_n_u32 (0xff);
+  const uint32x4_t bias = vdupq_n_u32 (129);
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  uint32x4_t alpha_bits = vdupq_n_u32 (0);
+  int k;
+
+  if (!copy_alpha)
+    alpha_bits = vdupq_n_u32 (3u << conversion->dst_offsets[3]);
+
+  for (; width >= 4; width -= 4)
+    {
+      uint32x4_t v = vld1q_u32 ((const uint32_t *) src);
+      uint32x4_t out = alpha_bits;
+
+      for (k = 0; k < 4; k++)
+        {
+          uint32x4_t c;
+
+          if (k == 3 && !copy_alpha)
+            break;
+
+          c = vshlq_u32 (v, vdupq_n_s32 (-conversion->src_offsets[k] * 8));
+          c = vmlaq_n_u32 (bias, vandq_u32 (c, byte_mask),
+                           k == 3 ? 3 : 1027);
+          c = vshrq_n_u32 (c, 8);
+          out = vorrq_u32 (out,
+                           vshlq_u32 (c, vdupq_n_s32 (conversion->dst_offsets[k])));
+        }
+
+      vst1q_u32 ((uint32_t *) dst, out);
+
+      src += 16;
+      dst += 16;
+    }
+
+  pack_2101010_scalar (conversion, src, dst, width);
+}
+
+static void
+unpack_2101010_neon (const CoglBitmapFastConversion *conversion,
+                     const uint8_t                  *src,
+                     uint8_t                        *dst,
+                     int                             width)
+{
+  const uint32x4_t mask_10 = vdupq_n_u32 (0x3ff);
+  const uint32x4_t mask_2 = vdupq_n_u32 (0x3);
+  const uint32x4_t bias = vdupq_n_u32 (2041);
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  uint32x4_t alpha_bits = vdupq_n_u32 (0);
+  int k;
+
+  if (!copy_alpha)
+    alpha_bits = vdupq_n_u32 (0xffu << (conversion->dst_offsets[3] * 8));
+
+  for (; width >= 4; width -= 4)
+    {
+      uint32x4_t v = vld1q_u32 ((const uint32_t *) src);
+      uint32x4_t out = alpha_bits;
+
+      for (k = 0; k < 4; k++)
+        {
+          uint32x4_t c;
+
+          if (k == 3 && !copy_alpha)
+            break;
+
+          c = vshlq_u32 (v, vdupq_n_s32 (-conversion->src_offsets[k]));
+          if (k == 3)
+            {
+              c = vmulq_n_u32 (vandq_u32 (c, mask_2), 85);
+            }
+          else
+            {
+              c = vmlaq_n_u32 (bias, vandq_u32 (c, mask_10), 1021);
+              c = vshrq_n_u32 (c, 12);
+            }
+
+          out = vorrq_u32 (out,
+                           vshlq_u32 (c, vdupq_n_s32 (conversion->dst_offsets[k] * 8)));
+        }
+
+      vst1q_u32 ((uint32_t *) dst, out);
+
+      src += 16;
+      dst += 16;
+    }
+
+  unpack_2101010_scalar (conversion, src, dst, width);
+}
+
+static void
+pack_fp16_neon (const CoglBitmapFastConversion *conversion,
+                const uint8_t                  *src,
+                uint8_t                        *dst,
+                int                             width)
+{
+  const float32x4_t scale = vdupq_n_f32 (1.0f / 255.0f);
+  uint8_t indices[16], opaque_mask[16];
+  uint8x16_t shuffle, opaque;
+  uint16_t *dst_components = (uint16_t *) dst;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = vld1q_u8 (indices);
+  opaque = vld1q_u8 (opaque_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      uint8x16_t v;
+      uint16x8_t words[2];
+      int i;
+
+      /* Put the components in destination order first */
+      v = vorrq_u8 (vqtbl1q_u8 (vld1q_u8 (src), shuffle), opaque);
+      words[0] = vmovl_u8 (vget_low_u8 (v));
+      words[1] = vmovl_high_u8 (v);
+
+      for (i = 0; i < 2; i++)
+        {
+          float32x4_t lo, hi;
+
+          lo = vmulq_f32 (vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (words[i]))),
+                          scale);
+          hi = vmulq_f32 (vcvtq_f32_u32 (vmovl_high_u16 (words[i])),
+                          scale);
+
+          vst1q_u16 (dst_components + i * 8,
+                     vreinterpretq_u16_f16 (vcvt_high_f16_f32 (vcvt_f16_f32 (lo),
+                                                               hi)));
+        }
+
+      src += 16;
+      dst_components += 16;
+    }
+
+  pack_fp16_scalar (conversion, src, (uint8_t *) dst_components, width);
+}
+
+static void
+unpack_fp16_neon (const CoglBitmapFastConversion *conversion,
+                  const uint8_t                  *src,
+                  uint8_t                        *dst,
+                  int                             width)
+{
+  const float32x4_t zero = vdupq_n_f32 (0.0f);
+  const float32x4_t one = vdupq_n_f32 (1.0f);
+  const float32x4_t scale = vdupq_n_f32 (255.0f);
+  const float32x4_t half = vdupq_n_f32 (0.5f);
+  const uint16_t *src_components = (const uint16_t *) src;
+  uint8_t indices[16], opaque_mask[16];
+  uint8x16_t shuffle, opaque;
+
+  expand_shuffle (conversion->shuffle, indices, opaque_mask);
+  shuffle = vld1q_u8 (indices);
+  opaque = vld1q_u8 (opaque_mask);
+
+  for (; width >= 4; width -= 4)
+    {
+      uint16x8_t words[2];
+      uint8x16_t v;
+      int i;
+
+      for (i = 0; i < 2; i++)
+        {
+          float16x8_t h = vreinterpretq_f16_u16 (vld1q_u16 (src_components + i * 8));
+          float32x4_t lo, hi;
+
+          /* maxnm returns the number when one operand is NaN */
+          lo = vminq_f32 (vmaxnmq_f32 (vcvt_f32_f16 (vget_low_f16 (h)), zero), one);
+          hi = vminq_f32 (vmaxnmq_f32 (vcvt_high_f32_f16 (h), zero), one);
+
+          lo = vaddq_f32 (vmulq_f32 (lo, scale), half);
+          hi = vaddq_f32 (vmulq_f32 (hi, scale), half);
+
+          words[i] = vcombine_u16 (vmovn_u32 (vcvtq_u32_f32 (lo)),
+                                   vmovn_u32 (vcvtq_u32_f32 (hi)));
+        }
+
+      v = vcombine_u8 (vmovn_u16 (words[0]), vmovn_u16 (words[1]));
+      vst1q_u8 (dst, vorrq_u8 (vqtbl1q_u8 (v, shuffle), opaque));
+
+      src_components += 16;
+      dst += 16;
+    }
+
+  unpack_fp16_scalar (conversion, (const uint8_t *) src_components, dst,
+                      width);
+}
+
+static const CoglBitmapSimdFuncs neon_funcs = {
+  .swizzle_8888 = swizzle_8888_neon,
+  .premult_8888 = premult_8888_neon,
+  .pack_2101010 = pack_2101010_neon,
+  .unpack_2101010 = unpack_2101010_neon,
+  .pack_fp16 = pack_fp16_neon,
+  .unpack_fp16 = unpack_fp16_neon,
+};
+
+#endif /* HAVE_BITMAP_SIMD_NEON */
+
+static CoglBitmapSimdImpl active_impl;
+static const CoglBitmapSimdFuncs *active_funcs;
+
+static gboolean
+is_impl_supported (CoglBitmapSimdImpl impl)
+{
+  switch (impl)
+    {
+    case COGL_BITMAP_SIMD_IMPL_AUTO:
+    case COGL_BITMAP_SIMD_IMPL_SCALAR:
+      return TRUE;
+    case COGL_BITMAP_SIMD_IMPL_SSE41:
+#ifdef HAVE_BITMAP_SIMD_X86
+      return __builtin_cpu_supports ("sse4.1");
+#else
+      return FALSE;
+#endif
+    case COGL_BITMAP_SIMD_IMPL_AVX2:
+#ifdef HAVE_BITMAP_SIMD_X86
+      return __builtin_cpu_supports ("avx2");
+#else
+      return FALSE;
+#endif
+    case COGL_BITMAP_SIMD_IMPL_NEON:
+#ifdef HAVE_BITMAP_SIMD_NEON
+      return TRUE;
+#else
+      return FALSE;
+#endif
+    }
+
+  g_assert_not_reached ();
+}
+
+static CoglBitmapSimdImpl
+choose_best_impl (void)
+{
+  if (is_impl_supported (COGL_BITMAP_SIMD_IMPL_AVX2))
+    return COGL_BITMAP_SIMD_IMPL_AVX2;
+  else if (is_impl_supported (COGL_BITMAP_SIMD_IMPL_SSE41))
+    return COGL_BITMAP_SIMD_IMPL_SSE41;
+  else if (is_impl_supported (COGL_BITMAP_SIMD_IMPL_NEON))
+    return COGL_BITMAP_SIMD_IMPL_NEON;
+  else
+    return COGL_BITMAP_SIMD_IMPL_SCALAR;
+}
+
+static void
+activate_impl (CoglBitmapSimdImpl impl)
+{
+  if (impl == COGL_BITMAP_SIMD_IMPL_AUTO)
+    impl = choose_best_impl ();
+
+  switch (impl)
+    {
+    case COGL_BITMAP_SIMD_IMPL_AUTO:
+      g_assert_not_reached ();
+      break;
+    case COGL_BITMAP_SIMD_IMPL_SCALAR:
+      active_funcs = &scalar_funcs;
+      break;
+    case COGL_BITMAP_SIMD_IMPL_SSE41:
+#ifdef HAVE_BITMAP_SIMD_X86
+      active_funcs = &sse41_funcs;
+#endif
+      break;
+    case COGL_BITMAP_SIMD_IMPL_AVX2:
+#ifdef HAVE_BITMAP_SIMD_X86
+      active_funcs = &avx2_funcs;
+#endif
+      break;
+    case COGL_BITMAP_SIMD_IMPL_NEON:
+#ifdef HAVE_BITMAP_SIMD_NEON
+      active_funcs = &neon_funcs;
+#endif
+      break;
+    }
+
+  active_impl = impl;
+}
+
+static const CoglBitmapSimdFuncs *
+ensure_funcs (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      if (!active_funcs)
+        activate_impl (COGL_BITMAP_SIMD_IMPL_AUTO);
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return active_funcs;
+}
+
+/*
+ * _cogl_bitmap_simd_set_impl:
+ * @impl: The implementation to use
+ *
+ * Overrides the automatically selected implementation. This is meant
+ * for testing and benchmarking, and must not be called while bitmaps
+ * are being converted.
+ *
+ * Returns: %FALSE if @impl is not supported on this CPU
+ */
+gboolean
+_cogl_bitmap_simd_set_impl (CoglBitmapSimdImpl impl)
+{
+  if (!is_impl_supported (impl))
+    return FALSE;
+
+  ensure_funcs ();
+  activate_impl (impl);
+
+  return TRUE;
+}
+
+const char *
+_cogl_bitmap_simd_get_impl_name (void)
+{
+  ensure_funcs ();
+
+  switch (active_impl)
+    {
+    case COGL_BITMAP_SIMD_IMPL_AUTO:
+      break;
+    case COGL_BITMAP_SIMD_IMPL_SCALAR:
+      return "scalar";
+    case COGL_BITMAP_SIMD_IMPL_SSE41:
+      return "sse4.1";
+    case COGL_BITMAP_SIMD_IMPL_AVX2:
+      return "avx2";
+    case COGL_BITMAP_SIMD_IMPL_NEON:
+      return "neon";
+    }
+
+  g_assert_not_reached ();
+}
+
+typedef enum _FormatClass
+{
+  FORMAT_CLASS_OTHER,
+  FORMAT_CLASS_8888,
+  FORMAT_CLASS_2101010,
+  FORMAT_CLASS_FP16,
+} FormatClass;
+
+static FormatClass
+get_format_class (CoglPixelFormat format)
+{
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGBX_8888:
+    case COGL_PIXEL_FORMAT_RGBA_8888:
+    case COGL_PIXEL_FORMAT_BGRX_8888:
+    case COGL_PIXEL_FORMAT_BGRA_8888:
+    case COGL_PIXEL_FORMAT_XRGB_8888:
+    case COGL_PIXEL_FORMAT_ARGB_8888:
+    case COGL_PIXEL_FORMAT_XBGR_8888:
+    case COGL_PIXEL_FORMAT_ABGR_8888:
+      return FORMAT_CLASS_8888;
+
+    case COGL_PIXEL_FORMAT_RGBA_1010102:
+    case COGL_PIXEL_FORMAT_BGRA_1010102:
+    case COGL_PIXEL_FORMAT_XRGB_2101010:
+    case COGL_PIXEL_FORMAT_ARGB_2101010:
+    case COGL_PIXEL_FORMAT_XBGR_2101010:
+    case COGL_PIXEL_FORMAT_ABGR_2101010:
+      return FORMAT_CLASS_2101010;
+
+    case COGL_PIXEL_FORMAT_RGBX_FP_16161616:
+    case COGL_PIXEL_FORMAT_RGBA_FP_16161616:
+    case COGL_PIXEL_FORMAT_BGRX_FP_16161616:
+    case COGL_PIXEL_FORMAT_BGRA_FP_16161616:
+    case COGL_PIXEL_FORMAT_XRGB_FP_16161616:
+    case COGL_PIXEL_FORMAT_ARGB_FP_16161616:
+    case COGL_PIXEL_FORMAT_XBGR_FP_16161616:
+    case COGL_PIXEL_FORMAT_ABGR_FP_16161616:
+      return FORMAT_CLASS_FP16;
+
+    default:
+      return FORMAT_CLASS_OTHER;
+    }
+}
+
+/* Gets the position of the red, green, blue and alpha (or padding)
+ * components, counted in components from the start of the pixel for
+ * 8888 and half float formats.
+ */
+static void
+get_component_positions (CoglPixelFormat format,
+                         int             positions[4])
+{
+  int first = (format & COGL_AFIRST_BIT) ? 1 : 0;
+  gboolean bgr = (format & COGL_BGR_BIT) != 0;
+
+  positions[0] = first + (bgr ? 2 : 0);
+  positions[1] = first + 1;
+  positions[2] = first + (bgr ? 0 : 2);
+  positions[3] = first ? 0 : 3;
+}
+
+/* For 10-bit formats the position is the shift of the component within
+ * the 32-bit pixel.
+ */
+static void
+get_component_shifts (CoglPixelFormat format,
+                      int             shifts[4])
+{
+  static const int alpha_last_shifts[] = { 22, 12, 2, 0 };
+  static const int alpha_first_shifts[] = { 30, 20, 10, 0 };
+  const int *msb_shifts;
+  int positions[4];
+  int k;
+
+  msb_shifts = (format & COGL_AFIRST_BIT) ? alpha_first_shifts
+                                          : alpha_last_shifts;
+
+  get_component_positions (format, positions);
+  for (k = 0; k < 4; k++)
+    shifts[k] = msb_shifts[positions[k]];
+}
+
+static void
+init_shuffle (CoglBitmapFastConversion *conversion)
+{
+  gboolean copy_alpha = conversion->src_has_alpha && conversion->dst_has_alpha;
+  int k;
+
+  for (k = 0; k < 4; k++)
+    {
+      int dst_position = conversion->dst_offsets[k];
+
+      if (k == 3 && !copy_alpha)
+        conversion->shuffle[dst_position] = SHUFFLE_OPAQUE;
+      else
+        conversion->shuffle[dst_position] = conversion->src_offsets[k];
+    }
+}
+
+/*
+ * _cogl_bitmap_fast_conversion_init:
+ * @conversion: The conversion to initialize
+ * @src_format: The source format
+ * @dst_format: The destination format
+ *
+ * Checks whether a conversion from @src_format to @dst_format can be
+ * done with one of the direct conversion kernels, and sets up
+ * @conversion for it.
+ *
+ * Returns: %TRUE if there is a direct conversion
+ */
+gboolean
+_cogl_bitmap_fast_conversion_init (CoglBitmapFastConversion *conversion,
+                                   CoglPixelFormat           src_format,
+                                   CoglPixelFormat           dst_format)
+{
+  FormatClass src_class = get_format_class (src_format);
+  FormatClass dst_class = get_format_class (dst_format);
+  gboolean need_premult;
+
+  memset (conversion, 0, sizeof (*conversion));
+
+  conversion->src_has_alpha = (src_format & COGL_A_BIT) != 0;
+  conversion->dst_has_alpha = (dst_format & COGL_A_BIT) != 0;
+
+  need_premult =
+    ((src_format & COGL_PREMULT_BIT) != (dst_format & COGL_PREMULT_BIT) &&
+     conversion->src_has_alpha && conversion->dst_has_alpha);
+
+  /* Premultiplication is only done for 8-bit formats on both sides, as
+   * the generic code does it with 16-bit components otherwise. Going
+   * the other way needs a division, which there is no point in doing
+   * in vectors.
+   */
+  if (need_premult &&
+      (src_class != FORMAT_CLASS_8888 ||
+       dst_class != FORMAT_CLASS_8888 ||
+       !(dst_format & COGL_PREMULT_BIT)))
+    return FALSE;
+
+  if (src_class == FORMAT_CLASS_8888)
+    get_component_positions (src_format, conversion->src_offsets);
+  else if (src_class == FORMAT_CLASS_2101010 && dst_class == FORMAT_CLASS_8888)
+    get_component_shifts (src_format, conversion->src_offsets);
+  else if (src_class == FORMAT_CLASS_FP16 && dst_class == FORMAT_CLASS_8888)
+    get_component_positions (src_format, conversion->src_offsets);
+  else
+    return FALSE;
+
+  switch (dst_class)
+    {
+    case FORMAT_CLASS_OTHER:
+      return FALSE;
+
+    case FORMAT_CLASS_8888:
+      get_component_positions (dst_format, conversion->dst_offsets);
+
+      if (src_class == FORMAT_CLASS_8888)
+        {
+          conversion->type = COGL_BITMAP_FAST_CONVERSION_SWIZZLE_8888;
+          conversion->premult = need_premult;
+          init_shuffle (conversion);
+        }
+      else if (src_class == FORMAT_CLASS_2101010)
+        {
+          conversion->type = COGL_BITMAP_FAST_CONVERSION_UNPACK_2101010;
+        }
+      else
+        {
+          conversion->type = COGL_BITMAP_FAST_CONVERSION_UNPACK_FP16;
+          init_shuffle (conversion);
+        }
+      return TRUE;
+
+    case FORMAT_CLASS_2101010:
+      conversion->type = COGL_BITMAP_FAST_CONVERSION_PACK_2101010;
+      get_component_shifts (dst_format, conversion->dst_offsets);
+      return TRUE;
+
+    case FORMAT_CLASS_FP16:
+      conversion->type = COGL_BITMAP_FAST_CONVERSION_PACK_FP16;
+      get_component_positions (dst_format, conversion->dst_offsets);
+      init_shuffle (conversion);
+      return TRUE;
+    }
+
+  g_assert_not_reached ();
+}
+
+void
+_cogl_bitmap_fast_conversion_run (const CoglBitmapFastConversion *conversion,
+                                  const uint8_t                  *src,
+                                  uint8_t                        *dst,
+                                  int                             width)
+{
+  const CoglBitmapSimdFuncs *funcs = ensure_funcs ();
+
+  switch (conversion->type)
+    {
+    case COGL_BITMAP_FAST_CONVERSION_SWIZZLE_8888:
+      funcs->swizzle_8888 (conversion, src, dst, width);
+      if (conversion->premult)
+        funcs->premult_8888 (dst, width, conversion->dst_offsets[3]);
+      return;
+    case COGL_BITMAP_FAST_CONVERSION_PACK_2101010:
+      funcs->pack_2101010 (conversion, src, dst, width);
+      return;
+    case COGL_BITMAP_FAST_CONVERSION_UNPACK_2101010:
+      funcs->unpack_2101010 (conversion, src, dst, width);
+      return;
+    case COGL_BITMAP_FAST_CONVERSION_PACK_FP16:
+      funcs->pack_fp16 (conversion, src, dst, width);
+      return;
+    case COGL_BITMAP_FAST_CONVERSION_UNPACK_FP16:
+      funcs->unpack_fp16 (conversion, src, dst, width);
+      return;
+    }
+
+  g_assert_not_reached ();
+}
+
+void
+_cogl_bitmap_premult_span_8888 (uint8_t *data,
+                                int      width,
+                                int      alpha_offset)
+{
+  ensure_funcs ()->premult_8888 (data, width, alpha_offset);
+}
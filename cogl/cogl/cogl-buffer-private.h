@@ -47,7 +47,10 @@ typedef enum _CoglBufferFlags
   COGL_BUFFER_FLAG_NONE            = 0,
   COGL_BUFFER_FLAG_BUFFER_OBJECT   = 1UL << 0,  /* real openGL buffer object */
   COGL_BUFFER_FLAG_MAPPED          = 1UL << 1,
-  COGL_BUFFER_FLAG_MAPPED_FALLBACK = 1UL << 2
+  COGL_BUFFER_FLAG_MAPPED_FALLBACK = 1UL << 2,
+  /* mapped for the whole lifetime of the buffer, see
+   * _cogl_buffer_map_persistent() */
+  COGL_BUFFER_FLAG_MAPPED_PERSISTENT = 1UL << 3
 } CoglBufferFlags;
 
 typedef enum
@@ -142,6 +145,16 @@ void *
 _cogl_buffer_map_range_for_fill_or_fallback (CoglBuffer *buffer,
                                              size_t offset,
                                              size_t size);
+/* Allocates immutable storage for the buffer and maps all of it for
+   writing, for as long as the buffer exists. The buffer can still be
+   used for drawing while mapped, so the caller is responsible for not
+   writing to parts of it the GPU may still be reading from. This
+   requires COGL_PRIVATE_FEATURE_BUFFER_STORAGE, and the buffer must
+   not have been used before. */
+void *
+_cogl_buffer_map_persistent (CoglBuffer *buffer,
+                             GError **error);
+
 COGL_EXPORT void *
 _cogl_buffer_map_for_fill_or_fallback (CoglBuffer *buffer);
 
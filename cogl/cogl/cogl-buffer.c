@@ -298,7 +298,9 @@ cogl_buffer_map_range (CoglBuffer *buffer,
                        GError **error)
 {
   g_return_val_if_fail (COGL_IS_BUFFER (buffer), NULL);
-  g_return_val_if_fail (!(buffer->flags & COGL_BUFFER_FLAG_MAPPED), NULL);
+  g_return_val_if_fail (!(buffer->flags & (COGL_BUFFER_FLAG_MAPPED |
+                                           COGL_BUFFER_FLAG_MAPPED_PERSISTENT)),
+                        NULL);
 
   if (G_UNLIKELY (buffer->immutable_ref))
     warn_about_midscene_changes ();
@@ -324,6 +326,28 @@ cogl_buffer_unmap (CoglBuffer *buffer)
   buffer->unmap (buffer);
 }
 
+void *
+_cogl_buffer_map_persistent (CoglBuffer *buffer,
+                             GError **error)
+{
+  const CoglDriverVtable *driver_vtable = buffer->context->driver_vtable;
+
+  g_return_val_if_fail (COGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (!(buffer->flags & COGL_BUFFER_FLAG_MAPPED), NULL);
+
+  if (!(buffer->flags & COGL_BUFFER_FLAG_BUFFER_OBJECT) ||
+      !driver_vtable->buffer_map_persistent)
+    {
+      g_set_error_literal (error,
+                           COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED,
+                           "Persistently mapped buffers are not supported");
+      return NULL;
+    }
+
+  return driver_vtable->buffer_map_persistent (buffer, error);
+}
+
 void *
 _cogl_buffer_map_for_fill_or_fallback (CoglBuffer *buffer)
 {
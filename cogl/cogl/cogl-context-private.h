@@ -51,6 +51,7 @@
 #include "cogl/cogl-onscreen-private.h"
 #include "cogl/cogl-fence-private.h"
 #include "cogl/cogl-poll-private.h"
+#include "cogl/cogl-stream-buffer-private.h"
 #include "cogl/cogl-private.h"
 #include "cogl/winsys/cogl-winsys-private.h"
 
@@ -143,6 +144,9 @@ struct _CoglContext
   /* Global journal buffers */
   GArray           *journal_flush_attributes_array;
   GArray           *journal_clip_bounds;
+  /* Ring buffer journal vertices are streamed through, if persistently
+   * mapped buffers are supported */
+  CoglStreamBuffer *journal_stream_buffer;
 
   /* Some simple caching, to minimize state changes... */
   CoglPipeline     *current_pipeline;
@@ -73,6 +73,8 @@ cogl_context_dispose (GObject *object)
   const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
   const CoglDriverVtable *driver = _cogl_context_get_driver (context);
 
+  g_clear_pointer (&context->journal_stream_buffer, _cogl_stream_buffer_free);
+
   winsys->context_deinit (context);
 
   if (context->default_gl_texture_2d_tex)
@@ -166,7 +168,10 @@ static void
 _cogl_init_feature_overrides (CoglContext *ctx)
 {
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_PBOS)))
-    COGL_FLAGS_SET (ctx->private_features, COGL_PRIVATE_FEATURE_PBOS, FALSE);
+    {
+      COGL_FLAGS_SET (ctx->private_features, COGL_PRIVATE_FEATURE_PBOS, FALSE);
+      COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT, FALSE);
+    }
 }
 
 /* For reference: There was some deliberation over whether to have a
@@ -333,6 +338,7 @@ cogl_context_new (CoglDisplay *display,
   context->journal_flush_attributes_array =
     g_array_new (TRUE, FALSE, sizeof (CoglAttribute *));
   context->journal_clip_bounds = NULL;
+  context->journal_stream_buffer = _cogl_stream_buffer_new (context);
 
   context->current_pipeline = NULL;
   context->current_pipeline_changes_since_flush = 0;
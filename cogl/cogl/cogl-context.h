@@ -171,6 +171,9 @@ cogl_context_get_renderer (CoglContext *context);
  *    expected to return age values other than 0.
  * @COGL_FEATURE_ID_BLIT_FRAMEBUFFER: Whether blitting using
  *    cogl_blit_framebuffer() is supported.
+ * @COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT: Whether #CoglPixelBuffer is backed
+ *    by a GPU buffer object, so that texture uploads from it don't need to
+ *    go through client memory.
  *
  * All the capabilities that can vary between different GPUs supported
  * by Cogl. Applications that depend on any of these features should explicitly
@@ -187,6 +190,7 @@ typedef enum _CoglFeatureID
   COGL_FEATURE_ID_TEXTURE_EGL_IMAGE_EXTERNAL,
   COGL_FEATURE_ID_BLIT_FRAMEBUFFER,
   COGL_FEATURE_ID_TIMESTAMP_QUERY,
+  COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT,
 
   /*< private >*/
   _COGL_N_FEATURE_IDS   /*< skip >*/
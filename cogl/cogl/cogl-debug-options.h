@@ -135,6 +135,12 @@ OPT (DISABLE_SOFTWARE_CLIP,
      "disable-software-clip",
      N_("Disable software clipping"),
      N_("Disables Cogl's attempts to clip some rectangles in software."))
+OPT (DISABLE_JOURNAL_REORDERING,
+     N_("Root Cause"),
+     "disable-journal-reordering",
+     N_("Disable Journal reordering"),
+     N_("Disable reordering of non-overlapping geometry in the Cogl Journal "
+        "to improve batching."))
 OPT (SHOW_SOURCE,
      N_("Cogl Tracing"),
      "show-source",
@@ -155,6 +161,11 @@ OPT (DISABLE_BLENDING,
      "disable-program-caches",
      N_("Disable program caches"),
      N_("Disable fallback caches for glsl programs"))
+OPT (DISABLE_PROGRAM_BINARY_CACHE,
+     N_("Root Cause"),
+     "disable-program-binary-cache",
+     N_("Disable program binary cache"),
+     N_("Disable the on-disk cache of linked glsl program binaries"))
 OPT (DISABLE_FAST_READ_PIXEL,
      N_("Root Cause"),
      "disable-fast-read-pixel",
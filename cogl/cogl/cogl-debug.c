@@ -80,7 +80,9 @@ static const GDebugKey cogl_behavioural_debug_keys[] = {
   { "disable-blending", COGL_DEBUG_DISABLE_BLENDING},
   { "wireframe", COGL_DEBUG_WIREFRAME},
   { "disable-software-clip", COGL_DEBUG_DISABLE_SOFTWARE_CLIP},
+  { "disable-journal-reordering", COGL_DEBUG_DISABLE_JOURNAL_REORDERING},
   { "disable-program-caches", COGL_DEBUG_DISABLE_PROGRAM_CACHES},
+  { "disable-program-binary-cache", COGL_DEBUG_DISABLE_PROGRAM_BINARY_CACHE},
   { "disable-fast-read-pixel", COGL_DEBUG_DISABLE_FAST_READ_PIXEL},
   { "sync-primitive", COGL_DEBUG_SYNC_PRIMITIVE },
   { "sync-frame", COGL_DEBUG_SYNC_FRAME},
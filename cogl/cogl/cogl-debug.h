@@ -74,6 +74,8 @@ typedef enum
   COGL_DEBUG_SYNC_FRAME,
   COGL_DEBUG_TEXTURES,
   COGL_DEBUG_STENCILLING,
+  COGL_DEBUG_DISABLE_PROGRAM_BINARY_CACHE,
+  COGL_DEBUG_DISABLE_JOURNAL_REORDERING,
 
   COGL_DEBUG_N_FLAGS
 } CoglDebugFlags;
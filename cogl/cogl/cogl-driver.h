@@ -218,6 +218,13 @@ struct _CoglDriverVtable
                        unsigned int size,
                        GError **error);
 
+  /* Maps a buffer into the CPU for its whole lifetime, see
+   * _cogl_buffer_map_persistent(). Optional.
+   */
+  void *
+  (* buffer_map_persistent) (CoglBuffer *buffer,
+                             GError **error);
+
   void
   (*sampler_init) (CoglContext *context,
                    CoglSamplerCacheEntry *entry);
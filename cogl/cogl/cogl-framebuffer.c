@@ -46,6 +46,8 @@
 #include "cogl/cogl-pipeline-state-private.h"
 #include "cogl/cogl-primitive-private.h"
 #include "cogl/cogl-offscreen.h"
+#include "cogl/cogl-pixel-buffer.h"
+#include "cogl/cogl-fence.h"
 #include "cogl/cogl1-context.h"
 #include "cogl/cogl-private.h"
 #include "cogl/cogl-primitives-private.h"
@@ -137,6 +139,9 @@ typedef struct _CoglFramebufferPrivate
 
   int samples_per_pixel;
 
+  /* Asynchronous read backs waiting for their fence */
+  GList *pending_read_pixels;
+
   /* Whether the depth buffer was enabled for this framebuffer,
  * usually means it needs to be cleared before being reused next.
  */
@@ -324,6 +329,52 @@ cogl_framebuffer_init_config (CoglFramebuffer             *framebuffer,
   g_object_ref (priv->config.swap_chain);
 }
 
+struct _CoglReadPixelsClosure
+{
+  CoglFramebuffer *framebuffer;
+  CoglPixelBuffer *pixel_buffer;
+  CoglFenceClosure *fence;
+
+  int width;
+  int height;
+  int bpp;
+  /* Whether the first row of the pixel buffer is the bottom one */
+  gboolean bottom_up;
+
+  uint8_t *pixels;
+  int rowstride;
+
+  CoglReadPixelsCallback callback;
+  void *user_data;
+};
+
+static void
+read_pixels_closure_free (CoglReadPixelsClosure *closure)
+{
+  g_object_unref (closure->pixel_buffer);
+  g_free (closure);
+}
+
+static void
+fail_pending_read_pixels (CoglFramebuffer *framebuffer)
+{
+  CoglFramebufferPrivate *priv =
+    cogl_framebuffer_get_instance_private (framebuffer);
+
+  while (priv->pending_read_pixels)
+    {
+      CoglReadPixelsClosure *closure = priv->pending_read_pixels->data;
+
+      priv->pending_read_pixels =
+        g_list_delete_link (priv->pending_read_pixels,
+                            priv->pending_read_pixels);
+
+      cogl_framebuffer_cancel_fence_callback (framebuffer, closure->fence);
+      closure->callback (framebuffer, FALSE, closure->user_data);
+      read_pixels_closure_free (closure);
+    }
+}
+
 static void
 cogl_framebuffer_dispose (GObject *object)
 {
@@ -338,6 +389,7 @@ cogl_framebuffer_dispose (GObject *object)
 
       g_signal_emit (framebuffer, signals[DESTROY], 0);
 
+      fail_pending_read_pixels (framebuffer);
       _cogl_fence_cancel_fences_for_framebuffer (framebuffer);
     }
 
@@ -1562,6 +1614,150 @@ cogl_framebuffer_read_pixels (CoglFramebuffer *framebuffer,
   return ret;
 }
 
+static gboolean
+copy_read_pixels (CoglReadPixelsClosure *closure)
+{
+  int row_size = closure->width * closure->bpp;
+  const uint8_t *data;
+  int y;
+
+  data = cogl_buffer_map (COGL_BUFFER (closure->pixel_buffer),
+                          COGL_BUFFER_ACCESS_READ,
+                          0);
+  if (!data)
+    return FALSE;
+
+  /* The rows were read without flipping them, so that the read back
+   * doesn't need the result on the CPU; flip them while copying instead.
+   */
+  for (y = 0; y < closure->height; y++)
+    {
+      int src_y = closure->bottom_up ? closure->height - y - 1 : y;
+
+      memcpy (closure->pixels + y * closure->rowstride,
+              data + src_y * row_size,
+              row_size);
+    }
+
+  cogl_buffer_unmap (COGL_BUFFER (closure->pixel_buffer));
+
+  return TRUE;
+}
+
+static void
+read_pixels_fence_cb (CoglFence *fence,
+                      void      *user_data)
+{
+  CoglReadPixelsClosure *closure = user_data;
+  CoglFramebuffer *framebuffer = closure->framebuffer;
+  CoglFramebufferPrivate *priv =
+    cogl_framebuffer_get_instance_private (framebuffer);
+  gboolean success;
+
+  priv->pending_read_pixels = g_list_remove (priv->pending_read_pixels,
+                                             closure);
+
+  success = copy_read_pixels (closure);
+  closure->callback (framebuffer, success, closure->user_data);
+  read_pixels_closure_free (closure);
+}
+
+CoglReadPixelsClosure *
+cogl_framebuffer_read_pixels_async (CoglFramebuffer         *framebuffer,
+                                    int                      x,
+                                    int                      y,
+                                    int                      width,
+                                    int                      height,
+                                    CoglPixelFormat          format,
+                                    uint8_t                 *pixels,
+                                    int                      rowstride,
+                                    CoglReadPixelsCallback   callback,
+                                    void                    *user_data,
+                                    GError                 **error)
+{
+  CoglFramebufferPrivate *priv =
+    cogl_framebuffer_get_instance_private (framebuffer);
+  CoglContext *ctx = priv->context;
+  g_autoptr (CoglPixelBuffer) pixel_buffer = NULL;
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  CoglReadPixelsClosure *closure;
+  int bpp;
+
+  g_return_val_if_fail (cogl_pixel_format_get_n_planes (format) == 1, NULL);
+  g_return_val_if_fail (callback != NULL, NULL);
+
+  if (!cogl_has_feature (ctx, COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT) ||
+      !cogl_has_feature (ctx, COGL_FEATURE_ID_FENCE))
+    {
+      g_set_error_literal (error, COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED,
+                           "Asynchronous read back is not supported");
+      return NULL;
+    }
+
+  bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  pixel_buffer = cogl_pixel_buffer_new (ctx, (size_t) width * height * bpp,
+                                        NULL);
+  bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (pixel_buffer),
+                                        format,
+                                        width, height,
+                                        width * bpp,
+                                        0);
+
+  if (!_cogl_framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                  x, y,
+                                                  COGL_READ_PIXELS_COLOR_BUFFER |
+                                                  COGL_READ_PIXELS_NO_FLIP,
+                                                  bitmap,
+                                                  error))
+    return NULL;
+
+  closure = g_new0 (CoglReadPixelsClosure, 1);
+  closure->framebuffer = framebuffer;
+  closure->pixel_buffer = g_steal_pointer (&pixel_buffer);
+  closure->width = width;
+  closure->height = height;
+  closure->bpp = bpp;
+  closure->bottom_up = !cogl_framebuffer_is_y_flipped (framebuffer);
+  closure->pixels = pixels;
+  closure->rowstride = rowstride;
+  closure->callback = callback;
+  closure->user_data = user_data;
+
+  closure->fence = cogl_framebuffer_add_fence_callback (framebuffer,
+                                                        read_pixels_fence_cb,
+                                                        closure);
+  if (!closure->fence)
+    {
+      read_pixels_closure_free (closure);
+      g_set_error_literal (error, COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED,
+                           "Failed to add a fence for the read back");
+      return NULL;
+    }
+
+  priv->pending_read_pixels = g_list_prepend (priv->pending_read_pixels,
+                                              closure);
+
+  return closure;
+}
+
+void
+cogl_framebuffer_cancel_read_pixels (CoglFramebuffer       *framebuffer,
+                                     CoglReadPixelsClosure *closure)
+{
+  CoglFramebufferPrivate *priv =
+    cogl_framebuffer_get_instance_private (framebuffer);
+
+  g_return_if_fail (closure->framebuffer == framebuffer);
+
+  priv->pending_read_pixels = g_list_remove (priv->pending_read_pixels,
+                                             closure);
+
+  cogl_framebuffer_cancel_fence_callback (framebuffer, closure->fence);
+  read_pixels_closure_free (closure);
+}
+
 gboolean
 cogl_framebuffer_is_y_flipped (CoglFramebuffer *framebuffer)
 {
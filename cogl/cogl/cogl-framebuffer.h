@@ -1265,6 +1265,84 @@ cogl_framebuffer_read_pixels (CoglFramebuffer *framebuffer,
                               CoglPixelFormat format,
                               uint8_t *pixels);
 
+/**
+ * CoglReadPixelsClosure:
+ *
+ * An opaque type representing a pending asynchronous read back started
+ * with cogl_framebuffer_read_pixels_async().
+ */
+typedef struct _CoglReadPixelsClosure CoglReadPixelsClosure;
+
+/**
+ * CoglReadPixelsCallback:
+ * @framebuffer: The #CoglFramebuffer the pixels were read from
+ * @success: Whether the pixels were read successfully
+ * @user_data: The private data passed to cogl_framebuffer_read_pixels_async()
+ *
+ * The callback prototype used with cogl_framebuffer_read_pixels_async()
+ * for notification of the read back having completed.
+ */
+typedef void (* CoglReadPixelsCallback) (CoglFramebuffer *framebuffer,
+                                         gboolean success,
+                                         void *user_data);
+
+/**
+ * cogl_framebuffer_read_pixels_async:
+ * @framebuffer: A #CoglFramebuffer
+ * @x: The x position to read from
+ * @y: The y position to read from
+ * @width: The width of the region of rectangles to read
+ * @height: The height of the region of rectangles to read
+ * @format: The pixel format to store the data in
+ * @pixels: The address of the buffer to store the data in
+ * @rowstride: The rowstride of @pixels
+ * @callback: (scope notified): A #CoglReadPixelsCallback to be called
+ *   once @pixels contains the read pixels
+ * @user_data: (closure): Private data that will be passed to the callback
+ * @error: A #GError for exceptions
+ *
+ * Like cogl_framebuffer_read_pixels(), but without waiting for the GPU
+ * to finish rendering. The pixels are read into a #CoglPixelBuffer and
+ * only copied into @pixels once a fence signals that the read back is
+ * done, at which point @callback is called. @pixels must stay valid
+ * until then, or until the read back is cancelled with
+ * cogl_framebuffer_cancel_read_pixels().
+ *
+ * If the framebuffer is destroyed before the read back completes,
+ * @callback is called with @success set to %FALSE.
+ *
+ * This requires both %COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT and
+ * %COGL_FEATURE_ID_FENCE.
+ *
+ * Return value: (transfer none): A #CoglReadPixelsClosure, or %NULL if
+ *   the read back could not be started
+ */
+COGL_EXPORT CoglReadPixelsClosure *
+cogl_framebuffer_read_pixels_async (CoglFramebuffer *framebuffer,
+                                    int x,
+                                    int y,
+                                    int width,
+                                    int height,
+                                    CoglPixelFormat format,
+                                    uint8_t *pixels,
+                                    int rowstride,
+                                    CoglReadPixelsCallback callback,
+                                    void *user_data,
+                                    GError **error);
+
+/**
+ * cogl_framebuffer_cancel_read_pixels:
+ * @framebuffer: The #CoglFramebuffer the pixels are being read from
+ * @closure: The #CoglReadPixelsClosure returned from
+ *   cogl_framebuffer_read_pixels_async()
+ *
+ * Cancels a pending read back; its callback will not be called and its
+ * destination buffer will not be written to.
+ */
+COGL_EXPORT void
+cogl_framebuffer_cancel_read_pixels (CoglFramebuffer *framebuffer,
+                                     CoglReadPixelsClosure *closure);
+
 COGL_EXPORT uint32_t
 cogl_framebuffer_error_quark (void);
 
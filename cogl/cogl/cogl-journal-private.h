@@ -64,6 +64,11 @@ typedef struct _CoglJournal
 
   int fast_read_pixel_count;
 
+  /* Scratch buffers used to reorder the entries when flushing */
+  GArray *reorder_buckets;
+  GArray *reorder_links;
+  GArray *reordered_entries;
+
   CoglList pending_fences;
 
 } CoglJournal;
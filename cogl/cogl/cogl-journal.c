@@ -96,6 +96,10 @@
    to do the clip */
 #define COGL_JOURNAL_HARDWARE_CLIP_THRESHOLD 8
 
+/* How many batches back an entry may be moved when reordering the
+   journal, to bound the cost of finding one it can join */
+#define COGL_JOURNAL_REORDER_MAX_LOOKBACK 16
+
 typedef struct _CoglJournalFlushState
 {
   CoglContext *ctx;
@@ -103,6 +107,9 @@ typedef struct _CoglJournalFlushState
   CoglJournal *journal;
 
   CoglAttributeBuffer *attribute_buffer;
+  /* Start of the persistent mapping of attribute_buffer, if the
+     vertices were streamed */
+  uint8_t *stream_data;
   GArray *attributes;
   int current_attribute;
 
@@ -122,6 +129,25 @@ typedef void (*CoglJournalBatchCallback) (CoglJournalEntry *start,
 typedef gboolean (*CoglJournalBatchTest) (CoglJournalEntry *entry0,
                                           CoglJournalEntry *entry1);
 
+typedef struct _CoglJournalBounds
+{
+  float x_1, y_1;
+  float x_2, y_2;
+} CoglJournalBounds;
+
+/* A run of entries that will end up in the same batch after reordering */
+typedef struct _CoglJournalBucket
+{
+  int first_entry;
+  int last_entry;
+  CoglJournalBounds bounds;
+} CoglJournalBucket;
+
+static void entry_to_screen_polygon (CoglFramebuffer        *framebuffer,
+                                     const CoglJournalEntry *entry,
+                                     float                  *vertices,
+                                     float                  *poly);
+
 G_DEFINE_TYPE (CoglJournal, cogl_journal, G_TYPE_OBJECT);
 
 static void
@@ -134,6 +160,9 @@ cogl_journal_dispose (GObject *object)
     g_array_free (journal->entries, TRUE);
   if (journal->vertices)
     g_array_free (journal->vertices, TRUE);
+  g_clear_pointer (&journal->reorder_buckets, g_array_unref);
+  g_clear_pointer (&journal->reorder_links, g_array_unref);
+  g_clear_pointer (&journal->reordered_entries, g_array_unref);
 
   for (i = 0; i < COGL_JOURNAL_VBO_POOL_SIZE; i++)
     if (journal->vbo_pool[i])
@@ -163,6 +192,11 @@ _cogl_journal_new (CoglFramebuffer *framebuffer)
   journal->framebuffer = framebuffer;
   journal->entries = g_array_new (FALSE, FALSE, sizeof (CoglJournalEntry));
   journal->vertices = g_array_new (FALSE, FALSE, sizeof (float));
+  journal->reorder_buckets = g_array_new (FALSE, FALSE,
+                                          sizeof (CoglJournalBucket));
+  journal->reorder_links = g_array_new (FALSE, FALSE, sizeof (int));
+  journal->reordered_entries = g_array_new (FALSE, FALSE,
+                                            sizeof (CoglJournalEntry));
 
   _cogl_list_init (&journal->pending_fences);
 
@@ -641,19 +675,29 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
     {
       uint8_t *verts;
 
-      /* Mapping a buffer for read is probably a really bad thing to
-         do but this will only happen during debugging so it probably
-         doesn't matter */
-      verts = ((uint8_t *)_cogl_buffer_map (COGL_BUFFER (state->attribute_buffer),
-                                            COGL_BUFFER_ACCESS_READ, 0,
-                                            NULL) +
-               state->array_offset);
-
-      _cogl_journal_dump_quad_batch (verts,
-                                     batch_start->n_layers,
-                                     batch_len);
-
-      cogl_buffer_unmap (COGL_BUFFER (state->attribute_buffer));
+      if (state->stream_data)
+        {
+          _cogl_journal_dump_quad_batch (state->stream_data +
+                                         state->array_offset,
+                                         batch_start->n_layers,
+                                         batch_len);
+        }
+      else
+        {
+          /* Mapping a buffer for read is probably a really bad thing to
+             do but this will only happen during debugging so it probably
+             doesn't matter */
+          verts = ((uint8_t *)_cogl_buffer_map (COGL_BUFFER (state->attribute_buffer),
+                                                COGL_BUFFER_ACCESS_READ, 0,
+                                                NULL) +
+                   state->array_offset);
+
+          _cogl_journal_dump_quad_batch (verts,
+                                         batch_start->n_layers,
+                                         batch_len);
+
+          cogl_buffer_unmap (COGL_BUFFER (state->attribute_buffer));
+        }
     }
 
   batch_and_call (batch_start,
@@ -1126,6 +1170,185 @@ compare_entry_viewports (CoglJournalEntry *entry0, CoglJournalEntry *entry1)
   return memcmp (entry0->viewport, entry1->viewport, sizeof (float) * 4) == 0;
 }
 
+static gboolean
+compare_entries_for_reordering (CoglJournalEntry *entry0,
+                                CoglJournalEntry *entry1)
+{
+  if (!compare_entry_viewports (entry0, entry1) ||
+      !compare_entry_dither_states (entry0, entry1) ||
+      !compare_entry_clip_stacks (entry0, entry1) ||
+      !compare_entry_strides (entry0, entry1) ||
+      !compare_entry_layer_numbers (entry0, entry1) ||
+      !compare_entry_pipelines (entry0, entry1))
+    return FALSE;
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_TRANSFORM)) &&
+      !compare_entry_modelviews (entry0, entry1))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+get_entry_screen_bounds (CoglJournal       *journal,
+                         CoglJournalEntry  *entry,
+                         CoglJournalBounds *bounds)
+{
+  float *vertices = &g_array_index (journal->vertices, float,
+                                    entry->array_offset + 1);
+  float poly[16];
+  int i;
+
+  entry_to_screen_polygon (journal->framebuffer, entry, vertices, poly);
+
+  bounds->x_1 = bounds->y_1 = G_MAXFLOAT;
+  bounds->x_2 = bounds->y_2 = -G_MAXFLOAT;
+
+  for (i = 0; i < 4; i++)
+    {
+      float x = poly[4 * i];
+      float y = poly[4 * i + 1];
+
+      /* Vertices behind the viewer don't give meaningful bounds, so
+         consider the entry to cover everything */
+      if (poly[4 * i + 3] <= 0.0f || isnan (x) || isnan (y))
+        {
+          bounds->x_1 = bounds->y_1 = -G_MAXFLOAT;
+          bounds->x_2 = bounds->y_2 = G_MAXFLOAT;
+          return;
+        }
+
+      bounds->x_1 = MIN (bounds->x_1, x);
+      bounds->y_1 = MIN (bounds->y_1, y);
+      bounds->x_2 = MAX (bounds->x_2, x);
+      bounds->y_2 = MAX (bounds->y_2, y);
+    }
+}
+
+static gboolean
+bounds_overlap (const CoglJournalBounds *bounds0,
+                const CoglJournalBounds *bounds1)
+{
+  return (bounds0->x_1 < bounds1->x_2 && bounds1->x_1 < bounds0->x_2 &&
+          bounds0->y_1 < bounds1->y_2 && bounds1->y_1 < bounds0->y_2);
+}
+
+/* Entries that share their state with an earlier batch are moved into
+ * that batch, as long as they don't overlap anything drawn in between.
+ * Non-overlapping entries touch disjoint pixels, so the order they are
+ * drawn in doesn't affect the result, whatever the pipeline does. This
+ * helps with e.g. alternating icons and text, which otherwise ends up
+ * with one draw call per entry. */
+static void
+_cogl_journal_reorder_entries (CoglJournal *journal)
+{
+  GArray *entries = journal->entries;
+  GArray *buckets = journal->reorder_buckets;
+  GArray *links = journal->reorder_links;
+  GArray *reordered_entries = journal->reordered_entries;
+  gboolean reordered = FALSE;
+  int i;
+
+  COGL_STATIC_TIMER (time_reorder_entries,
+                     "Journal Flush", /* parent */
+                     "flush: reorder",
+                     "The time spent reordering journal entries",
+                     0 /* no application private data */);
+
+  if (entries->len < 3)
+    return;
+
+  COGL_TIMER_START (_cogl_uprof_context, time_reorder_entries);
+
+  g_array_set_size (buckets, 0);
+  g_array_set_size (links, entries->len);
+
+  for (i = 0; i < entries->len; i++)
+    {
+      CoglJournalEntry *entry = &g_array_index (entries, CoglJournalEntry, i);
+      CoglJournalBucket *bucket = NULL;
+      CoglJournalBounds bounds;
+      int j;
+
+      get_entry_screen_bounds (journal, entry, &bounds);
+      g_array_index (links, int, i) = -1;
+
+      for (j = buckets->len - 1;
+           j >= 0 && j >= (int) buckets->len - COGL_JOURNAL_REORDER_MAX_LOOKBACK;
+           j--)
+        {
+          CoglJournalBucket *candidate =
+            &g_array_index (buckets, CoglJournalBucket, j);
+          CoglJournalEntry *last_entry =
+            &g_array_index (entries, CoglJournalEntry, candidate->last_entry);
+
+          if (compare_entries_for_reordering (last_entry, entry))
+            {
+              bucket = candidate;
+              break;
+            }
+
+          /* The entry can't be drawn before anything it overlaps */
+          if (bounds_overlap (&candidate->bounds, &bounds))
+            break;
+        }
+
+      if (bucket)
+        {
+          if (j != (int) buckets->len - 1)
+            reordered = TRUE;
+
+          g_array_index (links, int, bucket->last_entry) = i;
+          bucket->last_entry = i;
+          bucket->bounds.x_1 = MIN (bucket->bounds.x_1, bounds.x_1);
+          bucket->bounds.y_1 = MIN (bucket->bounds.y_1, bounds.y_1);
+          bucket->bounds.x_2 = MAX (bucket->bounds.x_2, bounds.x_2);
+          bucket->bounds.y_2 = MAX (bucket->bounds.y_2, bounds.y_2);
+        }
+      else
+        {
+          CoglJournalBucket new_bucket = {
+            .first_entry = i,
+            .last_entry = i,
+            .bounds = bounds,
+          };
+
+          g_array_append_val (buckets, new_bucket);
+        }
+    }
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
+    g_print ("BATCHING: reordered %d entries into %d batches\n",
+             entries->len, buckets->len);
+
+  if (reordered)
+    {
+      g_array_set_size (reordered_entries, 0);
+
+      for (i = 0; i < buckets->len; i++)
+        {
+          CoglJournalBucket *bucket =
+            &g_array_index (buckets, CoglJournalBucket, i);
+          int entry_num;
+
+          for (entry_num = bucket->first_entry;
+               entry_num != -1;
+               entry_num = g_array_index (links, int, entry_num))
+            {
+              g_array_append_val (reordered_entries,
+                                  g_array_index (entries, CoglJournalEntry,
+                                                 entry_num));
+            }
+        }
+
+      g_assert (reordered_entries->len == entries->len);
+      memcpy (entries->data, reordered_entries->data,
+              entries->len * sizeof (CoglJournalEntry));
+    }
+
+  COGL_TIMER_STOP (_cogl_uprof_context, time_reorder_entries);
+}
+
 /* Gets a new vertex array from the pool. A reference is taken on the
    array so it can be treated as if it was just newly allocated */
 static CoglAttributeBuffer *
@@ -1156,17 +1379,22 @@ create_attribute_buffer (CoglJournal *journal,
   return g_object_ref (vbo);
 }
 
-static CoglAttributeBuffer *
+/* Uploads the vertices of the entries, setting the attribute buffer
+   and offset to draw them from in the flush state */
+static void
 upload_vertices (CoglJournal *journal,
                  const CoglJournalEntry *entries,
                  int n_entries,
                  size_t needed_vbo_len,
-                 GArray *vertices)
+                 GArray *vertices,
+                 CoglJournalFlushState *state)
 {
-  CoglAttributeBuffer *attribute_buffer;
+  CoglContext *ctx = cogl_framebuffer_get_context (journal->framebuffer);
+  CoglAttributeBuffer *attribute_buffer = NULL;
   CoglBuffer *buffer;
   const float *vin;
-  float *vout;
+  float *vout = NULL;
+  size_t stream_offset = 0;
   int entry_num;
   int i;
   CoglMatrixEntry *last_modelview_entry = NULL;
@@ -1174,15 +1402,36 @@ upload_vertices (CoglJournal *journal,
 
   g_assert (needed_vbo_len);
 
-  attribute_buffer = create_attribute_buffer (journal, needed_vbo_len * 4);
-  buffer = COGL_BUFFER (attribute_buffer);
-  cogl_buffer_set_update_hint (buffer, COGL_BUFFER_UPDATE_HINT_DYNAMIC);
+  /* Streaming into the persistently mapped ring buffer avoids mapping
+     and reallocating one of the pooled buffers for every flush */
+  if (ctx->journal_stream_buffer)
+    {
+      vout = _cogl_stream_buffer_allocate (ctx->journal_stream_buffer,
+                                           needed_vbo_len * 4,
+                                           &attribute_buffer,
+                                           &stream_offset);
+    }
 
-  vout = _cogl_buffer_map_range_for_fill_or_fallback (buffer,
-                                                      0, /* offset */
-                                                      needed_vbo_len * 4);
-  vin = &g_array_index (vertices, float, 0);
+  if (vout)
+    {
+      g_object_ref (attribute_buffer);
+      state->stream_data = (uint8_t *) vout - stream_offset;
+    }
+  else
+    {
+      attribute_buffer = create_attribute_buffer (journal,
+                                                  needed_vbo_len * 4);
+      buffer = COGL_BUFFER (attribute_buffer);
+      cogl_buffer_set_update_hint (buffer, COGL_BUFFER_UPDATE_HINT_DYNAMIC);
+
+      vout = _cogl_buffer_map_range_for_fill_or_fallback (buffer,
+                                                          0, /* offset */
+                                                          needed_vbo_len * 4);
+      state->stream_data = NULL;
+    }
 
+  state->attribute_buffer = attribute_buffer;
+  state->array_offset = stream_offset;
   /* Expand the number of vertices from 2 to 4 while uploading */
   for (entry_num = 0; entry_num < n_entries; entry_num++)
     {
@@ -1191,6 +1440,10 @@ upload_vertices (CoglJournal *journal,
       size_t array_stride =
         GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
 
+      /* The entries may have been reordered, so the logged vertices
+         aren't necessarily in the same order */
+      vin = &g_array_index (vertices, float, entry->array_offset);
+
       /* Copy the color to all four of the vertices */
       for (i = 0; i < 4; i++)
         memcpy (vout + vb_stride * i + POS_STRIDE, vin, 4);
@@ -1247,13 +1500,11 @@ upload_vertices (CoglJournal *journal,
           tout[vb_stride * 3 + 1 + i * 2] = tin[i * 2 + 1];
         }
 
-      vin += array_stride * 2;
       vout += vb_stride * 4;
     }
 
-  _cogl_buffer_unmap_for_fill_or_fallback (buffer);
-
-  return attribute_buffer;
+  if (!state->stream_data)
+    _cogl_buffer_unmap_for_fill_or_fallback (COGL_BUFFER (attribute_buffer));
 }
 
 void
@@ -1437,15 +1688,19 @@ _cogl_journal_flush (CoglJournal *journal)
                       &state); /* data */
     }
 
+  /* Reorder after software clipping, as it may have merged clip stacks
+     and changed the bounds of the entries */
+  if (G_LIKELY (!COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_JOURNAL_REORDERING)))
+    _cogl_journal_reorder_entries (journal);
+
   /* We upload the vertices after the clip stack pass in case it
      modifies the entries */
-  state.attribute_buffer =
-    upload_vertices (journal,
-                     &g_array_index (journal->entries, CoglJournalEntry, 0),
-                     journal->entries->len,
-                     journal->needed_vbo_len,
-                     journal->vertices);
-  state.array_offset = 0;
+  upload_vertices (journal,
+                   &g_array_index (journal->entries, CoglJournalEntry, 0),
+                   journal->entries->len,
+                   journal->needed_vbo_len,
+                   journal->vertices,
+                   &state);
 
   /* batch_and_call() batches a list of journal entries according to some
    * given criteria and calls a callback once for each determined batch.
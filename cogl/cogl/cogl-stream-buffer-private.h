@@ -0,0 +1,64 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "cogl/cogl-attribute-buffer.h"
+#include "cogl/cogl-context.h"
+
+/*
+ * CoglStreamBuffer is a ring buffer for vertex data that is written
+ * once and drawn right away, such as the vertices of the journal. The
+ * attribute buffer behind it stays mapped for its whole lifetime, so
+ * streaming data is a plain copy, without remapping or reallocating
+ * buffers for each draw.
+ *
+ * The ring is split into a few segments, and a fence is inserted
+ * whenever an allocation leaves a segment. Allocating in a segment
+ * again first waits for its fence, so data is never overwritten while
+ * the GPU may still be reading it.
+ */
+typedef struct _CoglStreamBuffer CoglStreamBuffer;
+
+/* Returns NULL if persistently mapped buffers are not supported */
+CoglStreamBuffer *
+_cogl_stream_buffer_new (CoglContext *context);
+
+void
+_cogl_stream_buffer_free (CoglStreamBuffer *stream);
+
+/* Allocates @size bytes to be written to before the next allocation,
+ * and used for drawing from @buffer_out at @offset_out. No reference
+ * is returned on @buffer_out, so take one if needed beyond the next
+ * allocation. Returns NULL on failure, in which case the caller should
+ * fall back to uploading the data some other way. */
+void *
+_cogl_stream_buffer_allocate (CoglStreamBuffer     *stream,
+                              size_t                size,
+                              CoglAttributeBuffer **buffer_out,
+                              size_t               *offset_out);
@@ -0,0 +1,276 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cogl-config.h"
+
+#include "cogl/cogl-stream-buffer-private.h"
+#include "cogl/cogl-buffer-private.h"
+#include "cogl/cogl-context-private.h"
+#include "cogl/cogl-private.h"
+
+#define STREAM_BUFFER_INITIAL_SIZE (1024 * 1024)
+#define STREAM_BUFFER_N_SEGMENTS 4
+#define STREAM_BUFFER_ALIGNMENT 64
+/* Waiting for a segment should never take more than a few frames,
+ * anything longer means something went badly wrong with the GPU */
+#define STREAM_BUFFER_WAIT_TIMEOUT_NS (G_GUINT64_CONSTANT (1000000000))
+
+#ifdef GL_ARB_sync
+
+struct _CoglStreamBuffer
+{
+  CoglContext *context;
+
+  CoglAttributeBuffer *buffer;
+  uint8_t *data;
+  size_t size;
+
+  /* End of the last allocation */
+  size_t head;
+  /* Segments touched by the last allocation, or -1 */
+  int last_first_segment;
+  int last_last_segment;
+
+  /* Inserted when leaving a segment, waited for and cleared when
+   * entering it again */
+  GLsync segment_fences[STREAM_BUFFER_N_SEGMENTS];
+
+  /* Set if the GPU didn't let go of a segment in time */
+  gboolean broken;
+};
+
+static void
+clear_fences (CoglStreamBuffer *stream)
+{
+  CoglContext *ctx = stream->context;
+  int i;
+
+  for (i = 0; i < STREAM_BUFFER_N_SEGMENTS; i++)
+    {
+      if (stream->segment_fences[i])
+        {
+          ctx->glDeleteSync (stream->segment_fences[i]);
+          stream->segment_fences[i] = NULL;
+        }
+    }
+}
+
+static gboolean
+create_buffer (CoglStreamBuffer *stream,
+               size_t            size)
+{
+  g_autoptr (GError) error = NULL;
+
+  /* Draws still using the old buffer keep its storage alive, so there
+   * is no need to wait for them */
+  clear_fences (stream);
+  g_clear_object (&stream->buffer);
+  stream->data = NULL;
+
+  stream->buffer = cogl_attribute_buffer_new_with_size (stream->context,
+                                                        size);
+  stream->data = _cogl_buffer_map_persistent (COGL_BUFFER (stream->buffer),
+                                              &error);
+  if (!stream->data)
+    {
+      g_warning ("Failed to map vertex stream buffer: %s", error->message);
+      g_clear_object (&stream->buffer);
+      return FALSE;
+    }
+
+  stream->size = size;
+  stream->head = 0;
+  stream->last_first_segment = -1;
+  stream->last_last_segment = -1;
+
+  return TRUE;
+}
+
+CoglStreamBuffer *
+_cogl_stream_buffer_new (CoglContext *context)
+{
+  CoglStreamBuffer *stream;
+
+  if (!_cogl_has_private_feature (context, COGL_PRIVATE_FEATURE_BUFFER_STORAGE))
+    return NULL;
+
+  stream = g_new0 (CoglStreamBuffer, 1);
+  stream->context = context;
+
+  if (!create_buffer (stream, STREAM_BUFFER_INITIAL_SIZE))
+    {
+      g_free (stream);
+      return NULL;
+    }
+
+  return stream;
+}
+
+void
+_cogl_stream_buffer_free (CoglStreamBuffer *stream)
+{
+  clear_fences (stream);
+  g_clear_object (&stream->buffer);
+  g_free (stream);
+}
+
+static void
+fence_segment (CoglStreamBuffer *stream,
+               int               segment)
+{
+  CoglContext *ctx = stream->context;
+
+  g_assert (!stream->segment_fences[segment]);
+
+  /* Covers all draws submitted so far, including the ones reading
+   * from this segment */
+  stream->segment_fences[segment] =
+    ctx->glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static gboolean
+wait_segment (CoglStreamBuffer *stream,
+              int               segment)
+{
+  CoglContext *ctx = stream->context;
+  GLsync fence = stream->segment_fences[segment];
+  GLenum ret;
+
+  if (!fence)
+    return TRUE;
+
+  ret = ctx->glClientWaitSync (fence,
+                               GL_SYNC_FLUSH_COMMANDS_BIT,
+                               STREAM_BUFFER_WAIT_TIMEOUT_NS);
+  ctx->glDeleteSync (fence);
+  stream->segment_fences[segment] = NULL;
+
+  return ret == GL_ALREADY_SIGNALED || ret == GL_CONDITION_SATISFIED;
+}
+
+void *
+_cogl_stream_buffer_allocate (CoglStreamBuffer     *stream,
+                              size_t                size,
+                              CoglAttributeBuffer **buffer_out,
+                              size_t               *offset_out)
+{
+  size_t segment_size;
+  size_t start;
+  int first_segment;
+  int last_segment;
+  int i;
+
+  if (stream->broken)
+    return NULL;
+
+  /* Allocations never span more than two segments, so that there is
+   * always a segment between the one being written and the oldest
+   * one the GPU may still be reading from */
+  segment_size = stream->size / STREAM_BUFFER_N_SEGMENTS;
+  if (size > segment_size)
+    {
+      size_t new_size = stream->size;
+
+      while (new_size / STREAM_BUFFER_N_SEGMENTS < size)
+        new_size *= 2;
+
+      if (!create_buffer (stream, new_size))
+        {
+          stream->broken = TRUE;
+          return NULL;
+        }
+
+      segment_size = stream->size / STREAM_BUFFER_N_SEGMENTS;
+    }
+
+  start = ((stream->head + STREAM_BUFFER_ALIGNMENT - 1) &
+           ~((size_t) STREAM_BUFFER_ALIGNMENT - 1));
+  if (start + size > stream->size)
+    start = 0;
+
+  first_segment = start / segment_size;
+  last_segment = (start + size - 1) / segment_size;
+
+  /* Segments the last allocation is done with won't be written to
+   * again until the ring wraps around */
+  if (stream->last_last_segment != -1)
+    {
+      for (i = stream->last_first_segment; i < stream->last_last_segment; i++)
+        fence_segment (stream, i);
+
+      if (first_segment != stream->last_last_segment)
+        fence_segment (stream, stream->last_last_segment);
+    }
+
+  for (i = first_segment; i <= last_segment; i++)
+    {
+      if (i == stream->last_last_segment &&
+          first_segment == stream->last_last_segment)
+        continue;
+
+      if (!wait_segment (stream, i))
+        {
+          g_warning ("Timed out waiting for the GPU to release vertex "
+                     "stream buffer, falling back to regular buffers");
+          clear_fences (stream);
+          stream->broken = TRUE;
+          return NULL;
+        }
+    }
+
+  stream->head = start + size;
+  stream->last_first_segment = first_segment;
+  stream->last_last_segment = last_segment;
+
+  *buffer_out = stream->buffer;
+  *offset_out = start;
+
+  return stream->data + start;
+}
+
+#else /* GL_ARB_sync */
+
+CoglStreamBuffer *
+_cogl_stream_buffer_new (CoglContext *context)
+{
+  return NULL;
+}
+
+void
+_cogl_stream_buffer_free (CoglStreamBuffer *stream)
+{
+}
+
+void *
+_cogl_stream_buffer_allocate (CoglStreamBuffer     *stream,
+                              size_t                size,
+                              CoglAttributeBuffer **buffer_out,
+                              size_t               *offset_out)
+{
+  return NULL;
+}
+
+#endif /* GL_ARB_sync */
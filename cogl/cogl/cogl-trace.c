@@ -45,6 +45,8 @@ struct _CoglTraceContext
 {
   gatomicrefcount ref_count;
   SysprofCaptureWriter *writer;
+  /* CoglTraceCounter -> counter id in the writer */
+  GHashTable *counter_ids;
 };
 
 typedef struct _CoglTraceThreadContext
@@ -104,6 +106,7 @@ cogl_trace_context_new (int         fd,
 
   context = g_new0 (CoglTraceContext, 1);
   context->writer = writer;
+  context->counter_ids = g_hash_table_new (NULL, NULL);
   g_atomic_ref_count_init (&context->ref_count);
   return context;
 }
@@ -116,6 +119,7 @@ cogl_trace_context_unref (CoglTraceContext *trace_context)
       if (trace_context->writer)
         sysprof_capture_writer_flush (trace_context->writer);
       g_clear_pointer (&trace_context->writer, sysprof_capture_writer_unref);
+      g_hash_table_destroy (trace_context->counter_ids);
       g_free (trace_context);
     }
 }
@@ -290,25 +294,25 @@ cogl_set_tracing_disabled_on_thread (GMainContext *main_context)
 }
 
 static void
-cogl_trace_end_with_description (CoglTraceHead *head,
-                                 const char    *description)
+add_mark (uint64_t    begin_time,
+          uint64_t    end_time,
+          const char *name,
+          const char *description)
 {
-  SysprofTimeStamp end_time;
   CoglTraceContext *trace_context;
   CoglTraceThreadContext *trace_thread_context;
 
-  end_time = g_get_monotonic_time () * 1000;
   trace_thread_context = g_private_get (&cogl_trace_thread_data);
   trace_context = trace_thread_context->trace_context;
 
   g_mutex_lock (&cogl_trace_mutex);
   if (!sysprof_capture_writer_add_mark (trace_context->writer,
-                                        head->begin_time,
+                                        begin_time,
                                         trace_thread_context->cpu_id,
                                         trace_thread_context->pid,
-                                        (uint64_t) end_time - head->begin_time,
+                                        end_time - begin_time,
                                         trace_thread_context->group,
-                                        head->name,
+                                        name,
                                         description))
     {
       /* XXX: g_main_context_get_thread_default() might be wrong, it probably
@@ -321,6 +325,88 @@ cogl_trace_end_with_description (CoglTraceHead *head,
   g_mutex_unlock (&cogl_trace_mutex);
 }
 
+static void
+cogl_trace_end_with_description (CoglTraceHead *head,
+                                 const char    *description)
+{
+  SysprofTimeStamp end_time;
+
+  end_time = g_get_monotonic_time () * 1000;
+  add_mark (head->begin_time, end_time, head->name, description);
+}
+
+void
+cogl_trace_mark (const char *name,
+                 int64_t     begin_time_us,
+                 int64_t     end_time_us,
+                 const char *description)
+{
+  add_mark (begin_time_us * 1000,
+            MAX (begin_time_us, end_time_us) * 1000,
+            name,
+            description);
+}
+
+void
+cogl_trace_set_counter (const CoglTraceCounter *counter,
+                        int64_t                 value)
+{
+  CoglTraceContext *trace_context;
+  CoglTraceThreadContext *trace_thread_context;
+  SysprofCaptureCounterValue counter_value = { .v64 = value };
+  SysprofTimeStamp time;
+  gpointer id_pointer;
+  unsigned int id;
+
+  time = g_get_monotonic_time () * 1000;
+  trace_thread_context = g_private_get (&cogl_trace_thread_data);
+  trace_context = trace_thread_context->trace_context;
+
+  g_mutex_lock (&cogl_trace_mutex);
+
+  /* Counters are defined lazily, as each trace needs its own definitions */
+  if (g_hash_table_lookup_extended (trace_context->counter_ids, counter,
+                                    NULL, &id_pointer))
+    {
+      id = GPOINTER_TO_UINT (id_pointer);
+    }
+  else
+    {
+      SysprofCaptureCounter capture_counter = { 0 };
+
+      id = sysprof_capture_writer_request_counter (trace_context->writer, 1);
+
+      g_strlcpy (capture_counter.category, counter->category,
+                 sizeof (capture_counter.category));
+      g_strlcpy (capture_counter.name, counter->name,
+                 sizeof (capture_counter.name));
+      g_strlcpy (capture_counter.description, counter->description,
+                 sizeof (capture_counter.description));
+      capture_counter.id = id;
+      capture_counter.type = SYSPROF_CAPTURE_COUNTER_INT64;
+      capture_counter.value = counter_value;
+
+      sysprof_capture_writer_define_counters (trace_context->writer,
+                                              time,
+                                              trace_thread_context->cpu_id,
+                                              trace_thread_context->pid,
+                                              &capture_counter,
+                                              1);
+      g_hash_table_insert (trace_context->counter_ids,
+                           (gpointer) counter, GUINT_TO_POINTER (id));
+    }
+
+  sysprof_capture_writer_set_counters (trace_context->writer,
+                                       time,
+                                       trace_thread_context->cpu_id,
+                                       trace_thread_context->pid,
+                                       &id,
+                                       &counter_value,
+                                       1);
+
+  g_mutex_unlock (&cogl_trace_mutex);
+}
+
 void
 cogl_trace_end (CoglTraceHead *head)
 {
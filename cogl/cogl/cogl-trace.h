@@ -89,6 +89,34 @@ COGL_EXPORT void
 cogl_trace_describe (CoglTraceHead *head,
                      const char    *description);
 
+/*
+ * A counter to show alongside the trace, e.g. a statistic computed from
+ * multiple marks. Meant to be statically allocated, as it is identified
+ * by its address.
+ */
+typedef struct _CoglTraceCounter
+{
+  const char *category;
+  const char *name;
+  const char *description;
+} CoglTraceCounter;
+
+/*
+ * Adds a mark spanning from @begin_time_us to @end_time_us, both in the
+ * g_get_monotonic_time() time base. Unlike COGL_TRACE_BEGIN(), the mark
+ * doesn't need to start nor end at the time it is added, e.g. to trace
+ * the time it took for a timestamped input event to get somewhere.
+ */
+COGL_EXPORT void
+cogl_trace_mark (const char *name,
+                 int64_t     begin_time_us,
+                 int64_t     end_time_us,
+                 const char *description);
+
+COGL_EXPORT void
+cogl_trace_set_counter (const CoglTraceCounter *counter,
+                        int64_t                 value);
+
 static inline void
 cogl_auto_trace_end_helper (CoglTraceHead **head)
 {
@@ -137,6 +165,10 @@ cogl_is_tracing_enabled (void)
       ScopedCoglTrace##Name = &CoglTrace##Name; \
     }
 
+#define COGL_TRACE_MARK(name, begin_time_us, end_time_us, description) \
+  if (cogl_is_tracing_enabled ()) \
+    cogl_trace_mark (name, begin_time_us, end_time_us, description);
+
 #else /* COGL_HAS_TRACING */
 
 #include <stdio.h>
@@ -147,6 +179,8 @@ cogl_is_tracing_enabled (void)
 #define COGL_TRACE_DESCRIBE(Name, description) (void) 0
 #define COGL_TRACE_SCOPED_ANCHOR(Name) (void) 0
 #define COGL_TRACE_BEGIN_ANCHORED(Name, name) (void) 0
+#define COGL_TRACE_MARK(name, begin_time_us, end_time_us, description) \
+  (void) 0
 
 COGL_EXPORT
 gboolean cogl_start_tracing_with_path (const char  *filename,
@@ -62,6 +62,10 @@ _cogl_buffer_gl_set_data (CoglBuffer *buffer,
                           unsigned int size,
                           GError **error);
 
+void *
+_cogl_buffer_gl_map_persistent (CoglBuffer *buffer,
+                                GError **error);
+
 void *
 _cogl_buffer_gl_bind (CoglBuffer *buffer,
                       CoglBufferBindTarget target,
@@ -75,6 +75,12 @@
 #ifndef GL_MAP_INVALIDATE_BUFFER_BIT
 #define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
 #endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
 
 void
 _cogl_buffer_gl_create (CoglBuffer *buffer)
@@ -339,6 +345,65 @@ _cogl_buffer_gl_unmap (CoglBuffer *buffer)
   _cogl_buffer_gl_unbind (buffer);
 }
 
+void *
+_cogl_buffer_gl_map_persistent (CoglBuffer *buffer,
+                                GError **error)
+{
+  CoglContext *ctx = buffer->context;
+  GLbitfield gl_flags;
+  GLenum gl_target;
+  uint8_t *data;
+
+  g_return_val_if_fail (!buffer->store_created, NULL);
+
+  if (!_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_BUFFER_STORAGE))
+    {
+      g_set_error_literal (error,
+                           COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED,
+                           "Persistently mapped buffers are not supported");
+      return NULL;
+    }
+
+  _cogl_buffer_bind_no_create (buffer, buffer->last_target);
+
+  gl_target = convert_bind_target_to_gl_target (buffer->last_target);
+
+  /* Coherent mappings spare us flushing every written range, writes
+   * become visible to the GPU with the next draw call anyway */
+  gl_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  /* Clear any GL errors */
+  _cogl_gl_util_clear_gl_errors (ctx);
+
+  ctx->glBufferStorage (gl_target, buffer->size, NULL, gl_flags);
+
+  if (_cogl_gl_util_catch_out_of_memory (ctx, error))
+    {
+      _cogl_buffer_gl_unbind (buffer);
+      return NULL;
+    }
+
+  buffer->store_created = TRUE;
+
+  data = ctx->glMapBufferRange (gl_target, 0, buffer->size, gl_flags);
+
+  _cogl_buffer_gl_unbind (buffer);
+
+  if (!data)
+    {
+      g_set_error_literal (error,
+                           COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED,
+                           "Failed to map buffer persistently");
+      return NULL;
+    }
+
+  buffer->flags |= COGL_BUFFER_FLAG_MAPPED_PERSISTENT;
+
+  return data;
+}
+
 gboolean
 _cogl_buffer_gl_set_data (CoglBuffer *buffer,
                           unsigned int offset,
@@ -37,5 +37,5 @@
 
 extern const CoglPipelineFragend _cogl_pipeline_glsl_fragend;
 
-GLuint
+COGL_EXPORT_TEST GLuint
 _cogl_pipeline_fragend_glsl_get_shader (CoglPipeline *pipeline);
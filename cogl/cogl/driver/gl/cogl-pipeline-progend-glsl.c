@@ -811,6 +811,7 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
 
   if (program_state->program == 0)
     {
+      CoglProgramBinaryCache *program_binary_cache;
       GLuint backend_shader;
       GSList *l;
 
@@ -845,7 +846,27 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
       GE( ctx, glBindAttribLocation (program_state->program,
                                      0, "cogl_position_in"));
 
-      link_program (program_state->program);
+      program_binary_cache = _cogl_driver_gl_context (ctx)->program_binary_cache;
+      if (program_binary_cache)
+        {
+          g_autofree char *key = NULL;
+
+          if (!_cogl_program_binary_cache_load (program_binary_cache,
+                                                program_state->program,
+                                                &key))
+            {
+              link_program (program_state->program);
+
+              if (key)
+                _cogl_program_binary_cache_save (program_binary_cache,
+                                                 program_state->program,
+                                                 key);
+            }
+        }
+      else
+        {
+          link_program (program_state->program);
+        }
 
       program_changed = TRUE;
     }
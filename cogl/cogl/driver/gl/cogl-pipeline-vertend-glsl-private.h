@@ -39,7 +39,7 @@ typedef struct _CoglPipelineVertendShaderState CoglPipelineVertendShaderState;
 
 extern const CoglPipelineVertend _cogl_pipeline_glsl_vertend;
 
-GLuint
+COGL_EXPORT_TEST GLuint
 _cogl_pipeline_vertend_glsl_get_shader (CoglPipeline *pipeline);
 
 COGL_EXPORT_TEST
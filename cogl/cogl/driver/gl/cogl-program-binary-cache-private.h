@@ -0,0 +1,62 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#pragma once
+
+#include "cogl/cogl-context.h"
+#include "cogl/cogl-gl-header.h"
+#include "cogl/cogl-macros.h"
+
+typedef struct _CoglProgramBinaryCache CoglProgramBinaryCache;
+
+COGL_EXPORT_TEST CoglProgramBinaryCache *
+_cogl_program_binary_cache_new (CoglContext *context);
+
+COGL_EXPORT_TEST void
+_cogl_program_binary_cache_free (CoglProgramBinaryCache *cache);
+
+/*
+ * Tries to initialize @program, which must have all of its shaders
+ * attached and compiled, from a previously stored binary instead of
+ * linking it. The cache key is derived from the source of the attached
+ * shaders and the GL driver in use.
+ *
+ * Returns TRUE if @program was successfully loaded from the cache.
+ * Otherwise @key_out is set to the cache key that should be passed to
+ * _cogl_program_binary_cache_save() once the program has been linked,
+ * or to NULL if the program can't be cached.
+ */
+COGL_EXPORT_TEST gboolean
+_cogl_program_binary_cache_load (CoglProgramBinaryCache  *cache,
+                                 GLuint                   program,
+                                 char                   **key_out);
+
+COGL_EXPORT_TEST void
+_cogl_program_binary_cache_save (CoglProgramBinaryCache *cache,
+                                 GLuint                  program,
+                                 const char             *key);
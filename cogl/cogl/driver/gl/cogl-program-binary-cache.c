@@ -0,0 +1,334 @@
+/*
+ * Cogl
+ *
+ * A Low Level GPU Graphics and Utilities API
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#include "cogl-config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "cogl/cogl-context-private.h"
+#include "cogl/driver/gl/cogl-program-binary-cache-private.h"
+#include "cogl/driver/gl/cogl-util-gl-private.h"
+#include "mtk/mtk.h"
+
+/* Bump this whenever the file format or the way keys are derived
+ * changes */
+#define PROGRAM_BINARY_CACHE_VERSION 1
+#define PROGRAM_BINARY_MAGIC 0x42504743 /* "CGPB" */
+
+/* Least recently used binaries are evicted once the cache grows
+ * beyond this; stale ones left behind by older drivers age out */
+#define MAX_PROGRAM_BINARY_CACHE_SIZE (32 * 1024 * 1024)
+
+typedef struct _ProgramBinaryHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t binary_format;
+  uint32_t binary_length;
+} ProgramBinaryHeader;
+
+struct _CoglProgramBinaryCache
+{
+  CoglContext *context;
+
+  char *path;
+  char *driver_id;
+
+  gboolean write_failed;
+  goffset size;
+};
+
+static void
+prune_cache (CoglProgramBinaryCache *cache)
+{
+  /* Prune down to half the limit so that it doesn't happen again on the
+   * very next store */
+  cache->size = mtk_disk_cache_prune (cache->path, NULL,
+                                      MAX_PROGRAM_BINARY_CACHE_SIZE / 2, 0);
+}
+
+CoglProgramBinaryCache *
+_cogl_program_binary_cache_new (CoglContext *context)
+{
+  CoglProgramBinaryCache *cache;
+  g_autofree char *path = NULL;
+
+  path = g_build_filename (g_get_user_cache_dir (),
+                           "mutter",
+                           "program-binaries",
+                           NULL);
+  if (g_mkdir_with_parents (path, 0700) != 0)
+    {
+      g_warning ("Failed to create program binary cache directory %s: %s",
+                 path, g_strerror (errno));
+      return NULL;
+    }
+
+  cache = g_new0 (CoglProgramBinaryCache, 1);
+  cache->context = context;
+  cache->path = g_steal_pointer (&path);
+  cache->driver_id =
+    g_strdup_printf ("%s\n%s\n%s",
+                     (const char *) context->glGetString (GL_VENDOR),
+                     (const char *) context->glGetString (GL_RENDERER),
+                     _cogl_context_get_gl_version (context));
+
+  prune_cache (cache);
+
+  return cache;
+}
+
+void
+_cogl_program_binary_cache_free (CoglProgramBinaryCache *cache)
+{
+  g_free (cache->path);
+  g_free (cache->driver_id);
+  g_free (cache);
+}
+
+static int
+compare_digests (gconstpointer a,
+                 gconstpointer b)
+{
+  return strcmp (*(const char **) a, *(const char **) b);
+}
+
+static char *
+get_shader_digest (CoglContext *ctx,
+                   GLuint       shader)
+{
+  g_autoptr (GChecksum) checksum = NULL;
+  g_autofree char *source = NULL;
+  GLint shader_type = 0;
+  GLint source_length = 0;
+  GLsizei out_source_length = 0;
+
+  GE (ctx, glGetShaderiv (shader, GL_SHADER_TYPE, &shader_type));
+  GE (ctx, glGetShaderiv (shader, GL_SHADER_SOURCE_LENGTH, &source_length));
+  if (source_length <= 0)
+    return NULL;
+
+  source = g_malloc (source_length);
+  GE (ctx, glGetShaderSource (shader, source_length,
+                              &out_source_length, source));
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum,
+                     (const guchar *) &shader_type, sizeof (shader_type));
+  g_checksum_update (checksum,
+                     (const guchar *) source, out_source_length);
+
+  return g_strdup (g_checksum_get_string (checksum));
+}
+
+static char *
+compute_program_key (CoglProgramBinaryCache *cache,
+                     GLuint                  program)
+{
+  CoglContext *ctx = cache->context;
+  g_autoptr (GChecksum) checksum = NULL;
+  g_autoptr (GPtrArray) shader_digests = NULL;
+  g_autofree GLuint *shaders = NULL;
+  GLint n_shaders = 0;
+  GLsizei out_n_shaders = 0;
+  int i;
+
+  GE (ctx, glGetProgramiv (program, GL_ATTACHED_SHADERS, &n_shaders));
+  if (n_shaders <= 0)
+    return NULL;
+
+  shaders = g_new0 (GLuint, n_shaders);
+  GE (ctx, glGetAttachedShaders (program, n_shaders, &out_n_shaders, shaders));
+
+  shader_digests = g_ptr_array_new_with_free_func (g_free);
+  for (i = 0; i < out_n_shaders; i++)
+    {
+      char *digest;
+
+      digest = get_shader_digest (ctx, shaders[i]);
+      if (!digest)
+        return NULL;
+
+      g_ptr_array_add (shader_digests, digest);
+    }
+
+  /* The order in which the attached shaders are returned is
+   * implementation defined */
+  g_ptr_array_sort (shader_digests, compare_digests);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) cache->driver_id, -1);
+  for (i = 0; i < shader_digests->len; i++)
+    {
+      g_checksum_update (checksum,
+                         g_ptr_array_index (shader_digests, i),
+                         -1);
+    }
+
+  return g_strdup (g_checksum_get_string (checksum));
+}
+
+static gboolean
+load_program_binary (CoglProgramBinaryCache *cache,
+                     GLuint                  program,
+                     const char             *filename)
+{
+  CoglContext *ctx = cache->context;
+  g_autofree char *contents = NULL;
+  gsize length;
+  ProgramBinaryHeader header;
+  GLint link_status = GL_FALSE;
+
+  if (!g_file_get_contents (filename, &contents, &length, NULL))
+    return FALSE;
+
+  if (length < sizeof (header))
+    goto invalid;
+
+  memcpy (&header, contents, sizeof (header));
+  if (header.magic != PROGRAM_BINARY_MAGIC ||
+      header.version != PROGRAM_BINARY_CACHE_VERSION ||
+      header.binary_length != length - sizeof (header))
+    goto invalid;
+
+  _cogl_gl_util_clear_gl_errors (ctx);
+  ctx->glProgramBinary (program,
+                        header.binary_format,
+                        contents + sizeof (header),
+                        header.binary_length);
+  if (_cogl_gl_util_get_error (ctx) != GL_NO_ERROR)
+    goto invalid;
+
+  GE (ctx, glGetProgramiv (program, GL_LINK_STATUS, &link_status));
+  if (!link_status)
+    goto invalid;
+
+  /* Mark as recently used so it survives pruning */
+  g_utime (filename, NULL);
+
+  return TRUE;
+
+invalid:
+  /* Most likely the driver was updated, or the file is corrupt */
+  g_unlink (filename);
+  return FALSE;
+}
+
+gboolean
+_cogl_program_binary_cache_load (CoglProgramBinaryCache  *cache,
+                                 GLuint                   program,
+                                 char                   **key_out)
+{
+  CoglContext *ctx = cache->context;
+  g_autofree char *key = NULL;
+  g_autofree char *filename = NULL;
+
+  *key_out = NULL;
+
+  key = compute_program_key (cache, program);
+  if (!key)
+    return FALSE;
+
+  filename = g_build_filename (cache->path, key, NULL);
+  if (load_program_binary (cache, program, filename))
+    return TRUE;
+
+  if (ctx->glProgramParameteri)
+    {
+      GE (ctx, glProgramParameteri (program,
+                                    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                    GL_TRUE));
+    }
+
+  *key_out = g_steal_pointer (&key);
+  return FALSE;
+}
+
+void
+_cogl_program_binary_cache_save (CoglProgramBinaryCache *cache,
+                                 GLuint                  program,
+                                 const char             *key)
+{
+  CoglContext *ctx = cache->context;
+  g_autofree char *contents = NULL;
+  g_autofree char *filename = NULL;
+  g_autoptr (GError) error = NULL;
+  ProgramBinaryHeader header;
+  GLint link_status = GL_FALSE;
+  GLint binary_length = 0;
+  GLsizei out_binary_length = 0;
+  GLenum binary_format = 0;
+
+  if (cache->write_failed)
+    return;
+
+  GE (ctx, glGetProgramiv (program, GL_LINK_STATUS, &link_status));
+  if (!link_status)
+    return;
+
+  GE (ctx, glGetProgramiv (program, GL_PROGRAM_BINARY_LENGTH, &binary_length));
+  if (binary_length <= 0)
+    return;
+
+  contents = g_malloc (sizeof (header) + binary_length);
+  GE (ctx, glGetProgramBinary (program,
+                               binary_length,
+                               &out_binary_length,
+                               &binary_format,
+                               contents + sizeof (header)));
+  if (out_binary_length <= 0)
+    return;
+
+  header = (ProgramBinaryHeader) {
+    .magic = PROGRAM_BINARY_MAGIC,
+    .version = PROGRAM_BINARY_CACHE_VERSION,
+    .binary_format = binary_format,
+    .binary_length = out_binary_length,
+  };
+  memcpy (contents, &header, sizeof (header));
+
+  filename = g_build_filename (cache->path, key, NULL);
+  if (!g_file_set_contents_full (filename,
+                                 contents,
+                                 sizeof (header) + out_binary_length,
+                                 G_FILE_SET_CONTENTS_CONSISTENT,
+                                 0600,
+                                 &error))
+    {
+      g_warning ("Failed to store program binary, disabling cache: %s",
+                 error->message);
+      cache->write_failed = TRUE;
+      return;
+    }
+
+  cache->size += sizeof (header) + out_binary_length;
+  if (cache->size > MAX_PROGRAM_BINARY_CACHE_SIZE)
+    prune_cache (cache);
+}
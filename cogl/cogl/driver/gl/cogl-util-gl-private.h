@@ -36,6 +36,7 @@
 #include "cogl/cogl-context.h"
 #include "cogl/cogl-gl-header.h"
 #include "cogl/cogl-texture.h"
+#include "cogl/driver/gl/cogl-program-binary-cache-private.h"
 
 /* In OpenGL ES context, GL_CONTEXT_LOST has a _KHR prefix */
 #ifndef GL_CONTEXT_LOST
@@ -83,6 +84,9 @@ typedef struct _CoglGLContext {
   /* This is used for generated fake unique sampler object numbers
    when the sampler object extension is not supported */
   GLuint next_fake_sampler_object_number;
+
+  /* NULL if program binaries aren't supported or the cache is disabled */
+  CoglProgramBinaryCache *program_binary_cache;
 } CoglGLContext;
 
 CoglGLContext *
@@ -253,3 +257,19 @@ cogl_gl_get_gpu_time_ns (CoglContext *context);
 #ifndef GL_TEXTURE_LOD_BIAS
 #define GL_TEXTURE_LOD_BIAS 0x8501
 #endif
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_ATTACHED_SHADERS
+#define GL_ATTACHED_SHADERS 0x8B85
+#endif
+#ifndef GL_SHADER_SOURCE_LENGTH
+#define GL_SHADER_SOURCE_LENGTH 0x8B88
+#endif
@@ -34,6 +34,7 @@
 
 #include "cogl/cogl-types.h"
 #include "cogl/cogl-context-private.h"
+#include "cogl/cogl-debug.h"
 #include "cogl/driver/gl/cogl-framebuffer-gl-private.h"
 #include "cogl/driver/gl/cogl-gl-framebuffer-fbo.h"
 #include "cogl/driver/gl/cogl-gl-framebuffer-back.h"
@@ -123,12 +124,24 @@ _cogl_driver_gl_context_init (CoglContext *context)
   gl_context->active_texture_unit = 1;
   GE (context, glActiveTexture (GL_TEXTURE1));
 
+  if (_cogl_has_private_feature (context,
+                                 COGL_PRIVATE_FEATURE_PROGRAM_BINARY) &&
+      G_LIKELY (!COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_PROGRAM_BINARY_CACHE)))
+    {
+      gl_context->program_binary_cache =
+        _cogl_program_binary_cache_new (context);
+    }
+
   return TRUE;
 }
 
 void
 _cogl_driver_gl_context_deinit (CoglContext *context)
 {
+  CoglGLContext *gl_context = _cogl_driver_gl_context (context);
+
+  g_clear_pointer (&gl_context->program_binary_cache,
+                   _cogl_program_binary_cache_free);
   _cogl_destroy_texture_units (context);
   g_free (context->driver_context);
 }
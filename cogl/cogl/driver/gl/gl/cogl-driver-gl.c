@@ -453,6 +453,7 @@ _cogl_driver_update_features (CoglContext *ctx,
   COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_BLIT_FRAMEBUFFER, TRUE);
 
   COGL_FLAGS_SET (private_features, COGL_PRIVATE_FEATURE_PBOS, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT, TRUE);
 
   COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_MAP_BUFFER_FOR_READ, TRUE);
   COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_MAP_BUFFER_FOR_WRITE, TRUE);
@@ -490,6 +491,12 @@ _cogl_driver_update_features (CoglContext *ctx,
   if (ctx->glFenceSync)
     COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_FENCE, TRUE);
 
+  /* Streaming through a persistently mapped buffer relies on fences to
+   * know when parts of it can be overwritten */
+  if (ctx->glBufferStorage && ctx->glMapBufferRange && ctx->glFenceSync)
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_BUFFER_STORAGE, TRUE);
+
   COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_RG, TRUE);
 
   COGL_FLAGS_SET (private_features,
@@ -501,6 +508,17 @@ _cogl_driver_update_features (CoglContext *ctx,
   if (ctx->glGenQueries && ctx->glQueryCounter && ctx->glGetInteger64v)
     COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TIMESTAMP_QUERY, TRUE);
 
+  if (ctx->glGetProgramBinary && ctx->glProgramBinary)
+    {
+      GLint n_binary_formats = 0;
+
+      GE (ctx, glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS,
+                               &n_binary_formats));
+      if (n_binary_formats > 0)
+        COGL_FLAGS_SET (private_features,
+                        COGL_PRIVATE_FEATURE_PROGRAM_BINARY, TRUE);
+    }
+
   /* Cache features */
   for (i = 0; i < G_N_ELEMENTS (private_features); i++)
     ctx->private_features[i] |= private_features[i];
@@ -549,6 +567,7 @@ _cogl_driver_gl =
     _cogl_buffer_gl_map_range,
     _cogl_buffer_gl_unmap,
     _cogl_buffer_gl_set_data,
+    _cogl_buffer_gl_map_persistent,
     _cogl_sampler_gl_init,
     _cogl_sampler_gl_free,
     _cogl_gl_set_uniform, /* XXX name is weird... */
@@ -423,6 +423,14 @@ _cogl_driver_update_features (CoglContext *context,
                      COGL_FEATURE_ID_MAP_BUFFER_FOR_READ, TRUE);
     }
 
+  /* Pixel buffer objects are core in ES3 */
+  if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 3, 0))
+    {
+      COGL_FLAGS_SET (private_features, COGL_PRIVATE_FEATURE_PBOS, TRUE);
+      COGL_FLAGS_SET (context->features,
+                      COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT, TRUE);
+    }
+
   if (context->glEGLImageTargetTexture2D)
     COGL_FLAGS_SET (private_features,
                     COGL_PRIVATE_FEATURE_TEXTURE_2D_FROM_EGL_IMAGE, TRUE);
@@ -456,6 +464,14 @@ _cogl_driver_update_features (CoglContext *context,
 #ifdef GL_ARB_sync
   if (context->glFenceSync)
     COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_FENCE, TRUE);
+
+  /* Streaming through a persistently mapped buffer relies on fences to
+   * know when parts of it can be overwritten */
+  if (context->glBufferStorage &&
+      context->glMapBufferRange &&
+      context->glFenceSync)
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_BUFFER_STORAGE, TRUE);
 #endif
 
   if (_cogl_check_extension ("GL_EXT_texture_rg", gl_extensions))
@@ -472,6 +488,17 @@ _cogl_driver_update_features (CoglContext *context,
   if (context->glGenQueries && context->glQueryCounter && context->glGetInteger64v)
     COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TIMESTAMP_QUERY, TRUE);
 
+  if (context->glGetProgramBinary && context->glProgramBinary)
+    {
+      GLint n_binary_formats = 0;
+
+      GE (context, glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS,
+                                   &n_binary_formats));
+      if (n_binary_formats > 0)
+        COGL_FLAGS_SET (private_features,
+                        COGL_PRIVATE_FEATURE_PROGRAM_BINARY, TRUE);
+    }
+
   if (!g_strcmp0 ((char *) context->glGetString (GL_RENDERER), "Mali-400 MP"))
     {
       COGL_FLAGS_SET (private_features,
@@ -523,6 +550,7 @@ _cogl_driver_gles =
     _cogl_buffer_gl_map_range,
     _cogl_buffer_gl_unmap,
     _cogl_buffer_gl_set_data,
+    _cogl_buffer_gl_map_persistent,
     _cogl_sampler_gl_init,
     _cogl_sampler_gl_free,
     _cogl_gl_set_uniform,
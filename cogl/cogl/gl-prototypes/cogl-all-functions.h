@@ -214,6 +214,17 @@ COGL_EXT_FUNCTION (GLvoid *, glMapBufferRange,
                     GLbitfield access))
 COGL_EXT_END ()
 
+COGL_EXT_BEGIN (buffer_storage, 4, 4,
+                0, /* not in either GLES */
+                "ARB:\0EXT\0",
+                "buffer_storage\0")
+COGL_EXT_FUNCTION (void, glBufferStorage,
+                   (GLenum target,
+                    GLsizeiptr size,
+                    const GLvoid *data,
+                    GLbitfield flags))
+COGL_EXT_END ()
+
 #ifdef GL_ARB_sync
 COGL_EXT_BEGIN (sync, 3, 2,
                 COGL_EXT_IN_GLES3,
@@ -236,6 +247,33 @@ COGL_EXT_FUNCTION (void, glGetInteger64v,
                    (GLenum pname, GLint64 *params))
 COGL_EXT_END ()
 
+COGL_EXT_BEGIN (get_program_binary, 4, 1,
+                COGL_EXT_IN_GLES3,
+                "ARB:\0OES\0",
+                "get_program_binary\0")
+COGL_EXT_FUNCTION (void, glGetProgramBinary,
+                   (GLuint program,
+                    GLsizei bufSize,
+                    GLsizei *length,
+                    GLenum *binaryFormat,
+                    GLvoid *binary))
+COGL_EXT_FUNCTION (void, glProgramBinary,
+                   (GLuint program,
+                    GLenum binaryFormat,
+                    const GLvoid *binary,
+                    GLint length))
+COGL_EXT_END ()
+
+COGL_EXT_BEGIN (program_parameteri, 4, 1,
+                COGL_EXT_IN_GLES3,
+                "ARB:\0",
+                "get_program_binary\0")
+COGL_EXT_FUNCTION (void, glProgramParameteri,
+                   (GLuint program,
+                    GLenum pname,
+                    GLint value))
+COGL_EXT_END ()
+
 COGL_EXT_BEGIN (draw_buffers, 2, 0,
                 COGL_EXT_IN_GLES3,
                 "ARB\0EXT\0",
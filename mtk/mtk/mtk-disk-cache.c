@@ -0,0 +1,135 @@
+/*
+ * Mtk
+ *
+ * A low-level base library.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+#include <time.h>
+
+#include "mtk/mtk-disk-cache.h"
+
+typedef struct _CachedFile
+{
+  char *path;
+  goffset size;
+  time_t mtime;
+} CachedFile;
+
+static void
+cached_file_free (CachedFile *cached_file)
+{
+  g_free (cached_file->path);
+  g_free (cached_file);
+}
+
+static int
+compare_cached_files (gconstpointer a,
+                      gconstpointer b)
+{
+  const CachedFile *cached_file_a = *(CachedFile * const *) a;
+  const CachedFile *cached_file_b = *(CachedFile * const *) b;
+
+  /* Most recently used first */
+  if (cached_file_a->mtime > cached_file_b->mtime)
+    return -1;
+  else if (cached_file_a->mtime < cached_file_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+/**
+ * mtk_disk_cache_prune:
+ * @path: The cache directory
+ * @suffix: (nullable): Only consider files with this suffix
+ * @max_size: The size the cache is pruned down to
+ * @max_age_s: Age in seconds after which files are removed, or 0
+ *
+ * Prunes a directory of cache files, whose modification time is updated
+ * whenever they are used. Files older than @max_age_s are removed, and
+ * the least recently used ones while the cache is larger than @max_size.
+ *
+ * This does blocking I/O, and must not run concurrently for the same
+ * directory.
+ *
+ * Returns: The size of the files left in the cache
+ */
+goffset
+mtk_disk_cache_prune (const char *path,
+                      const char *suffix,
+                      goffset     max_size,
+                      int64_t     max_age_s)
+{
+  g_autoptr (GDir) dir = NULL;
+  g_autoptr (GPtrArray) cached_files = NULL;
+  const char *name;
+  goffset total_size = 0;
+  time_t now;
+  unsigned int i;
+
+  g_return_val_if_fail (path != NULL, 0);
+
+  dir = g_dir_open (path, 0, NULL);
+  if (!dir)
+    return 0;
+
+  cached_files =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) cached_file_free);
+  now = time (NULL);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      g_autofree char *file_path = NULL;
+      CachedFile *cached_file;
+      GStatBuf stat_buf;
+
+      if (suffix && !g_str_has_suffix (name, suffix))
+        continue;
+
+      file_path = g_build_filename (path, name, NULL);
+      if (g_stat (file_path, &stat_buf) != 0)
+        continue;
+
+      if (max_age_s > 0 && now - stat_buf.st_mtime > max_age_s)
+        {
+          g_unlink (file_path);
+          continue;
+        }
+
+      cached_file = g_new0 (CachedFile, 1);
+      cached_file->path = g_steal_pointer (&file_path);
+      cached_file->size = stat_buf.st_size;
+      cached_file->mtime = stat_buf.st_mtime;
+      g_ptr_array_add (cached_files, cached_file);
+    }
+
+  g_ptr_array_sort (cached_files, compare_cached_files);
+
+  for (i = 0; i < cached_files->len; i++)
+    {
+      CachedFile *cached_file = g_ptr_array_index (cached_files, i);
+
+      if (total_size + cached_file->size > max_size)
+        g_unlink (cached_file->path);
+      else
+        total_size += cached_file->size;
+    }
+
+  return total_size;
+}
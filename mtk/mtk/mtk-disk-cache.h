@@ -0,0 +1,31 @@
+/*
+ * Mtk
+ *
+ * A low-level base library.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdint.h>
+
+#include "mtk/mtk-macros.h"
+
+MTK_EXPORT
+goffset mtk_disk_cache_prune (const char *path,
+                              const char *suffix,
+                              goffset     max_size,
+                              int64_t     max_age_s);
@@ -23,6 +23,7 @@
 
 #define __MTK_H_INSIDE__
 
+#include "mtk/mtk-disk-cache.h"
 #include "mtk/mtk-rectangle.h"
 #include "mtk/mtk-region.h"
 #include "mtk/mtk-macros.h"
@@ -55,6 +55,7 @@
 #include "backends/meta-cursor-renderer.h"
 #include "backends/meta-cursor-tracker-private.h"
 #include "backends/meta-dbus-session-watcher.h"
+#include "backends/meta-frame-timings.h"
 #include "backends/meta-idle-manager.h"
 #include "backends/meta-idle-monitor-private.h"
 #include "backends/meta-input-capture.h"
@@ -134,6 +135,7 @@ struct _MetaBackendPrivate
   MetaCursorTracker *cursor_tracker;
   MetaInputMapper *input_mapper;
   MetaIdleManager *idle_manager;
+  MetaFrameTimings *frame_timings;
   MetaRenderer *renderer;
   MetaColorManager *color_manager;
 #ifdef HAVE_EGL
@@ -250,6 +252,7 @@ meta_backend_dispose (GObject *object)
   g_clear_pointer (&priv->default_seat, clutter_seat_destroy);
   g_clear_pointer (&priv->stage, clutter_actor_destroy);
   g_clear_pointer (&priv->idle_manager, meta_idle_manager_free);
+  g_clear_object (&priv->frame_timings);
   g_clear_object (&priv->renderer);
   g_clear_pointer (&priv->clutter_context, clutter_context_free);
   g_clear_list (&priv->gpus, g_object_unref);
@@ -549,6 +552,7 @@ meta_backend_real_post_init (MetaBackend *backend)
   meta_backend_sync_screen_size (backend);
 
   priv->idle_manager = meta_idle_manager_new (backend);
+  priv->frame_timings = meta_frame_timings_new (backend);
 
   g_signal_connect_object (seat, "device-added",
                            G_CALLBACK (on_device_added), backend, 0);
@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "backends/meta-frame-timings.h"
+
+#include "backends/meta-backend-private.h"
+#include "backends/meta-renderer.h"
+#include "clutter/clutter.h"
+#include "core/meta-context-private.h"
+
+#define META_FRAME_TIMINGS_DBUS_SERVICE "org.gnome.Mutter.FrameTimings"
+#define META_FRAME_TIMINGS_DBUS_PATH "/org/gnome/Mutter/FrameTimings"
+
+struct _MetaFrameTimings
+{
+  MetaDBusFrameTimingsSkeleton parent;
+
+  MetaBackend *backend;
+
+  guint dbus_name_id;
+};
+
+static void meta_frame_timings_init_iface (MetaDBusFrameTimingsIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (MetaFrameTimings, meta_frame_timings,
+                         META_DBUS_TYPE_FRAME_TIMINGS_SKELETON,
+                         G_IMPLEMENT_INTERFACE (META_DBUS_TYPE_FRAME_TIMINGS,
+                                                meta_frame_timings_init_iface))
+
+static const char *
+frame_timing_to_string (ClutterFrameTiming timing)
+{
+  switch (timing)
+    {
+    case CLUTTER_FRAME_TIMING_DISPATCH_LATENESS:
+      return "dispatch-lateness";
+    case CLUTTER_FRAME_TIMING_UPDATE_DURATION:
+      return "update-duration";
+    case CLUTTER_FRAME_TIMING_GPU_RENDER_TIME:
+      return "gpu-render-time";
+    case CLUTTER_FRAME_TIMING_PRESENTATION_DELTA:
+      return "presentation-delta";
+    case CLUTTER_FRAME_TIMING_MISSED_VBLANKS:
+      return "missed-vblanks";
+    case CLUTTER_N_FRAME_TIMINGS:
+      break;
+    }
+
+  g_assert_not_reached ();
+}
+
+static GVariant *
+serialize_frame_timing_stats (const ClutterFrameTimingStats *stats)
+{
+  GVariantBuilder stats_builder;
+  GVariantBuilder histogram_builder;
+  int i;
+
+  g_variant_builder_init (&histogram_builder, G_VARIANT_TYPE ("au"));
+  for (i = 0; i < CLUTTER_FRAME_TIMING_N_BUCKETS; i++)
+    g_variant_builder_add (&histogram_builder, "u", stats->buckets[i]);
+
+  g_variant_builder_init (&stats_builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "samples", g_variant_new_uint32 (stats->n_samples));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "min", g_variant_new_int64 (stats->min));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "max", g_variant_new_int64 (stats->max));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "mean", g_variant_new_int64 (stats->mean));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "p50", g_variant_new_int64 (stats->p50));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "p90", g_variant_new_int64 (stats->p90));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "p99", g_variant_new_int64 (stats->p99));
+  g_variant_builder_add (&stats_builder, "{sv}",
+                         "histogram",
+                         g_variant_builder_end (&histogram_builder));
+
+  return g_variant_builder_end (&stats_builder);
+}
+
+static GVariant *
+serialize_view (ClutterStageView *view)
+{
+  ClutterFrameClock *frame_clock = clutter_stage_view_get_frame_clock (view);
+  GVariantBuilder view_builder;
+  g_autofree char *name = NULL;
+  ClutterFrameTiming timing;
+
+  g_object_get (view, "name", &name, NULL);
+
+  g_variant_builder_init (&view_builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add (&view_builder, "{sv}",
+                         "name", g_variant_new_string (name ? name : ""));
+  g_variant_builder_add (&view_builder, "{sv}",
+                         "refresh-rate",
+                         g_variant_new_double (clutter_frame_clock_get_refresh_rate (frame_clock)));
+
+  for (timing = 0; timing < CLUTTER_N_FRAME_TIMINGS; timing++)
+    {
+      ClutterFrameTimingStats stats;
+
+      clutter_frame_clock_get_timing_stats (frame_clock, timing, &stats);
+      g_variant_builder_add (&view_builder, "{sv}",
+                             frame_timing_to_string (timing),
+                             serialize_frame_timing_stats (&stats));
+    }
+
+  return g_variant_builder_end (&view_builder);
+}
+
+static gboolean
+handle_get_frame_timings (MetaDBusFrameTimings  *skeleton,
+                          GDBusMethodInvocation *invocation)
+{
+  MetaFrameTimings *frame_timings = META_FRAME_TIMINGS (skeleton);
+  MetaRenderer *renderer = meta_backend_get_renderer (frame_timings->backend);
+  GVariantBuilder views_builder;
+  GList *l;
+
+  g_variant_builder_init (&views_builder, G_VARIANT_TYPE ("aa{sv}"));
+  for (l = meta_renderer_get_views (renderer); l; l = l->next)
+    g_variant_builder_add_value (&views_builder, serialize_view (l->data));
+
+  meta_dbus_frame_timings_complete_get_frame_timings (
+    skeleton, invocation, g_variant_builder_end (&views_builder));
+
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static gboolean
+handle_reset (MetaDBusFrameTimings  *skeleton,
+              GDBusMethodInvocation *invocation)
+{
+  MetaFrameTimings *frame_timings = META_FRAME_TIMINGS (skeleton);
+  MetaContext *context = meta_backend_get_context (frame_timings->backend);
+  MetaRenderer *renderer = meta_backend_get_renderer (frame_timings->backend);
+  GList *l;
+
+  if (!meta_context_get_unsafe_mode (context))
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                             G_DBUS_ERROR_ACCESS_DENIED,
+                                             "Resetting frame timings is "
+                                             "only allowed in unsafe mode");
+      return G_DBUS_METHOD_INVOCATION_HANDLED;
+    }
+
+  for (l = meta_renderer_get_views (renderer); l; l = l->next)
+    {
+      ClutterStageView *view = l->data;
+
+      clutter_frame_clock_reset_timing_stats (
+        clutter_stage_view_get_frame_clock (view));
+    }
+
+  meta_dbus_frame_timings_complete_reset (skeleton, invocation);
+
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static void
+meta_frame_timings_init_iface (MetaDBusFrameTimingsIface *iface)
+{
+  iface->handle_get_frame_timings = handle_get_frame_timings;
+  iface->handle_reset = handle_reset;
+}
+
+static void
+on_bus_acquired (GDBusConnection *connection,
+                 const char      *name,
+                 gpointer         user_data)
+{
+  MetaFrameTimings *frame_timings = user_data;
+  GDBusInterfaceSkeleton *interface_skeleton =
+    G_DBUS_INTERFACE_SKELETON (frame_timings);
+  g_autoptr (GError) error = NULL;
+
+  if (!g_dbus_interface_skeleton_export (interface_skeleton,
+                                         connection,
+                                         META_FRAME_TIMINGS_DBUS_PATH,
+                                         &error))
+    g_warning ("Failed to export frame timings object: %s", error->message);
+}
+
+static void
+on_name_acquired (GDBusConnection *connection,
+                  const char      *name,
+                  gpointer         user_data)
+{
+  g_info ("Acquired name %s", name);
+}
+
+static void
+on_name_lost (GDBusConnection *connection,
+              const char      *name,
+              gpointer         user_data)
+{
+  g_info ("Lost or failed to acquire name %s", name);
+}
+
+static void
+meta_frame_timings_finalize (GObject *object)
+{
+  MetaFrameTimings *frame_timings = META_FRAME_TIMINGS (object);
+
+  g_clear_handle_id (&frame_timings->dbus_name_id, g_bus_unown_name);
+
+  G_OBJECT_CLASS (meta_frame_timings_parent_class)->finalize (object);
+}
+
+static void
+meta_frame_timings_class_init (MetaFrameTimingsClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_frame_timings_finalize;
+}
+
+static void
+meta_frame_timings_init (MetaFrameTimings *frame_timings)
+{
+}
+
+MetaFrameTimings *
+meta_frame_timings_new (MetaBackend *backend)
+{
+  MetaFrameTimings *frame_timings;
+
+  frame_timings = g_object_new (META_TYPE_FRAME_TIMINGS, NULL);
+  frame_timings->backend = backend;
+
+  frame_timings->dbus_name_id =
+    g_bus_own_name (G_BUS_TYPE_SESSION,
+                    META_FRAME_TIMINGS_DBUS_SERVICE,
+                    G_BUS_NAME_OWNER_FLAGS_NONE,
+                    on_bus_acquired,
+                    on_name_acquired,
+                    on_name_lost,
+                    frame_timings,
+                    NULL);
+
+  return frame_timings;
+}
@@ -143,6 +143,7 @@ typedef struct _MetaOutputInfo
 
   gboolean supports_underscanning;
   gboolean supports_color_transform;
+  gboolean supports_vrr;
 
   unsigned int max_bpc_min;
   unsigned int max_bpc_max;
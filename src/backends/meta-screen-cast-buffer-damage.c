@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "backends/meta-screen-cast-buffer-damage.h"
+
+struct _MetaScreenCastBufferDamage
+{
+  /* Damaged region of each buffer, keyed by its fd. Buffers that were
+   * never filled have no entry.
+   */
+  GHashTable *regions;
+};
+
+MetaScreenCastBufferDamage *
+meta_screen_cast_buffer_damage_new (void)
+{
+  MetaScreenCastBufferDamage *buffer_damage;
+
+  buffer_damage = g_new0 (MetaScreenCastBufferDamage, 1);
+  buffer_damage->regions =
+    g_hash_table_new_full (NULL, NULL, NULL,
+                           (GDestroyNotify) mtk_region_unref);
+
+  return buffer_damage;
+}
+
+void
+meta_screen_cast_buffer_damage_free (MetaScreenCastBufferDamage *buffer_damage)
+{
+  g_hash_table_destroy (buffer_damage->regions);
+  g_free (buffer_damage);
+}
+
+/*
+ * Adds damage to every buffer that was filled before. A NULL damage region
+ * means the damage is unknown, i.e. a full repaint, which drops the
+ * accumulated damage so that every buffer is fully filled the next time it
+ * is used.
+ */
+void
+meta_screen_cast_buffer_damage_add (MetaScreenCastBufferDamage *buffer_damage,
+                                    const MtkRegion            *damage)
+{
+  GHashTableIter iter;
+  MtkRegion *region;
+
+  if (!damage)
+    {
+      g_hash_table_remove_all (buffer_damage->regions);
+      return;
+    }
+
+  g_hash_table_iter_init (&iter, buffer_damage->regions);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &region))
+    mtk_region_union (region, damage);
+}
+
+/*
+ * Returns the region of the buffer that changed since it was last filled,
+ * or NULL if it has to be filled completely.
+ */
+MtkRegion *
+meta_screen_cast_buffer_damage_get (MetaScreenCastBufferDamage *buffer_damage,
+                                    int                         fd)
+{
+  return g_hash_table_lookup (buffer_damage->regions, GINT_TO_POINTER (fd));
+}
+
+void
+meta_screen_cast_buffer_damage_mark_filled (MetaScreenCastBufferDamage *buffer_damage,
+                                            int                         fd)
+{
+  g_hash_table_insert (buffer_damage->regions,
+                       GINT_TO_POINTER (fd),
+                       mtk_region_create ());
+}
+
+void
+meta_screen_cast_buffer_damage_forget (MetaScreenCastBufferDamage *buffer_damage,
+                                       int                         fd)
+{
+  g_hash_table_remove (buffer_damage->regions, GINT_TO_POINTER (fd));
+}
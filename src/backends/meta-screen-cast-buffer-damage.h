@@ -0,0 +1,57 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "core/util-private.h"
+#include "mtk/mtk.h"
+
+G_BEGIN_DECLS
+
+/*
+ * MetaScreenCastBufferDamage:
+ *
+ * Tracks the region of each DMA buffer of a stream that changed since the
+ * buffer was last filled, so that only that region needs to be recorded
+ * the next time it is dequeued. Buffers are identified by their fd.
+ */
+typedef struct _MetaScreenCastBufferDamage MetaScreenCastBufferDamage;
+
+META_EXPORT_TEST
+MetaScreenCastBufferDamage * meta_screen_cast_buffer_damage_new (void);
+
+META_EXPORT_TEST
+void meta_screen_cast_buffer_damage_free (MetaScreenCastBufferDamage *buffer_damage);
+
+META_EXPORT_TEST
+void meta_screen_cast_buffer_damage_add (MetaScreenCastBufferDamage *buffer_damage,
+                                         const MtkRegion            *damage);
+
+META_EXPORT_TEST
+MtkRegion * meta_screen_cast_buffer_damage_get (MetaScreenCastBufferDamage *buffer_damage,
+                                                int                         fd);
+
+META_EXPORT_TEST
+void meta_screen_cast_buffer_damage_mark_filled (MetaScreenCastBufferDamage *buffer_damage,
+                                                 int                         fd);
+
+META_EXPORT_TEST
+void meta_screen_cast_buffer_damage_forget (MetaScreenCastBufferDamage *buffer_damage,
+                                            int                         fd);
+
+G_END_DECLS
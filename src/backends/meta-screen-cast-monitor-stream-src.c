@@ -130,6 +130,94 @@ meta_screen_cast_monitor_stream_src_get_specs (MetaScreenCastStreamSrc *src,
   return TRUE;
 }
 
+static float
+get_view_scale (MetaScreenCastMonitorStreamSrc *monitor_src)
+{
+  MetaBackend *backend = get_backend (monitor_src);
+  MetaMonitor *monitor = get_monitor (monitor_src);
+  MetaLogicalMonitor *logical_monitor =
+    meta_monitor_get_logical_monitor (monitor);
+
+  if (meta_backend_is_stage_views_scaled (backend))
+    return meta_logical_monitor_get_scale (logical_monitor);
+  else
+    return 1.0;
+}
+
+/*
+ * Translates a stage space redraw clip into the damaged region of the
+ * stream, or the whole stream if @redraw_clip is NULL.
+ */
+static MtkRegion *
+get_stream_damage (MetaScreenCastMonitorStreamSrc *monitor_src,
+                   const MtkRegion                *redraw_clip)
+{
+  MetaMonitor *monitor;
+  MetaLogicalMonitor *logical_monitor;
+  MtkRectangle logical_monitor_layout;
+  MtkRectangle stream_rect;
+  MtkRegion *damage;
+  float scale;
+  int n_rects;
+  int i;
+
+  monitor = get_monitor (monitor_src);
+  logical_monitor = meta_monitor_get_logical_monitor (monitor);
+  logical_monitor_layout = meta_logical_monitor_get_layout (logical_monitor);
+  scale = get_view_scale (monitor_src);
+
+  stream_rect = (MtkRectangle) {
+    .width = (int) roundf (logical_monitor_layout.width * scale),
+    .height = (int) roundf (logical_monitor_layout.height * scale),
+  };
+
+  if (!redraw_clip)
+    return mtk_region_create_rectangle (&stream_rect);
+
+  damage = mtk_region_create ();
+
+  n_rects = mtk_region_num_rectangles (redraw_clip);
+  for (i = 0; i < n_rects; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (redraw_clip, i);
+      MtkRectangle stream_damage;
+      int x1, y1, x2, y2;
+
+      if (!mtk_rectangle_intersect (&rect, &logical_monitor_layout, &rect))
+        continue;
+
+      x1 = (int) floorf ((rect.x - logical_monitor_layout.x) * scale);
+      y1 = (int) floorf ((rect.y - logical_monitor_layout.y) * scale);
+      x2 = (int) ceilf ((rect.x + rect.width - logical_monitor_layout.x) *
+                        scale);
+      y2 = (int) ceilf ((rect.y + rect.height - logical_monitor_layout.y) *
+                        scale);
+
+      stream_damage = (MtkRectangle) {
+        .x = x1,
+        .y = y1,
+        .width = x2 - x1,
+        .height = y2 - y1,
+      };
+      mtk_region_union_rectangle (damage, &stream_damage);
+    }
+
+  mtk_region_intersect_rectangle (damage, &stream_rect);
+
+  return damage;
+}
+
+static void
+add_stream_damage (MetaScreenCastMonitorStreamSrc *monitor_src,
+                   const MtkRegion                *redraw_clip)
+{
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (monitor_src);
+  g_autoptr (MtkRegion) damage = NULL;
+
+  damage = get_stream_damage (monitor_src, redraw_clip);
+  meta_screen_cast_stream_src_add_damage (src, damage);
+}
+
 static gboolean
 maybe_record_frame_on_idle (gpointer user_data)
 {
@@ -160,6 +248,8 @@ stage_painted (MetaStage        *stage,
     META_SCREEN_CAST_RECORD_RESULT_RECORDED_NOTHING;
   int64_t presentation_time_us;
 
+  add_stream_damage (monitor_src, redraw_clip);
+
   if (monitor_src->maybe_record_idle_id)
     return;
 
@@ -177,7 +267,8 @@ stage_painted (MetaStage        *stage,
                                                                        presentation_time_us);
     }
 
-  if (!(record_result & META_SCREEN_CAST_RECORD_RESULT_RECORDED_FRAME))
+  if (!(record_result & (META_SCREEN_CAST_RECORD_RESULT_RECORDED_FRAME |
+                         META_SCREEN_CAST_RECORD_RESULT_FRAME_UNCHANGED)))
     {
       monitor_src->maybe_record_idle_id = g_idle_add (maybe_record_frame_on_idle,
                                                       src);
@@ -199,13 +290,16 @@ before_stage_painted (MetaStage        *stage,
   MetaScreenCastRecordFlag flags;
   int64_t presentation_time_us;
 
-  if (monitor_src->maybe_record_idle_id)
+  if (!clutter_stage_view_peek_scanout (view))
     return;
 
-  if (!meta_screen_cast_stream_src_uses_dma_bufs (src))
+  /* Nothing is painted when scanning out, so no damage will be known */
+  add_stream_damage (monitor_src, NULL);
+
+  if (monitor_src->maybe_record_idle_id)
     return;
 
-  if (!clutter_stage_view_peek_scanout (view))
+  if (!meta_screen_cast_stream_src_uses_dma_bufs (src))
     return;
 
   if (!clutter_frame_get_target_presentation_time (frame, &presentation_time_us))
@@ -434,6 +528,7 @@ on_monitors_changed (MetaMonitorManager             *monitor_manager,
                      MetaScreenCastMonitorStreamSrc *monitor_src)
 {
   reattach_watches (monitor_src);
+  add_stream_damage (monitor_src, NULL);
 }
 
 static void
@@ -578,15 +673,13 @@ meta_screen_cast_monitor_stream_src_record_to_buffer (MetaScreenCastStreamSrc  *
   return TRUE;
 }
 
-static gboolean
-meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc  *src,
-                                                           CoglFramebuffer          *framebuffer,
-                                                           GError                  **error)
+static void
+paint_to_framebuffer (MetaScreenCastMonitorStreamSrc *monitor_src,
+                      CoglFramebuffer                *framebuffer,
+                      const MtkRegion                *region)
 {
-  MetaScreenCastMonitorStreamSrc *monitor_src =
-    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+  MetaScreenCastStreamSrc *src = META_SCREEN_CAST_STREAM_SRC (monitor_src);
   MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
-  MetaBackend *backend = get_backend (monitor_src);
   ClutterStage *stage = get_stage (monitor_src);
   MetaMonitor *monitor;
   MetaLogicalMonitor *logical_monitor;
@@ -597,11 +690,7 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
   monitor = get_monitor (monitor_src);
   logical_monitor = meta_monitor_get_logical_monitor (monitor);
   logical_monitor_layout = meta_logical_monitor_get_layout (logical_monitor);
-
-  if (meta_backend_is_stage_views_scaled (backend))
-    view_scale = meta_logical_monitor_get_scale (logical_monitor);
-  else
-    view_scale = 1.0;
+  view_scale = get_view_scale (monitor_src);
 
   switch (meta_screen_cast_stream_get_cursor_mode (stream))
     {
@@ -614,13 +703,50 @@ meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamS
       break;
     }
 
-  clutter_stage_paint_to_framebuffer (stage,
-                                      framebuffer,
-                                      &logical_monitor_layout,
-                                      view_scale,
-                                      paint_flags);
+  if (region)
+    {
+      clutter_stage_paint_region_to_framebuffer (stage,
+                                                 framebuffer,
+                                                 &logical_monitor_layout,
+                                                 view_scale,
+                                                 region,
+                                                 paint_flags);
+    }
+  else
+    {
+      clutter_stage_paint_to_framebuffer (stage,
+                                          framebuffer,
+                                          &logical_monitor_layout,
+                                          view_scale,
+                                          paint_flags);
+    }
 
   cogl_framebuffer_flush (framebuffer);
+}
+
+static gboolean
+meta_screen_cast_monitor_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc  *src,
+                                                           CoglFramebuffer          *framebuffer,
+                                                           GError                  **error)
+{
+  MetaScreenCastMonitorStreamSrc *monitor_src =
+    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+
+  paint_to_framebuffer (monitor_src, framebuffer, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+meta_screen_cast_monitor_stream_src_record_region_to_framebuffer (MetaScreenCastStreamSrc  *src,
+                                                                  CoglFramebuffer          *framebuffer,
+                                                                  const MtkRegion          *region,
+                                                                  GError                  **error)
+{
+  MetaScreenCastMonitorStreamSrc *monitor_src =
+    META_SCREEN_CAST_MONITOR_STREAM_SRC (src);
+
+  paint_to_framebuffer (monitor_src, framebuffer, region);
 
   return TRUE;
 }
@@ -795,6 +921,8 @@ meta_screen_cast_monitor_stream_src_class_init (MetaScreenCastMonitorStreamSrcCl
     meta_screen_cast_monitor_stream_src_record_to_buffer;
   src_class->record_to_framebuffer =
     meta_screen_cast_monitor_stream_src_record_to_framebuffer;
+  src_class->record_region_to_framebuffer =
+    meta_screen_cast_monitor_stream_src_record_region_to_framebuffer;
   src_class->record_follow_up =
     meta_screen_cast_monitor_stream_record_follow_up;
   src_class->set_cursor_metadata =
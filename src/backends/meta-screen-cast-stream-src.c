@@ -36,9 +36,11 @@
 #include <drm_fourcc.h>
 #endif
 
+#include "backends/meta-screen-cast-buffer-damage.h"
 #include "backends/meta-screen-cast-session.h"
 #include "backends/meta-screen-cast-stream.h"
 #include "clutter/clutter-mutter.h"
+#include "compositor/meta-multi-texture-format-private.h"
 #include "core/meta-fraction.h"
 #include "meta/boxes.h"
 
@@ -60,6 +62,11 @@
 
 #define DEFAULT_COGL_PIXEL_FORMAT COGL_PIXEL_FORMAT_BGRX_8888
 
+/* Number of consecutive cursor-only frames before halving their rate, and
+ * the rate they are never lowered below so that the pointer stays smooth */
+#define N_STATIC_FRAMES_PER_STEP 30
+#define MIN_CURSOR_FRAME_RATE 30.0
+
 enum
 {
   PROP_0,
@@ -105,6 +112,13 @@ typedef struct _MetaScreenCastStreamSrcPrivate
 
   int64_t last_frame_timestamp_us;
   guint follow_up_frame_source_id;
+  int64_t follow_up_frame_time_us;
+
+  /* The maximum frame rate is divided by this while content is static */
+  int frame_rate_divisor;
+  int n_static_frames;
+
+  MetaScreenCastStreamStats stats;
 
   int buffer_count;
   gboolean needs_follow_up_with_buffers;
@@ -112,7 +126,19 @@ typedef struct _MetaScreenCastStreamSrcPrivate
   gboolean uses_dma_bufs;
   GHashTable *dmabuf_handles;
 
+  MetaScreenCastBufferDamage *dmabuf_damage;
+
   MtkRegion *redraw_clip;
+
+  /* Set when a YUV format was negotiated, in which case frames are recorded
+   * into an intermediate RGB frame and converted into the DMA buffers.
+   */
+  MetaMultiTextureFormat yuv_format;
+  CoglOffscreen *yuv_frame;
+  gboolean is_yuv_frame_valid;
+  CoglPipeline *yuv_pipeline;
+  gboolean is_yuv_unsupported;
+  guint renegotiate_source_id;
 } MetaScreenCastStreamSrcPrivate;
 
 static const struct {
@@ -123,6 +149,17 @@ static const struct {
   { COGL_PIXEL_FORMAT_BGRA_8888_PRE, SPA_VIDEO_FORMAT_BGRA },
 };
 
+static const struct {
+  MetaMultiTextureFormat multi_format;
+  enum spa_video_format spa_video_format;
+} supported_yuv_formats[] = {
+  { META_MULTI_TEXTURE_FORMAT_NV12, SPA_VIDEO_FORMAT_NV12 },
+  { META_MULTI_TEXTURE_FORMAT_YUV420, SPA_VIDEO_FORMAT_I420 },
+};
+
+/* Two RGB formats, each with and without a modifier, and the YUV formats */
+#define MAX_FORMAT_PARAMS (4 + G_N_ELEMENTS (supported_yuv_formats))
+
 static gboolean
 spa_video_format_from_cogl_pixel_format (CoglPixelFormat        cogl_format,
                                          enum spa_video_format *out_spa_format)
@@ -161,6 +198,20 @@ cogl_pixel_format_from_spa_video_format (enum spa_video_format  spa_format,
   return FALSE;
 }
 
+static MetaMultiTextureFormat
+multi_texture_format_from_spa_video_format (enum spa_video_format spa_format)
+{
+  size_t i;
+
+  for (i = 0; i < G_N_ELEMENTS (supported_yuv_formats); i++)
+    {
+      if (supported_yuv_formats[i].spa_video_format == spa_format)
+        return supported_yuv_formats[i].multi_format;
+    }
+
+  return META_MULTI_TEXTURE_FORMAT_INVALID;
+}
+
 static struct spa_pod *
 push_format_object (struct spa_pod_builder *pod_builder,
                     enum spa_video_format   format,
@@ -276,6 +327,18 @@ meta_screen_cast_stream_src_record_to_framebuffer (MetaScreenCastStreamSrc  *src
   return klass->record_to_framebuffer (src, framebuffer, error);
 }
 
+static gboolean
+meta_screen_cast_stream_src_record_region_to_framebuffer (MetaScreenCastStreamSrc  *src,
+                                                          CoglFramebuffer          *framebuffer,
+                                                          const MtkRegion          *region,
+                                                          GError                  **error)
+{
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+
+  return klass->record_region_to_framebuffer (src, framebuffer, region, error);
+}
+
 static void
 meta_screen_cast_stream_src_record_follow_up (MetaScreenCastStreamSrc *src)
 {
@@ -579,6 +642,264 @@ meta_screen_cast_stream_src_calculate_stride (MetaScreenCastStreamSrc *src,
   return SPA_ROUND_UP_N (priv->video_format.size.width * bpp, 4);
 }
 
+static void
+update_chunks (MetaScreenCastStreamSrc *src,
+               struct spa_buffer       *spa_buffer)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  struct spa_data *spa_data = &spa_buffer->datas[0];
+  int plane_offsets[COGL_PIXEL_FORMAT_MAX_PLANES];
+  int plane_strides[COGL_PIXEL_FORMAT_MAX_PLANES];
+  int packed_width;
+  int packed_height;
+  int stride;
+  uint32_t i;
+
+  stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
+
+  if (priv->yuv_format == META_MULTI_TEXTURE_FORMAT_INVALID)
+    {
+      spa_data->chunk->size = spa_data->maxsize;
+      spa_data->chunk->stride = stride;
+      spa_data->chunk->flags = SPA_CHUNK_FLAG_NONE;
+      return;
+    }
+
+  /* All planes live in the same buffer, one after the other */
+  meta_multi_texture_format_get_packed_layout (priv->yuv_format,
+                                               priv->video_format.size.width,
+                                               priv->video_format.size.height,
+                                               &packed_width,
+                                               &packed_height,
+                                               plane_offsets,
+                                               plane_strides);
+
+  for (i = 0; i < spa_buffer->n_datas; i++)
+    {
+      struct spa_chunk *chunk = spa_buffer->datas[i].chunk;
+      int end_offset;
+
+      if (i + 1 < spa_buffer->n_datas)
+        end_offset = plane_offsets[i + 1];
+      else
+        end_offset = packed_height * packed_width;
+
+      chunk->offset = plane_offsets[i];
+      chunk->size = end_offset - plane_offsets[i];
+      chunk->stride = plane_strides[i];
+      chunk->flags = SPA_CHUNK_FLAG_NONE;
+    }
+}
+
+static gboolean
+record_to_dma_buf (MetaScreenCastStreamSrc  *src,
+                   int                       fd,
+                   CoglFramebuffer          *dmabuf_fbo,
+                   GError                  **error)
+{
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MtkRegion *buffer_damage;
+
+  if (!klass->record_region_to_framebuffer)
+    {
+      return meta_screen_cast_stream_src_record_to_framebuffer (src,
+                                                                dmabuf_fbo,
+                                                                error);
+    }
+
+  meta_screen_cast_buffer_damage_add (priv->dmabuf_damage, priv->redraw_clip);
+
+  buffer_damage = meta_screen_cast_buffer_damage_get (priv->dmabuf_damage, fd);
+  if (buffer_damage)
+    {
+      meta_topic (META_DEBUG_SCREEN_CAST,
+                  "Updating %d damaged rectangles of DMA buffer %d "
+                  "on stream %u",
+                  mtk_region_num_rectangles (buffer_damage), fd,
+                  priv->node_id);
+
+      if (!mtk_region_is_empty (buffer_damage) &&
+          !meta_screen_cast_stream_src_record_region_to_framebuffer (src,
+                                                                     dmabuf_fbo,
+                                                                     buffer_damage,
+                                                                     error))
+        {
+          meta_screen_cast_buffer_damage_forget (priv->dmabuf_damage, fd);
+          return FALSE;
+        }
+    }
+  else
+    {
+      if (!meta_screen_cast_stream_src_record_to_framebuffer (src,
+                                                              dmabuf_fbo,
+                                                              error))
+        return FALSE;
+    }
+
+  meta_screen_cast_buffer_damage_mark_filled (priv->dmabuf_damage, fd);
+
+  return TRUE;
+}
+
+static gboolean
+ensure_yuv_frame (MetaScreenCastStreamSrc  *src,
+                  GError                  **error)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
+  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
+  MetaScreenCast *screen_cast =
+    meta_screen_cast_session_get_screen_cast (session);
+  MetaBackend *backend = meta_screen_cast_get_backend (screen_cast);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  g_autoptr (CoglSnippet) globals_snippet = NULL;
+  g_autoptr (CoglSnippet) fragment_snippet = NULL;
+  CoglTexture *texture;
+  CoglOffscreen *offscreen;
+  CoglPipeline *pipeline;
+
+  if (priv->yuv_frame)
+    return TRUE;
+
+  texture = cogl_texture_2d_new_with_size (cogl_context,
+                                           priv->video_format.size.width,
+                                           priv->video_format.size.height);
+  cogl_primitive_texture_set_auto_mipmap (texture, FALSE);
+  if (!cogl_texture_allocate (texture, error))
+    {
+      g_object_unref (texture);
+      return FALSE;
+    }
+
+  offscreen = cogl_offscreen_new_with_texture (texture);
+  if (!cogl_framebuffer_allocate (COGL_FRAMEBUFFER (offscreen), error))
+    {
+      g_object_unref (offscreen);
+      g_object_unref (texture);
+      return FALSE;
+    }
+
+  pipeline = cogl_pipeline_new (cogl_context);
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_LINEAR,
+                                   COGL_PIPELINE_FILTER_LINEAR);
+  cogl_pipeline_set_layer_wrap_mode (pipeline, 0,
+                                     COGL_PIPELINE_WRAP_MODE_CLAMP_TO_EDGE);
+
+  meta_multi_texture_format_get_packed_snippets (priv->yuv_format,
+                                                 &globals_snippet,
+                                                 &fragment_snippet);
+  cogl_pipeline_add_snippet (pipeline, globals_snippet);
+  cogl_pipeline_add_snippet (pipeline, fragment_snippet);
+
+  g_object_unref (texture);
+
+  priv->yuv_frame = offscreen;
+  priv->yuv_pipeline = pipeline;
+  priv->is_yuv_frame_valid = FALSE;
+
+  return TRUE;
+}
+
+static void
+clear_yuv_frame (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  g_clear_object (&priv->yuv_frame);
+  g_clear_object (&priv->yuv_pipeline);
+  priv->is_yuv_frame_valid = FALSE;
+}
+
+static gboolean
+record_yuv_to_dma_buf (MetaScreenCastStreamSrc  *src,
+                       CoglFramebuffer          *dmabuf_fbo,
+                       GError                  **error)
+{
+  MetaScreenCastStreamSrcClass *klass =
+    META_SCREEN_CAST_STREAM_SRC_GET_CLASS (src);
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  CoglFramebuffer *frame_fb;
+  int packed_width;
+  int packed_height;
+  float frame_size[2];
+  float packed_size[2];
+  graphene_matrix_t projection;
+  gboolean recorded;
+
+  if (!ensure_yuv_frame (src, error))
+    return FALSE;
+
+  frame_fb = COGL_FRAMEBUFFER (priv->yuv_frame);
+
+  /* The RGB frame is shared by all buffers, so it only lacks the damage
+   * since the previous frame.
+   */
+  if (priv->is_yuv_frame_valid &&
+      priv->redraw_clip &&
+      klass->record_region_to_framebuffer)
+    {
+      recorded =
+        mtk_region_is_empty (priv->redraw_clip) ||
+        meta_screen_cast_stream_src_record_region_to_framebuffer (src,
+                                                                  frame_fb,
+                                                                  priv->redraw_clip,
+                                                                  error);
+    }
+  else
+    {
+      recorded = meta_screen_cast_stream_src_record_to_framebuffer (src,
+                                                                    frame_fb,
+                                                                    error);
+    }
+
+  priv->is_yuv_frame_valid = recorded;
+  if (!recorded)
+    return FALSE;
+
+  packed_width = cogl_framebuffer_get_width (dmabuf_fbo);
+  packed_height = cogl_framebuffer_get_height (dmabuf_fbo);
+
+  frame_size[0] = cogl_framebuffer_get_width (frame_fb);
+  frame_size[1] = cogl_framebuffer_get_height (frame_fb);
+  packed_size[0] = packed_width;
+  packed_size[1] = packed_height;
+
+  cogl_pipeline_set_uniform_float (priv->yuv_pipeline,
+                                   cogl_pipeline_get_uniform_location (priv->yuv_pipeline,
+                                                                       "frame_size"),
+                                   2, 1, frame_size);
+  cogl_pipeline_set_uniform_float (priv->yuv_pipeline,
+                                   cogl_pipeline_get_uniform_location (priv->yuv_pipeline,
+                                                                       "packed_size"),
+                                   2, 1, packed_size);
+
+  graphene_matrix_init_identity (&projection);
+
+  cogl_framebuffer_push_matrix (dmabuf_fbo);
+  cogl_framebuffer_identity_matrix (dmabuf_fbo);
+  cogl_framebuffer_set_projection_matrix (dmabuf_fbo, &projection);
+  cogl_framebuffer_set_viewport (dmabuf_fbo,
+                                 0, 0, packed_width, packed_height);
+  cogl_framebuffer_draw_rectangle (dmabuf_fbo, priv->yuv_pipeline,
+                                   -1, 1, 1, -1);
+  cogl_framebuffer_pop_matrix (dmabuf_fbo);
+
+  cogl_framebuffer_flush (dmabuf_fbo);
+
+  return TRUE;
+}
+
 static gboolean
 do_record_frame (MetaScreenCastStreamSrc   *src,
                  MetaScreenCastRecordFlag   flags,
@@ -610,9 +931,10 @@ do_record_frame (MetaScreenCastStreamSrc   *src,
       CoglFramebuffer *dmabuf_fbo =
         cogl_dma_buf_handle_get_framebuffer (dmabuf_handle);
 
-      return meta_screen_cast_stream_src_record_to_framebuffer (src,
-                                                                dmabuf_fbo,
-                                                                error);
+      if (priv->yuv_format != META_MULTI_TEXTURE_FORMAT_INVALID)
+        return record_yuv_to_dma_buf (src, dmabuf_fbo, error);
+
+      return record_to_dma_buf (src, spa_data->fd, dmabuf_fbo, error);
     }
 
   g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -649,14 +971,97 @@ maybe_schedule_follow_up_frame (MetaScreenCastStreamSrc *src,
   MetaScreenCastStreamSrcPrivate *priv =
     meta_screen_cast_stream_src_get_instance_private (src);
 
+  int64_t follow_up_frame_time_us;
+
+  follow_up_frame_time_us = g_get_monotonic_time () + timeout_us;
+
+  /* A pending follow up for a throttled cursor-only frame must not delay
+   * content that can be recorded earlier */
   if (priv->follow_up_frame_source_id)
-    return;
+    {
+      if (priv->follow_up_frame_time_us <= follow_up_frame_time_us)
+        return;
 
+      g_clear_handle_id (&priv->follow_up_frame_source_id, g_source_remove);
+    }
+
+  priv->follow_up_frame_time_us = follow_up_frame_time_us;
   priv->follow_up_frame_source_id = g_timeout_add (us2ms (timeout_us),
                                                    follow_up_frame_cb,
                                                    src);
 }
 
+static double
+get_max_frame_rate (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  if (priv->video_format.max_framerate.denom == 0)
+    return 0.0;
+
+  return ((double) priv->video_format.max_framerate.num /
+          (double) priv->video_format.max_framerate.denom);
+}
+
+/*
+ * Lowers the rate of frames not changing any content, i.e. those only
+ * carrying cursor metadata, in steps while nothing but the cursor changes,
+ * down to MIN_CURSOR_FRAME_RATE, and restores it as soon as a frame with
+ * damaged content is recorded.
+ * Frames changing content, however little, are never throttled by this.
+ */
+static void
+update_frame_rate_governor (MetaScreenCastStreamSrc *src,
+                            gboolean                 is_content_frame)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  double max_frame_rate;
+
+  if (is_content_frame)
+    {
+      if (priv->frame_rate_divisor > 1)
+        {
+          meta_topic (META_DEBUG_SCREEN_CAST,
+                      "Restoring full frame rate on stream %u",
+                      priv->node_id);
+        }
+
+      priv->frame_rate_divisor = 1;
+      priv->n_static_frames = 0;
+      return;
+    }
+
+  if (++priv->n_static_frames < N_STATIC_FRAMES_PER_STEP)
+    return;
+
+  priv->n_static_frames = 0;
+
+  max_frame_rate = get_max_frame_rate (src);
+  if (max_frame_rate / (priv->frame_rate_divisor * 2) <
+      MIN_CURSOR_FRAME_RATE)
+    return;
+
+  priv->frame_rate_divisor *= 2;
+
+  meta_topic (META_DEBUG_SCREEN_CAST,
+              "Content is static, lowering cursor-only frame rate of stream "
+              "%u to %.1f",
+              priv->node_id, max_frame_rate / priv->frame_rate_divisor);
+}
+
+void
+meta_screen_cast_stream_src_get_stats (MetaScreenCastStreamSrc   *src,
+                                       MetaScreenCastStreamStats *stats)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  *stats = priv->stats;
+  stats->frame_rate = get_max_frame_rate (src) / priv->frame_rate_divisor;
+}
+
 static void
 maybe_add_damaged_regions_metadata (MetaScreenCastStreamSrc *src,
                                     struct spa_buffer       *spa_buffer)
@@ -723,8 +1128,24 @@ maybe_add_damaged_regions_metadata (MetaScreenCastStreamSrc *src,
           }
         }
     }
+}
 
-  g_clear_pointer (&priv->redraw_clip, mtk_region_unref);
+/*
+ * Damage, in stream coordinates, that is to be reported with the next
+ * recorded frame. Sources passing a redraw clip when recording must also
+ * add the damage of changes that did not lead to a recording attempt.
+ */
+void
+meta_screen_cast_stream_src_add_damage (MetaScreenCastStreamSrc *src,
+                                        const MtkRegion         *damage)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  if (priv->redraw_clip)
+    mtk_region_union (priv->redraw_clip, damage);
+  else
+    priv->redraw_clip = mtk_region_copy (damage);
 }
 
 MetaScreenCastRecordResult
@@ -760,12 +1181,7 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
    * eventually but once we do, we should report all the previous damaged areas.
    */
   if (redraw_clip)
-    {
-      if (priv->redraw_clip)
-        mtk_region_union (priv->redraw_clip, redraw_clip);
-      else
-        priv->redraw_clip = mtk_region_copy (redraw_clip);
-    }
+    meta_screen_cast_stream_src_add_damage (src, redraw_clip);
 
   if (priv->buffer_count == 0)
     {
@@ -778,6 +1194,35 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       return record_result;
     }
 
+  /* Nothing changed since the last frame, so at most the cursor needs to
+   * be updated, without touching any framebuffer.
+   */
+  if (!(flags & META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY) &&
+      priv->redraw_clip &&
+      mtk_region_is_empty (priv->redraw_clip))
+    {
+      MetaScreenCastStream *stream =
+        meta_screen_cast_stream_src_get_stream (src);
+
+      record_result |= META_SCREEN_CAST_RECORD_RESULT_FRAME_UNCHANGED;
+
+      if (meta_screen_cast_stream_get_cursor_mode (stream) !=
+          META_SCREEN_CAST_CURSOR_MODE_METADATA)
+        {
+          meta_topic (META_DEBUG_SCREEN_CAST,
+                      "Skipped recording undamaged frame on stream %u",
+                      priv->node_id);
+          priv->stats.n_unchanged_frames++;
+          return record_result;
+        }
+
+      flags |= META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY;
+    }
+
+  /* Changed content is never held back by a lowered frame rate */
+  if (!(flags & META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY))
+    update_frame_rate_governor (src, TRUE);
+
   if (priv->video_format.max_framerate.num > 0 &&
       priv->last_frame_timestamp_us != 0)
     {
@@ -788,6 +1233,9 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
         ((G_USEC_PER_SEC * ((int64_t) priv->video_format.max_framerate.denom)) /
          ((int64_t) priv->video_format.max_framerate.num));
 
+      if (flags & META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY)
+        min_interval_us *= priv->frame_rate_divisor;
+
       time_since_last_frame_us = frame_timestamp_us - priv->last_frame_timestamp_us;
       if (time_since_last_frame_us < min_interval_us)
         {
@@ -798,6 +1246,7 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
           meta_topic (META_DEBUG_SCREEN_CAST,
                       "Skipped recording frame on stream %u, too early",
                       priv->node_id);
+          priv->stats.n_throttled_frames++;
           return record_result;
         }
     }
@@ -845,12 +1294,10 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       if (do_record_frame (src, flags, spa_buffer, &error))
         {
           maybe_add_damaged_regions_metadata (src, spa_buffer);
+          g_clear_pointer (&priv->redraw_clip, mtk_region_unref);
           struct spa_meta_region *spa_meta_video_crop;
 
-          spa_data->chunk->size = spa_data->maxsize;
-          spa_data->chunk->stride =
-            meta_screen_cast_stream_src_calculate_stride (src, spa_data);
-          spa_data->chunk->flags = SPA_CHUNK_FLAG_NONE;
+          update_chunks (src, spa_buffer);
 
           /* Update VideoCrop if needed */
           spa_meta_video_crop =
@@ -877,6 +1324,7 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
             }
 
           record_result |= META_SCREEN_CAST_RECORD_RESULT_RECORDED_FRAME;
+          priv->stats.n_frames++;
         }
       else
         {
@@ -890,6 +1338,8 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
     {
       spa_data->chunk->size = 0;
       spa_data->chunk->flags = SPA_CHUNK_FLAG_CORRUPTED;
+      priv->stats.n_cursor_frames++;
+      update_frame_rate_governor (src, FALSE);
     }
 
   record_result |= maybe_record_cursor (src, spa_buffer);
@@ -1023,6 +1473,7 @@ on_stream_param_changed (void                 *data,
   const struct spa_pod *params[5];
   int n_params = 0;
   int buffer_types;
+  int n_blocks;
 
   if (!format || id != SPA_PARAM_Format)
     return;
@@ -1030,17 +1481,36 @@ on_stream_param_changed (void                 *data,
   spa_format_video_raw_parse (format,
                               &priv->video_format);
 
+  /* Consumers need a complete frame after renegotiating */
+  g_clear_pointer (&priv->redraw_clip, mtk_region_unref);
+  priv->frame_rate_divisor = 1;
+  priv->n_static_frames = 0;
+
+  clear_yuv_frame (src);
+  priv->yuv_format =
+    multi_texture_format_from_spa_video_format (priv->video_format.format);
+
   pod_builder = SPA_POD_BUILDER_INIT (params_buffer, sizeof (params_buffer));
 
-  buffer_types = 1 << SPA_DATA_MemFd;
-  if (spa_pod_find_prop (format, NULL, SPA_FORMAT_VIDEO_modifier))
-    buffer_types |= 1 << SPA_DATA_DmaBuf;
+  if (priv->yuv_format != META_MULTI_TEXTURE_FORMAT_INVALID)
+    {
+      /* YUV frames are only converted on the GPU */
+      buffer_types = 1 << SPA_DATA_DmaBuf;
+      n_blocks = meta_multi_texture_format_get_n_planes (priv->yuv_format);
+    }
+  else
+    {
+      buffer_types = 1 << SPA_DATA_MemFd;
+      if (spa_pod_find_prop (format, NULL, SPA_FORMAT_VIDEO_modifier))
+        buffer_types |= 1 << SPA_DATA_DmaBuf;
+      n_blocks = 1;
+    }
 
   params[n_params++] = spa_pod_builder_add_object (
     &pod_builder,
     SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers,
     SPA_PARAM_BUFFERS_buffers, SPA_POD_CHOICE_RANGE_Int (16, 2, 16),
-    SPA_PARAM_BUFFERS_blocks, SPA_POD_Int (1),
+    SPA_PARAM_BUFFERS_blocks, SPA_POD_Int (n_blocks),
     SPA_PARAM_BUFFERS_align, SPA_POD_Int (16),
     SPA_PARAM_BUFFERS_dataType, SPA_POD_CHOICE_FLAGS_Int (buffer_types));
 
@@ -1070,6 +1540,157 @@ on_stream_param_changed (void                 *data,
     klass->notify_params_updated (src, &priv->video_format);
 }
 
+static int
+build_format_params (MetaScreenCastStreamSrc  *src,
+                     struct spa_pod_builder   *pod_builder,
+                     const struct spa_pod    **params)
+{
+#ifdef HAVE_NATIVE_BACKEND
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
+  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
+  MetaScreenCast *screen_cast =
+    meta_screen_cast_session_get_screen_cast (session);
+  MetaBackend *backend = meta_screen_cast_get_backend (screen_cast);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  CoglRenderer *cogl_renderer = cogl_context_get_renderer (cogl_context);
+#endif /* HAVE_NATIVE_BACKEND */
+  CoglPixelFormat preferred_cogl_format =
+    meta_screen_cast_stream_src_get_preferred_format (src);
+  enum spa_video_format preferred_spa_video_format;
+  enum spa_video_format spa_video_formats[2];
+  struct spa_rectangle default_size = DEFAULT_SIZE;
+  struct spa_rectangle min_size = MIN_SIZE;
+  struct spa_rectangle max_size = MAX_SIZE;
+  struct spa_fraction default_framerate = DEFAULT_FRAME_RATE;
+  struct spa_fraction min_framerate = MIN_FRAME_RATE;
+  struct spa_fraction max_framerate = MAX_FRAME_RATE;
+  int width;
+  int height;
+  float frame_rate;
+  int n_spa_video_formats = 0;
+  int n_params = 0;
+  int i;
+
+  if (meta_screen_cast_stream_src_get_specs (src, &width, &height, &frame_rate))
+    {
+      MetaFraction frame_rate_fraction;
+
+      frame_rate_fraction = meta_fraction_from_double (frame_rate);
+
+      min_framerate = SPA_FRACTION (1, 1);
+      max_framerate = SPA_FRACTION (frame_rate_fraction.num,
+                                    frame_rate_fraction.denom);
+      default_framerate = max_framerate;
+      min_size = max_size = default_size = SPA_RECTANGLE (width, height);
+    }
+
+  if (preferred_cogl_format != DEFAULT_COGL_PIXEL_FORMAT &&
+      spa_video_format_from_cogl_pixel_format (preferred_cogl_format,
+                                               &preferred_spa_video_format))
+    {
+      spa_video_formats[n_spa_video_formats++] = preferred_spa_video_format;
+    }
+
+  spa_video_formats[n_spa_video_formats++] = SPA_VIDEO_FORMAT_BGRx;
+
+  g_assert (n_spa_video_formats > 0 &&
+            n_spa_video_formats <= G_N_ELEMENTS (spa_video_formats));
+
+  for (i = 0; i < n_spa_video_formats; i++)
+    {
+#ifdef HAVE_NATIVE_BACKEND
+      if (cogl_renderer_is_dma_buf_supported (cogl_renderer))
+        {
+          uint64_t modifier = DRM_FORMAT_MOD_INVALID;
+
+          params[n_params++] = push_format_object (
+            pod_builder,
+            spa_video_formats[i], &modifier, 1,
+            SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle (&default_size,
+                                                                   &min_size,
+                                                                   &max_size),
+            SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction (&SPA_FRACTION (0, 1)),
+            SPA_FORMAT_VIDEO_maxFramerate,
+            SPA_POD_CHOICE_RANGE_Fraction (&default_framerate,
+                                           &min_framerate,
+                                           &max_framerate),
+            0);
+        }
+#endif
+
+      params[n_params++] = push_format_object (
+        pod_builder,
+        spa_video_formats[i], NULL, 0,
+        SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle (&default_size,
+                                                               &min_size,
+                                                               &max_size),
+        SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction (&SPA_FRACTION (0, 1)),
+        SPA_FORMAT_VIDEO_maxFramerate,
+        SPA_POD_CHOICE_RANGE_Fraction (&default_framerate,
+                                       &min_framerate,
+                                       &max_framerate),
+        0);
+    }
+
+#ifdef HAVE_NATIVE_BACKEND
+  /* YUV formats are converted while recording into DMA buffers, for
+   * consumers that would otherwise have to convert on the CPU.
+   */
+  if (!priv->is_yuv_unsupported &&
+      cogl_renderer_is_dma_buf_supported (cogl_renderer) &&
+      cogl_context_has_feature (cogl_context, COGL_FEATURE_ID_TEXTURE_RG))
+    {
+      for (i = 0; i < G_N_ELEMENTS (supported_yuv_formats); i++)
+        {
+          uint64_t modifier = DRM_FORMAT_MOD_INVALID;
+
+          params[n_params++] = push_format_object (
+            pod_builder,
+            supported_yuv_formats[i].spa_video_format, &modifier, 1,
+            SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle (&default_size,
+                                                                   &min_size,
+                                                                   &max_size),
+            SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction (&SPA_FRACTION (0, 1)),
+            SPA_FORMAT_VIDEO_maxFramerate,
+            SPA_POD_CHOICE_RANGE_Fraction (&default_framerate,
+                                           &min_framerate,
+                                           &max_framerate),
+            SPA_FORMAT_VIDEO_colorMatrix,
+            SPA_POD_Id (SPA_VIDEO_COLOR_MATRIX_BT601),
+            SPA_FORMAT_VIDEO_colorRange,
+            SPA_POD_Id (SPA_VIDEO_COLOR_RANGE_16_235),
+            0);
+        }
+    }
+#endif /* HAVE_NATIVE_BACKEND */
+
+  return n_params;
+}
+
+static gboolean
+renegotiate_without_yuv (gpointer user_data)
+{
+  MetaScreenCastStreamSrc *src = user_data;
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  uint8_t buffer[2048];
+  struct spa_pod_builder pod_builder =
+    SPA_POD_BUILDER_INIT (buffer, sizeof (buffer));
+  const struct spa_pod *params[MAX_FORMAT_PARAMS];
+  int n_params;
+
+  priv->renegotiate_source_id = 0;
+
+  n_params = build_format_params (src, &pod_builder, params);
+  pw_stream_update_params (priv->pipewire_stream, params, n_params);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 on_stream_add_buffer (void             *data,
                       struct pw_buffer *buffer)
@@ -1085,13 +1706,57 @@ on_stream_add_buffer (void             *data,
   struct spa_buffer *spa_buffer = buffer->buffer;
   struct spa_data *spa_data = &spa_buffer->datas[0];
   int stride;
+  uint32_t i;
 
   priv->buffer_count++;
 
   spa_data->mapoffset = 0;
   spa_data->data = NULL;
 
-  if (spa_data->type & (1 << SPA_DATA_DmaBuf))
+  if (priv->yuv_format != META_MULTI_TEXTURE_FORMAT_INVALID)
+    {
+      int plane_offsets[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int plane_strides[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int packed_width;
+      int packed_height;
+
+      /* The planes are rendered into a single 8 bit buffer */
+      meta_multi_texture_format_get_packed_layout (priv->yuv_format,
+                                                   priv->video_format.size.width,
+                                                   priv->video_format.size.height,
+                                                   &packed_width,
+                                                   &packed_height,
+                                                   plane_offsets,
+                                                   plane_strides);
+
+      dmabuf_handle =
+        meta_screen_cast_create_dma_buf_handle (screen_cast,
+                                                COGL_PIXEL_FORMAT_R_8,
+                                                packed_width,
+                                                packed_height);
+
+      /* The chroma planes are laid out relative to the packed width, so
+       * without such a buffer only RGB formats can be offered */
+      if (!dmabuf_handle ||
+          cogl_dma_buf_handle_get_stride (dmabuf_handle) != packed_width)
+        {
+          meta_topic (META_DEBUG_SCREEN_CAST,
+                      "Can't allocate packed %s DMA buffers, falling back "
+                      "to RGB on stream %u",
+                      meta_multi_texture_format_to_string (priv->yuv_format),
+                      pw_stream_get_node_id (priv->pipewire_stream));
+
+          g_clear_pointer (&dmabuf_handle, cogl_dma_buf_handle_free);
+          priv->is_yuv_unsupported = TRUE;
+          if (!priv->renegotiate_source_id)
+            {
+              priv->renegotiate_source_id =
+                g_idle_add (renegotiate_without_yuv, src);
+            }
+          return;
+        }
+    }
+  else if (spa_data->type & (1 << SPA_DATA_DmaBuf))
     {
       CoglPixelFormat cogl_format;
 
@@ -1138,7 +1803,21 @@ on_stream_add_buffer (void             *data,
                            dmabuf_handle);
 
       stride = meta_screen_cast_stream_src_calculate_stride (src, spa_data);
-      spa_data->maxsize = stride * priv->video_format.size.height;
+      spa_data->maxsize =
+        stride * cogl_dma_buf_handle_get_height (dmabuf_handle);
+
+      /* Every plane refers to the same buffer */
+      for (i = 1; i < spa_buffer->n_datas; i++)
+        {
+          struct spa_data *plane_data = &spa_buffer->datas[i];
+
+          plane_data->type = SPA_DATA_DmaBuf;
+          plane_data->flags = SPA_DATA_FLAG_READWRITE;
+          plane_data->fd = spa_data->fd;
+          plane_data->mapoffset = 0;
+          plane_data->maxsize = spa_data->maxsize;
+          plane_data->data = NULL;
+        }
     }
   else
     {
@@ -1219,6 +1898,9 @@ on_stream_remove_buffer (void             *data,
     {
       if (!g_hash_table_remove (priv->dmabuf_handles, GINT_TO_POINTER (spa_data->fd)))
         g_critical ("Failed to remove non-exported DMA buffer");
+
+      meta_screen_cast_buffer_damage_forget (priv->dmabuf_damage,
+                                             spa_data->fd);
     }
   else if (spa_data->type == SPA_DATA_MemFd)
     {
@@ -1246,39 +1928,13 @@ create_pipewire_stream (MetaScreenCastStreamSrc  *src,
 {
   MetaScreenCastStreamSrcPrivate *priv =
     meta_screen_cast_stream_src_get_instance_private (src);
-#ifdef HAVE_NATIVE_BACKEND
-  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
-  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
-  MetaScreenCast *screen_cast =
-    meta_screen_cast_session_get_screen_cast (session);
-  MetaBackend *backend = meta_screen_cast_get_backend (screen_cast);
-  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
-  CoglContext *cogl_context =
-    clutter_backend_get_cogl_context (clutter_backend);
-  CoglRenderer *cogl_renderer = cogl_context_get_renderer (cogl_context);
-#endif /* HAVE_NATIVE_BACKEND */
-  CoglPixelFormat preferred_cogl_format =
-    meta_screen_cast_stream_src_get_preferred_format (src);
-  enum spa_video_format preferred_spa_video_format;
-  enum spa_video_format spa_video_formats[2];
-  struct spa_rectangle default_size = DEFAULT_SIZE;
-  struct spa_rectangle min_size = MIN_SIZE;
-  struct spa_rectangle max_size = MAX_SIZE;
-  struct spa_fraction default_framerate = DEFAULT_FRAME_RATE;
-  struct spa_fraction min_framerate = MIN_FRAME_RATE;
-  struct spa_fraction max_framerate = MAX_FRAME_RATE;
   struct pw_stream *pipewire_stream;
-  uint8_t buffer[1024];
+  uint8_t buffer[2048];
   struct spa_pod_builder pod_builder =
     SPA_POD_BUILDER_INIT (buffer, sizeof (buffer));
-  int width;
-  int height;
-  float frame_rate;
-  const struct spa_pod *params[4];
-  int n_spa_video_formats = 0;
-  int n_params = 0;
+  const struct spa_pod *params[MAX_FORMAT_PARAMS];
+  int n_params;
   int result;
-  int i;
 
   priv->node_id = SPA_ID_INVALID;
 
@@ -1293,66 +1949,7 @@ create_pipewire_stream (MetaScreenCastStreamSrc  *src,
       return NULL;
     }
 
-  if (meta_screen_cast_stream_src_get_specs (src, &width, &height, &frame_rate))
-    {
-      MetaFraction frame_rate_fraction;
-
-      frame_rate_fraction = meta_fraction_from_double (frame_rate);
-
-      min_framerate = SPA_FRACTION (1, 1);
-      max_framerate = SPA_FRACTION (frame_rate_fraction.num,
-                                    frame_rate_fraction.denom);
-      default_framerate = max_framerate;
-      min_size = max_size = default_size = SPA_RECTANGLE (width, height);
-    }
-
-  if (preferred_cogl_format != DEFAULT_COGL_PIXEL_FORMAT &&
-      spa_video_format_from_cogl_pixel_format (preferred_cogl_format,
-                                               &preferred_spa_video_format))
-    {
-      spa_video_formats[n_spa_video_formats++] = preferred_spa_video_format;
-    }
-
-  spa_video_formats[n_spa_video_formats++] = SPA_VIDEO_FORMAT_BGRx;
-
-  g_assert (n_spa_video_formats > 0 &&
-            n_spa_video_formats <= G_N_ELEMENTS (spa_video_formats));
-
-  for (i = 0; i < n_spa_video_formats; i++)
-    {
-#ifdef HAVE_NATIVE_BACKEND
-      if (cogl_renderer_is_dma_buf_supported (cogl_renderer))
-        {
-          uint64_t modifier = DRM_FORMAT_MOD_INVALID;
-
-          params[n_params++] = push_format_object (
-            &pod_builder,
-            spa_video_formats[i], &modifier, 1,
-            SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle (&default_size,
-                                                                   &min_size,
-                                                                   &max_size),
-            SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction (&SPA_FRACTION (0, 1)),
-            SPA_FORMAT_VIDEO_maxFramerate,
-            SPA_POD_CHOICE_RANGE_Fraction (&default_framerate,
-                                           &min_framerate,
-                                           &max_framerate),
-            0);
-        }
-#endif
-
-      params[n_params++] = push_format_object (
-        &pod_builder,
-        spa_video_formats[i], NULL, 0,
-        SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle (&default_size,
-                                                               &min_size,
-                                                               &max_size),
-        SPA_FORMAT_VIDEO_framerate, SPA_POD_Fraction (&SPA_FRACTION (0, 1)),
-        SPA_FORMAT_VIDEO_maxFramerate,
-        SPA_POD_CHOICE_RANGE_Fraction (&default_framerate,
-                                       &min_framerate,
-                                       &max_framerate),
-        0);
-    }
+  n_params = build_format_params (src, &pod_builder, params);
 
   pw_stream_add_listener (pipewire_stream,
                           &priv->pipewire_stream_listener,
@@ -1552,8 +2149,11 @@ meta_screen_cast_stream_src_dispose (GObject *object)
   if (meta_screen_cast_stream_src_is_enabled (src))
     meta_screen_cast_stream_src_disable (src);
 
+  g_clear_handle_id (&priv->renegotiate_source_id, g_source_remove);
   g_clear_pointer (&priv->pipewire_stream, pw_stream_destroy);
   g_clear_pointer (&priv->dmabuf_handles, g_hash_table_destroy);
+  g_clear_pointer (&priv->dmabuf_damage, meta_screen_cast_buffer_damage_free);
+  clear_yuv_frame (src);
   g_clear_pointer (&priv->pipewire_core, pw_core_disconnect);
   g_clear_pointer (&priv->pipewire_context, pw_context_destroy);
   g_clear_pointer (&priv->pipewire_source, g_source_destroy);
@@ -1607,9 +2207,11 @@ meta_screen_cast_stream_src_init (MetaScreenCastStreamSrc *src)
   MetaScreenCastStreamSrcPrivate *priv =
     meta_screen_cast_stream_src_get_instance_private (src);
 
+  priv->frame_rate_divisor = 1;
   priv->dmabuf_handles =
     g_hash_table_new_full (NULL, NULL, NULL,
                            (GDestroyNotify) cogl_dma_buf_handle_free);
+  priv->dmabuf_damage = meta_screen_cast_buffer_damage_new ();
 }
 
 static void
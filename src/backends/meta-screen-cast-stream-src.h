@@ -45,8 +45,24 @@ typedef enum _MetaScreenCastRecordResult
   META_SCREEN_CAST_RECORD_RESULT_RECORDED_NOTHING = 0,
   META_SCREEN_CAST_RECORD_RESULT_RECORDED_FRAME = 1 << 0,
   META_SCREEN_CAST_RECORD_RESULT_RECORDED_CURSOR = 1 << 1,
+  META_SCREEN_CAST_RECORD_RESULT_FRAME_UNCHANGED = 1 << 2,
 } MetaScreenCastRecordResult;
 
+typedef struct _MetaScreenCastStreamStats
+{
+  /* Frames with content recorded */
+  uint64_t n_frames;
+  /* Buffers only carrying cursor metadata */
+  uint64_t n_cursor_frames;
+  /* Frame requests without any damage that were skipped entirely; in the
+   * metadata cursor mode these are recorded as cursor frames instead */
+  uint64_t n_unchanged_frames;
+  /* Frame requests postponed by frame rate limiting */
+  uint64_t n_throttled_frames;
+  /* Current maximum rate of cursor frames, after adapting to the content */
+  double frame_rate;
+} MetaScreenCastStreamStats;
+
 #define META_TYPE_SCREEN_CAST_STREAM_SRC (meta_screen_cast_stream_src_get_type ())
 G_DECLARE_DERIVABLE_TYPE (MetaScreenCastStreamSrc,
                           meta_screen_cast_stream_src,
@@ -72,6 +88,10 @@ struct _MetaScreenCastStreamSrcClass
   gboolean (* record_to_framebuffer) (MetaScreenCastStreamSrc  *src,
                                       CoglFramebuffer          *framebuffer,
                                       GError                  **error);
+  gboolean (* record_region_to_framebuffer) (MetaScreenCastStreamSrc  *src,
+                                             CoglFramebuffer          *framebuffer,
+                                             const MtkRegion          *region,
+                                             GError                  **error);
   void (* record_follow_up) (MetaScreenCastStreamSrc *src);
 
   gboolean (* get_videocrop) (MetaScreenCastStreamSrc *src,
@@ -98,8 +118,14 @@ MetaScreenCastRecordResult meta_screen_cast_stream_src_maybe_record_frame_with_t
                                                                                           const MtkRegion          *redraw_clip,
                                                                                           int64_t                   frame_timestamp_us);
 
+void meta_screen_cast_stream_src_add_damage (MetaScreenCastStreamSrc *src,
+                                             const MtkRegion         *damage);
+
 gboolean meta_screen_cast_stream_src_pending_follow_up_frame (MetaScreenCastStreamSrc *src);
 
+void meta_screen_cast_stream_src_get_stats (MetaScreenCastStreamSrc   *src,
+                                            MetaScreenCastStreamStats *stats);
+
 MetaScreenCastStream * meta_screen_cast_stream_src_get_stream (MetaScreenCastStreamSrc *src);
 
 gboolean meta_screen_cast_stream_src_draw_cursor_into (MetaScreenCastStreamSrc  *src,
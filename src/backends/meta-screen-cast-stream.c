@@ -66,6 +66,7 @@ typedef struct _MetaScreenCastStreamPrivate
   gboolean is_configured;
 
   MetaScreenCastStreamSrc *src;
+  guint statistics_source_id;
 
   char *mapping_id;
 } MetaScreenCastStreamPrivate;
@@ -132,6 +133,61 @@ on_stream_src_ready (MetaScreenCastStreamSrc *src,
                                  NULL);
 }
 
+static void
+set_statistics (MetaScreenCastStream            *stream,
+                const MetaScreenCastStreamStats *stats)
+{
+  MetaDBusScreenCastStream *skeleton = META_DBUS_SCREEN_CAST_STREAM (stream);
+  GVariantBuilder statistics_builder;
+
+  g_variant_builder_init (&statistics_builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "frames",
+                         g_variant_new_uint64 (stats->n_frames));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "cursor-frames",
+                         g_variant_new_uint64 (stats->n_cursor_frames));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "unchanged-frames",
+                         g_variant_new_uint64 (stats->n_unchanged_frames));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "throttled-frames",
+                         g_variant_new_uint64 (stats->n_throttled_frames));
+  g_variant_builder_add (&statistics_builder, "{sv}",
+                         "cursor-frame-rate",
+                         g_variant_new_double (stats->frame_rate));
+
+  meta_dbus_screen_cast_stream_set_statistics (
+    skeleton, g_variant_builder_end (&statistics_builder));
+}
+
+static gboolean
+update_statistics (gpointer user_data)
+{
+  MetaScreenCastStream *stream = META_SCREEN_CAST_STREAM (user_data);
+  MetaScreenCastStreamPrivate *priv =
+    meta_screen_cast_stream_get_instance_private (stream);
+  MetaScreenCastStreamStats stats;
+
+  meta_screen_cast_stream_src_get_stats (priv->src, &stats);
+
+  meta_topic (META_DEBUG_SCREEN_CAST,
+              "Stream %s: %" G_GUINT64_FORMAT " frames, "
+              "%" G_GUINT64_FORMAT " cursor frames at up to %.1f fps, "
+              "%" G_GUINT64_FORMAT " unchanged, "
+              "%" G_GUINT64_FORMAT " throttled",
+              priv->object_path,
+              stats.n_frames,
+              stats.n_cursor_frames,
+              stats.frame_rate,
+              stats.n_unchanged_frames,
+              stats.n_throttled_frames);
+
+  set_statistics (stream, &stats);
+
+  return G_SOURCE_CONTINUE;
+}
+
 MetaScreenCastSession *
 meta_screen_cast_stream_get_session (MetaScreenCastStream *stream)
 {
@@ -164,6 +220,9 @@ meta_screen_cast_stream_start (MetaScreenCastStream  *stream,
   g_signal_connect (src, "ready", G_CALLBACK (on_stream_src_ready), stream);
   g_signal_connect (src, "closed", G_CALLBACK (on_stream_src_closed), stream);
 
+  priv->statistics_source_id = g_timeout_add_seconds (1, update_statistics,
+                                                      stream);
+
   return TRUE;
 }
 
@@ -173,6 +232,7 @@ meta_screen_cast_stream_close (MetaScreenCastStream *stream)
   MetaScreenCastStreamPrivate *priv =
     meta_screen_cast_stream_get_instance_private (stream);
 
+  g_clear_handle_id (&priv->statistics_source_id, g_source_remove);
   g_clear_object (&priv->src);
 
   g_signal_emit (stream, signals[CLOSED], 0);
@@ -436,6 +496,8 @@ meta_screen_cast_stream_initable_init (GInitable     *initable,
   parameters_variant = g_variant_builder_end (&parameters_builder);
   meta_dbus_screen_cast_stream_set_parameters (skeleton, parameters_variant);
 
+  set_statistics (stream, &(MetaScreenCastStreamStats) { 0 });
+
   priv->object_path =
     g_strdup_printf (META_SCREEN_CAST_STREAM_DBUS_PATH "/u%u",
                      ++global_stream_number);
@@ -32,6 +32,9 @@ typedef enum _MetaExperimentalFeature
   META_EXPERIMENTAL_FEATURE_KMS_MODIFIERS  = (1 << 1),
   META_EXPERIMENTAL_FEATURE_RT_SCHEDULER = (1 << 2),
   META_EXPERIMENTAL_FEATURE_AUTOCLOSE_XWAYLAND  = (1 << 3),
+  META_EXPERIMENTAL_FEATURE_OVERLAY_SCANOUT = (1 << 4),
+  META_EXPERIMENTAL_FEATURE_VARIABLE_REFRESH_RATE = (1 << 5),
+  META_EXPERIMENTAL_FEATURE_ASYNC_SHM_UPLOAD = (1 << 6),
 } MetaExperimentalFeature;
 
 typedef enum _MetaXwaylandExtension
@@ -66,6 +69,10 @@ META_EXPORT_TEST
 void meta_settings_enable_experimental_feature (MetaSettings           *settings,
                                                 MetaExperimentalFeature feature);
 
+META_EXPORT_TEST
+void meta_settings_disable_experimental_feature (MetaSettings           *settings,
+                                                 MetaExperimentalFeature feature);
+
 void meta_settings_get_xwayland_grab_patterns (MetaSettings  *settings,
                                                GPtrArray    **allow_list_patterns,
                                                GPtrArray    **deny_list_patterns);
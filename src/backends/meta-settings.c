@@ -267,6 +267,15 @@ meta_settings_enable_experimental_feature (MetaSettings           *settings,
   settings->experimental_features |= feature;
 }
 
+void
+meta_settings_disable_experimental_feature (MetaSettings           *settings,
+                                            MetaExperimentalFeature feature)
+{
+  g_assert (settings->experimental_features_overridden);
+
+  settings->experimental_features &= ~feature;
+}
+
 static gboolean
 experimental_features_handler (GVariant *features_variant,
                                gpointer *result,
@@ -296,6 +305,12 @@ experimental_features_handler (GVariant *features_variant,
         feature = META_EXPERIMENTAL_FEATURE_RT_SCHEDULER;
       else if (g_str_equal (feature_str, "autoclose-xwayland"))
         feature = META_EXPERIMENTAL_FEATURE_AUTOCLOSE_XWAYLAND;
+      else if (g_str_equal (feature_str, "overlay-scanout"))
+        feature = META_EXPERIMENTAL_FEATURE_OVERLAY_SCANOUT;
+      else if (g_str_equal (feature_str, "variable-refresh-rate"))
+        feature = META_EXPERIMENTAL_FEATURE_VARIABLE_REFRESH_RATE;
+      else if (g_str_equal (feature_str, "async-shm-upload"))
+        feature = META_EXPERIMENTAL_FEATURE_ASYNC_SHM_UPLOAD;
 
       if (feature)
         g_message ("Enabling experimental feature '%s'", feature_str);
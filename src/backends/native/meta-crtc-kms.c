@@ -306,6 +306,51 @@ meta_crtc_kms_assign_primary_plane (MetaCrtcKms   *crtc_kms,
   return plane_assignment;
 }
 
+MetaKmsPlaneAssignment *
+meta_crtc_kms_assign_overlay_plane (MetaCrtcKms                *crtc_kms,
+                                    MetaDrmBuffer              *buffer,
+                                    const MetaFixed16Rectangle *src_rect,
+                                    const MtkRectangle         *dst_rect,
+                                    MetaKmsUpdate              *kms_update)
+{
+  MetaKmsCrtc *kms_crtc;
+  MetaKmsDevice *kms_device;
+  MetaKmsPlane *overlay_kms_plane;
+
+  kms_crtc = meta_crtc_kms_get_kms_crtc (crtc_kms);
+  kms_device = meta_kms_crtc_get_device (kms_crtc);
+  overlay_kms_plane = meta_kms_device_get_overlay_plane_for (kms_device,
+                                                             kms_crtc);
+  if (!overlay_kms_plane)
+    return NULL;
+
+  return meta_kms_update_assign_plane (kms_update,
+                                       kms_crtc,
+                                       overlay_kms_plane,
+                                       buffer,
+                                       *src_rect,
+                                       *dst_rect,
+                                       META_KMS_ASSIGN_PLANE_FLAG_NONE);
+}
+
+void
+meta_crtc_kms_unassign_overlay_plane (MetaCrtcKms   *crtc_kms,
+                                      MetaKmsUpdate *kms_update)
+{
+  MetaKmsCrtc *kms_crtc;
+  MetaKmsDevice *kms_device;
+  MetaKmsPlane *overlay_kms_plane;
+
+  kms_crtc = meta_crtc_kms_get_kms_crtc (crtc_kms);
+  kms_device = meta_kms_crtc_get_device (kms_crtc);
+  overlay_kms_plane = meta_kms_device_get_overlay_plane_for (kms_device,
+                                                             kms_crtc);
+  if (!overlay_kms_plane)
+    return;
+
+  meta_kms_update_unassign_plane (kms_update, kms_crtc, overlay_kms_plane);
+}
+
 static GList *
 generate_crtc_connector_list (MetaGpu  *gpu,
                               MetaCrtc *crtc)
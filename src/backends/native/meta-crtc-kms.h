@@ -44,6 +44,15 @@ MetaKmsPlaneAssignment * meta_crtc_kms_assign_primary_plane (MetaCrtcKms   *crtc
                                                              MetaDrmBuffer *buffer,
                                                              MetaKmsUpdate *kms_update);
 
+MetaKmsPlaneAssignment * meta_crtc_kms_assign_overlay_plane (MetaCrtcKms                *crtc_kms,
+                                                             MetaDrmBuffer              *buffer,
+                                                             const MetaFixed16Rectangle *src_rect,
+                                                             const MtkRectangle         *dst_rect,
+                                                             MetaKmsUpdate              *kms_update);
+
+void meta_crtc_kms_unassign_overlay_plane (MetaCrtcKms   *crtc_kms,
+                                           MetaKmsUpdate *kms_update);
+
 void meta_crtc_kms_set_mode (MetaCrtcKms   *crtc_kms,
                              MetaKmsUpdate *kms_update);
 
@@ -295,7 +295,7 @@ trigger_slow_keys (gpointer data)
                                 clutter_event_get_event_code (event),
                                 clutter_event_get_key_code (event),
                                 clutter_event_get_key_unicode (event));
-  _clutter_event_push (copy, FALSE);
+  _clutter_event_push_from_input_thread (copy);
 
   /* Then remote the pending event */
   device->slow_keys_list = g_list_remove (device->slow_keys_list, slow_keys_event);
@@ -563,7 +563,7 @@ rewrite_stickykeys_event (ClutterEvent          *event,
                            clutter_event_get_key_code (event),
                            clutter_event_get_key_unicode (event));
 
-  _clutter_event_push (rewritten_event, FALSE);
+  _clutter_event_push_from_input_thread (rewritten_event);
 }
 
 static void
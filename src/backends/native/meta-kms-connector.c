@@ -253,6 +253,12 @@ meta_kms_connector_is_hdr_metadata_supported (MetaKmsConnector *connector)
   return connector->current_state->hdr.supported;
 }
 
+gboolean
+meta_kms_connector_is_vrr_capable (MetaKmsConnector *connector)
+{
+  return connector->current_state->vrr_capable;
+}
+
 static void
 set_panel_orientation (MetaKmsConnectorState *state,
                        MetaKmsProp           *panel_orientation)
@@ -388,6 +394,10 @@ state_set_properties (MetaKmsConnectorState *state,
   if (prop->prop_id)
     state->non_desktop = prop->value;
 
+  prop = &props[META_KMS_CONNECTOR_PROP_VRR_CAPABLE];
+  if (prop->prop_id)
+    state->vrr_capable = prop->value;
+
   prop = &props[META_KMS_CONNECTOR_PROP_PRIVACY_SCREEN_HW_STATE];
   if (prop->prop_id)
     set_privacy_screen (state, connector, prop);
@@ -973,6 +983,9 @@ meta_kms_connector_state_changes (MetaKmsConnectorState *state,
   if (state->non_desktop != new_state->non_desktop)
     return META_KMS_RESOURCE_CHANGE_FULL;
 
+  if (state->vrr_capable != new_state->vrr_capable)
+    return META_KMS_RESOURCE_CHANGE_FULL;
+
   if (state->subpixel_order != new_state->subpixel_order)
     return META_KMS_RESOURCE_CHANGE_FULL;
 
@@ -1357,6 +1370,11 @@ init_properties (MetaKmsConnector  *connector,
           .name = "HDR_OUTPUT_METADATA",
           .type = DRM_MODE_PROP_BLOB,
         },
+      [META_KMS_CONNECTOR_PROP_VRR_CAPABLE] =
+        {
+          .name = "vrr_capable",
+          .type = DRM_MODE_PROP_RANGE,
+        },
     },
     .dpms_enum = {
       [META_KMS_CONNECTOR_DPMS_ON] =
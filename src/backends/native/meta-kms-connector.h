@@ -69,6 +69,8 @@ typedef struct _MetaKmsConnectorState
     gboolean supported;
     gboolean unknown;
   } hdr;
+
+  gboolean vrr_capable;
 } MetaKmsConnectorState;
 
 META_EXPORT_TEST
@@ -99,3 +101,5 @@ gboolean meta_kms_connector_is_color_space_supported (MetaKmsConnector     *conn
                                                       MetaOutputColorspace  color_space);
 
 gboolean meta_kms_connector_is_hdr_metadata_supported (MetaKmsConnector *connector);
+
+gboolean meta_kms_connector_is_vrr_capable (MetaKmsConnector *connector);
@@ -28,6 +28,7 @@ typedef enum _MetaKmsCrtcProp
   META_KMS_CRTC_PROP_ACTIVE,
   META_KMS_CRTC_PROP_GAMMA_LUT,
   META_KMS_CRTC_PROP_GAMMA_LUT_SIZE,
+  META_KMS_CRTC_PROP_VRR_ENABLED,
   META_KMS_CRTC_N_PROPS
 } MetaKmsCrtcProp;
 
@@ -43,6 +44,7 @@ void meta_kms_crtc_disable_in_impl (MetaKmsCrtc *crtc);
 void meta_kms_crtc_predict_state_in_impl (MetaKmsCrtc   *crtc,
                                   MetaKmsUpdate *update);
 
+META_EXPORT_TEST
 uint32_t meta_kms_crtc_get_prop_id (MetaKmsCrtc     *crtc,
                                     MetaKmsCrtcProp  prop);
 
@@ -57,3 +59,12 @@ gboolean meta_kms_crtc_determine_deadline (MetaKmsCrtc  *crtc,
                                            int64_t      *out_next_deadline_us,
                                            int64_t      *out_next_presentation_us,
                                            GError      **error);
+
+void meta_kms_crtc_record_commit_latency (MetaKmsCrtc *crtc,
+                                          int64_t      latency_us);
+
+void meta_kms_crtc_record_presentation (MetaKmsCrtc *crtc,
+                                        int64_t      commit_time_us,
+                                        gboolean     had_pending_fences,
+                                        int64_t      expected_presentation_us,
+                                        int64_t      presentation_us);
@@ -48,6 +48,8 @@ struct _MetaKmsCrtc
   MetaKmsCrtcState current_state;
 
   MetaKmsCrtcPropTable prop_table;
+
+  MetaKmsDeadlineEvasion deadline_evasion;
 };
 
 G_DEFINE_TYPE (MetaKmsCrtc, meta_kms_crtc, G_TYPE_OBJECT)
@@ -239,6 +241,7 @@ meta_kms_crtc_read_state (MetaKmsCrtc             *crtc,
   MetaKmsCrtcState crtc_state = {0};
   MetaKmsResourceChanges changes = META_KMS_RESOURCE_CHANGE_NONE;
   MetaKmsProp *active_prop;
+  MetaKmsProp *vrr_enabled_prop;
 
   meta_kms_impl_device_update_prop_table (impl_device,
                                           drm_props->props,
@@ -266,6 +269,10 @@ meta_kms_crtc_read_state (MetaKmsCrtc             *crtc,
 
   read_gamma_state (crtc, &crtc_state, impl_device, drm_crtc);
 
+  vrr_enabled_prop = &crtc->prop_table.props[META_KMS_CRTC_PROP_VRR_ENABLED];
+  crtc_state.vrr.supported = vrr_enabled_prop->prop_id != 0;
+  crtc_state.vrr.enabled = !!vrr_enabled_prop->value;
+
   if (!crtc_state.is_active)
     {
       if (crtc->current_state.is_active)
@@ -341,6 +348,7 @@ meta_kms_crtc_predict_state_in_impl (MetaKmsCrtc   *crtc,
 {
   GList *mode_sets;
   GList *crtc_color_updates;
+  GList *crtc_updates;
   GList *l;
 
   mode_sets = meta_kms_update_get_mode_sets (update);
@@ -396,6 +404,19 @@ meta_kms_crtc_predict_state_in_impl (MetaKmsCrtc   *crtc,
         }
       break;
     }
+
+  crtc_updates = meta_kms_update_get_crtc_updates (update);
+  for (l = crtc_updates; l; l = l->next)
+    {
+      MetaKmsCrtcUpdate *crtc_update = l->data;
+
+      if (crtc_update->crtc != crtc)
+        continue;
+
+      if (crtc_update->vrr.has_update)
+        crtc->current_state.vrr.enabled = crtc_update->vrr.is_enabled;
+      break;
+    }
 }
 
 static void
@@ -427,6 +448,11 @@ init_properties (MetaKmsCrtc       *crtc,
           .name = "GAMMA_LUT_SIZE",
           .type = DRM_MODE_PROP_RANGE,
         },
+      [META_KMS_CRTC_PROP_VRR_ENABLED] =
+        {
+          .name = "VRR_ENABLED",
+          .type = DRM_MODE_PROP_RANGE,
+        },
     }
   };
 }
@@ -480,6 +506,9 @@ meta_kms_crtc_init (MetaKmsCrtc *crtc)
 {
   crtc->current_state.gamma.size = 0;
   crtc->current_state.gamma.value = NULL;
+
+  meta_kms_deadline_evasion_init (&crtc->deadline_evasion,
+                                  DEADLINE_EVASION_US);
 }
 
 static void
@@ -564,10 +593,12 @@ meta_kms_crtc_determine_deadline (MetaKmsCrtc  *crtc,
    *
    */
 
+  deadline_evasion_us = crtc->deadline_evasion.evasion_us;
   if (meta_is_topic_enabled (META_DEBUG_KMS))
-    deadline_evasion_us = DEADLINE_EVASION_WITH_KMS_TOPIC_US;
-  else
-    deadline_evasion_us = DEADLINE_EVASION_US;
+    {
+      deadline_evasion_us = MAX (deadline_evasion_us,
+                                 DEADLINE_EVASION_WITH_KMS_TOPIC_US);
+    }
 
   vblank_duration_us = meta_calculate_drm_mode_vblank_duration_us (drm_mode);
   next_deadline_us = next_presentation_us - (vblank_duration_us +
@@ -578,3 +609,80 @@ meta_kms_crtc_determine_deadline (MetaKmsCrtc  *crtc,
 
   return TRUE;
 }
+
+static void
+log_deadline_evasion_change (MetaKmsCrtc *crtc,
+                             const char  *reason)
+{
+  MetaKmsDeadlineEvasion *deadline_evasion = &crtc->deadline_evasion;
+
+  meta_topic (META_DEBUG_KMS,
+              "Deadline evasion on CRTC %u (%s) changed to %" G_GINT64_FORMAT
+              " us (%s, commit latency: %" G_GINT64_FORMAT " us)",
+              crtc->id,
+              meta_kms_device_get_path (crtc->device),
+              deadline_evasion->evasion_us,
+              reason,
+              meta_kms_deadline_evasion_get_commit_latency_us (deadline_evasion));
+}
+
+/*
+ * Records the time it took from the deadline until the update was
+ * committed.
+ */
+void
+meta_kms_crtc_record_commit_latency (MetaKmsCrtc *crtc,
+                                     int64_t      latency_us)
+{
+  if (meta_kms_deadline_evasion_add_commit_latency (&crtc->deadline_evasion,
+                                                    latency_us))
+    log_deadline_evasion_change (crtc, "commit latency");
+}
+
+/*
+ * Records the presentation time of an update committed at the deadline, and
+ * makes the deadline earlier if the update didn't make it in time because
+ * it was committed too late. Updates that were committed in time but still
+ * waited for fences are late because of the client or the GPU instead.
+ */
+void
+meta_kms_crtc_record_presentation (MetaKmsCrtc *crtc,
+                                   int64_t      commit_time_us,
+                                   gboolean     had_pending_fences,
+                                   int64_t      expected_presentation_us,
+                                   int64_t      presentation_us)
+{
+  const drmModeModeInfo *drm_mode = &crtc->current_state.drm_mode;
+  int64_t frame_duration_us;
+  int64_t vblank_start_us;
+
+  if (!crtc->current_state.is_drm_mode_valid)
+    return;
+
+  frame_duration_us =
+    G_USEC_PER_SEC / meta_calculate_drm_mode_refresh_rate (drm_mode);
+  if (presentation_us - expected_presentation_us < frame_duration_us / 2)
+    return;
+
+  vblank_start_us = expected_presentation_us -
+                    meta_calculate_drm_mode_vblank_duration_us (drm_mode);
+  if (had_pending_fences && commit_time_us <= vblank_start_us)
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "Presentation on CRTC %u (%s) delayed by %" G_GINT64_FORMAT
+                  " us waiting for fences",
+                  crtc->id,
+                  meta_kms_device_get_path (crtc->device),
+                  presentation_us - expected_presentation_us);
+      return;
+    }
+
+  meta_topic (META_DEBUG_KMS,
+              "Missed deadline on CRTC %u (%s) by %" G_GINT64_FORMAT " us",
+              crtc->id,
+              meta_kms_device_get_path (crtc->device),
+              presentation_us - expected_presentation_us);
+
+  if (meta_kms_deadline_evasion_add_missed_deadline (&crtc->deadline_evasion))
+    log_deadline_evasion_change (crtc, "missed deadline");
+}
@@ -39,6 +39,11 @@ typedef struct _MetaKmsCrtcState
     int size;
     gboolean supported;
   } gamma;
+
+  struct {
+    gboolean supported;
+    gboolean enabled;
+  } vrr;
 } MetaKmsCrtcState;
 
 #define META_TYPE_KMS_CRTC (meta_kms_crtc_get_type ())
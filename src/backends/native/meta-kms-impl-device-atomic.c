@@ -36,11 +36,38 @@ typedef gboolean (* MetaKmsAtomicProcessFunc) (MetaKmsImplDevice  *impl_device,
                                                gpointer            user_data,
                                                GError            **error);
 
+#define MAX_CACHED_BLOBS 32
+
+typedef struct _MetaKmsCachedBlob
+{
+  GBytes *data;
+  uint32_t blob_id;
+  /* Sequence number of the update that last used the blob */
+  uint64_t last_used;
+} MetaKmsCachedBlob;
+
+typedef struct _MetaKmsPropValue
+{
+  uint32_t object_id;
+  uint32_t prop_id;
+  uint64_t value;
+} MetaKmsPropValue;
+
 struct _MetaKmsImplDeviceAtomic
 {
   MetaKmsImplDevice parent;
 
   GHashTable *page_flip_datas;
+
+  /* Property blobs kept across updates, keyed by their contents */
+  GHashTable *cached_blobs;
+  uint64_t update_sequence;
+
+  /* Property values known to be in effect, as set by earlier commits */
+  GHashTable *committed_props;
+  /* Property values set by the update being processed */
+  GArray *pending_props;
+  gboolean skip_committed_props;
 };
 
 static GInitableIface *initable_parent_iface;
@@ -92,6 +119,265 @@ release_blob_ids (MetaKmsImplDevice *impl_device,
     }
 }
 
+static guint
+prop_value_hash (gconstpointer key)
+{
+  const MetaKmsPropValue *prop_value = key;
+
+  return prop_value->object_id * 31 + prop_value->prop_id;
+}
+
+static gboolean
+prop_value_equal (gconstpointer a,
+                  gconstpointer b)
+{
+  const MetaKmsPropValue *prop_value_a = a;
+  const MetaKmsPropValue *prop_value_b = b;
+
+  return (prop_value_a->object_id == prop_value_b->object_id &&
+          prop_value_a->prop_id == prop_value_b->prop_id);
+}
+
+/*
+ * Returns TRUE if @value is already in effect for the property, and doesn't
+ * need to be part of the update. Otherwise, the value is remembered, to be
+ * considered in effect once the update has been committed.
+ */
+static gboolean
+is_prop_value_committed (MetaKmsImplDevice *impl_device,
+                         uint32_t           object_id,
+                         uint32_t           prop_id,
+                         uint64_t           value)
+{
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
+  MetaKmsPropValue prop_value = {
+    .object_id = object_id,
+    .prop_id = prop_id,
+    .value = value,
+  };
+  MetaKmsPropValue *committed_prop_value;
+
+  committed_prop_value = g_hash_table_lookup (impl_device_atomic->committed_props,
+                                              &prop_value);
+  if (impl_device_atomic->skip_committed_props &&
+      committed_prop_value &&
+      committed_prop_value->value == value)
+    return TRUE;
+
+  g_array_append_val (impl_device_atomic->pending_props, prop_value);
+  return FALSE;
+}
+
+static void
+forget_committed_props (MetaKmsImplDeviceAtomic *impl_device_atomic,
+                        uint32_t                 object_id,
+                        uint32_t                 blob_id)
+{
+  GHashTableIter iter;
+  MetaKmsPropValue *prop_value;
+
+  g_hash_table_iter_init (&iter, impl_device_atomic->committed_props);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &prop_value, NULL))
+    {
+      if ((object_id && prop_value->object_id == object_id) ||
+          (blob_id && prop_value->value == blob_id))
+        g_hash_table_iter_remove (&iter);
+    }
+}
+
+static void
+commit_pending_props (MetaKmsImplDeviceAtomic *impl_device_atomic)
+{
+  unsigned int i;
+
+  for (i = 0; i < impl_device_atomic->pending_props->len; i++)
+    {
+      MetaKmsPropValue *prop_value =
+        &g_array_index (impl_device_atomic->pending_props,
+                        MetaKmsPropValue, i);
+
+      g_hash_table_add (impl_device_atomic->committed_props,
+                        g_memdup2 (prop_value, sizeof (*prop_value)));
+    }
+}
+
+/*
+ * For tests: whether the last processed update set a property that is
+ * otherwise left out while its value is in effect.
+ */
+gboolean
+meta_kms_impl_device_atomic_was_prop_updated (MetaKmsImplDeviceAtomic *impl_device_atomic,
+                                              uint32_t                 object_id,
+                                              uint32_t                 prop_id)
+{
+  MetaKmsPropValue key = {
+    .object_id = object_id,
+    .prop_id = prop_id,
+  };
+  unsigned int i;
+
+  for (i = 0; i < impl_device_atomic->pending_props->len; i++)
+    {
+      MetaKmsPropValue *prop_value =
+        &g_array_index (impl_device_atomic->pending_props,
+                        MetaKmsPropValue, i);
+
+      if (prop_value_equal (prop_value, &key))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+cached_blob_free (MetaKmsCachedBlob *cached_blob)
+{
+  g_bytes_unref (cached_blob->data);
+  g_free (cached_blob);
+}
+
+static void
+evict_cached_blobs (MetaKmsImplDevice *impl_device)
+{
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
+  int fd = meta_kms_impl_device_get_fd (impl_device);
+
+  while (g_hash_table_size (impl_device_atomic->cached_blobs) >
+         MAX_CACHED_BLOBS)
+    {
+      GHashTableIter iter;
+      MetaKmsCachedBlob *cached_blob;
+      MetaKmsCachedBlob *least_recently_used = NULL;
+
+      g_hash_table_iter_init (&iter, impl_device_atomic->cached_blobs);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cached_blob))
+        {
+          if (!least_recently_used ||
+              cached_blob->last_used < least_recently_used->last_used)
+            least_recently_used = cached_blob;
+        }
+
+      /* Blobs used by the update being processed must stay around */
+      if (least_recently_used->last_used == impl_device_atomic->update_sequence)
+        break;
+
+      meta_topic (META_DEBUG_KMS,
+                  "[atomic] Evicting cached blob %u (%s)",
+                  least_recently_used->blob_id,
+                  meta_kms_impl_device_get_path (impl_device));
+
+      /* The ID may be reused by the kernel for a different blob */
+      forget_committed_props (impl_device_atomic, 0,
+                              least_recently_used->blob_id);
+
+      drmModeDestroyPropertyBlob (fd, least_recently_used->blob_id);
+      g_hash_table_remove (impl_device_atomic->cached_blobs,
+                           least_recently_used->data);
+    }
+}
+
+/*
+ * Like store_new_blob(), but the blob is kept around after the update, and
+ * used again for later updates with the same contents, e.g. for the same
+ * mode or gamma ramp on multiple CRTCs. Reusing the blob ID also lets the
+ * property be left out of the update if it's already in effect.
+ */
+static uint32_t
+get_cached_blob (MetaKmsImplDevice  *impl_device,
+                 const void         *data,
+                 size_t              size,
+                 GError            **error)
+{
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
+  int fd = meta_kms_impl_device_get_fd (impl_device);
+  g_autoptr (GBytes) bytes = NULL;
+  MetaKmsCachedBlob *cached_blob;
+  uint32_t blob_id;
+  int ret;
+
+  bytes = g_bytes_new (data, size);
+  cached_blob = g_hash_table_lookup (impl_device_atomic->cached_blobs, bytes);
+  if (cached_blob)
+    {
+      cached_blob->last_used = impl_device_atomic->update_sequence;
+      return cached_blob->blob_id;
+    }
+
+  ret = drmModeCreatePropertyBlob (fd, data, size, &blob_id);
+  if (ret < 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (-ret),
+                   "drmModeCreatePropertyBlob: %s", g_strerror (-ret));
+      return 0;
+    }
+
+  cached_blob = g_new0 (MetaKmsCachedBlob, 1);
+  cached_blob->data = g_steal_pointer (&bytes);
+  cached_blob->blob_id = blob_id;
+  cached_blob->last_used = impl_device_atomic->update_sequence;
+  g_hash_table_insert (impl_device_atomic->cached_blobs,
+                       cached_blob->data, cached_blob);
+
+  evict_cached_blobs (impl_device);
+
+  return blob_id;
+}
+
+static gboolean
+is_connector_prop_persistent (MetaKmsConnectorProp prop)
+{
+  switch (prop)
+    {
+    case META_KMS_CONNECTOR_PROP_UNDERSCAN:
+    case META_KMS_CONNECTOR_PROP_UNDERSCAN_HBORDER:
+    case META_KMS_CONNECTOR_PROP_UNDERSCAN_VBORDER:
+    case META_KMS_CONNECTOR_PROP_MAX_BPC:
+    case META_KMS_CONNECTOR_PROP_COLORSPACE:
+    case META_KMS_CONNECTOR_PROP_HDR_OUTPUT_METADATA:
+      return TRUE;
+    default:
+      /* The privacy screen state may also be changed by hotkeys */
+      return FALSE;
+    }
+}
+
+static gboolean
+is_crtc_prop_persistent (MetaKmsCrtcProp prop)
+{
+  switch (prop)
+    {
+    case META_KMS_CRTC_PROP_GAMMA_LUT:
+    case META_KMS_CRTC_PROP_VRR_ENABLED:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+is_plane_prop_persistent (MetaKmsPlaneProp prop)
+{
+  switch (prop)
+    {
+    case META_KMS_PLANE_PROP_ROTATION:
+    case META_KMS_PLANE_PROP_SRC_X:
+    case META_KMS_PLANE_PROP_SRC_Y:
+    case META_KMS_PLANE_PROP_SRC_W:
+    case META_KMS_PLANE_PROP_SRC_H:
+    case META_KMS_PLANE_PROP_CRTC_X:
+    case META_KMS_PLANE_PROP_CRTC_Y:
+    case META_KMS_PLANE_PROP_CRTC_W:
+    case META_KMS_PLANE_PROP_CRTC_H:
+      return TRUE;
+    default:
+      /* FB_ID and CRTC_ID are always set, for page flip events */
+      return FALSE;
+    }
+}
+
 static gboolean
 add_connector_property (MetaKmsImplDevice     *impl_device,
                         MetaKmsConnector      *connector,
@@ -114,6 +400,22 @@ add_connector_property (MetaKmsImplDevice     *impl_device,
 
   value = meta_kms_connector_get_prop_drm_value (connector, prop, value);
 
+  if (is_connector_prop_persistent (prop) &&
+      is_prop_value_committed (impl_device,
+                               meta_kms_connector_get_id (connector),
+                               prop_id, value))
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "[atomic] Connector %u (%s) property '%s' (%u) already "
+                  "set to %" G_GUINT64_FORMAT,
+                  meta_kms_connector_get_id (connector),
+                  meta_kms_impl_device_get_path (impl_device),
+                  meta_kms_connector_get_prop_name (connector, prop),
+                  prop_id,
+                  value);
+      return TRUE;
+    }
+
   meta_topic (META_DEBUG_KMS,
               "[atomic] Setting connector %u (%s) property '%s' (%u) to %"
               G_GUINT64_FORMAT,
@@ -265,11 +567,10 @@ process_connector_update (MetaKmsImplDevice  *impl_device,
 
           meta_set_drm_hdr_metadata (&connector_update->hdr.value, &metadata);
 
-          hdr_blob_id = store_new_blob (impl_device,
-                                        blob_ids,
-                                        &metadata,
-                                        sizeof (metadata),
-                                        error);
+          hdr_blob_id = get_cached_blob (impl_device,
+                                         &metadata,
+                                         sizeof (metadata),
+                                         error);
           if (!hdr_blob_id)
             return FALSE;
         }
@@ -307,6 +608,22 @@ add_crtc_property (MetaKmsImplDevice  *impl_device,
 
   value = meta_kms_crtc_get_prop_drm_value (crtc, prop, value);
 
+  if (is_crtc_prop_persistent (prop) &&
+      is_prop_value_committed (impl_device,
+                               meta_kms_crtc_get_id (crtc),
+                               prop_id, value))
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "[atomic] CRTC %u (%s) property '%s' (%u) already set to %"
+                  G_GUINT64_FORMAT,
+                  meta_kms_crtc_get_id (crtc),
+                  meta_kms_impl_device_get_path (impl_device),
+                  meta_kms_crtc_get_prop_name (crtc, prop),
+                  prop_id,
+                  value);
+      return TRUE;
+    }
+
   meta_topic (META_DEBUG_KMS,
               "[atomic] Setting CRTC %u (%s) property '%s' (%u) to %"
               G_GUINT64_FORMAT,
@@ -352,12 +669,13 @@ process_mode_set (MetaKmsImplDevice  *impl_device,
       uint32_t mode_id;
       GList *l;
 
-      mode_id = meta_kms_mode_create_blob_id (mode, error);
+      mode_id = get_cached_blob (impl_device,
+                                 meta_kms_mode_get_drm_mode (mode),
+                                 sizeof (drmModeModeInfo),
+                                 error);
       if (mode_id == 0)
         return FALSE;
 
-      g_array_append_val (blob_ids, mode_id);
-
       meta_topic (META_DEBUG_KMS,
                   "[atomic] Setting mode of CRTC %u (%s) to %s",
                   meta_kms_crtc_get_id (crtc),
@@ -438,6 +756,22 @@ add_plane_property (MetaKmsImplDevice  *impl_device,
 
   value = meta_kms_plane_get_prop_drm_value (plane, prop, value);
 
+  if (is_plane_prop_persistent (prop) &&
+      is_prop_value_committed (impl_device,
+                               meta_kms_plane_get_id (plane),
+                               prop_id, value))
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "[atomic] Plane %u (%s) property '%s' (%u) already set to %"
+                  G_GUINT64_FORMAT,
+                  meta_kms_plane_get_id (plane),
+                  meta_kms_impl_device_get_path (impl_device),
+                  meta_kms_plane_get_prop_name (plane, prop),
+                  prop_id,
+                  value);
+      return TRUE;
+    }
+
   switch (meta_kms_plane_get_prop_internal_type (plane, prop))
     {
     case META_KMS_PROP_TYPE_RAW:
@@ -591,6 +925,8 @@ process_plane_assignment (MetaKmsImplDevice  *impl_device,
     }
   else
     {
+      MetaKmsImplDeviceAtomic *impl_device_atomic =
+        META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
       int i;
       struct {
         MetaKmsPlaneProp prop;
@@ -606,6 +942,10 @@ process_plane_assignment (MetaKmsImplDevice  *impl_device,
         },
       };
 
+      /* Drivers may reset the state of disabled planes */
+      forget_committed_props (impl_device_atomic,
+                              meta_kms_plane_get_id (plane), 0);
+
       for (i = 0; i < G_N_ELEMENTS (props); i++)
         {
           if (!add_plane_property (impl_device,
@@ -693,11 +1033,12 @@ process_crtc_color_updates (MetaKmsImplDevice  *impl_device,
               drm_color_lut[i].blue = gamma->blue[i];
             }
 
-          color_lut_blob_id = store_new_blob (impl_device,
-                                              blob_ids,
-                                              drm_color_lut,
-                                              color_lut_size,
-                                              error);
+          color_lut_blob_id = get_cached_blob (impl_device,
+                                               drm_color_lut,
+                                               color_lut_size,
+                                               error);
+          if (!color_lut_blob_id)
+            return FALSE;
 
           meta_topic (META_DEBUG_KMS,
                       "[atomic] Setting CRTC (%u, %s) gamma, size: %zu",
@@ -724,6 +1065,37 @@ process_crtc_color_updates (MetaKmsImplDevice  *impl_device,
   return TRUE;
 }
 
+static gboolean
+process_crtc_update (MetaKmsImplDevice  *impl_device,
+                     MetaKmsUpdate      *update,
+                     drmModeAtomicReq   *req,
+                     GArray             *blob_ids,
+                     gpointer            update_entry,
+                     gpointer            user_data,
+                     GError            **error)
+{
+  MetaKmsCrtcUpdate *crtc_update = update_entry;
+  MetaKmsCrtc *crtc = crtc_update->crtc;
+
+  if (crtc_update->vrr.has_update)
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "[atomic] Setting VRR mode on CRTC (%u, %s) to %s",
+                  meta_kms_crtc_get_id (crtc),
+                  meta_kms_impl_device_get_path (impl_device),
+                  crtc_update->vrr.is_enabled ? "enabled" : "disabled");
+
+      if (!add_crtc_property (impl_device,
+                              crtc, req,
+                              META_KMS_CRTC_PROP_VRR_ENABLED,
+                              crtc_update->vrr.is_enabled,
+                              error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static gboolean
 process_page_flip_listener (MetaKmsImplDevice  *impl_device,
                             MetaKmsUpdate      *update,
@@ -962,6 +1334,8 @@ meta_kms_impl_device_atomic_process_update (MetaKmsImplDevice *impl_device,
                                             MetaKmsUpdate     *update,
                                             MetaKmsUpdateFlag  flags)
 {
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
   GError *error = NULL;
   GList *failed_planes = NULL;
   drmModeAtomicReq *req;
@@ -974,6 +1348,14 @@ meta_kms_impl_device_atomic_process_update (MetaKmsImplDevice *impl_device,
 
   meta_topic (META_DEBUG_KMS, "[atomic] Processing update");
 
+  impl_device_atomic->update_sequence++;
+  g_array_set_size (impl_device_atomic->pending_props, 0);
+
+  /* Mode sets disable all planes and connectors not part of the update, so
+   * every property needs to be set again. */
+  impl_device_atomic->skip_committed_props =
+    !meta_kms_update_get_mode_sets (update);
+
   req = drmModeAtomicAlloc ();
   if (!req)
     {
@@ -1029,6 +1411,16 @@ meta_kms_impl_device_atomic_process_update (MetaKmsImplDevice *impl_device,
                         &error))
     goto err;
 
+  if (!process_entries (impl_device,
+                        update,
+                        req,
+                        blob_ids,
+                        meta_kms_update_get_crtc_updates (update),
+                        NULL,
+                        process_crtc_update,
+                        &error))
+    goto err;
+
   if (meta_kms_update_get_needs_modeset (update))
     commit_flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
   else
@@ -1055,6 +1447,14 @@ meta_kms_impl_device_atomic_process_update (MetaKmsImplDevice *impl_device,
 
   drmModeAtomicFree (req);
 
+  if (!(flags & META_KMS_UPDATE_FLAG_TEST_ONLY))
+    {
+      if (meta_kms_update_get_mode_sets (update))
+        g_hash_table_remove_all (impl_device_atomic->committed_props);
+
+      commit_pending_props (impl_device_atomic);
+    }
+
   process_entries (impl_device,
                    update,
                    req,
@@ -1082,6 +1482,8 @@ err:
 static void
 meta_kms_impl_device_atomic_disable (MetaKmsImplDevice *impl_device)
 {
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
   g_autoptr (GError) error = NULL;
   drmModeAtomicReq *req;
   int fd;
@@ -1118,6 +1520,8 @@ meta_kms_impl_device_atomic_disable (MetaKmsImplDevice *impl_device)
       goto err;
     }
 
+  g_hash_table_remove_all (impl_device_atomic->committed_props);
+
   return;
 
 err:
@@ -1163,6 +1567,25 @@ meta_kms_impl_device_atomic_prepare_shutdown (MetaKmsImplDevice *impl_device)
                                impl_device);
 }
 
+static void
+meta_kms_impl_device_atomic_release_fd_resources (MetaKmsImplDevice *impl_device)
+{
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (impl_device);
+  int fd = meta_kms_impl_device_get_fd (impl_device);
+  GHashTableIter iter;
+  MetaKmsCachedBlob *cached_blob;
+
+  g_hash_table_iter_init (&iter, impl_device_atomic->cached_blobs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cached_blob))
+    {
+      drmModeDestroyPropertyBlob (fd, cached_blob->blob_id);
+      g_hash_table_iter_remove (&iter);
+    }
+
+  g_hash_table_remove_all (impl_device_atomic->committed_props);
+}
+
 static void
 meta_kms_impl_device_atomic_finalize (GObject *object)
 {
@@ -1172,6 +1595,9 @@ meta_kms_impl_device_atomic_finalize (GObject *object)
   g_assert (g_hash_table_size (impl_device_atomic->page_flip_datas) == 0);
 
   g_hash_table_unref (impl_device_atomic->page_flip_datas);
+  g_hash_table_unref (impl_device_atomic->cached_blobs);
+  g_hash_table_unref (impl_device_atomic->committed_props);
+  g_array_unref (impl_device_atomic->pending_props);
 
   G_OBJECT_CLASS (meta_kms_impl_device_atomic_parent_class)->finalize (object);
 }
@@ -1272,6 +1698,14 @@ static void
 meta_kms_impl_device_atomic_init (MetaKmsImplDeviceAtomic *impl_device_atomic)
 {
   impl_device_atomic->page_flip_datas = g_hash_table_new (NULL, NULL);
+  impl_device_atomic->cached_blobs =
+    g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+                           NULL, (GDestroyNotify) cached_blob_free);
+  impl_device_atomic->committed_props =
+    g_hash_table_new_full (prop_value_hash, prop_value_equal,
+                           g_free, NULL);
+  impl_device_atomic->pending_props =
+    g_array_new (FALSE, FALSE, sizeof (MetaKmsPropValue));
 }
 
 static void
@@ -1305,4 +1739,6 @@ meta_kms_impl_device_atomic_class_init (MetaKmsImplDeviceAtomicClass *klass)
     meta_kms_impl_device_atomic_discard_pending_page_flips;
   impl_device_class->prepare_shutdown =
     meta_kms_impl_device_atomic_prepare_shutdown;
+  impl_device_class->release_fd_resources =
+    meta_kms_impl_device_atomic_release_fd_resources;
 }
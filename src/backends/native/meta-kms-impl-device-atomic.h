@@ -23,3 +23,8 @@
 META_EXPORT_TEST
 G_DECLARE_FINAL_TYPE (MetaKmsImplDeviceAtomic, meta_kms_impl_device_atomic,
                       META, KMS_IMPL_DEVICE_ATOMIC, MetaKmsImplDevice)
+
+META_EXPORT_TEST
+gboolean meta_kms_impl_device_atomic_was_prop_updated (MetaKmsImplDeviceAtomic *impl_device_atomic,
+                                                       uint32_t                 object_id,
+                                                       uint32_t                 prop_id);
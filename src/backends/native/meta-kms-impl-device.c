@@ -21,11 +21,13 @@
 
 #include <errno.h>
 #include <glib/gstdio.h>
+#include <poll.h>
 #include <sys/timerfd.h>
 #include <xf86drm.h>
 
 #include "backends/native/meta-backend-native.h"
 #include "backends/native/meta-device-pool.h"
+#include "backends/native/meta-drm-buffer.h"
 #include "backends/native/meta-kms-connector-private.h"
 #include "backends/native/meta-kms-connector.h"
 #include "backends/native/meta-kms-crtc-private.h"
@@ -69,6 +71,9 @@ typedef struct _CrtcDeadline
     GSource *source;
     gboolean armed;
     gboolean is_deadline_page_flip;
+    gboolean had_pending_fences;
+    int64_t deadline_time_us;
+    int64_t commit_time_us;
     int64_t expected_presentation_time_us;
   } deadline;
 } CrtcFrame;
@@ -1071,6 +1076,7 @@ arm_crtc_frame_deadline_timer (CrtcFrame *crtc_frame,
   timerfd_settime (crtc_frame->deadline.timer_fd,
                    TFD_TIMER_ABSTIME, &its, NULL);
 
+  crtc_frame->deadline.deadline_time_us = next_deadline_us;
   crtc_frame->deadline.expected_presentation_time_us = next_presentation_us;
   crtc_frame->deadline.armed = TRUE;
 }
@@ -1101,8 +1107,7 @@ crtc_page_flip_feedback_flipped (MetaKmsCrtc  *crtc,
 {
   CrtcFrame *crtc_frame = user_data;
 
-  if (crtc_frame->deadline.is_deadline_page_flip &&
-      meta_is_topic_enabled (META_DEBUG_KMS))
+  if (crtc_frame->deadline.is_deadline_page_flip)
     {
       struct timeval page_flip_timeval;
       int64_t presentation_time_us;
@@ -1121,6 +1126,12 @@ crtc_page_flip_feedback_flipped (MetaKmsCrtc  *crtc,
                   crtc_frame->deadline.expected_presentation_time_us,
                   crtc_frame->deadline.expected_presentation_time_us -
                   presentation_time_us);
+
+      meta_kms_crtc_record_presentation (crtc,
+                                         crtc_frame->deadline.commit_time_us,
+                                         crtc_frame->deadline.had_pending_fences,
+                                         crtc_frame->deadline.expected_presentation_time_us,
+                                         presentation_time_us);
     }
 
   notify_crtc_frame_ready (crtc_frame);
@@ -1281,6 +1292,49 @@ do_process (MetaKmsImplDevice *impl_device,
   return feedback;
 }
 
+static gboolean
+is_buffer_busy (MetaDrmBuffer *buffer)
+{
+  struct pollfd pfd;
+  int fd;
+  int ret;
+
+  /* Dumb buffers can't be exported, but aren't written to by the GPU */
+  fd = meta_drm_buffer_export_fd (buffer, NULL);
+  if (fd == -1)
+    return FALSE;
+
+  /* The dma-buf only becomes readable once its write fences signaled */
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  do
+    {
+      ret = poll (&pfd, 1, 0);
+    }
+  while (ret == -1 && errno == EINTR);
+
+  close (fd);
+
+  return ret == 0;
+}
+
+static gboolean
+has_pending_fences (MetaKmsUpdate *update)
+{
+  GList *l;
+
+  for (l = meta_kms_update_get_plane_assignments (update); l; l = l->next)
+    {
+      MetaKmsPlaneAssignment *plane_assignment = l->data;
+
+      if (plane_assignment->buffer &&
+          is_buffer_busy (plane_assignment->buffer))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 static gpointer
 crtc_frame_deadline_dispatch (MetaThreadImpl  *thread_impl,
                               gpointer         user_data,
@@ -1309,12 +1363,21 @@ crtc_frame_deadline_dispatch (MetaThreadImpl  *thread_impl,
       return GINT_TO_POINTER (FALSE);
     }
 
+  crtc_frame->deadline.had_pending_fences =
+    has_pending_fences (crtc_frame->pending_update);
+
   feedback = do_process (impl_device,
                          crtc_frame->crtc,
                          g_steal_pointer (&crtc_frame->pending_update),
                          META_KMS_UPDATE_FLAG_NONE);
   if (meta_kms_feedback_did_pass (feedback))
-    crtc_frame->deadline.is_deadline_page_flip = TRUE;
+    {
+      crtc_frame->deadline.is_deadline_page_flip = TRUE;
+      crtc_frame->deadline.commit_time_us = g_get_monotonic_time ();
+      meta_kms_crtc_record_commit_latency (crtc_frame->crtc,
+                                           crtc_frame->deadline.commit_time_us -
+                                           crtc_frame->deadline.deadline_time_us);
+    }
   disarm_crtc_frame_deadline_timer (crtc_frame);
 
   return GINT_TO_POINTER (TRUE);
@@ -1741,6 +1804,12 @@ meta_kms_impl_device_unhold_fd (MetaKmsImplDevice *impl_device)
   priv->fd_hold_count--;
   if (priv->fd_hold_count == 0)
     {
+      MetaKmsImplDeviceClass *klass =
+        META_KMS_IMPL_DEVICE_GET_CLASS (impl_device);
+
+      if (klass->release_fd_resources)
+        klass->release_fd_resources (impl_device);
+
       g_clear_pointer (&priv->device_file, meta_device_file_release);
       clear_fd_source (impl_device);
     }
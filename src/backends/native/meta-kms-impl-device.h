@@ -95,6 +95,7 @@ struct _MetaKmsImplDeviceClass
                                       MetaKmsPageFlipData *page_flip_data);
   void (* discard_pending_page_flips) (MetaKmsImplDevice *impl_device);
   void (* prepare_shutdown) (MetaKmsImplDevice *impl_device);
+  void (* release_fd_resources) (MetaKmsImplDevice *impl_device);
 };
 
 enum
@@ -19,9 +19,6 @@
 
 #include "backends/native/meta-kms-mode.h"
 
-uint32_t meta_kms_mode_create_blob_id (MetaKmsMode  *mode,
-                                       GError      **error);
-
 META_EXPORT_TEST
 MetaKmsMode * meta_kms_mode_clone (MetaKmsMode *mode);
 
@@ -40,31 +40,6 @@ meta_kms_mode_get_height (MetaKmsMode *mode)
   return mode->drm_mode.vdisplay;
 }
 
-uint32_t
-meta_kms_mode_create_blob_id (MetaKmsMode  *mode,
-                              GError      **error)
-{
-  int fd;
-  int ret;
-  uint32_t blob_id;
-
-  fd = meta_kms_impl_device_get_fd (mode->impl_device);
-
-  ret = drmModeCreatePropertyBlob (fd,
-                                   &mode->drm_mode,
-                                   sizeof (mode->drm_mode),
-                                   &blob_id);
-  if (ret < 0)
-    {
-      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (-ret),
-                   "drmModeCreatePropertyBlob: %s",
-                   g_strerror (-ret));
-      return 0;
-    }
-
-  return blob_id;
-}
-
 const char *
 meta_kms_mode_get_name (MetaKmsMode *mode)
 {
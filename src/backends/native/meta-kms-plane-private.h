@@ -72,6 +72,7 @@ MetaKmsPlane * meta_kms_plane_new (MetaKmsPlaneType         type,
 MetaKmsPlane * meta_kms_plane_new_fake (MetaKmsPlaneType  type,
                                         MetaKmsCrtc      *crtc);
 
+META_EXPORT_TEST
 uint32_t meta_kms_plane_get_prop_id (MetaKmsPlane     *plane,
                                      MetaKmsPlaneProp  prop);
 
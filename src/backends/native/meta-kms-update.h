@@ -152,6 +152,10 @@ void meta_kms_update_set_crtc_gamma (MetaKmsUpdate      *update,
                                      MetaKmsCrtc        *crtc,
                                      const MetaGammaLut *gamma);
 
+void meta_kms_update_set_vrr (MetaKmsUpdate *update,
+                              MetaKmsCrtc   *crtc,
+                              gboolean       enabled);
+
 void meta_kms_plane_assignment_set_fb_damage (MetaKmsPlaneAssignment *plane_assignment,
                                               const int              *rectangles,
                                               int                     n_rectangles);
@@ -216,6 +220,12 @@ meta_fixed_16_to_double (MetaFixed16 fixed)
   return fixed / 65536.0;
 }
 
+static inline MetaFixed16
+meta_fixed_16_from_double (double d)
+{
+  return (MetaFixed16) (d * 65536.0);
+}
+
 static inline MtkRectangle
 meta_fixed_16_rectangle_to_rectangle (MetaFixed16Rectangle fixed_rect)
 {
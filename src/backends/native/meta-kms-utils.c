@@ -22,6 +22,23 @@
 
 #include <drm_fourcc.h>
 #include <glib.h>
+#include <string.h>
+
+#include "core/util-private.h"
+
+/* Deadline evasion is based on the 95th percentile of the commit latency,
+ * once enough samples have been collected, plus a safety margin. */
+#define COMMIT_LATENCY_PERCENTILE 95
+#define MIN_COMMIT_LATENCY_SAMPLES 16
+#define DEADLINE_EVASION_MARGIN_US 200
+#define MIN_DEADLINE_EVASION_US 300
+#define MAX_DEADLINE_EVASION_US 4000
+/* Added for each missed deadline */
+#define MISSED_DEADLINE_STEP_US 250
+/* Lowering the deadline evasion requires the target to be at least this much
+ * lower, and no increase for this many frames. */
+#define DEADLINE_EVASION_HYSTERESIS_US 100
+#define DEADLINE_EVASION_DECREASE_DELAY_FRAMES 120
 
 /* added in libdrm 2.4.95 */
 #ifndef DRM_FORMAT_INVALID
@@ -99,3 +116,102 @@ meta_drm_format_to_string (MetaDrmFormatBuf *tmp,
   return tmp->s;
 }
 
+void
+meta_kms_deadline_evasion_init (MetaKmsDeadlineEvasion *deadline_evasion,
+                                int64_t                 initial_us)
+{
+  *deadline_evasion = (MetaKmsDeadlineEvasion) {
+    .evasion_us = initial_us,
+  };
+}
+
+/**
+ * meta_kms_deadline_evasion_get_commit_latency_us:
+ * @deadline_evasion: a #MetaKmsDeadlineEvasion
+ *
+ * Returns the 95th percentile of the recent commit latencies, or 0 if not
+ * enough have been recorded yet.
+ */
+int64_t
+meta_kms_deadline_evasion_get_commit_latency_us (MetaKmsDeadlineEvasion *deadline_evasion)
+{
+  int64_t sorted_latencies_us[META_KMS_DEADLINE_EVASION_N_SAMPLES];
+  int n_samples = deadline_evasion->n_samples;
+
+  if (n_samples < MIN_COMMIT_LATENCY_SAMPLES)
+    return 0;
+
+  memcpy (sorted_latencies_us, deadline_evasion->commit_latencies_us,
+          n_samples * sizeof (int64_t));
+
+  return meta_sort_samples_get_percentile (sorted_latencies_us, n_samples,
+                                           COMMIT_LATENCY_PERCENTILE);
+}
+
+/**
+ * meta_kms_deadline_evasion_add_commit_latency:
+ * @deadline_evasion: a #MetaKmsDeadlineEvasion
+ * @latency_us: time from the deadline until the update was committed
+ *
+ * Returns: %TRUE if the deadline evasion changed
+ */
+gboolean
+meta_kms_deadline_evasion_add_commit_latency (MetaKmsDeadlineEvasion *deadline_evasion,
+                                              int64_t                 latency_us)
+{
+  int64_t commit_latency_us;
+  int64_t target_us;
+
+  deadline_evasion->commit_latencies_us[deadline_evasion->next_sample] =
+    MAX (latency_us, 0);
+  deadline_evasion->next_sample = ((deadline_evasion->next_sample + 1) %
+                                   META_KMS_DEADLINE_EVASION_N_SAMPLES);
+  deadline_evasion->n_samples = MIN (deadline_evasion->n_samples + 1,
+                                     META_KMS_DEADLINE_EVASION_N_SAMPLES);
+  deadline_evasion->n_frames_since_raised++;
+
+  commit_latency_us =
+    meta_kms_deadline_evasion_get_commit_latency_us (deadline_evasion);
+  if (!commit_latency_us)
+    return FALSE;
+
+  target_us = CLAMP (commit_latency_us + DEADLINE_EVASION_MARGIN_US,
+                     MIN_DEADLINE_EVASION_US,
+                     MAX_DEADLINE_EVASION_US);
+
+  if (target_us > deadline_evasion->evasion_us)
+    {
+      deadline_evasion->evasion_us = target_us;
+      deadline_evasion->n_frames_since_raised = 0;
+      return TRUE;
+    }
+
+  if (target_us + DEADLINE_EVASION_HYSTERESIS_US <
+      deadline_evasion->evasion_us &&
+      deadline_evasion->n_frames_since_raised >=
+      DEADLINE_EVASION_DECREASE_DELAY_FRAMES)
+    {
+      deadline_evasion->evasion_us = target_us;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/**
+ * meta_kms_deadline_evasion_add_missed_deadline:
+ * @deadline_evasion: a #MetaKmsDeadlineEvasion
+ *
+ * Returns: %TRUE if the deadline evasion changed
+ */
+gboolean
+meta_kms_deadline_evasion_add_missed_deadline (MetaKmsDeadlineEvasion *deadline_evasion)
+{
+  int64_t old_evasion_us = deadline_evasion->evasion_us;
+
+  deadline_evasion->evasion_us = MIN (old_evasion_us + MISSED_DEADLINE_STEP_US,
+                                      MAX_DEADLINE_EVASION_US);
+  deadline_evasion->n_frames_since_raised = 0;
+
+  return deadline_evasion->evasion_us != old_evasion_us;
+}
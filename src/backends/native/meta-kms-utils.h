@@ -28,6 +28,23 @@ typedef struct _MetaDrmFormatBuf
   char s[5];
 } MetaDrmFormatBuf;
 
+#define META_KMS_DEADLINE_EVASION_N_SAMPLES 64
+
+/*
+ * Time to leave between the deadline timer firing and the start of vblank,
+ * learned from how long it took to get updates committed after previous
+ * deadlines, and from deadlines that were missed.
+ */
+typedef struct _MetaKmsDeadlineEvasion
+{
+  int64_t commit_latencies_us[META_KMS_DEADLINE_EVASION_N_SAMPLES];
+  int n_samples;
+  int next_sample;
+
+  int64_t evasion_us;
+  int n_frames_since_raised;
+} MetaKmsDeadlineEvasion;
+
 META_EXPORT_TEST
 float meta_calculate_drm_mode_refresh_rate (const drmModeModeInfo *drm_mode);
 
@@ -36,3 +53,17 @@ int64_t meta_calculate_drm_mode_vblank_duration_us (const drmModeModeInfo *drm_m
 
 const char * meta_drm_format_to_string (MetaDrmFormatBuf *tmp,
                                         uint32_t          drm_format);
+
+META_EXPORT_TEST
+void meta_kms_deadline_evasion_init (MetaKmsDeadlineEvasion *deadline_evasion,
+                                     int64_t                 initial_us);
+
+META_EXPORT_TEST
+gboolean meta_kms_deadline_evasion_add_commit_latency (MetaKmsDeadlineEvasion *deadline_evasion,
+                                                       int64_t                 latency_us);
+
+META_EXPORT_TEST
+gboolean meta_kms_deadline_evasion_add_missed_deadline (MetaKmsDeadlineEvasion *deadline_evasion);
+
+META_EXPORT_TEST
+int64_t meta_kms_deadline_evasion_get_commit_latency_us (MetaKmsDeadlineEvasion *deadline_evasion);
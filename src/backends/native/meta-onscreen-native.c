@@ -32,6 +32,7 @@
 #include <drm_fourcc.h>
 
 #include "backends/meta-egl-ext.h"
+#include "backends/meta-settings-private.h"
 #include "backends/native/meta-crtc-kms.h"
 #include "backends/native/meta-device-pool.h"
 #include "backends/native/meta-drm-buffer-dumb.h"
@@ -97,6 +98,13 @@ struct _MetaOnscreenNative
     MetaDrmBuffer *next_fb;
   } gbm;
 
+  struct {
+    MetaDrmBuffer *current_fb;
+    MetaDrmBuffer *next_fb;
+    MetaFixed16Rectangle src_rect;
+    MtkRectangle dst_rect;
+  } overlay;
+
 #ifdef HAVE_EGL_DEVICE
   struct {
     EGLStreamKHR stream;
@@ -111,6 +119,9 @@ struct _MetaOnscreenNative
   gboolean is_privacy_screen_invalid;
   gboolean is_color_space_invalid;
   gboolean is_hdr_metadata_invalid;
+  gboolean is_vrr_invalid;
+
+  gboolean is_vrr_enabled;
 
   gulong gamma_lut_changed_handler_id;
   gulong privacy_screen_changed_handler_id;
@@ -134,6 +145,7 @@ free_current_bo (CoglOnscreen *onscreen)
   MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
 
   g_clear_object (&onscreen_native->gbm.current_fb);
+  g_clear_object (&onscreen_native->overlay.current_fb);
 }
 
 static void
@@ -148,6 +160,10 @@ meta_onscreen_native_swap_drm_fb (CoglOnscreen *onscreen)
 
   g_set_object (&onscreen_native->gbm.current_fb, onscreen_native->gbm.next_fb);
   g_clear_object (&onscreen_native->gbm.next_fb);
+
+  g_set_object (&onscreen_native->overlay.current_fb,
+                onscreen_native->overlay.next_fb);
+  g_clear_object (&onscreen_native->overlay.next_fb);
 }
 
 static void
@@ -156,6 +172,7 @@ meta_onscreen_native_clear_next_fb (CoglOnscreen *onscreen)
   MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
 
   g_clear_object (&onscreen_native->gbm.next_fb);
+  g_clear_object (&onscreen_native->overlay.next_fb);
 }
 
 static void
@@ -223,6 +240,7 @@ notify_view_crtc_presented (MetaRendererView *view,
   onscreen_native->is_privacy_screen_invalid = FALSE;
   onscreen_native->is_color_space_invalid = FALSE;
   onscreen_native->is_hdr_metadata_invalid = FALSE;
+  onscreen_native->is_vrr_invalid = FALSE;
 
   crtc = META_CRTC (meta_crtc_kms_from_kms_crtc (kms_crtc));
   maybe_update_frame_info (crtc, frame_info, time_us, flags, sequence);
@@ -451,6 +469,19 @@ meta_onscreen_native_flip_crtc (CoglOnscreen                *onscreen,
           meta_kms_plane_assignment_set_fb_damage (plane_assignment,
                                                    rectangles, n_rectangles);
         }
+
+      if (onscreen_native->overlay.next_fb)
+        {
+          meta_crtc_kms_assign_overlay_plane (crtc_kms,
+                                              onscreen_native->overlay.next_fb,
+                                              &onscreen_native->overlay.src_rect,
+                                              &onscreen_native->overlay.dst_rect,
+                                              kms_update);
+        }
+      else if (onscreen_native->overlay.current_fb)
+        {
+          meta_crtc_kms_unassign_overlay_plane (crtc_kms, kms_update);
+        }
       break;
     case META_RENDERER_NATIVE_MODE_SURFACELESS:
       g_assert_not_reached ();
@@ -1026,7 +1057,21 @@ swap_buffer_result_feedback (const MetaKmsFeedback *kms_feedback,
   if (!g_error_matches (error,
                         G_IO_ERROR,
                         G_IO_ERROR_PERMISSION_DENIED))
-    g_warning ("Page flip failed: %s", error->message);
+    {
+      MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
+
+      g_warning ("Page flip failed: %s", error->message);
+
+      if (onscreen_native->overlay.next_fb)
+        {
+          ClutterStageView *view = CLUTTER_STAGE_VIEW (onscreen_native->view);
+
+          cogl_scanout_notify_failed (COGL_SCANOUT (onscreen_native->overlay.next_fb),
+                                      onscreen);
+          clutter_stage_view_add_redraw_clip (view, NULL);
+          clutter_stage_view_schedule_update_now (view);
+        }
+    }
 
   frame_info = cogl_onscreen_peek_head_frame_info (onscreen);
   frame_info->flags |= COGL_FRAME_INFO_FLAG_SYMBOLIC;
@@ -1288,6 +1333,85 @@ meta_onscreen_native_is_buffer_scanout_compatible (CoglOnscreen  *onscreen,
   return result == META_KMS_FEEDBACK_PASSED;
 }
 
+static MetaFixed16Rectangle
+fixed_16_rectangle_from_graphene_rect (const graphene_rect_t *rect)
+{
+  return META_FIXED_16_RECTANGLE_INIT (meta_fixed_16_from_double (rect->origin.x),
+                                       meta_fixed_16_from_double (rect->origin.y),
+                                       meta_fixed_16_from_double (rect->size.width),
+                                       meta_fixed_16_from_double (rect->size.height));
+}
+
+gboolean
+meta_onscreen_native_is_buffer_overlay_compatible (CoglOnscreen          *onscreen,
+                                                   MetaDrmBuffer         *fb,
+                                                   const graphene_rect_t *src_rect,
+                                                   const MtkRectangle    *dst_rect)
+{
+  MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
+  MetaCrtc *crtc = onscreen_native->crtc;
+  MetaCrtcKms *crtc_kms = META_CRTC_KMS (crtc);
+  MetaGpuKms *gpu_kms;
+  MetaKmsDevice *kms_device;
+  MetaKmsCrtc *kms_crtc;
+  MetaKmsUpdate *test_update;
+  MetaFixed16Rectangle fixed_src_rect;
+  g_autoptr (MetaKmsFeedback) kms_feedback = NULL;
+  MetaKmsFeedbackResult result;
+
+  /* The overlay is tested together with what is currently on the primary
+   * plane, as hardware limits usually depend on the combination of planes. */
+  if (!onscreen_native->gbm.current_fb)
+    return FALSE;
+
+  gpu_kms = META_GPU_KMS (meta_crtc_get_gpu (crtc));
+  kms_device = meta_gpu_kms_get_kms_device (gpu_kms);
+  kms_crtc = meta_crtc_kms_get_kms_crtc (crtc_kms);
+
+  if (!meta_kms_device_get_overlay_plane_for (kms_device, kms_crtc))
+    {
+      meta_topic (META_DEBUG_KMS,
+                  "No overlay plane available for CRTC %u (%s)",
+                  meta_kms_crtc_get_id (kms_crtc),
+                  meta_kms_device_get_path (kms_device));
+      return FALSE;
+    }
+
+  test_update = meta_kms_update_new (kms_device);
+  meta_crtc_kms_assign_primary_plane (crtc_kms,
+                                      onscreen_native->gbm.current_fb,
+                                      test_update);
+  fixed_src_rect = fixed_16_rectangle_from_graphene_rect (src_rect);
+  meta_crtc_kms_assign_overlay_plane (crtc_kms, fb, &fixed_src_rect, dst_rect,
+                                      test_update);
+
+  meta_topic (META_DEBUG_KMS,
+              "Posting overlay scanout test update for CRTC %u (%s) synchronously",
+              meta_kms_crtc_get_id (kms_crtc),
+              meta_kms_device_get_path (kms_device));
+
+  kms_feedback =
+    meta_kms_device_process_update_sync (kms_device, test_update,
+                                         META_KMS_UPDATE_FLAG_TEST_ONLY);
+
+  result = meta_kms_feedback_get_result (kms_feedback);
+  return result == META_KMS_FEEDBACK_PASSED;
+}
+
+void
+meta_onscreen_native_assign_overlay_scanout (CoglOnscreen          *onscreen,
+                                             CoglScanout           *scanout,
+                                             const graphene_rect_t *src_rect,
+                                             const MtkRectangle    *dst_rect)
+{
+  MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
+
+  g_set_object (&onscreen_native->overlay.next_fb, META_DRM_BUFFER (scanout));
+  onscreen_native->overlay.src_rect =
+    fixed_16_rectangle_from_graphene_rect (src_rect);
+  onscreen_native->overlay.dst_rect = *dst_rect;
+}
+
 static void
 scanout_result_feedback (const MetaKmsFeedback *kms_feedback,
                          gpointer               user_data)
@@ -1480,6 +1604,16 @@ meta_onscreen_native_prepare_frame (CoglOnscreen *onscreen,
       meta_kms_update_set_privacy_screen (kms_update, kms_connector, enabled);
     }
 
+  if (onscreen_native->is_vrr_invalid)
+    {
+      MetaKmsUpdate *kms_update;
+
+      kms_update = meta_frame_native_ensure_kms_update (frame_native,
+                                                        kms_device);
+      meta_kms_update_set_vrr (kms_update, kms_crtc,
+                               onscreen_native->is_vrr_enabled);
+    }
+
   if (onscreen_native->is_color_space_invalid)
     {
       MetaKmsConnector *kms_connector =
@@ -1934,7 +2068,15 @@ meta_onscreen_native_set_view (CoglOnscreen     *onscreen,
                                MetaRendererView *view)
 {
   MetaOnscreenNative *onscreen_native = META_ONSCREEN_NATIVE (onscreen);
+  ClutterFrameClock *frame_clock;
+
   onscreen_native->view = view;
+
+  frame_clock = clutter_stage_view_get_frame_clock (CLUTTER_STAGE_VIEW (view));
+  clutter_frame_clock_set_mode (frame_clock,
+                                onscreen_native->is_vrr_enabled ?
+                                CLUTTER_FRAME_CLOCK_MODE_VARIABLE :
+                                CLUTTER_FRAME_CLOCK_MODE_FIXED);
 }
 
 static gboolean
@@ -2265,6 +2407,20 @@ init_secondary_gpu_state (MetaRendererNative  *renderer_native,
   return TRUE;
 }
 
+static gboolean
+is_vrr_supported (MetaOutput *output,
+                  MetaCrtc   *crtc)
+{
+  MetaKmsCrtc *kms_crtc = meta_crtc_kms_get_kms_crtc (META_CRTC_KMS (crtc));
+  const MetaKmsCrtcState *crtc_state;
+
+  if (!meta_output_get_info (output)->supports_vrr)
+    return FALSE;
+
+  crtc_state = meta_kms_crtc_get_current_state (kms_crtc);
+  return crtc_state->vrr.supported;
+}
+
 void
 meta_onscreen_native_invalidate (MetaOnscreenNative *onscreen_native)
 {
@@ -2278,6 +2434,8 @@ meta_onscreen_native_invalidate (MetaOnscreenNative *onscreen_native)
   if (meta_output_is_hdr_metadata_supported (onscreen_native->output,
                                              META_OUTPUT_HDR_METADATA_EOTF_TRADITIONAL_GAMMA_SDR))
     onscreen_native->is_hdr_metadata_invalid = TRUE;
+  if (is_vrr_supported (onscreen_native->output, onscreen_native->crtc))
+    onscreen_native->is_vrr_invalid = TRUE;
 }
 
 static void
@@ -2349,6 +2507,23 @@ meta_onscreen_native_new (MetaRendererNative *renderer_native,
   g_set_object (&onscreen_native->output, output);
   g_set_object (&onscreen_native->crtc, crtc);
 
+  if (is_vrr_supported (output, crtc))
+    {
+      MetaRenderer *renderer = META_RENDERER (renderer_native);
+      MetaBackend *backend = meta_renderer_get_backend (renderer);
+      MetaSettings *settings = meta_backend_get_settings (backend);
+
+      onscreen_native->is_vrr_enabled =
+        meta_settings_is_experimental_feature_enabled (
+          settings, META_EXPERIMENTAL_FEATURE_VARIABLE_REFRESH_RATE);
+      onscreen_native->is_vrr_invalid = TRUE;
+
+      meta_topic (META_DEBUG_KMS,
+                  "Variable refresh rate %s on CRTC %" G_GUINT64_FORMAT,
+                  onscreen_native->is_vrr_enabled ? "enabled" : "disabled",
+                  meta_crtc_get_id (crtc));
+    }
+
   if (meta_crtc_get_gamma_lut_size (crtc) > 0)
     {
       onscreen_native->is_gamma_lut_invalid = TRUE;
@@ -2421,6 +2596,7 @@ meta_onscreen_native_dispose (GObject *object)
     {
     case META_RENDERER_NATIVE_MODE_GBM:
       g_clear_object (&onscreen_native->gbm.next_fb);
+      g_clear_object (&onscreen_native->overlay.next_fb);
       free_current_bo (onscreen);
       break;
     case META_RENDERER_NATIVE_MODE_SURFACELESS:
@@ -48,6 +48,16 @@ void meta_onscreen_native_dummy_power_save_page_flip (CoglOnscreen *onscreen);
 gboolean meta_onscreen_native_is_buffer_scanout_compatible (CoglOnscreen  *onscreen,
                                                             MetaDrmBuffer *fb);
 
+gboolean meta_onscreen_native_is_buffer_overlay_compatible (CoglOnscreen          *onscreen,
+                                                            MetaDrmBuffer         *fb,
+                                                            const graphene_rect_t *src_rect,
+                                                            const MtkRectangle    *dst_rect);
+
+void meta_onscreen_native_assign_overlay_scanout (CoglOnscreen          *onscreen,
+                                                  CoglScanout           *scanout,
+                                                  const graphene_rect_t *src_rect,
+                                                  const MtkRectangle    *dst_rect);
+
 void meta_onscreen_native_set_view (CoglOnscreen     *onscreen,
                                     MetaRendererView *view);
 
@@ -487,6 +487,8 @@ meta_output_kms_new (MetaGpuKms        *gpu_kms,
   output_info->hotplug_mode_update = connector_state->hotplug_mode_update;
   output_info->supports_underscanning =
     meta_kms_connector_is_underscanning_supported (kms_connector);
+  output_info->supports_vrr =
+    meta_kms_connector_is_vrr_capable (kms_connector);
 
   max_bpc_range = meta_kms_connector_get_max_bpc (kms_connector);
   if (max_bpc_range)
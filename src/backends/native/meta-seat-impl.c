@@ -103,8 +103,21 @@ static guint signals[N_SIGNALS] = { 0 };
 typedef struct _MetaSeatImplPrivate
 {
   GHashTable *device_files;
+
+  /* Queued from the input thread, dispatched in one go by a single
+   * idle source in the main thread */
+  GMutex main_thread_idles_lock;
+  GQueue main_thread_idles;
+  GSource *main_thread_idles_source;
 } MetaSeatImplPrivate;
 
+typedef struct _MetaSeatImplIdle
+{
+  GSourceFunc func;
+  gpointer user_data;
+  GDestroyNotify destroy_notify;
+} MetaSeatImplIdle;
+
 static void meta_seat_impl_initable_iface_init (GInitableIface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (MetaSeatImpl, meta_seat_impl, G_TYPE_OBJECT,
@@ -293,7 +306,14 @@ queue_event (MetaSeatImpl *seat_impl,
     }
 #endif
 
-  _clutter_event_push (event, FALSE);
+  /* Event timestamps come from the kernel, so this shows how long
+   * libinput and the input thread took to get to it */
+  COGL_TRACE_MARK ("Input (to queued)",
+                   clutter_event_get_time_us (event),
+                   g_get_monotonic_time (),
+                   clutter_event_get_name (event));
+
+  _clutter_event_push_from_input_thread (event);
 }
 
 static int
@@ -320,20 +340,82 @@ update_button_count (MetaSeatImpl *seat_impl,
     }
 }
 
+static void
+seat_impl_idle_free (MetaSeatImplIdle *idle)
+{
+  if (idle->destroy_notify)
+    idle->destroy_notify (idle->user_data);
+  g_free (idle);
+}
+
+static void
+push_main_thread_idle (MetaSeatImpl     *seat_impl,
+                       MetaSeatImplIdle *idle);
+
+static gboolean
+dispatch_main_thread_idles (gpointer user_data)
+{
+  MetaSeatImpl *seat_impl = META_SEAT_IMPL (user_data);
+  MetaSeatImplPrivate *priv = meta_seat_impl_get_instance_private (seat_impl);
+  GQueue idles;
+  MetaSeatImplIdle *idle;
+
+  g_mutex_lock (&priv->main_thread_idles_lock);
+  idles = priv->main_thread_idles;
+  g_queue_init (&priv->main_thread_idles);
+  g_clear_pointer (&priv->main_thread_idles_source, g_source_unref);
+  g_mutex_unlock (&priv->main_thread_idles_lock);
+
+  while ((idle = g_queue_pop_head (&idles)))
+    {
+      if (idle->func (idle->user_data) == G_SOURCE_CONTINUE)
+        push_main_thread_idle (seat_impl, idle);
+      else
+        seat_impl_idle_free (idle);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+push_main_thread_idle (MetaSeatImpl     *seat_impl,
+                       MetaSeatImplIdle *idle)
+{
+  MetaSeatImplPrivate *priv = meta_seat_impl_get_instance_private (seat_impl);
+
+  g_mutex_lock (&priv->main_thread_idles_lock);
+
+  g_queue_push_tail (&priv->main_thread_idles, idle);
+
+  if (!priv->main_thread_idles_source)
+    {
+      GSource *source;
+
+      source = g_idle_source_new ();
+      g_source_set_priority (source, G_PRIORITY_HIGH);
+      g_source_set_callback (source, dispatch_main_thread_idles,
+                             seat_impl, NULL);
+      g_source_attach (source, seat_impl->main_context);
+      priv->main_thread_idles_source = source;
+    }
+
+  g_mutex_unlock (&priv->main_thread_idles_lock);
+}
+
 void
 meta_seat_impl_queue_main_thread_idle (MetaSeatImpl   *seat_impl,
                                        GSourceFunc     func,
                                        gpointer        user_data,
                                        GDestroyNotify  destroy_notify)
 {
-  GSource *source;
+  MetaSeatImplIdle *idle;
 
-  source = g_idle_source_new ();
-  g_source_set_priority (source, G_PRIORITY_HIGH);
-  g_source_set_callback (source, func, user_data, destroy_notify);
+  idle = g_new0 (MetaSeatImplIdle, 1);
+  idle->func = func;
+  idle->user_data = user_data;
+  idle->destroy_notify = destroy_notify;
 
-  g_source_attach (source, seat_impl->main_context);
-  g_source_unref (source);
+  push_main_thread_idle (seat_impl, idle);
 }
 
 typedef struct
@@ -2860,6 +2942,7 @@ input_thread (MetaSeatImpl *seat_impl)
   struct xkb_keymap *xkb_keymap;
 
   g_main_context_push_thread_default (seat_impl->input_context);
+  _clutter_event_register_input_thread ();
 
 #ifdef HAVE_PROFILER
   meta_profiler_register_thread (profiler,
@@ -2924,6 +3007,7 @@ input_thread (MetaSeatImpl *seat_impl)
   meta_profiler_unregister_thread (profiler, seat_impl->input_context);
 #endif
 
+  _clutter_event_unregister_input_thread ();
   g_main_context_pop_thread_default (seat_impl->input_context);
 
   return NULL;
@@ -3088,11 +3172,21 @@ static void
 meta_seat_impl_finalize (GObject *object)
 {
   MetaSeatImpl *seat_impl = META_SEAT_IMPL (object);
+  MetaSeatImplPrivate *priv = meta_seat_impl_get_instance_private (seat_impl);
 
   g_assert (!seat_impl->libinput);
   g_assert (!seat_impl->tools);
   g_assert (!seat_impl->libinput_source);
 
+  if (priv->main_thread_idles_source)
+    {
+      g_source_destroy (priv->main_thread_idles_source);
+      g_clear_pointer (&priv->main_thread_idles_source, g_source_unref);
+    }
+  g_queue_clear_full (&priv->main_thread_idles,
+                      (GDestroyNotify) seat_impl_idle_free);
+  g_mutex_clear (&priv->main_thread_idles_lock);
+
   g_free (seat_impl->seat_id);
 
   g_rw_lock_clear (&seat_impl->state_lock);
@@ -3350,6 +3444,8 @@ meta_seat_impl_class_init (MetaSeatImplClass *klass)
 static void
 meta_seat_impl_init (MetaSeatImpl *seat_impl)
 {
+  MetaSeatImplPrivate *priv = meta_seat_impl_get_instance_private (seat_impl);
+
   g_rw_lock_init (&seat_impl->state_lock);
 
   seat_impl->repeat = TRUE;
@@ -3359,6 +3455,9 @@ meta_seat_impl_init (MetaSeatImpl *seat_impl)
   g_mutex_init (&seat_impl->init_mutex);
   g_cond_init (&seat_impl->init_cond);
 
+  g_mutex_init (&priv->main_thread_idles_lock);
+  g_queue_init (&priv->main_thread_idles);
+
   seat_impl->barrier_manager = meta_barrier_manager_native_new ();
 }
 
@@ -204,7 +204,7 @@ release_device_in_impl (GTask *task)
                                                   CLUTTER_EVENT_NONE,
                                                   time_us,
                                                   impl_state->device);
-  _clutter_event_push (device_event, FALSE);
+  _clutter_event_push_from_input_thread (device_event);
 
   g_clear_object (&impl_state->device);
   g_task_return_boolean (task, TRUE);
@@ -0,0 +1,30 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "core/util-private.h"
+#include "meta/meta-background-image.h"
+
+G_BEGIN_DECLS
+
+META_EXPORT_TEST
+MetaBackgroundImage * meta_background_image_cache_load_scaled (MetaBackgroundImageCache *cache,
+                                                               GFile                    *file,
+                                                               int                       max_width,
+                                                               int                       max_height);
+
+G_END_DECLS
@@ -18,13 +18,24 @@
 
 #include "config.h"
 
-#include "meta/meta-background-image.h"
+#include "compositor/meta-background-image-private.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <math.h>
 
 #include "clutter/clutter.h"
 #include "compositor/cogl-utils.h"
+#include "compositor/meta-background-texture-cache.h"
+#include "mtk/mtk.h"
+
+#define MAX_DECODE_THREADS 4
+#define DECODE_BUFFER_SIZE (64 * 1024)
+
+/* Limits of the on-disk cache of scaled images */
+#define MAX_DISK_CACHE_SIZE (128 * 1024 * 1024)
+#define MAX_DISK_CACHE_AGE_S (30 * 24 * 60 * 60)
 
 enum
 {
@@ -47,6 +58,11 @@ struct _MetaBackgroundImageCache
   GObject parent_instance;
 
   GHashTable *images;
+
+  /* Decodes images, separately from the GTask pool used for file I/O */
+  GThreadPool *decode_pool;
+
+  guint prune_idle_id;
 };
 
 /**
@@ -58,18 +74,49 @@ struct _MetaBackgroundImage
 {
   GObject parent_instance;
   GFile *file;
+  char *key;
   MetaBackgroundImageCache *cache;
   gboolean in_cache;
   gboolean loaded;
   CoglTexture *texture;
 };
 
+typedef struct _LoadData
+{
+  GFile *file;
+  int max_width;
+  int max_height;
+
+  gboolean cached_file_saved;
+} LoadData;
+
+typedef struct _DecodeSize
+{
+  int max_width;
+  int max_height;
+  gboolean scaled;
+} DecodeSize;
+
 G_DEFINE_TYPE (MetaBackgroundImageCache, meta_background_image_cache, G_TYPE_OBJECT);
 
+static void decode_job_func (GTask    *task,
+                             gpointer  user_data);
+
+static void queue_prune_disk_cache (MetaBackgroundImageCache *cache);
+
 static void
 meta_background_image_cache_init (MetaBackgroundImageCache *cache)
 {
-  cache->images = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  cache->images = g_hash_table_new (g_str_hash, g_str_equal);
+  cache->decode_pool = g_thread_pool_new ((GFunc) decode_job_func,
+                                          NULL,
+                                          MIN (g_get_num_processors (),
+                                               MAX_DECODE_THREADS),
+                                          FALSE,
+                                          NULL);
+
+  /* Prune files left over from earlier sessions */
+  queue_prune_disk_cache (cache);
 }
 
 static void
@@ -87,6 +134,8 @@ meta_background_image_cache_finalize (GObject *object)
     }
 
   g_hash_table_destroy (cache->images);
+  g_thread_pool_free (cache->decode_pool, FALSE, TRUE);
+  g_clear_handle_id (&cache->prune_idle_id, g_source_remove);
 
   G_OBJECT_CLASS (meta_background_image_cache_parent_class)->finalize (object);
 }
@@ -116,32 +165,246 @@ meta_background_image_cache_get_default (void)
 }
 
 static void
-load_file (GTask               *task,
-           MetaBackgroundImage *image,
-           gpointer             task_data,
-           GCancellable        *cancellable)
+load_data_free (LoadData *load_data)
 {
-  GError *error = NULL;
+  g_object_unref (load_data->file);
+  g_free (load_data);
+}
+
+static char *
+get_cached_file_path (LoadData *load_data)
+{
+  g_autoptr (GFileInfo) file_info = NULL;
+  g_autofree char *uri = NULL;
+  g_autofree char *description = NULL;
+  g_autofree char *checksum = NULL;
+  g_autofree char *file_name = NULL;
+
+  file_info = g_file_query_info (load_data->file,
+                                 G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                 G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                 G_FILE_QUERY_INFO_NONE,
+                                 NULL, NULL);
+  if (!file_info)
+    return NULL;
+
+  /* Any change to the original file results in a different cache file */
+  uri = g_file_get_uri (load_data->file);
+  description =
+    g_strdup_printf ("%s\n%" G_GUINT64_FORMAT "\n%" G_GOFFSET_FORMAT "\n%dx%d",
+                     uri,
+                     g_file_info_get_attribute_uint64 (file_info,
+                                                       G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                     g_file_info_get_size (file_info),
+                     load_data->max_width, load_data->max_height);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256,
+                                            description, -1);
+  file_name = g_strconcat (checksum, ".png", NULL);
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           "mutter", "backgrounds", file_name,
+                           NULL);
+}
+
+/*
+ * Cache files are touched whenever they are used. Pruning happens on the
+ * main thread, so that decode threads don't race each other removing
+ * files.
+ */
+static gboolean
+prune_disk_cache (gpointer user_data)
+{
+  MetaBackgroundImageCache *cache = user_data;
+  g_autofree char *dir = NULL;
+
+  cache->prune_idle_id = 0;
+
+  dir = g_build_filename (g_get_user_cache_dir (),
+                          "mutter", "backgrounds",
+                          NULL);
+  mtk_disk_cache_prune (dir, ".png",
+                        MAX_DISK_CACHE_SIZE,
+                        MAX_DISK_CACHE_AGE_S);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+queue_prune_disk_cache (MetaBackgroundImageCache *cache)
+{
+  if (cache->prune_idle_id)
+    return;
+
+  cache->prune_idle_id = g_idle_add_full (G_PRIORITY_LOW,
+                                          prune_disk_cache, cache,
+                                          NULL);
+}
+
+static gboolean
+save_cached_file (GdkPixbuf  *pixbuf,
+                  const char *path)
+{
+  g_autofree char *dir = NULL;
+  g_autofree char *buffer = NULL;
+  gsize buffer_size;
+
+  dir = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dir, 0700) != 0)
+    return FALSE;
+
+  if (!gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_size, "png",
+                                  NULL, NULL))
+    return FALSE;
+
+  return g_file_set_contents (path, buffer, buffer_size, NULL);
+}
+
+static void
+on_size_prepared (GdkPixbufLoader *loader,
+                  int              width,
+                  int              height,
+                  DecodeSize      *size)
+{
+  double scale;
+
+  if (size->max_width == 0 || size->max_height == 0)
+    return;
+
+  /* Keep the image covering the largest area it is painted to, so that it
+   * is only ever scaled down further by the GPU.
+   */
+  scale = MAX ((double) size->max_width / width,
+               (double) size->max_height / height);
+  if (scale >= 1.0)
+    return;
+
+  gdk_pixbuf_loader_set_size (loader,
+                              (int) ceil (width * scale),
+                              (int) ceil (height * scale));
+  size->scaled = TRUE;
+}
+
+static GdkPixbuf *
+decode_file (GFile       *file,
+             DecodeSize  *size,
+             GError     **error)
+{
+  g_autoptr (GFileInputStream) stream = NULL;
+  g_autoptr (GdkPixbufLoader) loader = NULL;
+  g_autofree uint8_t *buffer = NULL;
   GdkPixbuf *pixbuf;
-  GFileInputStream *stream;
 
-  stream = g_file_read (image->file, NULL, &error);
+  stream = g_file_read (file, NULL, error);
   if (stream == NULL)
+    return NULL;
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared",
+                    G_CALLBACK (on_size_prepared), size);
+
+  buffer = g_malloc (DECODE_BUFFER_SIZE);
+  while (TRUE)
     {
-      g_task_return_error (task, error);
-      return;
+      gssize n_read;
+
+      n_read = g_input_stream_read (G_INPUT_STREAM (stream),
+                                    buffer, DECODE_BUFFER_SIZE,
+                                    NULL, error);
+      if (n_read < 0)
+        {
+          gdk_pixbuf_loader_close (loader, NULL);
+          return NULL;
+        }
+
+      if (n_read == 0)
+        break;
+
+      if (!gdk_pixbuf_loader_write (loader, buffer, n_read, error))
+        {
+          gdk_pixbuf_loader_close (loader, NULL);
+          return NULL;
+        }
     }
 
-  pixbuf = gdk_pixbuf_new_from_stream (G_INPUT_STREAM (stream), NULL, &error);
-  g_object_unref (stream);
+  if (!gdk_pixbuf_loader_close (loader, error))
+    return NULL;
 
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (pixbuf == NULL)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "No image data");
+      return NULL;
+    }
+
+  return gdk_pixbuf_apply_embedded_orientation (pixbuf);
+}
+
+static void
+decode_job_func (GTask    *task,
+                 gpointer  user_data)
+{
+  LoadData *load_data = g_task_get_task_data (task);
+  g_autofree char *cached_file_path = NULL;
+  GError *error = NULL;
+  DecodeSize size;
+  GdkPixbuf *pixbuf;
+
+  if (load_data->max_width > 0 && load_data->max_height > 0)
+    cached_file_path = get_cached_file_path (load_data);
+
+  if (cached_file_path)
+    {
+      pixbuf = gdk_pixbuf_new_from_file (cached_file_path, NULL);
+      if (pixbuf)
+        {
+          /* Mark as recently used, for pruning the cache */
+          g_utime (cached_file_path, NULL);
+          goto out;
+        }
+    }
+
+  size = (DecodeSize) {
+    .max_width = load_data->max_width,
+    .max_height = load_data->max_height,
+  };
+  pixbuf = decode_file (load_data->file, &size, &error);
   if (pixbuf == NULL)
     {
       g_task_return_error (task, error);
+      g_object_unref (task);
       return;
     }
 
+  if (!size.scaled)
+    goto out;
+
+  /* The orientation is only known after decoding; start over without
+   * scaling if rotating made the image too small.
+   */
+  if (gdk_pixbuf_get_width (pixbuf) < load_data->max_width ||
+      gdk_pixbuf_get_height (pixbuf) < load_data->max_height)
+    {
+      g_object_unref (pixbuf);
+
+      size = (DecodeSize) { 0 };
+      pixbuf = decode_file (load_data->file, &size, &error);
+      if (pixbuf == NULL)
+        {
+          g_task_return_error (task, error);
+          g_object_unref (task);
+          return;
+        }
+
+      goto out;
+    }
+
+  if (cached_file_path)
+    load_data->cached_file_saved = save_cached_file (pixbuf, cached_file_path);
+
+out:
   g_task_return_pointer (task, pixbuf, (GDestroyNotify) g_object_unref);
+  g_object_unref (task);
 }
 
 static void
@@ -152,9 +415,10 @@ file_loaded (GObject      *source_object,
   MetaBackgroundImage *image = META_BACKGROUND_IMAGE (source_object);
   g_autoptr (GError) error = NULL;
   g_autoptr (GError) local_error = NULL;
+  LoadData *load_data;
   GTask *task;
   CoglTexture *texture;
-  GdkPixbuf *pixbuf, *rotated;
+  GdkPixbuf *pixbuf;
   int width, height, row_stride;
   guchar *pixels;
   gboolean has_alpha;
@@ -162,6 +426,10 @@ file_loaded (GObject      *source_object,
   task = G_TASK (result);
   pixbuf = g_task_propagate_pointer (task, &error);
 
+  load_data = g_task_get_task_data (task);
+  if (load_data->cached_file_saved && image->in_cache)
+    queue_prune_disk_cache (image->cache);
+
   if (pixbuf == NULL)
     {
       char *uri = g_file_get_uri (image->file);
@@ -171,13 +439,6 @@ file_loaded (GObject      *source_object,
       goto out;
     }
 
-  rotated = gdk_pixbuf_apply_embedded_orientation (pixbuf);
-  if (rotated != NULL)
-    {
-      g_object_unref (pixbuf);
-      pixbuf = rotated;
-    }
-
   width = gdk_pixbuf_get_width (pixbuf);
   height = gdk_pixbuf_get_height (pixbuf);
   row_stride = gdk_pixbuf_get_rowstride (pixbuf);
@@ -209,6 +470,16 @@ out:
   g_signal_emit (image, signals[LOADED], 0);
 }
 
+static char *
+get_image_key (GFile *file,
+               int    max_width,
+               int    max_height)
+{
+  g_autofree char *uri = g_file_get_uri (file);
+
+  return g_strdup_printf ("%s@%dx%d", uri, max_width, max_height);
+}
+
 /**
  * meta_background_image_cache_load:
  * @cache: a #MetaBackgroundImageCache
@@ -228,14 +499,35 @@ out:
 MetaBackgroundImage *
 meta_background_image_cache_load (MetaBackgroundImageCache *cache,
                                   GFile                    *file)
+{
+  g_return_val_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache), NULL);
+  g_return_val_if_fail (file != NULL, NULL);
+
+  return meta_background_image_cache_load_scaled (cache, file, 0, 0);
+}
+
+/*
+ * Like meta_background_image_cache_load(), but allows the image to be scaled
+ * down while decoding, as long as it still covers @max_width x @max_height.
+ * Scaled down images are also kept in a cache on disk. Passing 0 for either
+ * size loads the image at its original size.
+ */
+MetaBackgroundImage *
+meta_background_image_cache_load_scaled (MetaBackgroundImageCache *cache,
+                                         GFile                    *file,
+                                         int                       max_width,
+                                         int                       max_height)
 {
   MetaBackgroundImage *image;
+  g_autofree char *key = NULL;
+  LoadData *load_data;
   GTask *task;
 
-  g_return_val_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache), NULL);
-  g_return_val_if_fail (file != NULL, NULL);
+  if (max_width <= 0 || max_height <= 0)
+    max_width = max_height = 0;
 
-  image = g_hash_table_lookup (cache->images, file);
+  key = get_image_key (file, max_width, max_height);
+  image = g_hash_table_lookup (cache->images, key);
   if (image != NULL)
     return g_object_ref (image);
 
@@ -243,12 +535,18 @@ meta_background_image_cache_load (MetaBackgroundImageCache *cache,
   image->cache = cache;
   image->in_cache = TRUE;
   image->file = g_object_ref (file);
-  g_hash_table_insert (cache->images, image->file, image);
+  image->key = g_steal_pointer (&key);
+  g_hash_table_insert (cache->images, image->key, image);
+
+  load_data = g_new0 (LoadData, 1);
+  load_data->file = g_object_ref (file);
+  load_data->max_width = max_width;
+  load_data->max_height = max_height;
 
   task = g_task_new (image, NULL, file_loaded, NULL);
+  g_task_set_task_data (task, load_data, (GDestroyNotify) load_data_free);
 
-  g_task_run_in_thread (task, (GTaskThreadFunc) load_file);
-  g_object_unref (task);
+  g_thread_pool_push (cache->decode_pool, task, NULL);
 
   return image;
 }
@@ -265,17 +563,27 @@ void
 meta_background_image_cache_purge (MetaBackgroundImageCache *cache,
                                    GFile                    *file)
 {
-  MetaBackgroundImage *image;
+  GHashTableIter iter;
+  gpointer value;
 
   g_return_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache));
   g_return_if_fail (file != NULL);
 
-  image = g_hash_table_lookup (cache->images, file);
-  if (image == NULL)
-    return;
+  meta_background_texture_cache_purge_file (meta_background_texture_cache_get_default (),
+                                            file);
 
-  g_hash_table_remove (cache->images, image->file);
-  image->in_cache = FALSE;
+  /* The file may be loaded at several sizes */
+  g_hash_table_iter_init (&iter, cache->images);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      MetaBackgroundImage *image = value;
+
+      if (!g_file_equal (image->file, file))
+        continue;
+
+      g_hash_table_iter_remove (&iter);
+      image->in_cache = FALSE;
+    }
 }
 
 G_DEFINE_TYPE (MetaBackgroundImage, meta_background_image, G_TYPE_OBJECT);
@@ -291,12 +599,13 @@ meta_background_image_finalize (GObject *object)
   MetaBackgroundImage *image = META_BACKGROUND_IMAGE (object);
 
   if (image->in_cache)
-    g_hash_table_remove (image->cache->images, image->file);
+    g_hash_table_remove (image->cache->images, image->key);
 
   if (image->texture)
     g_object_unref (image->texture);
   if (image->file)
     g_object_unref (image->file);
+  g_free (image->key);
 
   G_OBJECT_CLASS (meta_background_image_parent_class)->finalize (object);
 }
@@ -0,0 +1,373 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "compositor/meta-background-texture-cache.h"
+
+#include <stdlib.h>
+
+#include "meta/util.h"
+
+#define DEFAULT_BUDGET_MB 128
+#define MAX_FILES 2
+
+struct _MetaBackgroundCachedTexture
+{
+  MetaBackgroundTextureCache *cache;
+
+  char *key;
+  CoglTexture *texture;
+  size_t size;
+
+  /* Background images the texture was rendered from */
+  GFile *files[MAX_FILES];
+  int n_files;
+
+  /* Number of backgrounds using the texture */
+  int use_count;
+  /* Whether it can still be found by its key */
+  gboolean in_cache;
+  /* Position in the idle queue, while not used by any background */
+  GList idle_link;
+};
+
+struct _MetaBackgroundTextureCache
+{
+  GHashTable *textures;
+  /* Unused textures, most recently used first */
+  GQueue idle_textures;
+
+  size_t in_use_size;
+  size_t idle_size;
+  size_t budget;
+};
+
+static size_t
+get_texture_size (CoglTexture *texture)
+{
+  size_t size;
+
+  size = ((size_t) cogl_texture_get_width (texture) *
+          cogl_texture_get_height (texture) * 4);
+
+  /* Leave room for mipmaps, which backgrounds are often painted with */
+  return size + size / 3;
+}
+
+MetaBackgroundTextureCache *
+meta_background_texture_cache_new (size_t budget)
+{
+  MetaBackgroundTextureCache *cache;
+
+  cache = g_new0 (MetaBackgroundTextureCache, 1);
+  cache->textures = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&cache->idle_textures);
+  cache->budget = budget;
+
+  return cache;
+}
+
+/*
+ * Frees @cache, which must not have any texture in use anymore.
+ */
+void
+meta_background_texture_cache_free (MetaBackgroundTextureCache *cache)
+{
+  g_warn_if_fail (cache->in_use_size == 0);
+
+  meta_background_texture_cache_purge_all (cache);
+  g_hash_table_destroy (cache->textures);
+  g_free (cache);
+}
+
+MetaBackgroundTextureCache *
+meta_background_texture_cache_get_default (void)
+{
+  static MetaBackgroundTextureCache *cache;
+  const char *budget_env;
+
+  if (cache)
+    return cache;
+
+  cache = meta_background_texture_cache_new ((size_t) DEFAULT_BUDGET_MB *
+                                             1024 * 1024);
+
+  budget_env = g_getenv ("MUTTER_DEBUG_BACKGROUND_CACHE_BUDGET_MB");
+  if (budget_env)
+    {
+      meta_background_texture_cache_set_budget (cache,
+                                                (size_t) strtoul (budget_env,
+                                                                  NULL, 10) *
+                                                1024 * 1024);
+    }
+
+  return cache;
+}
+
+static void
+cached_texture_free (MetaBackgroundCachedTexture *cached_texture)
+{
+  int i;
+
+  for (i = 0; i < cached_texture->n_files; i++)
+    g_object_unref (cached_texture->files[i]);
+  g_object_unref (cached_texture->texture);
+  g_free (cached_texture->key);
+  g_free (cached_texture);
+}
+
+static void
+remove_idle_texture (MetaBackgroundTextureCache  *cache,
+                     MetaBackgroundCachedTexture *cached_texture)
+{
+  g_queue_unlink (&cache->idle_textures, &cached_texture->idle_link);
+  cache->idle_size -= cached_texture->size;
+
+  if (cached_texture->in_cache)
+    g_hash_table_remove (cache->textures, cached_texture->key);
+
+  cached_texture_free (cached_texture);
+}
+
+static void
+log_usage (MetaBackgroundTextureCache *cache)
+{
+  MetaBackgroundTextureCacheUsage usage;
+
+  if (!meta_is_topic_enabled (META_DEBUG_BACKGROUND))
+    return;
+
+  meta_background_texture_cache_get_usage (cache, &usage);
+  meta_topic (META_DEBUG_BACKGROUND,
+              "Texture cache holds %u textures, %zu KiB in use and %zu KiB "
+              "idle, out of a budget of %zu KiB",
+              usage.n_textures,
+              usage.in_use_size / 1024,
+              usage.idle_size / 1024,
+              usage.budget / 1024);
+}
+
+static void
+maybe_evict (MetaBackgroundTextureCache *cache)
+{
+  while (cache->in_use_size + cache->idle_size > cache->budget &&
+         !g_queue_is_empty (&cache->idle_textures))
+    {
+      GList *l = g_queue_peek_tail_link (&cache->idle_textures);
+
+      remove_idle_texture (cache, l->data);
+    }
+
+  log_usage (cache);
+}
+
+/*
+ * Returns the texture cached for @key, if any, which must be released with
+ * meta_background_cached_texture_release() when no longer used.
+ */
+MetaBackgroundCachedTexture *
+meta_background_texture_cache_lookup (MetaBackgroundTextureCache *cache,
+                                      const char                 *key)
+{
+  MetaBackgroundCachedTexture *cached_texture;
+
+  cached_texture = g_hash_table_lookup (cache->textures, key);
+  if (!cached_texture)
+    return NULL;
+
+  if (cached_texture->use_count == 0)
+    {
+      g_queue_unlink (&cache->idle_textures, &cached_texture->idle_link);
+      cache->idle_size -= cached_texture->size;
+      cache->in_use_size += cached_texture->size;
+    }
+
+  cached_texture->use_count++;
+
+  return cached_texture;
+}
+
+/*
+ * Adds @texture, rendered from @files, to the cache. It must not be changed
+ * afterwards, as it may be shared with other backgrounds.
+ */
+MetaBackgroundCachedTexture *
+meta_background_texture_cache_insert (MetaBackgroundTextureCache  *cache,
+                                      const char                  *key,
+                                      CoglTexture                 *texture,
+                                      GFile                      **files,
+                                      int                          n_files)
+{
+  MetaBackgroundCachedTexture *cached_texture;
+  MetaBackgroundCachedTexture *old_cached_texture;
+  int i;
+
+  g_return_val_if_fail (n_files <= MAX_FILES, NULL);
+
+  old_cached_texture = g_hash_table_lookup (cache->textures, key);
+  if (old_cached_texture)
+    {
+      g_hash_table_remove (cache->textures, key);
+      old_cached_texture->in_cache = FALSE;
+
+      if (old_cached_texture->use_count == 0)
+        remove_idle_texture (cache, old_cached_texture);
+    }
+
+  cached_texture = g_new0 (MetaBackgroundCachedTexture, 1);
+  cached_texture->cache = cache;
+  cached_texture->key = g_strdup (key);
+  cached_texture->texture = g_object_ref (texture);
+  cached_texture->size = get_texture_size (texture);
+  for (i = 0; i < n_files; i++)
+    cached_texture->files[i] = g_object_ref (files[i]);
+  cached_texture->n_files = n_files;
+  cached_texture->use_count = 1;
+  cached_texture->in_cache = TRUE;
+  cached_texture->idle_link.data = cached_texture;
+
+  g_hash_table_insert (cache->textures, cached_texture->key, cached_texture);
+  cache->in_use_size += cached_texture->size;
+
+  maybe_evict (cache);
+
+  return cached_texture;
+}
+
+void
+meta_background_cached_texture_release (MetaBackgroundCachedTexture *cached_texture)
+{
+  MetaBackgroundTextureCache *cache = cached_texture->cache;
+
+  g_return_if_fail (cached_texture->use_count > 0);
+
+  if (--cached_texture->use_count > 0)
+    return;
+
+  cache->in_use_size -= cached_texture->size;
+
+  if (!cached_texture->in_cache)
+    {
+      cached_texture_free (cached_texture);
+      return;
+    }
+
+  g_queue_push_head_link (&cache->idle_textures, &cached_texture->idle_link);
+  cache->idle_size += cached_texture->size;
+
+  maybe_evict (cache);
+}
+
+static void
+purge_texture (MetaBackgroundTextureCache  *cache,
+               MetaBackgroundCachedTexture *cached_texture)
+{
+  cached_texture->in_cache = FALSE;
+
+  if (cached_texture->use_count == 0)
+    {
+      g_queue_unlink (&cache->idle_textures, &cached_texture->idle_link);
+      cache->idle_size -= cached_texture->size;
+      cached_texture_free (cached_texture);
+    }
+}
+
+static gboolean
+cached_texture_uses_file (MetaBackgroundCachedTexture *cached_texture,
+                          GFile                       *file)
+{
+  int i;
+
+  for (i = 0; i < cached_texture->n_files; i++)
+    {
+      if (g_file_equal (cached_texture->files[i], file))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * Makes sure textures rendered from @file are not handed out again. Textures
+ * still in use stay valid until released.
+ */
+void
+meta_background_texture_cache_purge_file (MetaBackgroundTextureCache *cache,
+                                          GFile                      *file)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, cache->textures);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      MetaBackgroundCachedTexture *cached_texture = value;
+
+      if (!cached_texture_uses_file (cached_texture, file))
+        continue;
+
+      g_hash_table_iter_remove (&iter);
+      purge_texture (cache, cached_texture);
+    }
+}
+
+void
+meta_background_texture_cache_purge_all (MetaBackgroundTextureCache *cache)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, cache->textures);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      g_hash_table_iter_remove (&iter);
+      purge_texture (cache, value);
+    }
+}
+
+void
+meta_background_texture_cache_set_budget (MetaBackgroundTextureCache *cache,
+                                          size_t                      budget)
+{
+  cache->budget = budget;
+
+  maybe_evict (cache);
+}
+
+void
+meta_background_texture_cache_get_usage (MetaBackgroundTextureCache      *cache,
+                                         MetaBackgroundTextureCacheUsage *usage)
+{
+  *usage = (MetaBackgroundTextureCacheUsage) {
+    .in_use_size = cache->in_use_size,
+    .idle_size = cache->idle_size,
+    .budget = cache->budget,
+    .n_textures = g_hash_table_size (cache->textures),
+  };
+}
+
+const char *
+meta_background_cached_texture_get_key (MetaBackgroundCachedTexture *cached_texture)
+{
+  return cached_texture->key;
+}
+
+CoglTexture *
+meta_background_cached_texture_get_texture (MetaBackgroundCachedTexture *cached_texture)
+{
+  return cached_texture->texture;
+}
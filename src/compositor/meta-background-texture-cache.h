@@ -0,0 +1,96 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "cogl/cogl.h"
+#include "core/util-private.h"
+
+G_BEGIN_DECLS
+
+/*
+ * MetaBackgroundTextureCache:
+ *
+ * Process wide cache of textures rendered for backgrounds, e.g. the
+ * per-monitor blend of the background images. Textures are looked up by a
+ * key describing everything that went into rendering them, so that
+ * backgrounds and monitors ending up with identical pixels share a single
+ * texture.
+ *
+ * Textures no longer used by any background are kept around for reuse,
+ * until the total size of all cached textures exceeds the memory budget,
+ * at which point the least recently used ones are released.
+ */
+typedef struct _MetaBackgroundTextureCache MetaBackgroundTextureCache;
+
+typedef struct _MetaBackgroundCachedTexture MetaBackgroundCachedTexture;
+
+typedef struct _MetaBackgroundTextureCacheUsage
+{
+  /* Estimated size of textures used by backgrounds, in bytes */
+  size_t in_use_size;
+  /* Estimated size of textures only kept for reuse, in bytes */
+  size_t idle_size;
+  size_t budget;
+  unsigned int n_textures;
+} MetaBackgroundTextureCacheUsage;
+
+META_EXPORT_TEST
+MetaBackgroundTextureCache * meta_background_texture_cache_new (size_t budget);
+
+META_EXPORT_TEST
+void meta_background_texture_cache_free (MetaBackgroundTextureCache *cache);
+
+MetaBackgroundTextureCache * meta_background_texture_cache_get_default (void);
+
+META_EXPORT_TEST
+MetaBackgroundCachedTexture * meta_background_texture_cache_lookup (MetaBackgroundTextureCache *cache,
+                                                                    const char                 *key);
+
+META_EXPORT_TEST
+MetaBackgroundCachedTexture * meta_background_texture_cache_insert (MetaBackgroundTextureCache  *cache,
+                                                                    const char                  *key,
+                                                                    CoglTexture                 *texture,
+                                                                    GFile                      **files,
+                                                                    int                          n_files);
+
+META_EXPORT_TEST
+void meta_background_texture_cache_purge_file (MetaBackgroundTextureCache *cache,
+                                               GFile                      *file);
+
+META_EXPORT_TEST
+void meta_background_texture_cache_purge_all (MetaBackgroundTextureCache *cache);
+
+META_EXPORT_TEST
+void meta_background_texture_cache_set_budget (MetaBackgroundTextureCache *cache,
+                                               size_t                      budget);
+
+META_EXPORT_TEST
+void meta_background_texture_cache_get_usage (MetaBackgroundTextureCache      *cache,
+                                              MetaBackgroundTextureCacheUsage *usage);
+
+META_EXPORT_TEST
+void meta_background_cached_texture_release (MetaBackgroundCachedTexture *cached_texture);
+
+META_EXPORT_TEST
+const char * meta_background_cached_texture_get_key (MetaBackgroundCachedTexture *cached_texture);
+
+META_EXPORT_TEST
+CoglTexture * meta_background_cached_texture_get_texture (MetaBackgroundCachedTexture *cached_texture);
+
+G_END_DECLS
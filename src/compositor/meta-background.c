@@ -21,12 +21,14 @@
 
 #include "compositor/meta-background-private.h"
 
+#include <math.h>
 #include <string.h>
 
 #include "backends/meta-backend-private.h"
 #include "compositor/cogl-utils.h"
+#include "compositor/meta-background-image-private.h"
+#include "compositor/meta-background-texture-cache.h"
 #include "meta/display.h"
-#include "meta/meta-background-image.h"
 #include "meta/meta-background.h"
 #include "meta/meta-monitor-manager.h"
 #include "meta/util.h"
@@ -44,8 +46,7 @@ typedef struct _MetaBackgroundMonitor MetaBackgroundMonitor;
 struct _MetaBackgroundMonitor
 {
   gboolean dirty;
-  CoglTexture *texture;
-  CoglFramebuffer *fbo;
+  MetaBackgroundCachedTexture *texture;
 };
 
 struct _MetaBackground
@@ -66,8 +67,12 @@ struct _MetaBackground
   GFile *file2;
   MetaBackgroundImage *background_image2;
 
+  /* Size the images may be scaled down to while loading, or 0 */
+  int image_max_width;
+  int image_max_height;
+
   CoglTexture *color_texture;
-  CoglTexture *wallpaper_texture;
+  MetaBackgroundCachedTexture *wallpaper_texture;
 
   float blend_factor;
 
@@ -95,8 +100,8 @@ free_fbos (MetaBackground *self)
     {
       MetaBackgroundMonitor *monitor = &self->monitors[i];
 
-      g_clear_object (&monitor->fbo);
-      g_clear_object (&monitor->texture);
+      g_clear_pointer (&monitor->texture,
+                       meta_background_cached_texture_release);
     }
 }
 
@@ -109,7 +114,8 @@ free_color_texture (MetaBackground *self)
 static void
 free_wallpaper_texture (MetaBackground *self)
 {
-  g_clear_object (&self->wallpaper_texture);
+  g_clear_pointer (&self->wallpaper_texture,
+                   meta_background_cached_texture_release);
 
   self->wallpaper_allocation_failed = FALSE;
 }
@@ -133,12 +139,6 @@ invalidate_monitor_backgrounds (MetaBackground *self)
     }
 }
 
-static void
-on_monitors_changed (MetaBackground *self)
-{
-  invalidate_monitor_backgrounds (self);
-}
-
 static void
 set_display (MetaBackground *self,
              MetaDisplay    *display)
@@ -256,13 +256,91 @@ set_file (MetaBackground       *self,
         {
           MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
 
-          *imagep = meta_background_image_cache_load (cache, file);
+          *imagep = meta_background_image_cache_load_scaled (cache, file,
+                                                              self->image_max_width,
+                                                              self->image_max_height);
           g_signal_connect (*imagep, "loaded",
                             G_CALLBACK (on_background_loaded), self);
         }
     }
 }
 
+static void
+get_image_max_size (MetaBackground *self,
+                    int            *max_width,
+                    int            *max_height)
+{
+  float max_scale = 1.0;
+  int i;
+
+  *max_width = 0;
+  *max_height = 0;
+
+  if (!self->display)
+    return;
+
+  switch (self->style)
+    {
+    case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
+    case G_DESKTOP_BACKGROUND_STYLE_SCALED:
+    case G_DESKTOP_BACKGROUND_STYLE_ZOOM:
+      for (i = 0; i < self->n_monitors; i++)
+        {
+          MtkRectangle geometry;
+          float scale;
+
+          meta_display_get_monitor_geometry (self->display, i, &geometry);
+          scale = meta_display_get_monitor_scale (self->display, i);
+
+          *max_width = MAX (*max_width, (int) ceilf (geometry.width * scale));
+          *max_height = MAX (*max_height, (int) ceilf (geometry.height * scale));
+        }
+      break;
+    case G_DESKTOP_BACKGROUND_STYLE_SPANNED:
+      for (i = 0; i < self->n_monitors; i++)
+        max_scale = MAX (max_scale,
+                         meta_display_get_monitor_scale (self->display, i));
+
+      meta_display_get_size (self->display, max_width, max_height);
+      *max_width = (int) ceilf (*max_width * max_scale);
+      *max_height = (int) ceilf (*max_height * max_scale);
+      break;
+    case G_DESKTOP_BACKGROUND_STYLE_NONE:
+    case G_DESKTOP_BACKGROUND_STYLE_WALLPAPER:
+    case G_DESKTOP_BACKGROUND_STYLE_CENTERED:
+    default:
+      /* The image is painted at its original size */
+      break;
+    }
+}
+
+static gboolean
+update_image_max_size (MetaBackground *self)
+{
+  int max_width, max_height;
+
+  get_image_max_size (self, &max_width, &max_height);
+  if (max_width == self->image_max_width &&
+      max_height == self->image_max_height)
+    return FALSE;
+
+  self->image_max_width = max_width;
+  self->image_max_height = max_height;
+  return TRUE;
+}
+
+static void
+on_monitors_changed (MetaBackground *self)
+{
+  invalidate_monitor_backgrounds (self);
+
+  if (update_image_max_size (self))
+    {
+      set_file (self, &self->file1, &self->background_image1, self->file1, TRUE);
+      set_file (self, &self->file2, &self->background_image2, self->file2, TRUE);
+    }
+}
+
 static void
 on_gl_video_memory_purged (MetaBackground *self)
 {
@@ -653,23 +731,45 @@ texture_has_alpha (CoglTexture *texture)
     }
 }
 
+static char *
+get_wallpaper_texture_key (MetaBackground *self)
+{
+  g_autofree char *uri = g_file_get_uri (self->file1);
+
+  return g_strdup_printf ("wallpaper:%s:%02x%02x%02x",
+                          uri,
+                          self->color.red,
+                          self->color.green,
+                          self->color.blue);
+}
+
 static gboolean
 ensure_wallpaper_texture (MetaBackground *self,
                           CoglTexture    *texture)
 {
   if (self->wallpaper_texture == NULL && !self->wallpaper_allocation_failed)
     {
+      MetaBackgroundTextureCache *cache =
+        meta_background_texture_cache_get_default ();
+      g_autofree char *key = NULL;
       int width = cogl_texture_get_width (texture);
       int height = cogl_texture_get_height (texture);
+      CoglTexture *wallpaper_texture;
       CoglOffscreen *offscreen;
       CoglFramebuffer *fbo;
       GError *catch_error = NULL;
       CoglPipeline *pipeline;
 
-      self->wallpaper_texture = meta_create_texture (width, height,
-                                                     COGL_TEXTURE_COMPONENTS_RGBA,
-                                                     META_TEXTURE_FLAGS_NONE);
-      offscreen = cogl_offscreen_new_with_texture (self->wallpaper_texture);
+      key = get_wallpaper_texture_key (self);
+      self->wallpaper_texture = meta_background_texture_cache_lookup (cache,
+                                                                      key);
+      if (self->wallpaper_texture)
+        return TRUE;
+
+      wallpaper_texture = meta_create_texture (width, height,
+                                               COGL_TEXTURE_COMPONENTS_RGBA,
+                                               META_TEXTURE_FLAGS_NONE);
+      offscreen = cogl_offscreen_new_with_texture (wallpaper_texture);
       fbo = COGL_FRAMEBUFFER (offscreen);
 
       if (!cogl_framebuffer_allocate (fbo, &catch_error))
@@ -680,7 +780,7 @@ ensure_wallpaper_texture (MetaBackground *self,
            */
           g_error_free (catch_error);
 
-          g_clear_object (&self->wallpaper_texture);
+          g_object_unref (wallpaper_texture);
           g_object_unref (fbo);
 
           self->wallpaper_allocation_failed = TRUE;
@@ -707,6 +807,11 @@ ensure_wallpaper_texture (MetaBackground *self,
         }
 
       g_object_unref (fbo);
+
+      self->wallpaper_texture =
+        meta_background_texture_cache_insert (cache, key, wallpaper_texture,
+                                              &self->file1, 1);
+      g_object_unref (wallpaper_texture);
     }
 
   return self->wallpaper_texture != NULL;
@@ -749,6 +854,188 @@ get_best_mipmap_level (CoglTexture *texture,
   return MAX (0, halves - 1);
 }
 
+static char *
+get_monitor_texture_key (MetaBackground *self,
+                         CoglTexture    *texture1,
+                         CoglTexture    *texture2,
+                         MtkRectangle   *monitor_area,
+                         float           monitor_scale,
+                         int             texture_width,
+                         int             texture_height)
+{
+  g_autofree char *uri1 = NULL;
+  g_autofree char *uri2 = NULL;
+  int screen_width = 0, screen_height = 0;
+  int x = 0, y = 0;
+
+  /* The same file may be loaded at different sizes */
+  if (texture1)
+    {
+      g_autofree char *uri = g_file_get_uri (self->file1);
+
+      uri1 = g_strdup_printf ("%s@%dx%d", uri,
+                              cogl_texture_get_width (texture1),
+                              cogl_texture_get_height (texture1));
+    }
+  if (texture2)
+    {
+      g_autofree char *uri = g_file_get_uri (self->file2);
+
+      uri2 = g_strdup_printf ("%s@%dx%d", uri,
+                              cogl_texture_get_width (texture2),
+                              cogl_texture_get_height (texture2));
+    }
+
+  /* Only these depend on where the monitor is, so that other styles can
+   * share the texture between monitors of the same size.
+   */
+  if (self->style == G_DESKTOP_BACKGROUND_STYLE_WALLPAPER ||
+      self->style == G_DESKTOP_BACKGROUND_STYLE_SPANNED)
+    {
+      meta_display_get_size (self->display, &screen_width, &screen_height);
+      x = monitor_area->x;
+      y = monitor_area->y;
+    }
+
+  return g_strdup_printf ("monitor:%s:%s:%g:%d:%d:"
+                          "%02x%02x%02x:%02x%02x%02x:"
+                          "%dx%d:%g:%d,%d:%dx%d",
+                          uri1 ? uri1 : "",
+                          uri2 ? uri2 : "",
+                          self->blend_factor,
+                          self->style,
+                          self->shading_direction,
+                          self->color.red,
+                          self->color.green,
+                          self->color.blue,
+                          self->second_color.red,
+                          self->second_color.green,
+                          self->second_color.blue,
+                          texture_width, texture_height,
+                          monitor_scale,
+                          x, y,
+                          screen_width, screen_height);
+}
+
+static CoglTexture *
+render_monitor_texture (MetaBackground *self,
+                        CoglTexture    *texture1,
+                        CoglTexture    *texture2,
+                        MtkRectangle    monitor_area,
+                        float           monitor_scale,
+                        int             texture_width,
+                        int             texture_height)
+{
+  GError *catch_error = NULL;
+  gboolean bare_region_visible = FALSE;
+  CoglTexture *texture;
+  CoglOffscreen *offscreen;
+  CoglFramebuffer *fbo;
+
+  texture = meta_create_texture (texture_width,
+                                 texture_height,
+                                 COGL_TEXTURE_COMPONENTS_RGB,
+                                 META_TEXTURE_FLAGS_NONE);
+  offscreen = cogl_offscreen_new_with_texture (texture);
+  fbo = COGL_FRAMEBUFFER (offscreen);
+
+  if (self->style != G_DESKTOP_BACKGROUND_STYLE_WALLPAPER)
+    {
+      monitor_area.x *= monitor_scale;
+      monitor_area.y *= monitor_scale;
+      monitor_area.width *= monitor_scale;
+      monitor_area.height *= monitor_scale;
+    }
+
+  if (!cogl_framebuffer_allocate (fbo, &catch_error))
+    {
+      /* Texture or framebuffer allocation failed; it's unclear why this happened;
+       * we'll try again the next time this is called. (MetaBackgroundActor
+       * caches the result, so user might be left without a background.)
+       */
+      g_object_unref (fbo);
+      g_object_unref (texture);
+
+      g_error_free (catch_error);
+      return NULL;
+    }
+
+  cogl_framebuffer_orthographic (fbo, 0, 0,
+                                 monitor_area.width, monitor_area.height, -1., 1.);
+
+  if (texture2 != NULL && self->blend_factor != 0.0)
+    {
+      CoglPipeline *pipeline = create_pipeline (PIPELINE_REPLACE);
+      int mipmap_level;
+
+      mipmap_level = get_best_mipmap_level (texture2,
+                                            texture_width,
+                                            texture_height);
+
+      cogl_pipeline_set_color4f (pipeline,
+                                  self->blend_factor, self->blend_factor, self->blend_factor, self->blend_factor);
+      cogl_pipeline_set_layer_texture (pipeline, 0, texture2);
+      cogl_pipeline_set_layer_wrap_mode (pipeline, 0, get_wrap_mode (self->style));
+      cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
+
+      bare_region_visible = draw_texture (self,
+                                          fbo, pipeline,
+                                          texture2, &monitor_area,
+                                          monitor_scale);
+
+      g_object_unref (pipeline);
+    }
+  else
+    {
+      cogl_framebuffer_clear4f (fbo,
+                                COGL_BUFFER_BIT_COLOR,
+                                0.0, 0.0, 0.0, 0.0);
+    }
+
+  if (texture1 != NULL && self->blend_factor != 1.0)
+    {
+      CoglPipeline *pipeline = create_pipeline (PIPELINE_ADD);
+      int mipmap_level;
+
+      mipmap_level = get_best_mipmap_level (texture1,
+                                            texture_width,
+                                            texture_height);
+
+      cogl_pipeline_set_color4f (pipeline,
+                                 (1 - self->blend_factor),
+                                 (1 - self->blend_factor),
+                                 (1 - self->blend_factor),
+                                 (1 - self->blend_factor));
+      cogl_pipeline_set_layer_texture (pipeline, 0, texture1);
+      cogl_pipeline_set_layer_wrap_mode (pipeline, 0, get_wrap_mode (self->style));
+      cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
+
+      bare_region_visible = bare_region_visible || draw_texture (self,
+                                                                 fbo, pipeline,
+                                                                 texture1, &monitor_area,
+                                                                 monitor_scale);
+
+      g_object_unref (pipeline);
+    }
+
+  if (bare_region_visible)
+    {
+      CoglPipeline *pipeline = create_pipeline (PIPELINE_OVER_REVERSE);
+
+      ensure_color_texture (self);
+      cogl_pipeline_set_layer_texture (pipeline, 0, self->color_texture);
+      cogl_framebuffer_draw_rectangle (fbo,
+                                       pipeline,
+                                       0, 0,
+                                       monitor_area.width, monitor_area.height);
+      g_object_unref (pipeline);
+    }
+
+  g_object_unref (fbo);
+
+  return texture;
+}
+
 CoglTexture *
 meta_background_get_texture (MetaBackground       *self,
                              int                   monitor_index,
@@ -792,18 +1079,21 @@ meta_background_get_texture (MetaBackground       *self,
     {
       if (texture_area)
         get_texture_area (self, &monitor_area, monitor_scale,
-                          self->wallpaper_texture, texture_area);
+                          meta_background_cached_texture_get_texture (self->wallpaper_texture),
+                          texture_area);
       if (wrap_mode)
         *wrap_mode = COGL_PIPELINE_WRAP_MODE_REPEAT;
-      return self->wallpaper_texture;
+      return meta_background_cached_texture_get_texture (self->wallpaper_texture);
     }
 
   if (monitor->dirty)
     {
       MetaContext *context = meta_display_get_context (self->display);
       MetaBackend *backend = meta_context_get_backend (context);
-      GError *catch_error = NULL;
-      gboolean bare_region_visible = FALSE;
+      MetaBackgroundTextureCache *cache =
+        meta_background_texture_cache_get_default ();
+      MetaBackgroundCachedTexture *cached_texture;
+      g_autofree char *key = NULL;
       int texture_width, texture_height;
 
       if (meta_backend_is_stage_views_scaled (backend))
@@ -817,110 +1107,36 @@ meta_background_get_texture (MetaBackground       *self,
           texture_height = monitor_area.height;
         }
 
-      if (monitor->texture == NULL)
-        {
-          CoglOffscreen *offscreen;
-
-          monitor->texture = meta_create_texture (texture_width,
-                                                  texture_height,
-                                                  COGL_TEXTURE_COMPONENTS_RGB,
-                                                  META_TEXTURE_FLAGS_NONE);
-          offscreen = cogl_offscreen_new_with_texture (monitor->texture);
-          monitor->fbo = COGL_FRAMEBUFFER (offscreen);
-        }
-
-      if (self->style != G_DESKTOP_BACKGROUND_STYLE_WALLPAPER)
+      key = get_monitor_texture_key (self, texture1, texture2,
+                                     &monitor_area, monitor_scale,
+                                     texture_width, texture_height);
+      cached_texture = meta_background_texture_cache_lookup (cache, key);
+      if (!cached_texture)
         {
-          monitor_area.x *= monitor_scale;
-          monitor_area.y *= monitor_scale;
-          monitor_area.width *= monitor_scale;
-          monitor_area.height *= monitor_scale;
-        }
-
-      if (!cogl_framebuffer_allocate (monitor->fbo, &catch_error))
-        {
-          /* Texture or framebuffer allocation failed; it's unclear why this happened;
-           * we'll try again the next time this is called. (MetaBackgroundActor
-           * caches the result, so user might be left without a background.)
-           */
-          g_clear_object (&monitor->texture);
-          g_clear_object (&monitor->fbo);
-
-          g_error_free (catch_error);
-          return NULL;
-        }
-
-      cogl_framebuffer_orthographic (monitor->fbo, 0, 0,
-                                     monitor_area.width, monitor_area.height, -1., 1.);
-
-      if (texture2 != NULL && self->blend_factor != 0.0)
-        {
-          CoglPipeline *pipeline = create_pipeline (PIPELINE_REPLACE);
-          int mipmap_level;
-
-          mipmap_level = get_best_mipmap_level (texture2,
-                                                texture_width,
-                                                texture_height);
-
-          cogl_pipeline_set_color4f (pipeline,
-                                      self->blend_factor, self->blend_factor, self->blend_factor, self->blend_factor);
-          cogl_pipeline_set_layer_texture (pipeline, 0, texture2);
-          cogl_pipeline_set_layer_wrap_mode (pipeline, 0, get_wrap_mode (self->style));
-          cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
-
-          bare_region_visible = draw_texture (self,
-                                              monitor->fbo, pipeline,
-                                              texture2, &monitor_area,
-                                              monitor_scale);
-
-          g_object_unref (pipeline);
-        }
-      else
-        {
-          cogl_framebuffer_clear4f (monitor->fbo,
-                                    COGL_BUFFER_BIT_COLOR,
-                                    0.0, 0.0, 0.0, 0.0);
-        }
-
-      if (texture1 != NULL && self->blend_factor != 1.0)
-        {
-          CoglPipeline *pipeline = create_pipeline (PIPELINE_ADD);
-          int mipmap_level;
-
-          mipmap_level = get_best_mipmap_level (texture1,
-                                                texture_width,
-                                                texture_height);
-
-          cogl_pipeline_set_color4f (pipeline,
-                                     (1 - self->blend_factor),
-                                     (1 - self->blend_factor),
-                                     (1 - self->blend_factor),
-                                     (1 - self->blend_factor));
-          cogl_pipeline_set_layer_texture (pipeline, 0, texture1);
-          cogl_pipeline_set_layer_wrap_mode (pipeline, 0, get_wrap_mode (self->style));
-          cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
-
-          bare_region_visible = bare_region_visible || draw_texture (self,
-                                                                     monitor->fbo, pipeline,
-                                                                     texture1, &monitor_area,
-                                                                     monitor_scale);
-
-          g_object_unref (pipeline);
-        }
-
-      if (bare_region_visible)
-        {
-          CoglPipeline *pipeline = create_pipeline (PIPELINE_OVER_REVERSE);
-
-          ensure_color_texture (self);
-          cogl_pipeline_set_layer_texture (pipeline, 0, self->color_texture);
-          cogl_framebuffer_draw_rectangle (monitor->fbo,
-                                           pipeline,
-                                           0, 0,
-                                           monitor_area.width, monitor_area.height);
-          g_object_unref (pipeline);
+          g_autoptr (CoglTexture) texture = NULL;
+          GFile *files[2];
+          int n_files = 0;
+
+          texture = render_monitor_texture (self, texture1, texture2,
+                                            monitor_area, monitor_scale,
+                                            texture_width, texture_height);
+          if (!texture)
+            return NULL;
+
+          if (texture1)
+            files[n_files++] = self->file1;
+          if (texture2)
+            files[n_files++] = self->file2;
+
+          cached_texture = meta_background_texture_cache_insert (cache, key,
+                                                                 texture,
+                                                                 files,
+                                                                 n_files);
         }
 
+      g_clear_pointer (&monitor->texture,
+                       meta_background_cached_texture_release);
+      monitor->texture = cached_texture;
       monitor->dirty = FALSE;
     }
 
@@ -929,7 +1145,7 @@ meta_background_get_texture (MetaBackground       *self,
 
   if (wrap_mode)
     *wrap_mode = COGL_PIPELINE_WRAP_MODE_CLAMP_TO_EDGE;
-  return monitor->texture;
+  return meta_background_cached_texture_get_texture (monitor->texture);
 }
 
 MetaBackground *
@@ -998,15 +1214,20 @@ meta_background_set_blend (MetaBackground          *self,
                            double                   blend_factor,
                            GDesktopBackgroundStyle  style)
 {
+  gboolean max_size_changed;
+
   g_return_if_fail (META_IS_BACKGROUND (self));
   g_return_if_fail (blend_factor >= 0.0 && blend_factor <= 1.0);
 
-  set_file (self, &self->file1, &self->background_image1, file1, FALSE);
-  set_file (self, &self->file2, &self->background_image2, file2, FALSE);
-
   self->blend_factor = blend_factor;
   self->style = style;
 
+  max_size_changed = update_image_max_size (self);
+  set_file (self, &self->file1, &self->background_image1, file1,
+            max_size_changed);
+  set_file (self, &self->file2, &self->background_image2, file2,
+            max_size_changed);
+
   free_wallpaper_texture (self);
   mark_changed (self);
 }
@@ -1014,8 +1235,13 @@ meta_background_set_blend (MetaBackground          *self,
 void
 meta_background_refresh_all (void)
 {
+  MetaBackgroundTextureCache *cache =
+    meta_background_texture_cache_get_default ();
   GSList *l;
 
+  /* Rendered textures are shared, so all of them need rendering again */
+  meta_background_texture_cache_purge_all (cache);
+
   for (l = all_backgrounds; l; l = l->next)
     mark_changed (l->data);
 }
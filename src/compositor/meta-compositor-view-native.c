@@ -24,9 +24,14 @@
 
 #include "compositor/meta-compositor-view-native.h"
 
+#include <math.h>
+
 #include "backends/meta-crtc.h"
+#include "backends/meta-settings-private.h"
 #include "backends/native/meta-crtc-kms.h"
+#include "backends/native/meta-onscreen-native.h"
 #include "compositor/compositor-private.h"
+#include "compositor/meta-shaped-texture-private.h"
 #include "compositor/meta-window-actor-private.h"
 
 #ifdef HAVE_WAYLAND
@@ -40,6 +45,9 @@ struct _MetaCompositorViewNative
 
 #ifdef HAVE_WAYLAND
   MetaWaylandSurface *scanout_candidate;
+
+  MetaSurfaceActor *overlay_actor;
+  MtkRectangle overlay_actor_rect;
 #endif /* HAVE_WAYLAND */
 };
 
@@ -68,6 +76,43 @@ update_scanout_candidate (MetaCompositorViewNative *view_native,
     }
 }
 
+static gboolean
+is_software_cursor_within (MetaCompositor        *compositor,
+                           ClutterStageView      *stage_view,
+                           const graphene_rect_t *rect)
+{
+  MetaStageView *view = META_STAGE_VIEW (stage_view);
+  MetaBackend *backend = meta_compositor_get_backend (compositor);
+  MetaCursorTracker *cursor_tracker =
+    meta_backend_get_cursor_tracker (backend);
+  CoglTexture *cursor_sprite;
+  graphene_rect_t cursor_rect;
+  graphene_point_t position;
+  float scale;
+  int hotspot_x;
+  int hotspot_y;
+
+  cursor_sprite = meta_cursor_tracker_get_sprite (cursor_tracker);
+  if (!cursor_sprite ||
+      !meta_cursor_tracker_get_pointer_visible (cursor_tracker) ||
+      meta_stage_view_is_cursor_overlay_inhibited (view))
+    return FALSE;
+
+  meta_cursor_tracker_get_pointer (cursor_tracker, &position, NULL);
+  meta_cursor_tracker_get_hot (cursor_tracker, &hotspot_x, &hotspot_y);
+
+  scale = (clutter_stage_view_get_scale (stage_view) *
+           meta_cursor_tracker_get_scale (cursor_tracker));
+
+  graphene_rect_init (&cursor_rect,
+                      position.x - (hotspot_x * scale),
+                      position.y - (hotspot_y * scale),
+                      cogl_texture_get_width (cursor_sprite) * scale,
+                      cogl_texture_get_height (cursor_sprite) * scale);
+
+  return graphene_rect_intersection (rect, &cursor_rect, NULL);
+}
+
 static gboolean
 find_scanout_candidate (MetaCompositorView  *compositor_view,
                         MetaCompositor      *compositor,
@@ -77,17 +122,13 @@ find_scanout_candidate (MetaCompositorView  *compositor_view,
 {
   ClutterStageView *stage_view =
     meta_compositor_view_get_stage_view (compositor_view);
-  MetaStageView *view = META_STAGE_VIEW (stage_view);
   MetaRendererView *renderer_view = META_RENDERER_VIEW (stage_view);
-  MetaBackend *backend = meta_compositor_get_backend (compositor);
-  MetaCursorTracker *cursor_tracker =
-    meta_backend_get_cursor_tracker (backend);
-  CoglTexture *cursor_sprite;
   MetaCrtc *crtc;
   CoglFramebuffer *framebuffer;
   MetaWindowActor *window_actor;
   MetaWindow *window;
   MtkRectangle view_rect;
+  graphene_rect_t graphene_view_rect;
   ClutterActorBox actor_box;
   MetaSurfaceActor *surface_actor;
   MetaSurfaceActorWayland *surface_actor_wayland;
@@ -103,39 +144,12 @@ find_scanout_candidate (MetaCompositorView  *compositor_view,
 
   clutter_stage_view_get_layout (stage_view, &view_rect);
 
-  cursor_sprite = meta_cursor_tracker_get_sprite (cursor_tracker);
-  if (cursor_sprite &&
-      meta_cursor_tracker_get_pointer_visible (cursor_tracker) &&
-      !meta_stage_view_is_cursor_overlay_inhibited (view))
-    {
-      graphene_rect_t graphene_view_rect;
-      graphene_rect_t cursor_rect;
-      graphene_point_t position;
-      float scale;
-      int hotspot_x;
-      int hotspot_y;
-
-      meta_cursor_tracker_get_pointer (cursor_tracker, &position, NULL);
-      meta_cursor_tracker_get_hot (cursor_tracker, &hotspot_x, &hotspot_y);
-
-      scale = (clutter_stage_view_get_scale (stage_view) *
-               meta_cursor_tracker_get_scale (cursor_tracker));
-
-      graphene_rect_init (&cursor_rect,
-                          position.x - (hotspot_x * scale),
-                          position.y - (hotspot_y * scale),
-                          cogl_texture_get_width (cursor_sprite) * scale,
-                          cogl_texture_get_height (cursor_sprite) * scale);
-
-      graphene_view_rect = mtk_rectangle_to_graphene_rect (&view_rect);
-      if (graphene_rect_intersection (&graphene_view_rect,
-                                      &cursor_rect,
-                                      NULL))
-        {
-          meta_topic (META_DEBUG_RENDER,
-                      "No direct scanout candidate: using software cursor");
-          return FALSE;
-        }
+  graphene_view_rect = mtk_rectangle_to_graphene_rect (&view_rect);
+  if (is_software_cursor_within (compositor, stage_view, &graphene_view_rect))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No direct scanout candidate: using software cursor");
+      return FALSE;
     }
 
   crtc = meta_renderer_view_get_crtc (renderer_view);
@@ -282,6 +296,337 @@ try_assign_next_scanout (MetaCompositorView *compositor_view,
   clutter_stage_view_assign_next_scanout (stage_view, scanout);
 }
 
+static gboolean
+paints_within (ClutterActor          *actor,
+               const graphene_rect_t *rect)
+{
+  ClutterActorBox paint_box;
+  graphene_rect_t paint_rect;
+
+  if (!clutter_actor_is_mapped (actor))
+    return FALSE;
+
+  /* Without a paint box, assume it may paint anywhere */
+  if (!clutter_actor_get_paint_box (actor, &paint_box))
+    return TRUE;
+
+  graphene_rect_init (&paint_rect,
+                      paint_box.x1, paint_box.y1,
+                      paint_box.x2 - paint_box.x1,
+                      paint_box.y2 - paint_box.y1);
+
+  return graphene_rect_intersection (rect, &paint_rect, NULL);
+}
+
+/* The overlay plane stacks above the primary plane, so anything painted
+ * after the actor within its bounds, such as popups, notifications or
+ * OSDs, would end up hidden underneath it. */
+static gboolean
+is_painted_over (ClutterActor          *actor,
+                 const graphene_rect_t *rect)
+{
+  ClutterActor *child;
+  ClutterActor *parent;
+
+  for (child = clutter_actor_get_first_child (actor);
+       child;
+       child = clutter_actor_get_next_sibling (child))
+    {
+      if (paints_within (child, rect))
+        return TRUE;
+    }
+
+  while ((parent = clutter_actor_get_parent (actor)))
+    {
+      ClutterActor *sibling;
+
+      for (sibling = clutter_actor_get_next_sibling (actor);
+           sibling;
+           sibling = clutter_actor_get_next_sibling (sibling))
+        {
+          if (paints_within (sibling, rect))
+            return TRUE;
+        }
+
+      actor = parent;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+find_overlay_candidate (MetaCompositorView  *compositor_view,
+                        MetaCompositor      *compositor,
+                        CoglOnscreen       **onscreen_out,
+                        MetaSurfaceActor   **surface_actor_out,
+                        MtkRectangle        *stage_rect_out,
+                        MtkRectangle        *dst_rect_out)
+{
+  ClutterStageView *stage_view =
+    meta_compositor_view_get_stage_view (compositor_view);
+  MetaRendererView *renderer_view = META_RENDERER_VIEW (stage_view);
+  CoglFramebuffer *framebuffer;
+  MetaWindowActor *window_actor;
+  MtkRectangle view_rect;
+  ClutterActorBox actor_box;
+  graphene_rect_t actor_rect;
+  MetaSurfaceActor *surface_actor;
+  float view_scale;
+
+  if (meta_compositor_is_unredirect_inhibited (compositor))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: unredirect inhibited");
+      return FALSE;
+    }
+
+  if (!META_IS_CRTC_KMS (meta_renderer_view_get_crtc (renderer_view)))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: no KMS CRTC");
+      return FALSE;
+    }
+
+  framebuffer = clutter_stage_view_get_onscreen (stage_view);
+  if (!META_IS_ONSCREEN_NATIVE (framebuffer))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: no native onscreen "
+                  "framebuffer");
+      return FALSE;
+    }
+
+  if (clutter_stage_view_has_shadowfb (stage_view))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: stage-view has shadowfb");
+      return FALSE;
+    }
+
+  if (meta_renderer_view_get_transform (renderer_view) !=
+      META_MONITOR_TRANSFORM_NORMAL)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: stage-view is transformed");
+      return FALSE;
+    }
+
+  window_actor = meta_compositor_view_get_top_window_actor (compositor_view);
+  if (!window_actor)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: no top window actor");
+      return FALSE;
+    }
+
+  if (meta_window_actor_effect_in_progress (window_actor) ||
+      clutter_actor_has_transitions (CLUTTER_ACTOR (window_actor)))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: window-actor is animating");
+      return FALSE;
+    }
+
+  if (clutter_actor_is_scaled (CLUTTER_ACTOR (window_actor)) ||
+      clutter_actor_is_rotated (CLUTTER_ACTOR (window_actor)))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: window-actor is transformed");
+      return FALSE;
+    }
+
+  surface_actor = meta_window_actor_get_scanout_candidate (window_actor);
+  if (!surface_actor || !META_IS_SURFACE_ACTOR_WAYLAND (surface_actor))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: window-actor has no scanout "
+                  "candidate");
+      return FALSE;
+    }
+
+  if (!meta_surface_actor_is_opaque (surface_actor) ||
+      clutter_actor_get_paint_opacity (CLUTTER_ACTOR (surface_actor)) != 0xff)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: surface-actor is translucent");
+      return FALSE;
+    }
+
+  if (meta_surface_actor_is_effectively_obscured (surface_actor))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: surface-actor is obscured");
+      return FALSE;
+    }
+
+  if (!clutter_actor_get_paint_box (CLUTTER_ACTOR (surface_actor),
+                                    &actor_box))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: no actor paint-box");
+      return FALSE;
+    }
+
+  clutter_stage_view_get_layout (stage_view, &view_rect);
+  view_scale = clutter_stage_view_get_scale (stage_view);
+
+  graphene_rect_init (&actor_rect,
+                      actor_box.x1, actor_box.y1,
+                      actor_box.x2 - actor_box.x1,
+                      actor_box.y2 - actor_box.y1);
+  if (actor_box.x1 < view_rect.x ||
+      actor_box.y1 < view_rect.y ||
+      actor_box.x2 > view_rect.x + view_rect.width ||
+      actor_box.y2 > view_rect.y + view_rect.height)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: paint-box (%f,%f,%f,%f) not "
+                  "within stage-view layout (%d,%d,%d,%d)",
+                  actor_box.x1, actor_box.y1,
+                  actor_box.x2 - actor_box.x1, actor_box.y2 - actor_box.y1,
+                  view_rect.x, view_rect.y, view_rect.width, view_rect.height);
+      return FALSE;
+    }
+
+  if (is_software_cursor_within (compositor, stage_view, &actor_rect))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: software cursor above "
+                  "surface");
+      return FALSE;
+    }
+
+  if (is_painted_over (CLUTTER_ACTOR (surface_actor), &actor_rect))
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "No overlay scanout candidate: surface-actor is painted "
+                  "over");
+      return FALSE;
+    }
+
+  *stage_rect_out = (MtkRectangle) {
+    .x = (int) floorf (actor_box.x1),
+    .y = (int) floorf (actor_box.y1),
+    .width = (int) ceilf (actor_box.x2) - (int) floorf (actor_box.x1),
+    .height = (int) ceilf (actor_box.y2) - (int) floorf (actor_box.y1),
+  };
+  *dst_rect_out = (MtkRectangle) {
+    .x = (int) roundf ((actor_box.x1 - view_rect.x) * view_scale),
+    .y = (int) roundf ((actor_box.y1 - view_rect.y) * view_scale),
+    .width = (int) roundf ((actor_box.x2 - actor_box.x1) * view_scale),
+    .height = (int) roundf ((actor_box.y2 - actor_box.y1) * view_scale),
+  };
+
+  *onscreen_out = COGL_ONSCREEN (framebuffer);
+  *surface_actor_out = surface_actor;
+
+  return TRUE;
+}
+
+static gboolean
+try_assign_overlay_scanout (CoglOnscreen       *onscreen,
+                            MetaSurfaceActor   *surface_actor,
+                            const MtkRectangle *dst_rect)
+{
+  MetaSurfaceActorWayland *surface_actor_wayland =
+    META_SURFACE_ACTOR_WAYLAND (surface_actor);
+  MetaWaylandSurface *surface;
+  g_autoptr (CoglScanout) scanout = NULL;
+  graphene_rect_t src_rect;
+
+  surface = meta_surface_actor_wayland_get_surface (surface_actor_wayland);
+  if (!surface)
+    return FALSE;
+
+  if (!meta_wayland_surface_get_overlay_src_rect (surface, &src_rect))
+    return FALSE;
+
+  scanout = meta_wayland_surface_try_acquire_overlay_scanout (surface,
+                                                              onscreen,
+                                                              &src_rect,
+                                                              dst_rect);
+  if (!scanout)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "Could not acquire overlay scanout");
+      return FALSE;
+    }
+
+  meta_onscreen_native_assign_overlay_scanout (onscreen, scanout,
+                                               &src_rect, dst_rect);
+  return TRUE;
+}
+
+static void
+update_overlay_actor (MetaCompositorViewNative *view_native,
+                      MetaSurfaceActor         *surface_actor,
+                      const MtkRectangle       *stage_rect)
+{
+  MetaCompositorView *compositor_view = META_COMPOSITOR_VIEW (view_native);
+  ClutterStageView *stage_view =
+    meta_compositor_view_get_stage_view (compositor_view);
+
+  if (view_native->overlay_actor &&
+      view_native->overlay_actor != surface_actor)
+    {
+      MetaShapedTexture *stex =
+        meta_surface_actor_get_texture (view_native->overlay_actor);
+
+      meta_shaped_texture_set_overlay_view (stex, NULL);
+      g_clear_weak_pointer (&view_native->overlay_actor);
+    }
+
+  /* The area covered by the overlay was not composited while it was in use,
+   * so repaint it as part of this frame. */
+  if (!mtk_rectangle_equal (&view_native->overlay_actor_rect, stage_rect))
+    {
+      if (view_native->overlay_actor_rect.width > 0 &&
+          view_native->overlay_actor_rect.height > 0)
+        {
+          clutter_stage_view_add_redraw_clip (stage_view,
+                                              &view_native->overlay_actor_rect);
+        }
+      view_native->overlay_actor_rect = *stage_rect;
+    }
+
+  if (surface_actor)
+    {
+      MetaShapedTexture *stex = meta_surface_actor_get_texture (surface_actor);
+
+      meta_shaped_texture_set_overlay_view (stex, stage_view);
+      g_set_weak_pointer (&view_native->overlay_actor, surface_actor);
+    }
+}
+
+static void
+maybe_assign_overlay_scanout (MetaCompositorViewNative *view_native,
+                              MetaCompositor           *compositor)
+{
+  MetaCompositorView *compositor_view = META_COMPOSITOR_VIEW (view_native);
+  CoglOnscreen *onscreen = NULL;
+  MetaSurfaceActor *surface_actor = NULL;
+  MtkRectangle stage_rect = { 0 };
+  MtkRectangle dst_rect;
+  MetaBackend *backend = meta_compositor_get_backend (compositor);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+
+  if (!meta_settings_is_experimental_feature_enabled (settings,
+                                                      META_EXPERIMENTAL_FEATURE_OVERLAY_SCANOUT) ||
+      !find_overlay_candidate (compositor_view,
+                               compositor,
+                               &onscreen,
+                               &surface_actor,
+                               &stage_rect,
+                               &dst_rect) ||
+      !try_assign_overlay_scanout (onscreen, surface_actor, &dst_rect))
+    {
+      surface_actor = NULL;
+      stage_rect = (MtkRectangle) { 0 };
+    }
+
+  update_overlay_actor (view_native, surface_actor, &stage_rect);
+}
+
 void
 meta_compositor_view_native_maybe_assign_scanout (MetaCompositorViewNative *view_native,
                                                   MetaCompositor           *compositor)
@@ -299,9 +644,16 @@ meta_compositor_view_native_maybe_assign_scanout (MetaCompositorViewNative *view
                                             &surface);
   if (candidate_found)
     {
+      MtkRectangle no_overlay_rect = { 0 };
+
       try_assign_next_scanout (compositor_view,
                                onscreen,
                                surface);
+      update_overlay_actor (view_native, NULL, &no_overlay_rect);
+    }
+  else
+    {
+      maybe_assign_overlay_scanout (view_native, compositor);
     }
 
   update_scanout_candidate (view_native, surface, crtc);
@@ -325,6 +677,7 @@ meta_compositor_view_native_finalize (GObject *object)
   MetaCompositorViewNative *view_native = META_COMPOSITOR_VIEW_NATIVE (object);
 
   g_clear_weak_pointer (&view_native->scanout_candidate);
+  g_clear_weak_pointer (&view_native->overlay_actor);
 #endif /* HAVE_WAYLAND */
 
   G_OBJECT_CLASS (meta_compositor_view_native_parent_class)->finalize (object);
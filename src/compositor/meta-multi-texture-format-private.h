@@ -21,12 +21,15 @@
 
 #include <cogl/cogl.h>
 
+#include "core/util-private.h"
 #include "meta/meta-multi-texture-format.h"
 
 G_BEGIN_DECLS
 
+META_EXPORT_TEST
 const char * meta_multi_texture_format_to_string (MetaMultiTextureFormat format);
 
+META_EXPORT_TEST
 int meta_multi_texture_format_get_n_planes (MetaMultiTextureFormat format);
 
 void meta_multi_texture_format_get_subformats (MetaMultiTextureFormat  format,
@@ -35,6 +38,7 @@ void meta_multi_texture_format_get_subformats (MetaMultiTextureFormat  format,
 void meta_multi_texture_format_get_plane_indices (MetaMultiTextureFormat  format,
                                                   uint8_t                *plane_indices);
 
+META_EXPORT_TEST
 void meta_multi_texture_format_get_subsampling_factors (MetaMultiTextureFormat  format,
                                                         uint8_t                *horizontal_factors,
                                                         uint8_t                *vertical_factors);
@@ -43,4 +47,18 @@ gboolean meta_multi_texture_format_get_snippets (MetaMultiTextureFormat   format
                                                  CoglSnippet            **fragment_globals_snippet,
                                                  CoglSnippet            **fragment_snippet);
 
+META_EXPORT_TEST
+gboolean meta_multi_texture_format_get_packed_layout (MetaMultiTextureFormat  format,
+                                                      int                     width,
+                                                      int                     height,
+                                                      int                    *packed_width,
+                                                      int                    *packed_height,
+                                                      int                    *plane_offsets,
+                                                      int                    *plane_strides);
+
+META_EXPORT_TEST
+gboolean meta_multi_texture_format_get_packed_snippets (MetaMultiTextureFormat   format,
+                                                        CoglSnippet            **fragment_globals_snippet,
+                                                        CoglSnippet            **fragment_snippet);
+
 G_END_DECLS
@@ -38,6 +38,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* Linear buffers are commonly allocated with rows aligned to 256 bytes */
+#define PACKED_WIDTH_ALIGNMENT 256
+
 static const char *shader_global_conversions =
   "vec4 yuv_to_rgb(vec4 yuva)                                               \n"
   "{                                                                        \n"
@@ -51,6 +54,18 @@ static const char *shader_global_conversions =
   "  res.rgb *= yuva.w;                                                     \n"
   "  res.a = yuva.w;                                                        \n"
   "  return res;                                                            \n"
+  "}                                                                        \n"
+  "                                                                         \n"
+  "vec3 rgb_to_yuv(vec3 rgb)                                                \n"
+  "{                                                                        \n"
+  "  vec3 res;                                                              \n"
+  "  res.x = 0.06274510 + 0.25678824 * rgb.r + 0.50412941 * rgb.g           \n"
+  "                     + 0.09790588 * rgb.b;                               \n"
+  "  res.y = 0.50196078 - 0.14822290 * rgb.r - 0.29099279 * rgb.g           \n"
+  "                     + 0.43921569 * rgb.b;                               \n"
+  "  res.z = 0.50196078 + 0.43921569 * rgb.r - 0.36778831 * rgb.g           \n"
+  "                     - 0.07142737 * rgb.b;                               \n"
+  "  return res;                                                            \n"
   "}                                                                        \n";
 
 static const char rgba_shader[] =
@@ -79,6 +94,60 @@ static const char y_u_v_shader[] =
   "yuva.z = texture2D(cogl_sampler2, cogl_tex_coord2_in.st).x;              \n"
   "cogl_color_out = yuv_to_rgb(yuva);                                       \n";
 
+/*
+ * Shaders packing all planes of a frame into a single 8 bit buffer, as laid
+ * out by meta_multi_texture_format_get_packed_layout(). The frame is sampled
+ * from cogl_sampler0 with linear filtering, so that sampling the corner
+ * shared by 4 pixels gives the subsampled chroma value.
+ */
+static const char packed_shader_globals[] =
+  "uniform vec2 frame_size;                                                 \n"
+  "uniform vec2 packed_size;                                                \n"
+  "                                                                         \n"
+  "vec3 sample_yuv(vec2 pos)                                                \n"
+  "{                                                                        \n"
+  "  vec4 rgba = texture2D(cogl_sampler0, pos / frame_size);                \n"
+  "  return rgb_to_yuv(rgba.rgb);                                           \n"
+  "}                                                                        \n";
+
+/* Y-plane followed by an interleaved UV-plane */
+static const char y_uv_packed_shader[] =
+  "vec2 pos = floor(cogl_tex_coord0_in.st * packed_size);                   \n"
+  "float value;                                                             \n"
+  "if (pos.y < frame_size.y)                                                \n"
+  "  {                                                                      \n"
+  "    value = sample_yuv(pos + 0.5).x;                                     \n"
+  "  }                                                                      \n"
+  "else                                                                     \n"
+  "  {                                                                      \n"
+  "    vec2 chroma_pos = vec2(floor(pos.x / 2.0), pos.y - frame_size.y);    \n"
+  "    vec3 yuv = sample_yuv(chroma_pos * 2.0 + 1.0);                       \n"
+  "    value = mod(pos.x, 2.0) < 1.0 ? yuv.y : yuv.z;                       \n"
+  "  }                                                                      \n"
+  "cogl_color_out = vec4(value, value, value, 1.0);                         \n";
+
+/* Y-plane followed by a U-plane and a V-plane, with half the stride of
+ * the Y-plane, i.e. two chroma rows per row of the buffer */
+static const char y_u_v_packed_shader[] =
+  "vec2 pos = floor(cogl_tex_coord0_in.st * packed_size);                   \n"
+  "float value;                                                             \n"
+  "if (pos.y < frame_size.y)                                                \n"
+  "  {                                                                      \n"
+  "    value = sample_yuv(pos + 0.5).x;                                     \n"
+  "  }                                                                      \n"
+  "else                                                                     \n"
+  "  {                                                                      \n"
+  "    float chroma_stride = packed_size.x / 2.0;                           \n"
+  "    float chroma_height = ceil(frame_size.y / 2.0);                      \n"
+  "    float chroma_row = (pos.y - frame_size.y) * 2.0 +                    \n"
+  "                       floor(pos.x / chroma_stride);                     \n"
+  "    vec2 chroma_pos = vec2(mod(pos.x, chroma_stride),                    \n"
+  "                           mod(chroma_row, chroma_height));              \n"
+  "    vec3 yuv = sample_yuv(chroma_pos * 2.0 + 1.0);                       \n"
+  "    value = chroma_row < chroma_height ? yuv.y : yuv.z;                  \n"
+  "  }                                                                      \n"
+  "cogl_color_out = vec4(value, value, value, 1.0);                         \n";
+
 typedef struct _MetaMultiTextureFormatInfo
 {
   MetaMultiTextureFormat multi_format;
@@ -93,8 +162,10 @@ typedef struct _MetaMultiTextureFormatInfo
 
   /* Shaders */
   const char *rgb_shader;  /* Shader to convert to RGBA (or NULL) */
+  const char *packed_shader;  /* Shader to convert from RGBA (or NULL) */
 
   GOnce snippet_once;
+  GOnce packed_snippet_once;
 } MetaMultiTextureFormatInfo;
 
 /* NOTE: The actual enum values are used as the index, so you don't need to
@@ -133,7 +204,9 @@ static MetaMultiTextureFormatInfo multi_format_table[] = {
     .hsub = { 1, 2 },
     .vsub = { 1, 2 },
     .rgb_shader = y_uv_shader,
+    .packed_shader = y_uv_packed_shader,
     .snippet_once = G_ONCE_INIT,
+    .packed_snippet_once = G_ONCE_INIT,
   },
   [META_MULTI_TEXTURE_FORMAT_P010] = {
     .name = "P010",
@@ -154,7 +227,9 @@ static MetaMultiTextureFormatInfo multi_format_table[] = {
     .hsub = { 1, 2, 2 },
     .vsub = { 1, 2, 2 },
     .rgb_shader = y_u_v_shader,
+    .packed_shader = y_u_v_packed_shader,
     .snippet_once = G_ONCE_INIT,
+    .packed_snippet_once = G_ONCE_INIT,
   },
 };
 
@@ -264,3 +339,101 @@ meta_multi_texture_format_get_snippets (MetaMultiTextureFormat   format,
 
   return TRUE;
 }
+
+/*
+ * The packed layout stores the planes of a frame one after the other in a
+ * single buffer with 8 bit components, which must have @packed_width as its
+ * stride. @plane_offsets and @plane_strides receive the offset and stride of
+ * each plane, in bytes. The width is aligned so that buffers of that width
+ * usually get allocated without any additional padding.
+ */
+gboolean
+meta_multi_texture_format_get_packed_layout (MetaMultiTextureFormat  format,
+                                             int                     width,
+                                             int                     height,
+                                             int                    *packed_width,
+                                             int                    *packed_height,
+                                             int                    *plane_offsets,
+                                             int                    *plane_strides)
+{
+  const MetaMultiTextureFormatInfo *info;
+  int offset = 0;
+  size_t i;
+
+  g_return_val_if_fail (format < G_N_ELEMENTS (multi_format_table), FALSE);
+
+  info = &multi_format_table[format];
+  if (!info->packed_shader)
+    return FALSE;
+
+  *packed_width = ((width + PACKED_WIDTH_ALIGNMENT - 1) &
+                   ~(PACKED_WIDTH_ALIGNMENT - 1));
+
+  for (i = 0; i < info->n_planes; i++)
+    {
+      int bpp = cogl_pixel_format_get_bytes_per_pixel (info->subformats[i], 0);
+      int rows = (height + info->vsub[i] - 1) / info->vsub[i];
+
+      plane_offsets[i] = offset;
+      plane_strides[i] = *packed_width / info->hsub[i] * bpp;
+      offset += rows * plane_strides[i];
+    }
+  *packed_height = (offset + *packed_width - 1) / *packed_width;
+
+  return TRUE;
+}
+
+static gpointer
+create_packed_globals_snippet (gpointer data)
+{
+  g_autofree char *globals = NULL;
+
+  globals = g_strconcat (shader_global_conversions,
+                         packed_shader_globals,
+                         NULL);
+
+  return cogl_snippet_new (COGL_SNIPPET_HOOK_FRAGMENT_GLOBALS,
+                           globals,
+                           NULL);
+}
+
+static gpointer
+create_packed_format_snippet (gpointer data)
+{
+  MetaMultiTextureFormat format =
+    (MetaMultiTextureFormat) GPOINTER_TO_INT (data);
+
+  return cogl_snippet_new (COGL_SNIPPET_HOOK_FRAGMENT,
+                           NULL,
+                           multi_format_table[format].packed_shader);
+}
+
+/*
+ * Snippets for drawing an RGBA texture into a buffer with the packed
+ * layout. The pipeline must set the "frame_size" uniform to the size of
+ * the texture and "packed_size" to the size of the packed buffer.
+ */
+gboolean
+meta_multi_texture_format_get_packed_snippets (MetaMultiTextureFormat   format,
+                                               CoglSnippet            **fragment_globals_snippet,
+                                               CoglSnippet            **fragment_snippet)
+{
+  static GOnce globals_once = G_ONCE_INIT;
+  CoglSnippet *globals_snippet;
+  CoglSnippet *format_snippet;
+
+  g_return_val_if_fail (format < G_N_ELEMENTS (multi_format_table), FALSE);
+
+  if (multi_format_table[format].packed_shader == NULL)
+    return FALSE;
+
+  globals_snippet = g_once (&globals_once, create_packed_globals_snippet, NULL);
+  *fragment_globals_snippet = g_object_ref (globals_snippet);
+
+  format_snippet = g_once (&multi_format_table[format].packed_snippet_once,
+                           create_packed_format_snippet,
+                           GINT_TO_POINTER (format));
+  *fragment_snippet = g_object_ref (format_snippet);
+
+  return TRUE;
+}
@@ -0,0 +1,29 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "core/util-private.h"
+#include "mtk/mtk.h"
+
+G_BEGIN_DECLS
+
+META_EXPORT_TEST
+guchar * meta_shadow_factory_blur_region (MtkRegion *region,
+                                          int        radius,
+                                          int       *buffer_width_out,
+                                          int       *buffer_height_out);
+
+G_END_DECLS
@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include "compositor/cogl-utils.h"
+#include "compositor/meta-shadow-factory-private.h"
 #include "compositor/region-utils.h"
 #include "meta/meta-shadow-factory.h"
 #include "meta/util.h"
@@ -40,12 +41,17 @@
  *   2D blur as 1D blur of the rows followed by a 1D blur of the
  *   columns.
  *
- * - For better cache efficiency, we blur rows, transpose the image
- *   in blocks, blur rows again, and then transpose back.
+ * - For better cache efficiency, we blur columns by sliding along
+ *   all of them at once, a row at a time, rather than transposing
+ *   the image.
  *
  * - We approximate the 1D gaussian blur as 3 successive box filters.
  */
 
+/* How much memory, in texture bytes, is kept for shadows that are no
+ * longer used, in case a window with the same shape shows up again. */
+#define MAX_UNUSED_SHADOWS_SIZE (4 * 1024 * 1024)
+
 typedef struct _MetaShadowCacheKey  MetaShadowCacheKey;
 typedef struct _MetaShadowClassInfo MetaShadowClassInfo;
 
@@ -79,6 +85,12 @@ struct _MetaShadow
 
   guint scale_width : 1;
   guint scale_height : 1;
+  guint cached : 1;
+
+  /* Size of the texture, and the link in the factory's queue of
+   * unused shadows while the shadow is cached but not referenced */
+  size_t size;
+  GList unused_link;
 };
 
 struct _MetaShadowClassInfo
@@ -93,8 +105,13 @@ struct _MetaShadowFactory
   GObject parent_instance;
 
   /* MetaShadowCacheKey => MetaShadow; the shadows are not referenced
-   * by the factory, they are simply removed from the table when freed */
+   * by the factory. When the last reference to a shadow is dropped, it
+   * is kept in the unused shadows queue, most recently used first, until
+   * it is either used again or evicted to stay within
+   * MAX_UNUSED_SHADOWS_SIZE. */
   GHashTable *shadows;
+  GQueue unused_shadows;
+  size_t unused_shadows_size;
 
   /* class name => MetaShadowClassInfo */
   GHashTable *shadow_classes;
@@ -154,23 +171,48 @@ meta_shadow_ref (MetaShadow *shadow)
   return shadow;
 }
 
+static void
+meta_shadow_free (MetaShadow *shadow)
+{
+  meta_window_shape_unref (shadow->key.shape);
+  g_object_unref (shadow->texture);
+  g_object_unref (shadow->pipeline);
+
+  g_free (shadow);
+}
+
+static void
+trim_unused_shadows (MetaShadowFactory *factory)
+{
+  while (factory->unused_shadows_size > MAX_UNUSED_SHADOWS_SIZE)
+    {
+      GList *link = g_queue_pop_tail_link (&factory->unused_shadows);
+      MetaShadow *shadow = link->data;
+
+      factory->unused_shadows_size -= shadow->size;
+      g_hash_table_remove (factory->shadows, &shadow->key);
+      meta_shadow_free (shadow);
+    }
+}
+
 void
 meta_shadow_unref (MetaShadow *shadow)
 {
+  MetaShadowFactory *factory = shadow->factory;
+
   shadow->ref_count--;
   if (shadow->ref_count == 0)
     {
-      if (shadow->factory)
+      if (factory && shadow->cached)
         {
-          g_hash_table_remove (shadow->factory->shadows,
-                               &shadow->key);
+          g_queue_push_head_link (&factory->unused_shadows,
+                                  &shadow->unused_link);
+          factory->unused_shadows_size += shadow->size;
+          trim_unused_shadows (factory);
+          return;
         }
 
-      meta_window_shape_unref (shadow->key.shape);
-      g_object_unref (shadow->texture);
-      g_object_unref (shadow->pipeline);
-
-      g_free (shadow);
+      meta_shadow_free (shadow);
     }
 }
 
@@ -415,15 +457,22 @@ meta_shadow_factory_finalize (GObject *object)
   GHashTableIter iter;
   gpointer key, value;
 
-  /* Detach from the shadows in the table so we won't try to
-   * remove them when they're freed. */
+  /* Free the unused shadows, and detach from the others so they are
+   * simply freed once no longer referenced. */
   g_hash_table_iter_init (&iter, factory->shadows);
   while (g_hash_table_iter_next (&iter, &key, &value))
     {
-      MetaShadow *shadow = key;
-      shadow->factory = NULL;
+      MetaShadow *shadow = value;
+
+      if (shadow->ref_count == 0)
+        meta_shadow_free (shadow);
+      else
+        shadow->factory = NULL;
     }
 
+  g_queue_init (&factory->unused_shadows);
+  factory->unused_shadows_size = 0;
+
   g_hash_table_destroy (factory->shadows);
   g_hash_table_destroy (factory->shadow_classes);
 
@@ -476,10 +525,9 @@ meta_shadow_factory_get_default (void)
  *
  * http://www.w3.org/TR/SVG/filters.html#feGaussianBlurElement
  *
- * The 2D blur is then done by blurring the rows, flipping the
- * image and blurring the columns. (This is possible because the
- * Gaussian kernel is separable - it's the product of a horizontal
- * blur and a vertical blur.)
+ * The 2D blur is then done by blurring the columns and then the
+ * rows. (This is possible because the Gaussian kernel is separable -
+ * it's the product of a horizontal blur and a vertical blur.)
  */
 static int
 get_box_filter_size (int radius)
@@ -508,6 +556,36 @@ get_shadow_spread (int radius)
     return 3 * (d / 2) - 1;
 }
 
+/* Dividing the sums of the box filter by its size is the slowest part
+ * of the blur, so it is done as a multiplication by the reciprocal of
+ * the size in 9.23 fixed point instead. The reciprocal is off by less
+ * than 2^-23, so for the sums that can occur, below 256 * d, the
+ * result is exact as long as 256 * d / 2^23 stays under 1 / d. Larger
+ * filters are divided as usual.
+ */
+#define BOX_DIVIDE_SHIFT 23
+#define BOX_DIVIDE_MAX_SIZE 181
+
+static guint32
+get_box_divide_multiplier (int d)
+{
+  if (d >= BOX_DIVIDE_MAX_SIZE)
+    return 0;
+
+  return ((1 << BOX_DIVIDE_SHIFT) + d - 1) / d;
+}
+
+static inline guchar
+box_divide (guint32 sum,
+            int     d,
+            guint32 multiplier)
+{
+  if (multiplier)
+    return ((sum + d / 2) * multiplier) >> BOX_DIVIDE_SHIFT;
+  else
+    return (sum + d / 2) / d;
+}
+
 /* This applies a single box blur pass to a horizontal range of pixels;
  * since the box blur has the same weight for all pixels, we can
  * implement an efficient sliding window algorithm where we add
@@ -527,6 +605,7 @@ blur_xspan (guchar *row,
             int     d,
             int     shift)
 {
+  guint32 multiplier = get_box_divide_multiplier (d);
   int offset;
   int sum = 0;
   int i;
@@ -539,11 +618,7 @@ blur_xspan (guchar *row,
   /* All the conditionals in here look slow, but the branches will
    * be well predicted and there are enough different possibilities
    * that trying to write this as a series of unconditional loops
-   * is hard and not an obvious win. The main slow down here seems
-   * to be the integer division per pixel; one possible optimization
-   * would be to accumulate into two 16-bit integer buffers and
-   * only divide down after all three passes. (SSE parallel implementation
-   * of the divide step is possible.)
+   * is hard and not an obvious win.
    */
   for (i = x0 - d + offset; i < x1 + offset; i++)
     {
@@ -555,13 +630,86 @@ blur_xspan (guchar *row,
           if (i >= d)
             sum -= row[i - d];
 
-          tmp_buffer[i - offset] = (sum + d / 2) / d;
+          tmp_buffer[i - offset] = box_divide (sum, d, multiplier);
         }
     }
 
   memcpy (row + x0, tmp_buffer + x0, x1 - x0);
 }
 
+/* The vertical equivalent of blur_xspan(), for the columns x0 to x1
+ * between the rows y0 and y1. Rather than sliding along one column at
+ * a time, this slides along all of the columns at once, so that every
+ * step works on a contiguous part of a row and can be vectorized by
+ * the compiler. The d rows in the window are kept in @ring, as the
+ * original values are needed when they leave the window after having
+ * been overwritten.
+ */
+static void
+blur_yspan (guchar  *buffer,
+            int      buffer_width,
+            int      buffer_height,
+            int      x0,
+            int      x1,
+            int      y0,
+            int      y1,
+            int      d,
+            int      shift,
+            guint32 *sums,
+            guchar  *ring)
+{
+  guint32 multiplier = get_box_divide_multiplier (d);
+  int width = x1 - x0;
+  int offset;
+  int start;
+  int i, x;
+
+  if (d % 2 == 1)
+    offset = d / 2;
+  else
+    offset = (d - shift) / 2;
+
+  memset (sums, 0, width * sizeof (guint32));
+
+  start = y0 - d + offset;
+  for (i = start; i < y1 + offset; i++)
+    {
+      guchar *ring_row = ring + ((i - start) % d) * width;
+
+      /* The row leaving the window was stored d rows ago, in the slot
+       * the entering row goes to */
+      if (i >= y0 + offset && i >= d)
+        {
+          for (x = 0; x < width; x++)
+            sums[x] -= ring_row[x];
+        }
+
+      if (i >= 0 && i < buffer_height)
+        {
+          memcpy (ring_row, buffer + i * buffer_width + x0, width);
+
+          for (x = 0; x < width; x++)
+            sums[x] += ring_row[x];
+        }
+
+      if (i >= y0 + offset)
+        {
+          guchar *row = buffer + (i - offset) * buffer_width + x0;
+
+          if (multiplier)
+            {
+              for (x = 0; x < width; x++)
+                row[x] = ((sums[x] + d / 2) * multiplier) >> BOX_DIVIDE_SHIFT;
+            }
+          else
+            {
+              for (x = 0; x < width; x++)
+                row[x] = (sums[x] + d / 2) / d;
+            }
+        }
+    }
+}
+
 static void
 blur_rows (MtkRegion *convolve_region,
            int        x_offset,
@@ -614,6 +762,66 @@ blur_rows (MtkRegion *convolve_region,
   g_free (tmp_buffer);
 }
 
+/* Blurs the columns of the buffer in place. The convolve region is
+ * flipped, as returned by meta_make_border_region(), so that each of
+ * its rectangles covers a range of columns that are all blurred along
+ * the same range of rows.
+ */
+static void
+blur_columns (MtkRegion *convolve_region,
+              int        x_offset,
+              int        y_offset,
+              guchar    *buffer,
+              int        buffer_width,
+              int        buffer_height,
+              int        d)
+{
+  int i;
+  int n_rectangles;
+  guint32 *sums;
+  guchar *ring;
+
+  sums = g_new (guint32, buffer_width);
+  ring = g_malloc ((d + 1) * buffer_width);
+
+  n_rectangles = mtk_region_num_rectangles (convolve_region);
+  for (i = 0; i < n_rectangles; i++)
+    {
+      MtkRectangle rect;
+      int x0, x1, y0, y1;
+
+      rect = mtk_region_get_rectangle (convolve_region, i);
+
+      x0 = x_offset + rect.y;
+      x1 = x0 + rect.height;
+      y0 = y_offset + rect.x;
+      y1 = y0 + rect.width;
+
+      /* See blur_rows() */
+      if (d % 2 == 1)
+        {
+          blur_yspan (buffer, buffer_width, buffer_height,
+                      x0, x1, y0, y1, d, 0, sums, ring);
+          blur_yspan (buffer, buffer_width, buffer_height,
+                      x0, x1, y0, y1, d, 0, sums, ring);
+          blur_yspan (buffer, buffer_width, buffer_height,
+                      x0, x1, y0, y1, d, 0, sums, ring);
+        }
+      else
+        {
+          blur_yspan (buffer, buffer_width, buffer_height,
+                      x0, x1, y0, y1, d, 1, sums, ring);
+          blur_yspan (buffer, buffer_width, buffer_height,
+                      x0, x1, y0, y1, d, -1, sums, ring);
+          blur_yspan (buffer, buffer_width, buffer_height,
+                      x0, x1, y0, y1, d + 1, 0, sums, ring);
+        }
+    }
+
+  g_free (ring);
+  g_free (sums);
+}
+
 static void
 fade_bytes (guchar *bytes,
             int     width,
@@ -627,87 +835,19 @@ fade_bytes (guchar *bytes,
     bytes[i] = (bytes[i] * multiplier) >> 16;
 }
 
-/* Swaps width and height. Either swaps in-place and returns the original
- * buffer or allocates a new buffer, frees the original buffer and returns
- * the new buffer.
+/*
+ * Renders @region, which must have its extents at the origin, blurred
+ * with @radius into a newly allocated A8 buffer. The region is offset by
+ * the spread of the blur within the buffer.
  */
-static guchar *
-flip_buffer (guchar *buffer,
-             int     width,
-             int     height)
-{
-  /* Working in blocks increases cache efficiency, compared to reading
-   * or writing an entire column at once */
-#define BLOCK_SIZE 16
-
-  if (width == height)
-    {
-      int i0, j0;
-
-      for (j0 = 0; j0 < height; j0 += BLOCK_SIZE)
-        for (i0 = 0; i0 <= j0; i0 += BLOCK_SIZE)
-          {
-            int max_j = MIN(j0 + BLOCK_SIZE, height);
-            int max_i = MIN(i0 + BLOCK_SIZE, width);
-            int i, j;
-
-            if (i0 == j0)
-              {
-                for (j = j0; j < max_j; j++)
-                  for (i = i0; i < j; i++)
-                    {
-                      guchar tmp = buffer[j * width + i];
-                      buffer[j * width + i] = buffer[i * width + j];
-                      buffer[i * width + j] = tmp;
-                    }
-              }
-            else
-              {
-                for (j = j0; j < max_j; j++)
-                  for (i = i0; i < max_i; i++)
-                    {
-                      guchar tmp = buffer[j * width + i];
-                      buffer[j * width + i] = buffer[i * width + j];
-                      buffer[i * width + j] = tmp;
-                    }
-              }
-          }
-
-      return buffer;
-    }
-  else
-    {
-      guchar *new_buffer = g_malloc (height * width);
-      int i0, j0;
-
-      for (i0 = 0; i0 < width; i0 += BLOCK_SIZE)
-        for (j0 = 0; j0 < height; j0 += BLOCK_SIZE)
-          {
-            int max_j = MIN(j0 + BLOCK_SIZE, height);
-            int max_i = MIN(i0 + BLOCK_SIZE, width);
-            int i, j;
-
-            for (i = i0; i < max_i; i++)
-              for (j = j0; j < max_j; j++)
-                new_buffer[i * height + j] = buffer[j * width + i];
-          }
-
-      g_free (buffer);
-
-      return new_buffer;
-    }
-#undef BLOCK_SIZE
-}
-
-static void
-make_shadow (MetaShadow *shadow,
-             MtkRegion  *region)
+guchar *
+meta_shadow_factory_blur_region (MtkRegion *region,
+                                 int        radius,
+                                 int       *buffer_width_out,
+                                 int       *buffer_height_out)
 {
-  ClutterBackend *backend = clutter_get_default_backend ();
-  CoglContext *ctx = clutter_backend_get_cogl_context (backend);
-  GError *error = NULL;
-  int d = get_box_filter_size (shadow->key.radius);
-  int spread = get_shadow_spread (shadow->key.radius);
+  int d = get_box_filter_size (radius);
+  int spread = get_shadow_spread (radius);
   MtkRectangle extents;
   g_autoptr (MtkRegion) row_convolve_region = NULL;
   g_autoptr (MtkRegion) column_convolve_region = NULL;
@@ -732,17 +872,8 @@ make_shadow (MetaShadow *shadow,
   buffer_width = extents.width + 2 * spread;
   buffer_height = extents.height + 2 * spread;
 
-  /* Round up so we have aligned rows/columns */
+  /* Round up so we have aligned rows */
   buffer_width = (buffer_width + 3) & ~3;
-  buffer_height = (buffer_height + 3) & ~3;
-
-  /* Square buffer allows in-place swaps, which are roughly 70% faster, but we
-   * don't want to over-allocate too much memory.
-   */
-  if (buffer_height < buffer_width && buffer_height > (3 * buffer_width) / 4)
-    buffer_height = buffer_width;
-  if (buffer_width < buffer_height && buffer_width > (3 * buffer_height) / 4)
-    buffer_width = buffer_height;
 
   buffer = g_malloc0 (buffer_width * buffer_height);
 
@@ -768,23 +899,49 @@ make_shadow (MetaShadow *shadow,
         memset (buffer + buffer_width * j + x_offset + rect.x, 255, rect.width);
     }
 
-  /* Step 2: swap rows and columns */
-  buffer = flip_buffer (buffer, buffer_width, buffer_height);
-
-  /* Step 3: blur rows (really columns) */
-  blur_rows (column_convolve_region, y_offset, x_offset,
-             buffer, buffer_height, buffer_width,
-             d);
+  /* Step 2: blur columns */
+  blur_columns (column_convolve_region, x_offset, y_offset,
+                buffer, buffer_width, buffer_height,
+                d);
 
-  /* Step 4: swap rows and columns */
-  buffer = flip_buffer (buffer, buffer_height, buffer_width);
-
-  /* Step 5: blur rows */
+  /* Step 3: blur rows */
   blur_rows (row_convolve_region, x_offset, y_offset,
              buffer, buffer_width, buffer_height,
              d);
 
-  /* Step 6: fade out the top, if applicable */
+  *buffer_width_out = buffer_width;
+  *buffer_height_out = buffer_height;
+
+  return buffer;
+}
+
+static void
+make_shadow (MetaShadow *shadow,
+             MtkRegion  *region)
+{
+  ClutterBackend *backend = clutter_get_default_backend ();
+  CoglContext *ctx = clutter_backend_get_cogl_context (backend);
+  GError *error = NULL;
+  int spread = get_shadow_spread (shadow->key.radius);
+  MtkRectangle extents;
+  guchar *buffer;
+  int buffer_width;
+  int buffer_height;
+  int texture_width;
+  int texture_height;
+  int x_offset;
+  int y_offset;
+  int j;
+
+  extents = mtk_region_get_extents (region);
+
+  buffer = meta_shadow_factory_blur_region (region, shadow->key.radius,
+                                            &buffer_width, &buffer_height);
+
+  x_offset = spread;
+  y_offset = spread;
+
+  /* Step 4: fade out the top, if applicable */
   if (shadow->key.top_fade >= 0)
     {
       for (j = y_offset; j < y_offset + MIN (shadow->key.top_fade, extents.height + shadow->outer_border_bottom); j++)
@@ -795,9 +952,13 @@ make_shadow (MetaShadow *shadow,
    * in the case of top_fade >= 0. We also account for padding at the left for symmetry
    * though that doesn't currently occur.
    */
+  texture_width = shadow->outer_border_left + extents.width + shadow->outer_border_right;
+  texture_height = shadow->outer_border_top + extents.height + shadow->outer_border_bottom;
+  shadow->size = (size_t) texture_width * texture_height;
+
   shadow->texture = cogl_texture_2d_new_from_data (ctx,
-                                                   shadow->outer_border_left + extents.width + shadow->outer_border_right,
-                                                   shadow->outer_border_top + extents.height + shadow->outer_border_bottom,
+                                                   texture_width,
+                                                   texture_height,
                                                    COGL_PIXEL_FORMAT_A_8,
                                                    buffer_width,
                                                    (buffer +
@@ -942,13 +1103,23 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
 
       shadow = g_hash_table_lookup (factory->shadows, &key);
       if (shadow)
-        return meta_shadow_ref (shadow);
+        {
+          if (shadow->ref_count == 0)
+            {
+              g_queue_unlink (&factory->unused_shadows,
+                              &shadow->unused_link);
+              factory->unused_shadows_size -= shadow->size;
+            }
+
+          return meta_shadow_ref (shadow);
+        }
     }
 
   shadow = g_new0 (MetaShadow, 1);
 
   shadow->ref_count = 1;
   shadow->factory = factory;
+  shadow->unused_link.data = shadow;
   shadow->key.shape = meta_window_shape_ref (shape);
   shadow->key.radius = params->radius;
   shadow->key.top_fade = params->top_fade;
@@ -980,7 +1151,10 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
   make_shadow (shadow, region);
 
   if (cacheable)
-    g_hash_table_insert (factory->shadows, &shadow->key, shadow);
+    {
+      shadow->cached = TRUE;
+      g_hash_table_insert (factory->shadows, &shadow->key, shadow);
+    }
 
   return shadow;
 }
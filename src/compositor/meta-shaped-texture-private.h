@@ -70,6 +70,8 @@ void meta_shaped_texture_set_clip_region (MetaShapedTexture *stex,
                                           MtkRegion         *clip_region);
 void meta_shaped_texture_set_opaque_region (MetaShapedTexture *stex,
                                             MtkRegion         *opaque_region);
+void meta_shaped_texture_set_overlay_view (MetaShapedTexture *stex,
+                                           ClutterStageView  *overlay_view);
 
 void meta_shaped_texture_ensure_size_valid (MetaShapedTexture *stex);
 
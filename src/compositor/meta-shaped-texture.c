@@ -93,6 +93,9 @@ struct _MetaShapedTexture
   /* MetaCullable regions, see that documentation for more details */
   MtkRegion *clip_region;
 
+  /* Stage view on which the content is scanned out on an overlay plane */
+  ClutterStageView *overlay_view;
+
   gboolean size_invalid;
   MetaMonitorTransform transform;
   gboolean has_viewport_src_rect;
@@ -253,6 +256,8 @@ meta_shaped_texture_dispose (GObject *object)
 
   g_clear_pointer (&stex->snippet, g_object_unref);
 
+  g_clear_weak_pointer (&stex->overlay_view);
+
   G_OBJECT_CLASS (meta_shaped_texture_parent_class)->dispose (object);
 }
 
@@ -906,6 +911,14 @@ meta_shaped_texture_paint_content (ClutterContent      *content,
   if (stex->clip_region && mtk_region_is_empty (stex->clip_region))
     return;
 
+  /* The content is put on an overlay plane above the view framebuffer, so
+   * there is nothing to composite when painting directly onto it. */
+  if (stex->overlay_view &&
+      clutter_paint_context_get_stage_view (paint_context) == stex->overlay_view &&
+      clutter_paint_context_get_framebuffer (paint_context) ==
+      clutter_stage_view_get_onscreen (stex->overlay_view))
+    return;
+
   /* The GL EXT_texture_from_pixmap extension does allow for it to be
    * used together with SGIS_generate_mipmap, however this is very
    * rarely supported. Also, even when it is supported there
@@ -1175,6 +1188,13 @@ meta_shaped_texture_get_texture (MetaShapedTexture *stex)
   return stex->texture;
 }
 
+void
+meta_shaped_texture_set_overlay_view (MetaShapedTexture *stex,
+                                      ClutterStageView  *overlay_view)
+{
+  g_set_weak_pointer (&stex->overlay_view, overlay_view);
+}
+
 /**
  * meta_shaped_texture_set_opaque_region:
  * @stex: a #MetaShapedTexture
@@ -20,6 +20,7 @@
 #include "compositor/meta-surface-actor.h"
 
 #include "clutter/clutter.h"
+#include "clutter/clutter-mutter.h"
 #include "compositor/clutter-utils.h"
 #include "compositor/meta-cullable.h"
 #include "compositor/meta-shaped-texture-private.h"
@@ -538,6 +539,7 @@ meta_surface_actor_set_input_region (MetaSurfaceActor *self,
 {
   MetaSurfaceActorPrivate *priv =
     meta_surface_actor_get_instance_private (self);
+  ClutterActor *stage;
 
   g_clear_pointer (&priv->input_region, mtk_region_unref);
 
@@ -545,6 +547,10 @@ meta_surface_actor_set_input_region (MetaSurfaceActor *self,
     priv->input_region = mtk_region_ref (region);
   else
     priv->input_region = NULL;
+
+  stage = clutter_actor_get_stage (CLUTTER_ACTOR (self));
+  if (stage)
+    clutter_stage_invalidate_pick (CLUTTER_STAGE (stage));
 }
 
 void
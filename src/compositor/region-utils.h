@@ -25,6 +25,7 @@
 #include "backends/meta-backend-types.h"
 #include "clutter/clutter.h"
 #include "core/boxes-private.h"
+#include "core/util-private.h"
 
 /**
  * MetaRegionIterator:
@@ -95,6 +96,7 @@ void     meta_region_iterator_next      (MetaRegionIterator *iter);
 MtkRegion * meta_region_scale (MtkRegion *region,
                                int        scale);
 
+META_EXPORT_TEST
 MtkRegion * meta_make_border_region (MtkRegion *region,
                                      int        x_amount,
                                      int        y_amount,
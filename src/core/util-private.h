@@ -42,6 +42,11 @@ char *   meta_generate_random_id (GRand *rand,
 
 void meta_init_debug_utils (void);
 
+META_EXPORT_TEST
+int64_t meta_sort_samples_get_percentile (int64_t *samples,
+                                          int      n_samples,
+                                          int      percentile);
+
 static inline int64_t
 meta_timeval_to_microseconds (const struct timeval *tv)
 {
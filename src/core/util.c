@@ -69,6 +69,7 @@ static const GDebugKey meta_debug_keys[] = {
   { "color", META_DEBUG_COLOR },
   { "input-events", META_DEBUG_INPUT_EVENTS },
   { "eis", META_DEBUG_EIS },
+  { "background", META_DEBUG_BACKGROUND },
 };
 
 static gint verbose_topics = 0;
@@ -326,6 +327,8 @@ meta_topic_to_string (MetaDebugTopic topic)
       return "INPUT_EVENTS";
     case META_DEBUG_EIS:
       return "EIS";
+    case META_DEBUG_BACKGROUND:
+      return "BACKGROUND";
     }
 
   return "WM";
@@ -589,6 +592,36 @@ meta_get_debug_paint_flags (void)
   return debug_paint_flags;
 }
 
+static int
+compare_samples (const void *a,
+                 const void *b)
+{
+  int64_t sample_a = *(const int64_t *) a;
+  int64_t sample_b = *(const int64_t *) b;
+
+  return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+/*
+ * Sorts @samples in place, and returns the nearest-rank @percentile of
+ * them, e.g. of latencies recorded over the last frames.
+ */
+int64_t
+meta_sort_samples_get_percentile (int64_t *samples,
+                                  int      n_samples,
+                                  int      percentile)
+{
+  int index;
+
+  g_return_val_if_fail (n_samples > 0, 0);
+
+  qsort (samples, n_samples, sizeof (int64_t), compare_samples);
+
+  index = MAX ((n_samples * percentile + 99) / 100 - 1, 0);
+
+  return samples[index];
+}
+
 void
 meta_log (const char *format, ...)
 {
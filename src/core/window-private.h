@@ -644,6 +644,9 @@ void        meta_window_unmanage_on_idle   (MetaWindow *window);
 void        meta_window_queue              (MetaWindow  *window,
                                             MetaQueueType queue_types);
 META_EXPORT_TEST
+gboolean    meta_window_is_queued          (MetaWindow    *window,
+                                            MetaQueueType  queue_types);
+META_EXPORT_TEST
 void        meta_window_untile             (MetaWindow        *window);
 
 META_EXPORT_TEST
@@ -1840,6 +1840,15 @@ meta_window_queue (MetaWindow   *window,
   meta_display_queue_window (window->display, window, queue_types);
 }
 
+gboolean
+meta_window_is_queued (MetaWindow    *window,
+                       MetaQueueType  queue_types)
+{
+  MetaWindowPrivate *priv = meta_window_get_instance_private (window);
+
+  return (priv->queued_types & queue_types) != 0;
+}
+
 static gboolean
 intervening_user_event_occurred (MetaWindow *window)
 {
@@ -5416,7 +5425,7 @@ invalidate_work_areas (MetaWindow *window)
 
   while (tmp != NULL)
     {
-      meta_workspace_invalidate_work_area (tmp->data);
+      meta_workspace_invalidate_struts (tmp->data);
       tmp = tmp->next;
     }
 }
@@ -63,6 +63,9 @@ struct _MetaWorkspace
   GSList *builtin_struts;
   GSList *all_struts;
   guint work_areas_invalid : 1;
+  /* Set when all_struts and the work areas of all monitors must be
+   * recomputed, rather than only those of monitors with changed struts */
+  guint struts_invalid : 1;
 
   guint showing_desktop : 1;
 };
@@ -87,6 +90,8 @@ void meta_workspace_get_work_area_for_logical_monitor (MetaWorkspace      *works
 
 void meta_workspace_invalidate_work_area (MetaWorkspace *workspace);
 
+void meta_workspace_invalidate_struts (MetaWorkspace *workspace);
+
 GList* meta_workspace_get_onscreen_region       (MetaWorkspace *workspace);
 GList * meta_workspace_get_onmonitor_region (MetaWorkspace      *workspace,
                                              MetaLogicalMonitor *logical_monitor);
@@ -227,6 +227,7 @@ meta_workspace_new (MetaWorkspaceManager *workspace_manager)
   workspace->mru_list = NULL;
 
   workspace->work_areas_invalid = TRUE;
+  workspace->struts_invalid = TRUE;
   workspace->work_area_screen.x = 0;
   workspace->work_area_screen.y = 0;
   workspace->work_area_screen.width = 0;
@@ -316,20 +317,15 @@ meta_workspace_remove (MetaWorkspace *workspace)
 
   workspace_free_builtin_struts (workspace);
 
-  /* screen.c:update_num_workspaces(), which calls us, removes windows from
-   * workspaces first, which can cause the workareas on the workspace to be
-   * invalidated (and hence for struts/regions/edges to be freed).
-   * So, no point trying to double free it; that causes a crash
-   * anyway.  #361804.
-   */
-
-  if (!workspace->work_areas_invalid)
-    {
-      workspace_free_all_struts (workspace);
-      meta_rectangle_free_list_and_elements (workspace->screen_region);
-      meta_rectangle_free_list_and_elements (workspace->screen_edges);
-      meta_rectangle_free_list_and_elements (workspace->monitor_edges);
-    }
+  /* Invalidating the work areas, e.g. when removing windows from the
+   * workspace, already frees and clears some or all of these */
+  workspace_free_all_struts (workspace);
+  g_clear_pointer (&workspace->screen_region,
+                   meta_rectangle_free_list_and_elements);
+  g_clear_pointer (&workspace->screen_edges,
+                   meta_rectangle_free_list_and_elements);
+  g_clear_pointer (&workspace->monitor_edges,
+                   meta_rectangle_free_list_and_elements);
 
   g_object_unref (workspace);
 
@@ -376,9 +372,9 @@ meta_workspace_add_window (MetaWorkspace *workspace,
   if (window->struts)
     {
       meta_topic (META_DEBUG_WORKAREA,
-                  "Invalidating work area of workspace %d since we're adding window %s to it",
+                  "Invalidating struts of workspace %d since we're adding window %s to it",
                   meta_workspace_index (workspace), window->desc);
-      meta_workspace_invalidate_work_area (workspace);
+      meta_workspace_invalidate_struts (workspace);
     }
 
   if (workspace != workspace_manager->active_workspace)
@@ -405,9 +401,9 @@ meta_workspace_remove_window (MetaWorkspace *workspace,
   if (window->struts)
     {
       meta_topic (META_DEBUG_WORKAREA,
-                  "Invalidating work area of workspace %d since we're removing window %s from it",
+                  "Invalidating struts of workspace %d since we're removing window %s from it",
                   meta_workspace_index (workspace), window->desc);
-      meta_workspace_invalidate_work_area (workspace);
+      meta_workspace_invalidate_struts (workspace);
     }
 
   if (workspace != workspace_manager->active_workspace)
@@ -757,13 +753,43 @@ meta_workspace_list_windows (MetaWorkspace *workspace)
   return workspace_windows;
 }
 
+static void
+update_window_drag_edges (MetaWorkspace *workspace)
+{
+  MetaWindowDrag *window_drag;
+
+  window_drag =
+    meta_compositor_get_current_window_drag (workspace->display->compositor);
+
+  /* If we are in the middle of a resize or move operation, we
+   * might have cached pointers to the workspace's edges */
+  if (window_drag &&
+      workspace == workspace->manager->active_workspace)
+    meta_window_drag_update_edges (window_drag);
+}
+
+static void
+workspace_free_screen_regions (MetaWorkspace *workspace)
+{
+  g_clear_pointer (&workspace->screen_region,
+                   meta_rectangle_free_list_and_elements);
+  g_clear_pointer (&workspace->screen_edges,
+                   meta_rectangle_free_list_and_elements);
+  g_clear_pointer (&workspace->monitor_edges,
+                   meta_rectangle_free_list_and_elements);
+}
+
+/*
+ * Throws away all work areas of @workspace, and queues all of its windows to
+ * be constrained again. Needed when the monitor layout changed; when only
+ * struts changed, use meta_workspace_invalidate_struts() instead.
+ */
 void
 meta_workspace_invalidate_work_area (MetaWorkspace *workspace)
 {
-  MetaWindowDrag *window_drag;
   GList *windows, *l;
 
-  if (workspace->work_areas_invalid)
+  if (workspace->struts_invalid)
     {
       meta_topic (META_DEBUG_WORKAREA,
                   "Work area for workspace %d is already invalid",
@@ -775,27 +801,15 @@ meta_workspace_invalidate_work_area (MetaWorkspace *workspace)
               "Invalidating work area for workspace %d",
               meta_workspace_index (workspace));
 
-  window_drag =
-    meta_compositor_get_current_window_drag (workspace->display->compositor);
-
-  /* If we are in the middle of a resize or move operation, we
-   * might have cached pointers to the workspace's edges */
-  if (window_drag &&
-      workspace == workspace->manager->active_workspace)
-    meta_window_drag_update_edges (window_drag);
+  update_window_drag_edges (workspace);
 
   meta_workspace_clear_logical_monitor_data (workspace);
 
   workspace_free_all_struts (workspace);
-
-  meta_rectangle_free_list_and_elements (workspace->screen_region);
-  meta_rectangle_free_list_and_elements (workspace->screen_edges);
-  meta_rectangle_free_list_and_elements (workspace->monitor_edges);
-  workspace->screen_region = NULL;
-  workspace->screen_edges = NULL;
-  workspace->monitor_edges = NULL;
+  workspace_free_screen_regions (workspace);
 
   workspace->work_areas_invalid = TRUE;
+  workspace->struts_invalid = TRUE;
 
   /* redo the size/position constraints on all windows */
   windows = meta_workspace_list_windows (workspace);
@@ -828,6 +842,198 @@ copy_strut_list(GSList *original)
   return g_slist_reverse (result);
 }
 
+static GSList *
+collect_struts (MetaWorkspace *workspace)
+{
+  GSList *struts;
+  GList *l;
+
+  struts = copy_strut_list (workspace->builtin_struts);
+
+  /* Windows being removed from the workspace are already gone from this
+   * list, unlike from meta_workspace_list_windows() */
+  for (l = workspace->windows; l; l = l->next)
+    {
+      MetaWindow *window = l->data;
+      GSList *s;
+
+      if (window->override_redirect)
+        continue;
+
+      for (s = window->struts; s; s = s->next)
+        struts = g_slist_prepend (struts, copy_strut (s->data));
+    }
+
+  return struts;
+}
+
+static gboolean
+strut_list_contains (GSList    *struts,
+                     MetaStrut *strut)
+{
+  GSList *l;
+
+  for (l = struts; l; l = l->next)
+    {
+      MetaStrut *other = l->data;
+
+      if (other->side == strut->side &&
+          mtk_rectangle_equal (&other->rect, &strut->rect))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Returns the struts only in one of the lists */
+static GSList *
+find_changed_struts (GSList *old_struts,
+                     GSList *new_struts)
+{
+  GSList *changed_struts = NULL;
+  GSList *l;
+
+  for (l = old_struts; l; l = l->next)
+    {
+      if (!strut_list_contains (new_struts, l->data))
+        changed_struts = g_slist_prepend (changed_struts, copy_strut (l->data));
+    }
+
+  for (l = new_struts; l; l = l->next)
+    {
+      if (!strut_list_contains (old_struts, l->data))
+        changed_struts = g_slist_prepend (changed_struts, copy_strut (l->data));
+    }
+
+  return changed_struts;
+}
+
+static gboolean
+overlaps_any_strut (const MtkRectangle *rect,
+                    GSList             *struts)
+{
+  GSList *l;
+
+  for (l = struts; l; l = l->next)
+    {
+      MetaStrut *strut = l->data;
+
+      if (mtk_rectangle_overlap (rect, &strut->rect))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+is_window_affected_by_struts (MetaWindow *window,
+                              GList      *affected_monitors,
+                              GSList     *changed_struts)
+{
+  MtkRectangle frame_rect;
+  GList *l;
+
+  if (window->monitor && g_list_find (affected_monitors, window->monitor))
+    return TRUE;
+
+  meta_window_get_frame_rect (window, &frame_rect);
+
+  for (l = affected_monitors; l; l = l->next)
+    {
+      MetaLogicalMonitor *logical_monitor = l->data;
+
+      if (mtk_rectangle_overlap (&frame_rect, &logical_monitor->rect))
+        return TRUE;
+    }
+
+  return overlaps_any_strut (&frame_rect, changed_struts);
+}
+
+/*
+ * Updates the work areas of @workspace after its struts changed, e.g. when
+ * a panel or dock is shown, hidden or resized. Only the work areas of the
+ * monitors the changed struts are on are recomputed, and only windows on
+ * those monitors are queued to be constrained again.
+ */
+void
+meta_workspace_invalidate_struts (MetaWorkspace *workspace)
+{
+  MetaContext *context = meta_display_get_context (workspace->display);
+  MetaBackend *backend = meta_context_get_backend (context);
+  MetaMonitorManager *monitor_manager =
+    meta_backend_get_monitor_manager (backend);
+  g_autoptr (GList) affected_monitors = NULL;
+  GSList *new_struts;
+  GSList *changed_struts;
+  GList *logical_monitors, *windows, *l;
+
+  if (workspace->struts_invalid)
+    {
+      meta_topic (META_DEBUG_WORKAREA,
+                  "Work area for workspace %d is already invalid",
+                  meta_workspace_index (workspace));
+      return;
+    }
+
+  new_struts = collect_struts (workspace);
+  changed_struts = find_changed_struts (workspace->all_struts, new_struts);
+  if (!changed_struts)
+    {
+      meta_topic (META_DEBUG_WORKAREA,
+                  "Struts of workspace %d didn't change",
+                  meta_workspace_index (workspace));
+      g_slist_free_full (new_struts, g_free);
+      return;
+    }
+
+  update_window_drag_edges (workspace);
+
+  workspace_free_all_struts (workspace);
+  workspace->all_struts = new_struts;
+
+  logical_monitors =
+    meta_monitor_manager_get_logical_monitors (monitor_manager);
+  for (l = logical_monitors; l; l = l->next)
+    {
+      MetaLogicalMonitor *logical_monitor = l->data;
+
+      if (!overlaps_any_strut (&logical_monitor->rect, changed_struts))
+        continue;
+
+      meta_topic (META_DEBUG_WORKAREA,
+                  "Invalidating work area for workspace %d monitor %d",
+                  meta_workspace_index (workspace),
+                  logical_monitor->number);
+
+      if (workspace->logical_monitor_data)
+        g_hash_table_remove (workspace->logical_monitor_data, logical_monitor);
+
+      affected_monitors = g_list_prepend (affected_monitors, logical_monitor);
+    }
+
+  /* These span all monitors, but are cheap to recompute compared to
+   * constraining all windows again */
+  workspace_free_screen_regions (workspace);
+
+  workspace->work_areas_invalid = TRUE;
+
+  windows = meta_workspace_list_windows (workspace);
+  for (l = windows; l; l = l->next)
+    {
+      MetaWindow *window = l->data;
+
+      if (is_window_affected_by_struts (window,
+                                        affected_monitors,
+                                        changed_struts))
+        meta_window_queue (window, META_QUEUE_MOVE_RESIZE);
+    }
+  g_list_free (windows);
+
+  g_slist_free_full (changed_struts, g_free);
+
+  meta_display_queue_workarea_recalc (workspace->display);
+}
+
 static void
 ensure_work_areas_validated (MetaWorkspace *workspace)
 {
@@ -835,7 +1041,6 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
   MetaBackend *backend = meta_context_get_backend (context);
   MetaMonitorManager *monitor_manager =
     meta_backend_get_monitor_manager (backend);
-  GList *windows;
   GList *tmp;
   GList *logical_monitors, *l;
   MtkRectangle display_rect = { 0 };
@@ -844,7 +1049,6 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
   if (!workspace->work_areas_invalid)
     return;
 
-  g_assert (workspace->all_struts == NULL);
   g_assert (workspace->screen_region == NULL);
   g_assert (workspace->screen_edges == NULL);
   g_assert (workspace->monitor_edges == NULL);
@@ -853,28 +1057,20 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
                          &display_rect.width,
                          &display_rect.height);
 
-  /* STEP 1: Get the list of struts */
-
-  workspace->all_struts = copy_strut_list (workspace->builtin_struts);
-
-  windows = meta_workspace_list_windows (workspace);
-  for (tmp = windows; tmp != NULL; tmp = tmp->next)
+  /* STEP 1: Get the list of struts, unless only some monitors were
+   *         invalidated, in which case it is already up to date
+   */
+  if (workspace->struts_invalid)
     {
-      MetaWindow *win = tmp->data;
-      GSList *s_iter;
+      g_assert (workspace->all_struts == NULL);
 
-      for (s_iter = win->struts; s_iter != NULL; s_iter = s_iter->next) {
-        workspace->all_struts = g_slist_prepend (workspace->all_struts,
-                                                 copy_strut(s_iter->data));
-      }
+      workspace->all_struts = collect_struts (workspace);
+      workspace->struts_invalid = FALSE;
     }
-  g_list_free (windows);
 
   /* STEP 2: Get the maximal/spanning rects for the onscreen and
-   *         on-single-monitor regions
+   *         on-single-monitor regions, and the work areas of monitors
    */
-  g_assert (workspace->screen_region   == NULL);
-
   logical_monitors =
     meta_monitor_manager_get_logical_monitors (monitor_manager);
   for (l = logical_monitors; l; l = l->next)
@@ -882,8 +1078,9 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
       MetaLogicalMonitor *logical_monitor = l->data;
       MetaWorkspaceLogicalMonitorData *data;
 
-      g_assert (!meta_workspace_get_logical_monitor_data (workspace,
-                                                          logical_monitor));
+      /* Still valid, the struts changed elsewhere */
+      if (meta_workspace_get_logical_monitor_data (workspace, logical_monitor))
+        continue;
 
       data = meta_workspace_ensure_logical_monitor_data (workspace,
                                                          logical_monitor);
@@ -891,6 +1088,30 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
         meta_rectangle_get_minimal_spanning_set_for_region (
           &logical_monitor->rect,
           workspace->all_struts);
+
+      work_area = logical_monitor->rect;
+
+      if (!data->logical_monitor_region)
+        /* FIXME: constraints.c untested with this, but it might be nice for
+         * a screen reader or magnifier.
+         */
+        work_area = MTK_RECTANGLE_INIT (work_area.x, work_area.y, -1, -1);
+      else
+        meta_rectangle_clip_to_region (data->logical_monitor_region,
+                                       FIXED_DIRECTION_NONE,
+                                       &work_area);
+
+      data->logical_monitor_work_area = work_area;
+
+      meta_topic (META_DEBUG_WORKAREA,
+                  "Computed work area for workspace %d "
+                  "monitor %d: %d,%d %d x %d",
+                  meta_workspace_index (workspace),
+                  logical_monitor->number,
+                  data->logical_monitor_work_area.x,
+                  data->logical_monitor_work_area.y,
+                  data->logical_monitor_work_area.width,
+                  data->logical_monitor_work_area.height);
     }
 
   workspace->screen_region =
@@ -898,8 +1119,7 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
       &display_rect,
       workspace->all_struts);
 
-  /* STEP 3: Get the work areas (region-to-maximize-to) for the screen and
-   *         monitors.
+  /* STEP 3: Get the work area (region-to-maximize-to) for the screen.
    */
   work_area = display_rect;  /* start with the screen */
   if (workspace->screen_region == NULL)
@@ -956,39 +1176,6 @@ ensure_work_areas_validated (MetaWorkspace *workspace)
               workspace->work_area_screen.width,
               workspace->work_area_screen.height);
 
-  /* Now find the work areas for each monitor */
-  for (l = logical_monitors; l; l = l->next)
-    {
-      MetaLogicalMonitor *logical_monitor = l->data;
-      MetaWorkspaceLogicalMonitorData *data;
-
-      data = meta_workspace_get_logical_monitor_data (workspace,
-                                                      logical_monitor);
-      work_area = logical_monitor->rect;
-
-      if (!data->logical_monitor_region)
-        /* FIXME: constraints.c untested with this, but it might be nice for
-         * a screen reader or magnifier.
-         */
-        work_area = MTK_RECTANGLE_INIT (work_area.x, work_area.y, -1, -1);
-      else
-        meta_rectangle_clip_to_region (data->logical_monitor_region,
-                                       FIXED_DIRECTION_NONE,
-                                       &work_area);
-
-      data->logical_monitor_work_area = work_area;
-
-      meta_topic (META_DEBUG_WORKAREA,
-                  "Computed work area for workspace %d "
-                  "monitor %d: %d,%d %d x %d",
-                  meta_workspace_index (workspace),
-                  logical_monitor->number,
-                  data->logical_monitor_work_area.x,
-                  data->logical_monitor_work_area.y,
-                  data->logical_monitor_work_area.width,
-                  data->logical_monitor_work_area.height);
-    }
-
   /* STEP 4: Make sure the screen_region is nonempty (separate from step 2
    *         since it relies on step 3).
    */
@@ -1119,7 +1306,7 @@ meta_workspace_set_builtin_struts (MetaWorkspace *workspace,
   workspace_free_builtin_struts (workspace);
   workspace->builtin_struts = copy_strut_list (struts);
 
-  meta_workspace_invalidate_work_area (workspace);
+  meta_workspace_invalidate_struts (workspace);
 }
 
 void
@@ -76,6 +76,7 @@ void meta_fatal      (const char *format,
  * @META_DEBUG_COLOR: color management
  * @META_DEBUG_INPUT_EVENTS: input events
  * @META_DEBUG_EIS: eis state
+ * @META_DEBUG_BACKGROUND: background texture cache
  */
 typedef enum
 {
@@ -109,6 +110,7 @@ typedef enum
   META_DEBUG_COLOR           = 1 << 26,
   META_DEBUG_INPUT_EVENTS    = 1 << 27,
   META_DEBUG_EIS             = 1 << 28,
+  META_DEBUG_BACKGROUND      = 1 << 29,
 } MetaDebugTopic;
 
 /**
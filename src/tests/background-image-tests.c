@@ -0,0 +1,227 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+#include <time.h>
+#include <utime.h>
+
+#include "compositor/meta-background-image-private.h"
+#include "meta-test/meta-context-test.h"
+
+#define IMAGE_WIDTH 400
+#define IMAGE_HEIGHT 300
+
+static char *
+get_disk_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "mutter", "backgrounds",
+                           NULL);
+}
+
+static GPtrArray *
+list_cached_files (void)
+{
+  g_autofree char *cache_path = get_disk_cache_path ();
+  g_autoptr (GDir) dir = NULL;
+  GPtrArray *cached_files;
+  const char *name;
+
+  cached_files = g_ptr_array_new_with_free_func (g_free);
+
+  dir = g_dir_open (cache_path, 0, NULL);
+  if (!dir)
+    return cached_files;
+
+  while ((name = g_dir_read_name (dir)))
+    g_ptr_array_add (cached_files, g_build_filename (cache_path, name, NULL));
+
+  return cached_files;
+}
+
+static void
+clear_disk_cache (void)
+{
+  g_autoptr (GPtrArray) cached_files = list_cached_files ();
+  int i;
+
+  for (i = 0; i < cached_files->len; i++)
+    g_unlink (g_ptr_array_index (cached_files, i));
+}
+
+static void
+save_image (const char *path,
+            int         width,
+            int         height)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) error = NULL;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  gdk_pixbuf_fill (pixbuf, 0x3366ccff);
+  gdk_pixbuf_save (pixbuf, path, "png", &error, NULL);
+  g_assert_no_error (error);
+}
+
+static void
+on_loaded (MetaBackgroundImage *image,
+           gboolean            *loaded)
+{
+  *loaded = TRUE;
+}
+
+static MetaBackgroundImage *
+load_image (GFile *file,
+            int    max_width,
+            int    max_height)
+{
+  MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
+  MetaBackgroundImage *image;
+  gboolean loaded = FALSE;
+
+  image = meta_background_image_cache_load_scaled (cache, file,
+                                                   max_width, max_height);
+  if (!meta_background_image_is_loaded (image))
+    {
+      gulong handler_id;
+
+      handler_id = g_signal_connect (image, "loaded",
+                                     G_CALLBACK (on_loaded), &loaded);
+      while (!loaded)
+        g_main_context_iteration (NULL, TRUE);
+      g_signal_handler_disconnect (image, handler_id);
+    }
+
+  g_assert_true (meta_background_image_get_success (image));
+
+  return image;
+}
+
+static void
+assert_texture_size (MetaBackgroundImage *image,
+                     int                  width,
+                     int                  height)
+{
+  CoglTexture *texture = meta_background_image_get_texture (image);
+
+  g_assert_nonnull (texture);
+  g_assert_cmpint (cogl_texture_get_width (texture), ==, width);
+  g_assert_cmpint (cogl_texture_get_height (texture), ==, height);
+}
+
+static void
+meta_test_background_image_load_scaled (void)
+{
+  MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
+  g_autofree char *dir = NULL;
+  g_autofree char *path = NULL;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (GPtrArray) cached_files = NULL;
+  g_autoptr (GError) error = NULL;
+  MetaBackgroundImage *image;
+  MetaBackgroundImage *other_image;
+  struct utimbuf times;
+
+  clear_disk_cache ();
+
+  dir = g_dir_make_tmp ("mutter-background-XXXXXX", &error);
+  g_assert_no_error (error);
+  path = g_build_filename (dir, "background.png", NULL);
+  save_image (path, IMAGE_WIDTH, IMAGE_HEIGHT);
+  file = g_file_new_for_path (path);
+
+  /* Decoding keeps the aspect ratio, covering the requested area */
+  image = load_image (file, 100, 50);
+  assert_texture_size (image, 100, 75);
+
+  other_image = load_image (file, 100, 50);
+  g_assert (other_image == image);
+  g_object_unref (other_image);
+  g_object_unref (image);
+
+  cached_files = list_cached_files ();
+  g_assert_cmpuint (cached_files->len, ==, 1);
+
+  /* Once dropped from memory, the image comes from the disk cache; make
+   * that recognizable by its size */
+  meta_background_image_cache_purge (cache, file);
+  save_image (g_ptr_array_index (cached_files, 0), 101, 76);
+
+  image = load_image (file, 100, 50);
+  assert_texture_size (image, 101, 76);
+  g_object_unref (image);
+
+  /* Another size is decoded from the original file */
+  image = load_image (file, 200, 100);
+  assert_texture_size (image, 200, 150);
+  g_object_unref (image);
+  g_clear_pointer (&cached_files, g_ptr_array_unref);
+  cached_files = list_cached_files ();
+  g_assert_cmpuint (cached_files->len, ==, 2);
+
+  /* As is the same size once the original file changes */
+  meta_background_image_cache_purge (cache, file);
+  save_image (path, IMAGE_WIDTH * 2, IMAGE_HEIGHT * 2);
+  times.actime = times.modtime = time (NULL) - 60;
+  g_assert_cmpint (g_utime (path, &times), ==, 0);
+
+  image = load_image (file, 100, 50);
+  assert_texture_size (image, 100, 75);
+  g_object_unref (image);
+  g_clear_pointer (&cached_files, g_ptr_array_unref);
+  cached_files = list_cached_files ();
+  g_assert_cmpuint (cached_files->len, ==, 3);
+
+  /* Images that don't need scaling aren't cached on disk */
+  meta_background_image_cache_purge (cache, file);
+  image = load_image (file, IMAGE_WIDTH * 4, IMAGE_HEIGHT * 4);
+  assert_texture_size (image, IMAGE_WIDTH * 2, IMAGE_HEIGHT * 2);
+  g_object_unref (image);
+  g_clear_pointer (&cached_files, g_ptr_array_unref);
+  cached_files = list_cached_files ();
+  g_assert_cmpuint (cached_files->len, ==, 3);
+
+  meta_background_image_cache_purge (cache, file);
+  clear_disk_cache ();
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/compositor/background-image/load-scaled",
+                   meta_test_background_image_load_scaled);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NO_X11);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
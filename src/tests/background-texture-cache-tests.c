@@ -0,0 +1,251 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "backends/meta-backend-private.h"
+#include "compositor/meta-background-texture-cache.h"
+#include "meta-test/meta-context-test.h"
+
+#define TEXTURE_SIZE 64
+
+static MetaContext *test_context;
+
+static CoglTexture *
+create_texture (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+
+  return cogl_texture_2d_new_with_size (cogl_context,
+                                        TEXTURE_SIZE, TEXTURE_SIZE);
+}
+
+static MetaBackgroundCachedTexture *
+insert_texture (MetaBackgroundTextureCache  *cache,
+                const char                  *key,
+                GFile                      **files,
+                int                          n_files)
+{
+  g_autoptr (CoglTexture) texture = NULL;
+  MetaBackgroundCachedTexture *cached_texture;
+
+  texture = create_texture ();
+  cached_texture = meta_background_texture_cache_insert (cache, key, texture,
+                                                         files, n_files);
+  g_assert_nonnull (cached_texture);
+  g_assert (meta_background_cached_texture_get_texture (cached_texture) ==
+            texture);
+  g_assert_cmpstr (meta_background_cached_texture_get_key (cached_texture),
+                   ==, key);
+
+  return cached_texture;
+}
+
+static size_t
+get_texture_cost (void)
+{
+  MetaBackgroundTextureCache *cache;
+  MetaBackgroundCachedTexture *cached_texture;
+  MetaBackgroundTextureCacheUsage usage;
+
+  cache = meta_background_texture_cache_new (G_MAXSIZE);
+  cached_texture = insert_texture (cache, "cost", NULL, 0);
+  meta_background_texture_cache_get_usage (cache, &usage);
+  meta_background_cached_texture_release (cached_texture);
+  meta_background_texture_cache_free (cache);
+
+  return usage.in_use_size;
+}
+
+static void
+assert_usage (MetaBackgroundTextureCache *cache,
+              size_t                      in_use_size,
+              size_t                      idle_size,
+              unsigned int                n_textures)
+{
+  MetaBackgroundTextureCacheUsage usage;
+
+  meta_background_texture_cache_get_usage (cache, &usage);
+  g_assert_cmpuint (usage.in_use_size, ==, in_use_size);
+  g_assert_cmpuint (usage.idle_size, ==, idle_size);
+  g_assert_cmpuint (usage.n_textures, ==, n_textures);
+}
+
+static void
+meta_test_background_texture_cache_release (void)
+{
+  MetaBackgroundTextureCache *cache;
+  MetaBackgroundCachedTexture *cached_texture;
+  size_t cost = get_texture_cost ();
+
+  cache = meta_background_texture_cache_new (G_MAXSIZE);
+
+  g_assert_null (meta_background_texture_cache_lookup (cache, "a"));
+
+  cached_texture = insert_texture (cache, "a", NULL, 0);
+  assert_usage (cache, cost, 0, 1);
+
+  g_assert (meta_background_texture_cache_lookup (cache, "a") ==
+            cached_texture);
+  assert_usage (cache, cost, 0, 1);
+
+  /* Only the last release makes the texture idle */
+  meta_background_cached_texture_release (cached_texture);
+  assert_usage (cache, cost, 0, 1);
+  meta_background_cached_texture_release (cached_texture);
+  assert_usage (cache, 0, cost, 1);
+
+  /* Looking up an idle texture makes it used again */
+  g_assert (meta_background_texture_cache_lookup (cache, "a") ==
+            cached_texture);
+  assert_usage (cache, cost, 0, 1);
+  meta_background_cached_texture_release (cached_texture);
+
+  meta_background_texture_cache_free (cache);
+}
+
+static void
+meta_test_background_texture_cache_budget (void)
+{
+  MetaBackgroundTextureCache *cache;
+  MetaBackgroundCachedTexture *a, *b, *c;
+  size_t cost = get_texture_cost ();
+
+  cache = meta_background_texture_cache_new (2 * cost);
+
+  a = insert_texture (cache, "a", NULL, 0);
+  b = insert_texture (cache, "b", NULL, 0);
+  meta_background_cached_texture_release (a);
+  meta_background_cached_texture_release (b);
+  assert_usage (cache, 0, 2 * cost, 2);
+
+  /* Reviving "a" makes "b" the least recently used idle texture */
+  a = meta_background_texture_cache_lookup (cache, "a");
+  g_assert_nonnull (a);
+  meta_background_cached_texture_release (a);
+
+  c = insert_texture (cache, "c", NULL, 0);
+  assert_usage (cache, cost, cost, 2);
+  g_assert_null (meta_background_texture_cache_lookup (cache, "b"));
+
+  a = meta_background_texture_cache_lookup (cache, "a");
+  g_assert_nonnull (a);
+  assert_usage (cache, 2 * cost, 0, 2);
+
+  /* Textures in use are never evicted, even when over budget */
+  b = insert_texture (cache, "b", NULL, 0);
+  assert_usage (cache, 3 * cost, 0, 3);
+
+  meta_background_cached_texture_release (c);
+  assert_usage (cache, 2 * cost, 0, 2);
+  g_assert_null (meta_background_texture_cache_lookup (cache, "c"));
+
+  /* Shrinking the budget evicts idle textures right away */
+  meta_background_cached_texture_release (a);
+  meta_background_cached_texture_release (b);
+  assert_usage (cache, 0, 2 * cost, 2);
+  meta_background_texture_cache_set_budget (cache, cost);
+  assert_usage (cache, 0, cost, 1);
+  g_assert_null (meta_background_texture_cache_lookup (cache, "a"));
+
+  meta_background_texture_cache_set_budget (cache, 0);
+  assert_usage (cache, 0, 0, 0);
+
+  meta_background_texture_cache_free (cache);
+}
+
+static void
+meta_test_background_texture_cache_purge (void)
+{
+  MetaBackgroundTextureCache *cache;
+  MetaBackgroundCachedTexture *a, *b, *c, *new_a;
+  g_autoptr (GFile) file1 = NULL;
+  g_autoptr (GFile) file2 = NULL;
+  g_autoptr (GFile) file1_copy = NULL;
+  GFile *files_a[] = { NULL, NULL };
+  size_t cost = get_texture_cost ();
+
+  file1 = g_file_new_for_path ("/backgrounds/1.png");
+  file2 = g_file_new_for_path ("/backgrounds/2.png");
+  file1_copy = g_file_new_for_path ("/backgrounds/1.png");
+  files_a[0] = file1;
+  files_a[1] = file2;
+
+  cache = meta_background_texture_cache_new (G_MAXSIZE);
+
+  a = insert_texture (cache, "a", files_a, G_N_ELEMENTS (files_a));
+  b = insert_texture (cache, "b", &file1, 1);
+  c = insert_texture (cache, "c", &file2, 1);
+  meta_background_cached_texture_release (b);
+  assert_usage (cache, 2 * cost, cost, 3);
+
+  /* Textures still in use stay valid until released */
+  meta_background_texture_cache_purge_file (cache, file1_copy);
+  assert_usage (cache, 2 * cost, 0, 1);
+  g_assert_null (meta_background_texture_cache_lookup (cache, "b"));
+  g_assert_nonnull (meta_background_cached_texture_get_texture (a));
+
+  /* A purged key can be rendered again without affecting the old texture */
+  new_a = insert_texture (cache, "a", files_a, G_N_ELEMENTS (files_a));
+  g_assert (new_a != a);
+  assert_usage (cache, 3 * cost, 0, 2);
+
+  meta_background_cached_texture_release (a);
+  assert_usage (cache, 2 * cost, 0, 2);
+
+  meta_background_cached_texture_release (new_a);
+  meta_background_texture_cache_purge_all (cache);
+  assert_usage (cache, cost, 0, 0);
+  g_assert_null (meta_background_texture_cache_lookup (cache, "a"));
+  g_assert_null (meta_background_texture_cache_lookup (cache, "c"));
+
+  meta_background_cached_texture_release (c);
+  assert_usage (cache, 0, 0, 0);
+
+  meta_background_texture_cache_free (cache);
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/compositor/background-texture-cache/release",
+                   meta_test_background_texture_cache_release);
+  g_test_add_func ("/compositor/background-texture-cache/budget",
+                   meta_test_background_texture_cache_budget);
+  g_test_add_func ("/compositor/background-texture-cache/purge",
+                   meta_test_background_texture_cache_purge);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NO_X11);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  test_context = context;
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
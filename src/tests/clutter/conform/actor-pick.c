@@ -1,5 +1,6 @@
 #define CLUTTER_DISABLE_DEPRECATION_WARNINGS
 #include <clutter/clutter.h>
+#include <clutter/clutter-mutter.h>
 
 #include "tests/clutter-test-utils.h"
 
@@ -223,6 +224,137 @@ actor_pick (void)
   g_list_free_full (state.actor_list, (GDestroyNotify) clutter_actor_destroy);
 }
 
+static ClutterActor *
+pick_actor_center (ClutterActor    *stage,
+                   ClutterActor    *actor,
+                   ClutterPickMode  mode)
+{
+  float x, y;
+
+  clutter_actor_get_position (actor, &x, &y);
+
+  return clutter_stage_get_actor_at_pos (CLUTTER_STAGE (stage), mode,
+                                         x + clutter_actor_get_width (actor) / 2,
+                                         y + clutter_actor_get_height (actor) / 2);
+}
+
+static gboolean
+on_retained_timeout (gpointer data)
+{
+  State *state = data;
+  graphene_point_t points[ACTORS_X * ACTORS_Y + 1];
+  ClutterActor *actors[ACTORS_X * ACTORS_Y + 1];
+  ClutterActor *actor;
+  int pass, i;
+
+  /* Pick every actor a few times without changing the scene in between,
+   * so that the stage keeps the pick stack of the whole view around.
+   */
+  for (pass = 0; pass < 3; pass++)
+    {
+      for (i = 0; i < ACTORS_X * ACTORS_Y; i++)
+        {
+          actor = pick_actor_center (state->stage, state->actors[i],
+                                     CLUTTER_PICK_REACTIVE);
+          g_assert_true (actor == state->actors[i]);
+        }
+    }
+
+  /* Picking all of them at once must give the same results */
+  for (i = 0; i < ACTORS_X * ACTORS_Y; i++)
+    {
+      float x, y;
+
+      clutter_actor_get_position (state->actors[i], &x, &y);
+      points[i] = GRAPHENE_POINT_INIT (x + state->actor_width / 2,
+                                       y + state->actor_height / 2);
+    }
+  points[i] = GRAPHENE_POINT_INIT (-1, -1);
+
+  clutter_actor_queue_redraw (state->stage);
+  clutter_stage_get_actors_at_pos (CLUTTER_STAGE (state->stage),
+                                   CLUTTER_PICK_REACTIVE,
+                                   G_N_ELEMENTS (points), points,
+                                   actors);
+
+  for (i = 0; i < ACTORS_X * ACTORS_Y; i++)
+    g_assert_true (actors[i] == state->actors[i]);
+  g_assert_true (actors[i] == state->stage);
+
+  /* Changes that don't queue a redraw must still be picked up */
+  clutter_actor_set_reactive (state->actors[0], FALSE);
+  actor = pick_actor_center (state->stage, state->actors[0],
+                             CLUTTER_PICK_REACTIVE);
+  g_assert_true (actor == state->stage);
+
+  actor = pick_actor_center (state->stage, state->actors[0],
+                             CLUTTER_PICK_ALL);
+  g_assert_true (actor == state->actors[0]);
+
+  clutter_actor_set_reactive (state->actors[0], TRUE);
+  actor = pick_actor_center (state->stage, state->actors[0],
+                             CLUTTER_PICK_REACTIVE);
+  g_assert_true (actor == state->actors[0]);
+
+  /* Neither must hiding an actor after the stage picked the whole view */
+  for (i = 0; i < ACTORS_X * ACTORS_Y; i++)
+    pick_actor_center (state->stage, state->actors[i], CLUTTER_PICK_REACTIVE);
+
+  clutter_actor_hide (state->actors[1]);
+  actor = pick_actor_center (state->stage, state->actors[1],
+                             CLUTTER_PICK_REACTIVE);
+  g_assert_true (actor == state->stage);
+
+  actor = pick_actor_center (state->stage, state->actors[2],
+                             CLUTTER_PICK_REACTIVE);
+  g_assert_true (actor == state->actors[2]);
+
+  clutter_test_quit ();
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+actor_pick_retained (void)
+{
+  State state = { 0 };
+  int y, x;
+
+  state.stage = clutter_test_get_stage ();
+
+  state.actor_width = STAGE_WIDTH / ACTORS_X;
+  state.actor_height = STAGE_HEIGHT / ACTORS_Y;
+
+  for (y = 0; y < ACTORS_Y; y++)
+    for (x = 0; x < ACTORS_X; x++)
+      {
+        ClutterActor *rect = clutter_actor_new ();
+
+        state.actor_list = g_list_prepend (state.actor_list, rect);
+
+        clutter_actor_set_position (rect,
+                                    x * state.actor_width,
+                                    y * state.actor_height);
+        clutter_actor_set_size (rect,
+                                state.actor_width,
+                                state.actor_height);
+        clutter_actor_set_reactive (rect, TRUE);
+
+        clutter_actor_add_child (state.stage, rect);
+
+        state.actors[y * ACTORS_X + x] = rect;
+      }
+
+  clutter_actor_show (state.stage);
+
+  clutter_threads_add_idle (on_retained_timeout, &state);
+
+  clutter_test_main ();
+
+  g_list_free_full (state.actor_list, (GDestroyNotify) clutter_actor_destroy);
+}
+
 CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/actor/pick", actor_pick)
+  CLUTTER_TEST_UNIT ("/actor/pick-retained", actor_pick_retained)
 )
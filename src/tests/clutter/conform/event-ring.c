@@ -0,0 +1,175 @@
+#include <clutter/clutter.h>
+
+#include "backends/native/meta-seat-impl.h"
+#include "backends/native/meta-seat-native.h"
+#include "clutter/clutter-event-private.h"
+#include "tests/clutter-test-utils.h"
+
+/* Same as in clutter-event.c */
+#define EVENT_RING_SIZE 512
+
+typedef struct
+{
+  ClutterInputDevice *device;
+  int64_t first_time_us;
+  int n_events;
+
+  GMutex mutex;
+  GCond cond;
+  gboolean done;
+} PushData;
+
+static gboolean
+push_events_in_impl (GTask *task)
+{
+  PushData *data = g_task_get_task_data (task);
+  int i;
+
+  for (i = 0; i < data->n_events; i++)
+    {
+      ClutterEvent *event;
+
+      event = clutter_event_motion_new (CLUTTER_EVENT_NONE,
+                                        data->first_time_us + i,
+                                        data->device,
+                                        NULL, 0,
+                                        GRAPHENE_POINT_INIT (0, 0),
+                                        GRAPHENE_POINT_INIT (0, 0),
+                                        GRAPHENE_POINT_INIT (0, 0),
+                                        GRAPHENE_POINT_INIT (0, 0),
+                                        NULL);
+      _clutter_event_push_from_input_thread (event);
+    }
+
+  g_task_return_boolean (task, TRUE);
+
+  g_mutex_lock (&data->mutex);
+  data->done = TRUE;
+  g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->mutex);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Pushes @n_events motion events from the input thread of the seat,
+ * timestamped from @first_time_us on.
+ */
+static void
+push_events_from_input_thread (int64_t first_time_us,
+                               int     n_events)
+{
+  ClutterBackend *backend = clutter_get_default_backend ();
+  ClutterSeat *seat = clutter_backend_get_default_seat (backend);
+  g_autoptr (GTask) task = NULL;
+  PushData data = { 0 };
+
+  data.device = clutter_seat_get_pointer (seat);
+  data.first_time_us = first_time_us;
+  data.n_events = n_events;
+  g_mutex_init (&data.mutex);
+  g_cond_init (&data.cond);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, &data, NULL);
+  meta_seat_impl_run_input_task (META_SEAT_NATIVE (seat)->impl, task,
+                                 (GSourceFunc) push_events_in_impl);
+
+  /* Iterating the main context would dispatch the events, so block */
+  g_mutex_lock (&data.mutex);
+  while (!data.done)
+    g_cond_wait (&data.cond, &data.mutex);
+  g_mutex_unlock (&data.mutex);
+
+  g_mutex_clear (&data.mutex);
+  g_cond_clear (&data.cond);
+}
+
+static void
+pop_events (int64_t    first_time_us,
+            int        n_events,
+            GPtrArray *events)
+{
+  int i;
+
+  for (i = 0; i < n_events; i++)
+    {
+      ClutterEvent *event;
+
+      event = clutter_event_get ();
+      g_assert_nonnull (event);
+      g_assert_cmpint (clutter_event_get_time_us (event),
+                       ==,
+                       first_time_us + i);
+
+      g_ptr_array_add (events, event);
+    }
+}
+
+static void
+event_ring_order (void)
+{
+  g_autoptr (GPtrArray) events = NULL;
+
+  events = g_ptr_array_new_with_free_func ((GDestroyNotify) clutter_event_free);
+
+  /* Fill the ring, and queue more events than it holds */
+  push_events_from_input_thread (0, EVENT_RING_SIZE + 100);
+
+  /* Events pushed while older ones wait in the overflow queue go after
+   * them, even if the ring has room again */
+  pop_events (0, 50, events);
+  push_events_from_input_thread (EVENT_RING_SIZE + 100, 50);
+
+  pop_events (50, EVENT_RING_SIZE + 100, events);
+  g_assert_null (clutter_event_get ());
+}
+
+static void
+event_ring_recycle (void)
+{
+  g_autoptr (GPtrArray) events = NULL;
+  g_autoptr (GPtrArray) overflow_events = NULL;
+  g_autoptr (GPtrArray) recycled_events = NULL;
+  g_autoptr (GHashTable) pooled_events = NULL;
+  int i;
+
+  events = g_ptr_array_new ();
+  overflow_events =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) clutter_event_free);
+  recycled_events =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) clutter_event_free);
+  pooled_events = g_hash_table_new (NULL, NULL);
+
+  /* Take every event of the pool, and some allocated ones on top */
+  push_events_from_input_thread (0, EVENT_RING_SIZE + 10);
+  pop_events (0, EVENT_RING_SIZE, events);
+  pop_events (EVENT_RING_SIZE, 10, overflow_events);
+
+  /* Hand the pooled ones back from the main thread, keeping the others
+   * alive so their memory can't be reused */
+  for (i = 0; i < events->len; i++)
+    {
+      ClutterEvent *event = g_ptr_array_index (events, i);
+
+      g_hash_table_add (pooled_events, event);
+      clutter_event_free (event);
+    }
+
+  push_events_from_input_thread (0, EVENT_RING_SIZE);
+  pop_events (0, EVENT_RING_SIZE, recycled_events);
+
+  for (i = 0; i < recycled_events->len; i++)
+    {
+      ClutterEvent *event = g_ptr_array_index (recycled_events, i);
+
+      g_assert_true (g_hash_table_remove (pooled_events, event));
+    }
+
+  g_assert_null (clutter_event_get ());
+}
+
+CLUTTER_TEST_SUITE (
+  CLUTTER_TEST_UNIT ("/event-ring/order", event_ring_order)
+  CLUTTER_TEST_UNIT ("/event-ring/recycle", event_ring_recycle)
+)
@@ -830,6 +830,170 @@ frame_clock_notify_ready (void)
   clutter_frame_clock_destroy (frame_clock);
 }
 
+static int64_t last_variable_presentation_time_us;
+
+static ClutterFrameResult
+variable_frame_clock_frame (ClutterFrameClock *frame_clock,
+                            ClutterFrame      *frame,
+                            gpointer           user_data)
+{
+  GMainLoop *main_loop = user_data;
+  int64_t now_us;
+  int64_t target_presentation_time_us;
+  int64_t presentation_time_us;
+  ClutterFrameInfo frame_info;
+
+  g_assert_cmpint (clutter_frame_get_count (frame), ==, expected_frame_count);
+
+  expected_frame_count++;
+
+  if (test_frame_count == 0)
+    {
+      g_main_loop_quit (main_loop);
+      return CLUTTER_FRAME_RESULT_IDLE;
+    }
+
+  test_frame_count--;
+
+  now_us = g_get_monotonic_time ();
+
+  if (clutter_frame_get_target_presentation_time (frame,
+                                                  &target_presentation_time_us))
+    {
+      /* Never faster than the maximum refresh rate, and never held back
+       * waiting for a fixed presentation time further away than that.
+       */
+      g_assert_cmpint (target_presentation_time_us -
+                       last_variable_presentation_time_us,
+                       >=,
+                       refresh_interval_us);
+      g_assert_cmpint (target_presentation_time_us - now_us,
+                       <=,
+                       refresh_interval_us);
+    }
+
+  /* A variable refresh rate display starts scanning out as soon as a new
+   * buffer is flipped, as long as the previous refresh cycle has completed.
+   */
+  presentation_time_us = MAX (now_us,
+                              last_variable_presentation_time_us +
+                              refresh_interval_us);
+  last_variable_presentation_time_us = presentation_time_us;
+
+  init_frame_info (&frame_info, presentation_time_us);
+  clutter_frame_clock_notify_presented (frame_clock, &frame_info);
+
+  if (test_frame_count % 2)
+    g_idle_add (schedule_update_idle, frame_clock);
+  else
+    g_timeout_add (refresh_interval_us * 3 / 2 / 1000,
+                   schedule_update_timeout, frame_clock);
+
+  return CLUTTER_FRAME_RESULT_PENDING_PRESENTED;
+}
+
+static const ClutterFrameListenerIface variable_frame_listener_iface = {
+  .frame = variable_frame_clock_frame,
+};
+
+static void
+frame_clock_variable_refresh_rate (void)
+{
+  GMainLoop *main_loop;
+  ClutterFrameClock *frame_clock;
+
+  test_frame_count = 10;
+  expected_frame_count = 0;
+  last_variable_presentation_time_us = 0;
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+  frame_clock = clutter_frame_clock_new (refresh_rate,
+                                         0,
+                                         &variable_frame_listener_iface,
+                                         main_loop);
+  clutter_frame_clock_set_mode (frame_clock, CLUTTER_FRAME_CLOCK_MODE_VARIABLE);
+  g_assert_cmpint (clutter_frame_clock_get_mode (frame_clock),
+                   ==,
+                   CLUTTER_FRAME_CLOCK_MODE_VARIABLE);
+
+  clutter_frame_clock_schedule_update (frame_clock);
+  g_main_loop_run (main_loop);
+
+  g_assert_cmpint (expected_frame_count, ==, 11);
+
+  g_main_loop_unref (main_loop);
+  clutter_frame_clock_destroy (frame_clock);
+}
+
+static void
+frame_clock_timing_stats (void)
+{
+  FrameClockTest test;
+  ClutterFrameClock *frame_clock;
+  ClutterFrameTimingStats stats;
+  GSource *source;
+  FakeHwClock *fake_hw_clock;
+  unsigned int n_bucket_samples;
+  int i;
+
+  test_frame_count = 10;
+  expected_frame_count = 0;
+
+  test.main_loop = g_main_loop_new (NULL, FALSE);
+  frame_clock = clutter_frame_clock_new (refresh_rate,
+                                         0,
+                                         &frame_listener_iface,
+                                         &test);
+
+  fake_hw_clock = fake_hw_clock_new (frame_clock,
+                                     schedule_update_hw_callback,
+                                     frame_clock);
+  source = &fake_hw_clock->source;
+  g_source_attach (source, NULL);
+
+  test.fake_hw_clock = fake_hw_clock;
+
+  clutter_frame_clock_schedule_update (frame_clock);
+  g_main_loop_run (test.main_loop);
+
+  clutter_frame_clock_get_timing_stats (frame_clock,
+                                        CLUTTER_FRAME_TIMING_DISPATCH_LATENESS,
+                                        &stats);
+  g_assert_cmpuint (stats.n_samples, ==, 11);
+
+  clutter_frame_clock_get_timing_stats (frame_clock,
+                                        CLUTTER_FRAME_TIMING_PRESENTATION_DELTA,
+                                        &stats);
+  g_assert_cmpuint (stats.n_samples, ==, 9);
+  g_assert_cmpint (stats.min, <=, stats.p50);
+  g_assert_cmpint (stats.p50, <=, stats.p90);
+  g_assert_cmpint (stats.p90, <=, stats.p99);
+  g_assert_cmpint (stats.p99, <=, stats.max);
+  g_assert_cmpint (stats.min, >, 0);
+
+  n_bucket_samples = 0;
+  for (i = 0; i < CLUTTER_FRAME_TIMING_N_BUCKETS; i++)
+    n_bucket_samples += stats.buckets[i];
+  g_assert_cmpuint (n_bucket_samples, ==, stats.n_samples);
+
+  clutter_frame_clock_get_timing_stats (frame_clock,
+                                        CLUTTER_FRAME_TIMING_GPU_RENDER_TIME,
+                                        &stats);
+  g_assert_cmpuint (stats.n_samples, ==, 0);
+
+  clutter_frame_clock_reset_timing_stats (frame_clock);
+  clutter_frame_clock_get_timing_stats (frame_clock,
+                                        CLUTTER_FRAME_TIMING_PRESENTATION_DELTA,
+                                        &stats);
+  g_assert_cmpuint (stats.n_samples, ==, 0);
+
+  g_main_loop_unref (test.main_loop);
+
+  clutter_frame_clock_destroy (frame_clock);
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
 CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/frame-clock/schedule-update", frame_clock_schedule_update)
   CLUTTER_TEST_UNIT ("/frame-clock/immediate-present", frame_clock_immediate_present)
@@ -841,4 +1005,6 @@ CLUTTER_TEST_SUITE (
   CLUTTER_TEST_UNIT ("/frame-clock/reschedule-on-idle", frame_clock_reschedule_on_idle)
   CLUTTER_TEST_UNIT ("/frame-clock/destroy-signal", frame_clock_destroy_signal)
   CLUTTER_TEST_UNIT ("/frame-clock/notify-ready", frame_clock_notify_ready)
+  CLUTTER_TEST_UNIT ("/frame-clock/variable-refresh-rate", frame_clock_variable_refresh_rate)
+  CLUTTER_TEST_UNIT ("/frame-clock/timing-stats", frame_clock_timing_stats)
 )
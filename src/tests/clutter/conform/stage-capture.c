@@ -0,0 +1,222 @@
+#include <clutter/clutter.h>
+#include <clutter/clutter-mutter.h>
+#include <gio/gio.h>
+
+#include "tests/clutter-test-utils.h"
+
+static void
+on_presented (ClutterStage     *stage,
+              ClutterStageView *view,
+              ClutterFrameInfo *frame_info,
+              gboolean         *was_presented)
+{
+  *was_presented = TRUE;
+}
+
+static void
+wait_for_paint (ClutterActor *stage)
+{
+  gboolean was_presented = FALSE;
+  gulong presented_handler_id;
+
+  presented_handler_id = g_signal_connect (stage, "presented",
+                                           G_CALLBACK (on_presented),
+                                           &was_presented);
+  clutter_actor_queue_redraw (stage);
+  while (!was_presented)
+    g_main_context_iteration (NULL, FALSE);
+  g_signal_handler_disconnect (stage, presented_handler_id);
+}
+
+static void
+on_capture_finished (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  GAsyncResult **result_out = user_data;
+
+  *result_out = g_object_ref (result);
+}
+
+static GAsyncResult *
+capture_view (ClutterActor       *stage,
+              const MtkRectangle *rect,
+              GCancellable       *cancellable)
+{
+  ClutterStageView *view;
+  GAsyncResult *result = NULL;
+
+  view = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage))->data;
+
+  clutter_stage_capture_view_async (CLUTTER_STAGE (stage), view, rect,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                    cancellable,
+                                    on_capture_finished, &result);
+  if (cancellable)
+    g_cancellable_cancel (cancellable);
+
+  while (!result)
+    g_main_context_iteration (NULL, TRUE);
+
+  return result;
+}
+
+static void
+stage_capture_view_async (void)
+{
+  ClutterActor *stage = clutter_test_get_stage ();
+  ClutterColor red = { 0xff, 0x00, 0x00, 0xff };
+  ClutterColor blue = { 0x00, 0x00, 0xff, 0xff };
+  MtkRectangle rect = { .x = 5, .y = 5, .width = 10, .height = 10 };
+  g_autoptr (GAsyncResult) result = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  g_autoptr (GError) error = NULL;
+  ClutterActor *actor;
+  const uint8_t *pixels;
+  int stride;
+  int x, y;
+
+  clutter_actor_set_background_color (stage, &blue);
+
+  actor = clutter_actor_new ();
+  clutter_actor_set_background_color (actor, &red);
+  clutter_actor_set_position (actor, 10, 10);
+  clutter_actor_set_size (actor, 10, 10);
+  clutter_actor_add_child (stage, actor);
+
+  clutter_actor_show (stage);
+  wait_for_paint (stage);
+
+  result = capture_view (stage, &rect, NULL);
+  bytes = clutter_stage_capture_view_finish (CLUTTER_STAGE (stage), result,
+                                             &stride, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (bytes);
+  g_assert_cmpint (stride, ==, rect.width * 4);
+  g_assert_cmpuint (g_bytes_get_size (bytes), ==, stride * rect.height);
+
+  /* The actor covers the bottom right quarter of the captured area */
+  pixels = g_bytes_get_data (bytes, NULL);
+  for (y = 0; y < rect.height; y++)
+    {
+      for (x = 0; x < rect.width; x++)
+        {
+          const uint8_t *pixel = pixels + y * stride + x * 4;
+          const ClutterColor *expected;
+
+          if (x >= 5 && y >= 5)
+            expected = &red;
+          else
+            expected = &blue;
+
+          g_assert_cmpuint (pixel[0], ==, expected->red);
+          g_assert_cmpuint (pixel[1], ==, expected->green);
+          g_assert_cmpuint (pixel[2], ==, expected->blue);
+        }
+    }
+
+  clutter_actor_destroy (actor);
+}
+
+static void
+stage_capture_view_async_cancel (void)
+{
+  ClutterActor *stage = clutter_test_get_stage ();
+  g_autoptr (GCancellable) cancellable = NULL;
+  g_autoptr (GAsyncResult) result = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  g_autoptr (GError) error = NULL;
+
+  clutter_actor_show (stage);
+  wait_for_paint (stage);
+
+  cancellable = g_cancellable_new ();
+  result = capture_view (stage, NULL, cancellable);
+  bytes = clutter_stage_capture_view_finish (CLUTTER_STAGE (stage), result,
+                                             NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (bytes);
+}
+
+static void
+stage_paint_region_to_framebuffer (void)
+{
+  ClutterActor *stage = clutter_test_get_stage ();
+  ClutterBackend *backend = clutter_get_default_backend ();
+  CoglContext *context = clutter_backend_get_cogl_context (backend);
+  ClutterColor red = { 0xff, 0x00, 0x00, 0xff };
+  ClutterColor green = { 0x00, 0xff, 0x00, 0xff };
+  ClutterColor blue = { 0x00, 0x00, 0xff, 0xff };
+  MtkRectangle rect = { .x = 0, .y = 0, .width = 20, .height = 20 };
+  g_autoptr (CoglTexture) texture = NULL;
+  g_autoptr (CoglOffscreen) offscreen = NULL;
+  g_autoptr (MtkRegion) region = NULL;
+  g_autoptr (GError) error = NULL;
+  CoglFramebuffer *framebuffer;
+  CoglColor clear_color;
+  uint8_t pixels[20 * 20 * 4];
+  ClutterActor *actor;
+  int x, y;
+
+  clutter_actor_set_background_color (stage, &blue);
+
+  actor = clutter_actor_new ();
+  clutter_actor_set_background_color (actor, &red);
+  clutter_actor_set_position (actor, 10, 10);
+  clutter_actor_set_size (actor, 10, 10);
+  clutter_actor_add_child (stage, actor);
+
+  clutter_actor_show (stage);
+  wait_for_paint (stage);
+
+  texture = cogl_texture_2d_new_with_size (context, rect.width, rect.height);
+  offscreen = cogl_offscreen_new_with_texture (texture);
+  framebuffer = COGL_FRAMEBUFFER (offscreen);
+  cogl_framebuffer_allocate (framebuffer, &error);
+  g_assert_no_error (error);
+
+  cogl_color_init_from_4ub (&clear_color, 0x00, 0xff, 0x00, 0xff);
+  cogl_framebuffer_clear (framebuffer, COGL_BUFFER_BIT_COLOR, &clear_color);
+
+  /* Two separate rectangles, one of them partly covering the actor */
+  region = mtk_region_create_rectangle (&MTK_RECTANGLE_INIT (5, 5, 10, 10));
+  mtk_region_union_rectangle (region, &MTK_RECTANGLE_INIT (16, 0, 4, 4));
+
+  clutter_stage_paint_region_to_framebuffer (CLUTTER_STAGE (stage),
+                                             framebuffer,
+                                             &rect, 1.0f,
+                                             region,
+                                             CLUTTER_PAINT_FLAG_CLEAR);
+
+  cogl_framebuffer_read_pixels (framebuffer, 0, 0, rect.width, rect.height,
+                                COGL_PIXEL_FORMAT_RGBA_8888_PRE, pixels);
+
+  /* Pixels outside of the region keep the color of the earlier paint */
+  for (y = 0; y < rect.height; y++)
+    {
+      for (x = 0; x < rect.width; x++)
+        {
+          const uint8_t *pixel = pixels + (y * rect.width + x) * 4;
+          const ClutterColor *expected;
+
+          if (!mtk_region_contains_point (region, x, y))
+            expected = &green;
+          else if (x >= 10 && y >= 10)
+            expected = &red;
+          else
+            expected = &blue;
+
+          g_assert_cmpuint (pixel[0], ==, expected->red);
+          g_assert_cmpuint (pixel[1], ==, expected->green);
+          g_assert_cmpuint (pixel[2], ==, expected->blue);
+        }
+    }
+
+  clutter_actor_destroy (actor);
+}
+
+CLUTTER_TEST_SUITE (
+  CLUTTER_TEST_UNIT ("/stage/capture-view-async", stage_capture_view_async)
+  CLUTTER_TEST_UNIT ("/stage/capture-view-async-cancel", stage_capture_view_async_cancel)
+  CLUTTER_TEST_UNIT ("/stage/paint-region-to-framebuffer", stage_paint_region_to_framebuffer)
+)
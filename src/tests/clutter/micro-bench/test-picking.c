@@ -2,11 +2,18 @@
 #include <math.h>
 #include <stdlib.h>
 #include <clutter/clutter.h>
+#include <clutter/clutter-mutter.h>
 
 #include "tests/clutter-test-utils.h"
 
 #define N_ACTORS 100
 #define N_EVENTS 5
+#define N_DEVICES 10
+#define N_REPORT_FRAMES 100
+
+static int64_t single_picks_us;
+static int64_t batched_picks_us;
+static int n_frames;
 
 static gboolean
 motion_event_cb (ClutterActor *actor, ClutterEvent *event, gpointer user_data)
@@ -36,6 +43,78 @@ do_events (ClutterActor *stage)
     }
 }
 
+static void
+get_device_points (graphene_point_t points[N_DEVICES])
+{
+  static double angle = 0;
+  int i;
+
+  angle += (2.0 * G_PI) / (double) N_ACTORS;
+  while (angle > G_PI * 2.0)
+    angle -= G_PI * 2.0;
+
+  /* Spread the devices around the circle of actors, as with several
+   * touch points or pointers all active at the same time */
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      double device_angle = angle + (2.0 * G_PI * i) / N_DEVICES;
+
+      points[i] = GRAPHENE_POINT_INIT (256.0 + 206.0 * cos (device_angle),
+                                       256.0 + 206.0 * sin (device_angle));
+    }
+}
+
+static void
+do_device_updates (ClutterActor *stage)
+{
+  graphene_point_t points[N_DEVICES];
+  ClutterActor *single_actors[N_DEVICES];
+  ClutterActor *batched_actors[N_DEVICES];
+  int64_t start_us;
+  int i;
+
+  get_device_points (points);
+
+  /* Like re-picking every device after a stage update, one by one;
+   * each pick is done from scratch, as without a retained pick stack.
+   */
+  start_us = g_get_monotonic_time ();
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      clutter_stage_invalidate_pick (CLUTTER_STAGE (stage));
+      single_actors[i] =
+        clutter_stage_get_actor_at_pos (CLUTTER_STAGE (stage),
+                                        CLUTTER_PICK_REACTIVE,
+                                        points[i].x, points[i].y);
+    }
+  single_picks_us += g_get_monotonic_time () - start_us;
+
+  /* And all at once */
+  clutter_stage_invalidate_pick (CLUTTER_STAGE (stage));
+  start_us = g_get_monotonic_time ();
+  clutter_stage_get_actors_at_pos (CLUTTER_STAGE (stage),
+                                   CLUTTER_PICK_REACTIVE,
+                                   N_DEVICES, points,
+                                   batched_actors);
+  batched_picks_us += g_get_monotonic_time () - start_us;
+
+  for (i = 0; i < N_DEVICES; i++)
+    g_assert_true (single_actors[i] == batched_actors[i]);
+
+  if (++n_frames == N_REPORT_FRAMES)
+    {
+      printf ("%d devices: %.3f ms/frame picking one by one, "
+              "%.3f ms/frame batched\n",
+              N_DEVICES,
+              single_picks_us / 1000.0 / N_REPORT_FRAMES,
+              batched_picks_us / 1000.0 / N_REPORT_FRAMES);
+
+      single_picks_us = 0;
+      batched_picks_us = 0;
+      n_frames = 0;
+    }
+}
+
 static void
 on_after_paint (ClutterActor        *stage,
                 ClutterStageView    *view,
@@ -43,6 +122,7 @@ on_after_paint (ClutterActor        *stage,
                 gconstpointer       *data)
 {
   do_events (stage);
+  do_device_updates (stage);
 }
 
 static gboolean
@@ -73,9 +153,10 @@ main (int argc, char **argv)
   clutter_stage_set_title (CLUTTER_STAGE (stage), "Picking");
 
   printf ("Picking performance test with "
-          "%d actors and %d events per frame\n",
+          "%d actors, %d events and %d devices per frame\n",
           N_ACTORS,
-          N_EVENTS);
+          N_EVENTS,
+          N_DEVICES);
 
   for (i = N_ACTORS - 1; i >= 0; i--)
     {
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include <clutter/clutter.h>
+#include <clutter/clutter-mutter.h>
+
+#define FB_WIDTH 3840
+#define FB_HEIGHT 2160
+#define BPP 4
+#define TILE_SIZE 16
+#define N_ITERATIONS 50
+
+typedef enum _DamageType
+{
+  DAMAGE_TYPE_NONE,
+  DAMAGE_TYPE_CURSOR,
+  DAMAGE_TYPE_FULL,
+} DamageType;
+
+static const struct {
+  ClutterTileCompareImpl impl;
+  const char *name;
+} impls[] = {
+  { CLUTTER_TILE_COMPARE_IMPL_SCALAR, "scalar" },
+  { CLUTTER_TILE_COMPARE_IMPL_SSE2, "sse2" },
+  { CLUTTER_TILE_COMPARE_IMPL_AVX2, "avx2" },
+  { CLUTTER_TILE_COMPARE_IMPL_NEON, "neon" },
+};
+
+static const char *
+damage_type_to_string (DamageType damage_type)
+{
+  switch (damage_type)
+    {
+    case DAMAGE_TYPE_NONE:
+      return "unchanged";
+    case DAMAGE_TYPE_CURSOR:
+      return "cursor sized change";
+    case DAMAGE_TYPE_FULL:
+      return "fully changed";
+    }
+
+  g_assert_not_reached ();
+}
+
+static void
+prepare_buffers (uint8_t    *current_data,
+                 uint8_t    *prev_data,
+                 DamageType  damage_type)
+{
+  int stride = FB_WIDTH * BPP;
+  int y;
+
+  for (y = 0; y < FB_HEIGHT; y++)
+    memset (prev_data + y * stride, y & 0xff, stride);
+  memcpy (current_data, prev_data, (size_t) stride * FB_HEIGHT);
+
+  switch (damage_type)
+    {
+    case DAMAGE_TYPE_NONE:
+      break;
+    case DAMAGE_TYPE_CURSOR:
+      for (y = FB_HEIGHT / 2; y < FB_HEIGHT / 2 + 64; y++)
+        memset (current_data + y * stride + (FB_WIDTH / 2) * BPP, 0xff,
+                64 * BPP);
+      break;
+    case DAMAGE_TYPE_FULL:
+      for (y = 0; y < FB_HEIGHT; y++)
+        memset (current_data + y * stride, ~y & 0xff, stride);
+      break;
+    }
+}
+
+static int
+scan_framebuffer (const uint8_t *current_data,
+                  const uint8_t *prev_data)
+{
+  MtkRectangle tiles[FB_WIDTH / TILE_SIZE];
+  gboolean dirty[FB_WIDTH / TILE_SIZE];
+  int n_dirty = 0;
+  int tile_x, tile_y;
+
+  for (tile_y = 0; tile_y < FB_HEIGHT / TILE_SIZE; tile_y++)
+    {
+      for (tile_x = 0; tile_x < FB_WIDTH / TILE_SIZE; tile_x++)
+        {
+          tiles[tile_x] = (MtkRectangle) {
+            .x = tile_x * TILE_SIZE,
+            .y = tile_y * TILE_SIZE,
+            .width = TILE_SIZE,
+            .height = TILE_SIZE,
+          };
+        }
+
+      clutter_tile_compare_find_dirty (current_data, prev_data,
+                                       FB_WIDTH * BPP, BPP,
+                                       tiles, G_N_ELEMENTS (tiles),
+                                       dirty);
+
+      for (tile_x = 0; tile_x < FB_WIDTH / TILE_SIZE; tile_x++)
+        {
+          if (dirty[tile_x])
+            n_dirty++;
+        }
+    }
+
+  return n_dirty;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autofree uint8_t *current_data = NULL;
+  g_autofree uint8_t *prev_data = NULL;
+  DamageType damage_type;
+  int i;
+
+  current_data = g_malloc ((size_t) FB_WIDTH * FB_HEIGHT * BPP);
+  prev_data = g_malloc ((size_t) FB_WIDTH * FB_HEIGHT * BPP);
+
+  printf ("Shadow framebuffer damage detection on a %dx%d framebuffer, "
+          "%d iterations\n",
+          FB_WIDTH, FB_HEIGHT, N_ITERATIONS);
+
+  for (damage_type = DAMAGE_TYPE_NONE;
+       damage_type <= DAMAGE_TYPE_FULL;
+       damage_type++)
+    {
+      prepare_buffers (current_data, prev_data, damage_type);
+
+      for (i = 0; i < G_N_ELEMENTS (impls); i++)
+        {
+          int64_t start_us;
+          int64_t elapsed_us;
+          int n_dirty = 0;
+          int j;
+
+          if (!clutter_tile_compare_set_impl (impls[i].impl))
+            continue;
+
+          start_us = g_get_monotonic_time ();
+          for (j = 0; j < N_ITERATIONS; j++)
+            n_dirty = scan_framebuffer (current_data, prev_data);
+          elapsed_us = g_get_monotonic_time () - start_us;
+
+          printf ("%-20s %-8s %8.3f ms/frame (%d dirty tiles)\n",
+                  damage_type_to_string (damage_type),
+                  impls[i].name,
+                  elapsed_us / 1000.0 / N_ITERATIONS,
+                  n_dirty);
+        }
+    }
+
+  clutter_tile_compare_set_impl (CLUTTER_TILE_COMPARE_IMPL_AUTO);
+
+  return EXIT_SUCCESS;
+}
@@ -44,6 +44,145 @@ test_journal_unref_flush (void)
   g_object_unref (texture);
 }
 
+static void
+setup_orthographic_modelview (void)
+{
+  graphene_matrix_t matrix;
+  int fb_width = cogl_framebuffer_get_width (test_fb);
+  int fb_height = cogl_framebuffer_get_height (test_fb);
+
+  graphene_matrix_init_ortho (&matrix,
+                              0.f, fb_width,
+                              fb_height, 0.f,
+                              -1.f, 1.f);
+  cogl_framebuffer_set_modelview_matrix (test_fb, &matrix);
+}
+
+static CoglPipeline *
+create_textured_pipeline (uint32_t color)
+{
+  CoglPipeline *pipeline;
+  CoglTexture *texture;
+
+  texture = test_utils_create_color_texture (test_ctx, color);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+  g_object_unref (texture);
+
+  return pipeline;
+}
+
+static void
+test_journal_reorder_interleaved (void)
+{
+  CoglPipeline *plain_pipeline;
+  CoglPipeline *textured_pipeline;
+  int i;
+
+  setup_orthographic_modelview ();
+
+  plain_pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (plain_pipeline, 0xff, 0x00, 0x00, 0xff);
+  textured_pipeline = create_textured_pipeline (0x00ff00ff);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* Alternating pipelines next to each other, like icons and labels,
+   * can all be reordered into two batches */
+  for (i = 0; i < 8; i++)
+    {
+      cogl_framebuffer_draw_rectangle (test_fb,
+                                       i % 2 ? textured_pipeline : plain_pipeline,
+                                       i * 20, 0,
+                                       i * 20 + 20, 20);
+    }
+
+  for (i = 0; i < 8; i++)
+    {
+      test_utils_check_region (test_fb,
+                               i * 20 + 2, 2,
+                               16, 16,
+                               i % 2 ? 0x00ff00ff : 0xff0000ff);
+    }
+
+  g_object_unref (textured_pipeline);
+  g_object_unref (plain_pipeline);
+}
+
+static void
+test_journal_reorder_overlapping (void)
+{
+  CoglPipeline *plain_pipeline;
+  CoglPipeline *textured_pipeline;
+
+  setup_orthographic_modelview ();
+
+  plain_pipeline = cogl_pipeline_new (test_ctx);
+  textured_pipeline = create_textured_pipeline (0x00ff00ff);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* The last rectangle could be batched with the first one, but it
+   * overlaps the one in between, so it must still be drawn last */
+  cogl_pipeline_set_color4ub (plain_pipeline, 0xff, 0x00, 0x00, 0xff);
+  cogl_framebuffer_draw_rectangle (test_fb, plain_pipeline, 0, 0, 100, 100);
+  cogl_framebuffer_draw_rectangle (test_fb, textured_pipeline, 20, 20, 80, 80);
+  cogl_pipeline_set_color4ub (plain_pipeline, 0x00, 0x00, 0xff, 0xff);
+  cogl_framebuffer_draw_rectangle (test_fb, plain_pipeline, 40, 40, 60, 60);
+
+  /* Not overlapping anything but the first rectangle, so it may be moved
+   * into the first batch */
+  cogl_framebuffer_draw_rectangle (test_fb, plain_pipeline, 100, 0, 120, 20);
+
+  test_utils_check_region (test_fb, 2, 2, 16, 16, 0xff0000ff);
+  test_utils_check_region (test_fb, 22, 22, 16, 16, 0x00ff00ff);
+  test_utils_check_region (test_fb, 42, 42, 16, 16, 0x0000ffff);
+  test_utils_check_region (test_fb, 102, 2, 16, 16, 0x0000ffff);
+
+  g_object_unref (textured_pipeline);
+  g_object_unref (plain_pipeline);
+}
+
+static void
+test_journal_large_flushes (void)
+{
+  CoglPipeline *pipeline;
+  int round;
+
+  setup_orthographic_modelview ();
+
+  pipeline = cogl_pipeline_new (test_ctx);
+
+  /* Enough vertices per flush to outgrow the vertex stream buffer, and
+   * enough flushes to wrap around it, with each flush checked */
+  for (round = 0; round < 12; round++)
+    {
+      int n_rectangles = 1000 << (round % 6);
+      uint8_t value = 0x20 + round * 0x10;
+      int i;
+
+      for (i = 0; i < n_rectangles; i++)
+        {
+          uint8_t red = i == n_rectangles - 1 ? value : 0x00;
+
+          cogl_pipeline_set_color4ub (pipeline, red, 0x00, value, 0xff);
+          cogl_framebuffer_draw_rectangle (test_fb, pipeline,
+                                           i % 8, i % 8,
+                                           32 - i % 8, 32 - i % 8);
+        }
+
+      test_utils_check_region (test_fb, 8, 8, 16, 16,
+                               (value << 24) | (value << 8) | 0xff);
+    }
+
+  g_object_unref (pipeline);
+}
+
 COGL_TEST_SUITE (
   g_test_add_func ("/journal/unref-flush", test_journal_unref_flush);
+  g_test_add_func ("/journal/reorder/interleaved",
+                   test_journal_reorder_interleaved);
+  g_test_add_func ("/journal/reorder/overlapping",
+                   test_journal_reorder_overlapping);
+  g_test_add_func ("/journal/large-flushes", test_journal_large_flushes);
 )
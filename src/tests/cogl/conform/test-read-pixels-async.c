@@ -0,0 +1,112 @@
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "tests/cogl-test-utils.h"
+
+static GMainLoop *loop;
+
+static gboolean
+timeout (void *user_data)
+{
+  g_assert (!"timeout not reached");
+
+  return FALSE;
+}
+
+static void
+read_pixels_cb (CoglFramebuffer *framebuffer,
+                gboolean         success,
+                void            *user_data)
+{
+  gboolean *done = user_data;
+
+  g_assert_true (framebuffer == test_fb);
+  g_assert_true (success);
+
+  *done = TRUE;
+  g_main_loop_quit (loop);
+}
+
+static void
+not_reached_cb (CoglFramebuffer *framebuffer,
+                gboolean         success,
+                void            *user_data)
+{
+  g_assert_not_reached ();
+}
+
+static void
+test_read_pixels_async (void)
+{
+  GSource *cogl_source;
+  int fb_width = cogl_framebuffer_get_width (test_fb);
+  int fb_height = cogl_framebuffer_get_height (test_fb);
+  CoglPipeline *pipeline;
+  CoglReadPixelsClosure *closure;
+  uint8_t expected[16 * 16 * 4];
+  uint8_t pixels[16 * 16 * 4];
+  uint8_t cancelled_pixels[16 * 16 * 4];
+  gboolean done = FALSE;
+  GError *error = NULL;
+
+  if (!cogl_has_feature (test_ctx, COGL_FEATURE_ID_FENCE) ||
+      !cogl_has_feature (test_ctx, COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT))
+    {
+      g_test_skip ("Missing fence or pixel buffer support");
+      return;
+    }
+
+  cogl_source = cogl_glib_source_new (test_ctx, G_PRIORITY_DEFAULT);
+  g_source_attach (cogl_source, NULL);
+  loop = g_main_loop_new (NULL, TRUE);
+
+  cogl_framebuffer_orthographic (test_fb, 0, 0, fb_width, fb_height, -1, 100);
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR,
+                            0.0f, 0.0f, 1.0f, 1.0f);
+
+  /* Red top half and a green square, so that flipped or shifted reads
+   * are caught */
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 0xff, 0x00, 0x00, 0xff);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline, 0, 0, fb_width, 8);
+  cogl_pipeline_set_color4ub (pipeline, 0x00, 0xff, 0x00, 0xff);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline, 4, 2, 6, 12);
+  g_object_unref (pipeline);
+
+  cogl_framebuffer_read_pixels (test_fb, 2, 0, 16, 16,
+                                COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                expected);
+
+  closure = cogl_framebuffer_read_pixels_async (test_fb, 2, 0, 16, 16,
+                                                COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                pixels, 16 * 4,
+                                                read_pixels_cb, &done,
+                                                &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (closure);
+
+  /* A cancelled read back must neither call back nor write anything */
+  memset (cancelled_pixels, 0x55, sizeof (cancelled_pixels));
+  closure = cogl_framebuffer_read_pixels_async (test_fb, 2, 0, 16, 16,
+                                                COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                cancelled_pixels, 16 * 4,
+                                                not_reached_cb, NULL,
+                                                &error);
+  g_assert_no_error (error);
+  cogl_framebuffer_cancel_read_pixels (test_fb, closure);
+
+  g_timeout_add_seconds (5, timeout, NULL);
+
+  g_main_loop_run (loop);
+
+  g_assert_true (done);
+  g_assert_cmpmem (pixels, sizeof (pixels), expected, sizeof (expected));
+  g_assert_cmpuint (cancelled_pixels[0], ==, 0x55);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/read-pixels-async", test_read_pixels_async);
+)
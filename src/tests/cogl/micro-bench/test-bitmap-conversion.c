@@ -0,0 +1,139 @@
+#include "cogl-config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cogl/cogl-bitmap-simd-private.h"
+
+#define IMAGE_WIDTH 3840
+#define IMAGE_HEIGHT 2160
+#define N_ITERATIONS 20
+
+static const struct {
+  CoglBitmapSimdImpl impl;
+  const char *name;
+} impls[] = {
+  { COGL_BITMAP_SIMD_IMPL_SCALAR, "scalar" },
+  { COGL_BITMAP_SIMD_IMPL_SSE41, "sse4.1" },
+  { COGL_BITMAP_SIMD_IMPL_AVX2, "avx2" },
+  { COGL_BITMAP_SIMD_IMPL_NEON, "neon" },
+};
+
+static const struct {
+  CoglPixelFormat src_format;
+  CoglPixelFormat dst_format;
+  int src_bpp;
+  int dst_bpp;
+  const char *name;
+} conversions[] = {
+  {
+    COGL_PIXEL_FORMAT_BGRA_8888, COGL_PIXEL_FORMAT_RGBA_8888, 4, 4,
+    "BGRA to RGBA",
+  },
+  {
+    COGL_PIXEL_FORMAT_ARGB_8888, COGL_PIXEL_FORMAT_BGRA_8888_PRE, 4, 4,
+    "ARGB to BGRA premult",
+  },
+  {
+    COGL_PIXEL_FORMAT_RGBA_8888, COGL_PIXEL_FORMAT_XRGB_2101010, 4, 4,
+    "RGBA to XRGB2101010",
+  },
+  {
+    COGL_PIXEL_FORMAT_XBGR_2101010, COGL_PIXEL_FORMAT_BGRA_8888, 4, 4,
+    "XBGR2101010 to BGRA",
+  },
+  {
+    COGL_PIXEL_FORMAT_BGRA_8888, COGL_PIXEL_FORMAT_RGBA_FP_16161616, 4, 8,
+    "BGRA to RGBA FP16",
+  },
+  {
+    COGL_PIXEL_FORMAT_RGBA_FP_16161616, COGL_PIXEL_FORMAT_BGRA_8888, 8, 4,
+    "RGBA FP16 to BGRA",
+  },
+};
+
+static void
+convert_image (const CoglBitmapFastConversion *conversion,
+               const uint8_t                  *src_data,
+               int                             src_stride,
+               uint8_t                        *dst_data,
+               int                             dst_stride)
+{
+  int y;
+
+  for (y = 0; y < IMAGE_HEIGHT; y++)
+    {
+      _cogl_bitmap_fast_conversion_run (conversion,
+                                        src_data + y * src_stride,
+                                        dst_data + y * dst_stride,
+                                        IMAGE_WIDTH);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autofree uint8_t *src_data = NULL;
+  g_autofree uint8_t *dst_data = NULL;
+  size_t size;
+  size_t i;
+
+  /* Large enough for half float formats on either side */
+  size = (size_t) IMAGE_WIDTH * IMAGE_HEIGHT * 8;
+  src_data = g_malloc (size);
+  dst_data = g_malloc (size);
+
+  /* Half floats between 0.0 and 1.0 when read as such */
+  for (i = 0; i < size; i++)
+    src_data[i] = (i & 1) ? (i >> 1) % 0x3c : (i >> 1) & 0xff;
+
+  printf ("Bitmap format conversion of a %dx%d image, %d iterations\n",
+          IMAGE_WIDTH, IMAGE_HEIGHT, N_ITERATIONS);
+
+  for (i = 0; i < G_N_ELEMENTS (conversions); i++)
+    {
+      CoglBitmapFastConversion conversion;
+      int src_stride;
+      int dst_stride;
+      int j;
+
+      if (!_cogl_bitmap_fast_conversion_init (&conversion,
+                                              conversions[i].src_format,
+                                              conversions[i].dst_format))
+        g_assert_not_reached ();
+
+      src_stride = IMAGE_WIDTH * conversions[i].src_bpp;
+      dst_stride = IMAGE_WIDTH * conversions[i].dst_bpp;
+
+      for (j = 0; j < G_N_ELEMENTS (impls); j++)
+        {
+          int64_t start_us;
+          int64_t elapsed_us;
+          int k;
+
+          if (!_cogl_bitmap_simd_set_impl (impls[j].impl))
+            continue;
+
+          start_us = g_get_monotonic_time ();
+          for (k = 0; k < N_ITERATIONS; k++)
+            {
+              convert_image (&conversion,
+                             src_data, src_stride,
+                             dst_data, dst_stride);
+            }
+          elapsed_us = g_get_monotonic_time () - start_us;
+
+          printf ("%-24s %-8s %8.3f ms/image (%.0f Mpixels/s)\n",
+                  conversions[i].name,
+                  impls[j].name,
+                  elapsed_us / 1000.0 / N_ITERATIONS,
+                  (double) IMAGE_WIDTH * IMAGE_HEIGHT * N_ITERATIONS /
+                  elapsed_us);
+        }
+    }
+
+  _cogl_bitmap_simd_set_impl (COGL_BITMAP_SIMD_IMPL_AUTO);
+
+  return EXIT_SUCCESS;
+}
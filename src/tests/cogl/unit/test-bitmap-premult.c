@@ -0,0 +1,80 @@
+#include "cogl-config.h"
+
+#include "cogl/cogl-bitmap-private.h"
+#include "tests/cogl-test-utils.h"
+
+#define WIDTH 8
+
+static uint32_t
+pack_rgba_1010102 (unsigned int red,
+                   unsigned int green,
+                   unsigned int blue,
+                   unsigned int alpha)
+{
+  return red << 22 | green << 12 | blue << 2 | alpha;
+}
+
+/* 10-bit formats are (un)premultiplied through 16-bit components, one
+ * row at a time. Each pixel of a row must be handled exactly once.
+ */
+static void
+test_premult_16 (void)
+{
+  uint32_t data[WIDTH];
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  g_autoptr (GError) error = NULL;
+  int i;
+
+  for (i = 0; i < WIDTH; i++)
+    data[i] = pack_rgba_1010102 (1023, 512, 0, 1);
+
+  bitmap = cogl_bitmap_new_for_data (test_ctx,
+                                     WIDTH, 1,
+                                     COGL_PIXEL_FORMAT_RGBA_1010102,
+                                     sizeof (data),
+                                     (uint8_t *) data);
+
+  g_assert_true (_cogl_bitmap_premult (bitmap, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (cogl_bitmap_get_format (bitmap),
+                   ==,
+                   COGL_PIXEL_FORMAT_RGBA_1010102_PRE);
+
+  g_assert_cmpuint (data[0] >> 22, <, 1023);
+  g_assert_cmpuint (data[0] >> 22, >, 0);
+  for (i = 1; i < WIDTH; i++)
+    g_assert_cmphex (data[i], ==, data[0]);
+}
+
+static void
+test_unpremult_16 (void)
+{
+  uint32_t data[WIDTH];
+  g_autoptr (CoglBitmap) bitmap = NULL;
+  g_autoptr (GError) error = NULL;
+  int i;
+
+  for (i = 0; i < WIDTH; i++)
+    data[i] = pack_rgba_1010102 (341, 170, 0, 1);
+
+  bitmap = cogl_bitmap_new_for_data (test_ctx,
+                                     WIDTH, 1,
+                                     COGL_PIXEL_FORMAT_RGBA_1010102_PRE,
+                                     sizeof (data),
+                                     (uint8_t *) data);
+
+  g_assert_true (_cogl_bitmap_unpremult (bitmap, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (cogl_bitmap_get_format (bitmap),
+                   ==,
+                   COGL_PIXEL_FORMAT_RGBA_1010102);
+
+  g_assert_cmpuint (data[0] >> 22, >, 341);
+  for (i = 1; i < WIDTH; i++)
+    g_assert_cmphex (data[i], ==, data[0]);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/bitmap-premult/16-bit/premult", test_premult_16);
+  g_test_add_func ("/bitmap-premult/16-bit/unpremult", test_unpremult_16);
+)
@@ -0,0 +1,279 @@
+#include "cogl-config.h"
+
+#include "cogl/cogl-bitmap-simd-private.h"
+#include "tests/cogl-test-utils.h"
+
+/* Not a multiple of any vector width, to also cover the tails */
+#define WIDTH 1031
+
+static const CoglBitmapSimdImpl simd_impls[] = {
+  COGL_BITMAP_SIMD_IMPL_SSE41,
+  COGL_BITMAP_SIMD_IMPL_AVX2,
+  COGL_BITMAP_SIMD_IMPL_NEON,
+};
+
+static const CoglPixelFormat formats_8888[] = {
+  COGL_PIXEL_FORMAT_RGBX_8888,
+  COGL_PIXEL_FORMAT_RGBA_8888,
+  COGL_PIXEL_FORMAT_BGRX_8888,
+  COGL_PIXEL_FORMAT_BGRA_8888,
+  COGL_PIXEL_FORMAT_XRGB_8888,
+  COGL_PIXEL_FORMAT_ARGB_8888,
+  COGL_PIXEL_FORMAT_XBGR_8888,
+  COGL_PIXEL_FORMAT_ABGR_8888,
+  COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+  COGL_PIXEL_FORMAT_BGRA_8888_PRE,
+  COGL_PIXEL_FORMAT_ARGB_8888_PRE,
+  COGL_PIXEL_FORMAT_ABGR_8888_PRE,
+};
+
+static const CoglPixelFormat formats_2101010[] = {
+  COGL_PIXEL_FORMAT_RGBA_1010102,
+  COGL_PIXEL_FORMAT_BGRA_1010102,
+  COGL_PIXEL_FORMAT_XRGB_2101010,
+  COGL_PIXEL_FORMAT_ARGB_2101010,
+  COGL_PIXEL_FORMAT_XBGR_2101010,
+  COGL_PIXEL_FORMAT_ABGR_2101010,
+};
+
+static const CoglPixelFormat formats_fp16[] = {
+  COGL_PIXEL_FORMAT_RGBX_FP_16161616,
+  COGL_PIXEL_FORMAT_RGBA_FP_16161616,
+  COGL_PIXEL_FORMAT_BGRX_FP_16161616,
+  COGL_PIXEL_FORMAT_BGRA_FP_16161616,
+  COGL_PIXEL_FORMAT_XRGB_FP_16161616,
+  COGL_PIXEL_FORMAT_ARGB_FP_16161616,
+  COGL_PIXEL_FORMAT_XBGR_FP_16161616,
+  COGL_PIXEL_FORMAT_ABGR_FP_16161616,
+};
+
+static void
+fill_random (uint8_t *data,
+             size_t   size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+}
+
+/* Half floats covering the whole [0, 1] range as well as values
+ * outside of it, infinities and NaN.
+ */
+static void
+fill_random_halves (uint16_t *data,
+                    int       n_components)
+{
+  static const uint16_t special_values[] = {
+    0x0000, 0x8000, 0x3c00, 0xbc00, 0x4000, 0x7c00, 0xfc00, 0x7e00, 0x0001,
+  };
+  int i;
+
+  for (i = 0; i < n_components; i++)
+    {
+      if (g_test_rand_int_range (0, 16) == 0)
+        {
+          int j = g_test_rand_int_range (0, G_N_ELEMENTS (special_values));
+
+          data[i] = special_values[j];
+        }
+      else
+        {
+          /* Non-negative values up to just above 1.0 */
+          data[i] = g_test_rand_int_range (0, 0x3c40);
+        }
+    }
+}
+
+static void
+compare_impls (CoglPixelFormat  src_format,
+               CoglPixelFormat  dst_format,
+               const uint8_t   *src,
+               size_t           dst_size)
+{
+  CoglBitmapFastConversion conversion;
+  g_autofree uint8_t *expected = NULL;
+  g_autofree uint8_t *result = NULL;
+  int i;
+
+  if (!_cogl_bitmap_fast_conversion_init (&conversion, src_format, dst_format))
+    return;
+
+  expected = g_malloc (dst_size);
+  result = g_malloc (dst_size);
+
+  g_assert_true (_cogl_bitmap_simd_set_impl (COGL_BITMAP_SIMD_IMPL_SCALAR));
+  _cogl_bitmap_fast_conversion_run (&conversion, src, expected, WIDTH);
+
+  for (i = 0; i < G_N_ELEMENTS (simd_impls); i++)
+    {
+      if (!_cogl_bitmap_simd_set_impl (simd_impls[i]))
+        continue;
+
+      g_test_message ("Converting 0x%x to 0x%x with %s",
+                      src_format, dst_format,
+                      _cogl_bitmap_simd_get_impl_name ());
+
+      memset (result, 0, dst_size);
+      _cogl_bitmap_fast_conversion_run (&conversion, src, result, WIDTH);
+      g_assert_cmpmem (result, dst_size, expected, dst_size);
+    }
+
+  _cogl_bitmap_simd_set_impl (COGL_BITMAP_SIMD_IMPL_AUTO);
+}
+
+static void
+test_swizzle (void)
+{
+  uint8_t src[WIDTH * 4];
+  CoglBitmapFastConversion conversion;
+  uint8_t pixel[4] = { 0x10, 0x20, 0x30, 0x80 };
+  uint8_t result[4];
+  int i, j;
+
+  fill_random (src, sizeof (src));
+
+  for (i = 0; i < G_N_ELEMENTS (formats_8888); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (formats_8888); j++)
+        compare_impls (formats_8888[i], formats_8888[j], src, sizeof (src));
+    }
+
+  /* RGBA to premultiplied ARGB */
+  g_assert_true (_cogl_bitmap_fast_conversion_init (&conversion,
+                                                    COGL_PIXEL_FORMAT_RGBA_8888,
+                                                    COGL_PIXEL_FORMAT_ARGB_8888_PRE));
+  _cogl_bitmap_fast_conversion_run (&conversion, pixel, result, 1);
+  g_assert_cmpuint (result[0], ==, 0x80);
+  g_assert_cmpuint (result[1], ==, 0x08);
+  g_assert_cmpuint (result[2], ==, 0x10);
+  g_assert_cmpuint (result[3], ==, 0x18);
+
+  /* Padding is opaque */
+  g_assert_true (_cogl_bitmap_fast_conversion_init (&conversion,
+                                                    COGL_PIXEL_FORMAT_BGRA_8888,
+                                                    COGL_PIXEL_FORMAT_XRGB_8888));
+  _cogl_bitmap_fast_conversion_run (&conversion, pixel, result, 1);
+  g_assert_cmpuint (result[0], ==, 0xff);
+  g_assert_cmpuint (result[1], ==, 0x30);
+  g_assert_cmpuint (result[2], ==, 0x20);
+  g_assert_cmpuint (result[3], ==, 0x10);
+
+  /* Unpremultiplying is left to the generic code */
+  g_assert_false (_cogl_bitmap_fast_conversion_init (&conversion,
+                                                     COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                     COGL_PIXEL_FORMAT_RGBA_8888));
+}
+
+static void
+test_premult (void)
+{
+  uint8_t src[WIDTH * 4];
+  uint8_t expected[WIDTH * 4];
+  uint8_t result[WIDTH * 4];
+  int alpha_offset;
+  int i;
+
+  fill_random (src, sizeof (src));
+
+  for (alpha_offset = 0; alpha_offset < 4; alpha_offset += 3)
+    {
+      memcpy (expected, src, sizeof (src));
+      g_assert_true (_cogl_bitmap_simd_set_impl (COGL_BITMAP_SIMD_IMPL_SCALAR));
+      _cogl_bitmap_premult_span_8888 (expected, WIDTH, alpha_offset);
+
+      for (i = 0; i < G_N_ELEMENTS (simd_impls); i++)
+        {
+          if (!_cogl_bitmap_simd_set_impl (simd_impls[i]))
+            continue;
+
+          memcpy (result, src, sizeof (src));
+          _cogl_bitmap_premult_span_8888 (result, WIDTH, alpha_offset);
+          g_assert_cmpmem (result, sizeof (result), expected, sizeof (expected));
+        }
+    }
+
+  _cogl_bitmap_simd_set_impl (COGL_BITMAP_SIMD_IMPL_AUTO);
+}
+
+static void
+test_2101010 (void)
+{
+  uint8_t src[WIDTH * 4];
+  CoglBitmapFastConversion conversion;
+  uint8_t pixel[4] = { 0xff, 0x80, 0x00, 0xff };
+  uint32_t packed;
+  int i, j;
+
+  fill_random (src, sizeof (src));
+
+  for (i = 0; i < G_N_ELEMENTS (formats_8888); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (formats_2101010); j++)
+        {
+          compare_impls (formats_8888[i], formats_2101010[j],
+                         src, sizeof (src));
+          compare_impls (formats_2101010[j], formats_8888[i],
+                         src, sizeof (src));
+        }
+    }
+
+  g_assert_true (_cogl_bitmap_fast_conversion_init (&conversion,
+                                                    COGL_PIXEL_FORMAT_RGBA_8888,
+                                                    COGL_PIXEL_FORMAT_XRGB_2101010));
+  _cogl_bitmap_fast_conversion_run (&conversion, pixel, (uint8_t *) &packed, 1);
+  g_assert_cmpuint (packed, ==, (0x3u << 30) | (0x3ffu << 20) | (0x202u << 10));
+}
+
+static void
+test_fp16 (void)
+{
+  uint8_t src_8888[WIDTH * 4];
+  uint16_t src_fp16[WIDTH * 4];
+  CoglBitmapFastConversion conversion;
+  uint8_t pixel[4] = { 0x00, 0x80, 0xff, 0x33 };
+  uint16_t halves[4] = { 0x3800, 0x3c00, 0x7e00, 0xbc00 };
+  uint16_t packed[4];
+  uint8_t unpacked[4];
+  int i, j;
+
+  fill_random (src_8888, sizeof (src_8888));
+  fill_random_halves (src_fp16, G_N_ELEMENTS (src_fp16));
+
+  for (i = 0; i < G_N_ELEMENTS (formats_8888); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (formats_fp16); j++)
+        {
+          compare_impls (formats_8888[i], formats_fp16[j],
+                         src_8888, sizeof (src_fp16));
+          compare_impls (formats_fp16[j], formats_8888[i],
+                         (const uint8_t *) src_fp16, sizeof (src_8888));
+        }
+    }
+
+  g_assert_true (_cogl_bitmap_fast_conversion_init (&conversion,
+                                                    COGL_PIXEL_FORMAT_RGBA_8888,
+                                                    COGL_PIXEL_FORMAT_RGBA_FP_16161616));
+  _cogl_bitmap_fast_conversion_run (&conversion, pixel, (uint8_t *) packed, 1);
+  g_assert_cmpuint (packed[0], ==, 0x0000);
+  g_assert_cmpuint (packed[1], ==, 0x3804);
+  g_assert_cmpuint (packed[2], ==, 0x3c00);
+  g_assert_cmpuint (packed[3], ==, 0x3266);
+
+  /* 0.5, 1.0, NaN and -1.0 */
+  g_assert_true (_cogl_bitmap_fast_conversion_init (&conversion,
+                                                    COGL_PIXEL_FORMAT_RGBA_FP_16161616,
+                                                    COGL_PIXEL_FORMAT_RGBA_8888));
+  _cogl_bitmap_fast_conversion_run (&conversion, (uint8_t *) halves, unpacked, 1);
+  g_assert_cmpuint (unpacked[0], ==, 0x80);
+  g_assert_cmpuint (unpacked[1], ==, 0xff);
+  g_assert_cmpuint (unpacked[2], ==, 0x00);
+  g_assert_cmpuint (unpacked[3], ==, 0x00);
+}
+
+COGL_TEST_SUITE_MINIMAL (
+  g_test_add_func ("/bitmap-simd/swizzle", test_swizzle);
+  g_test_add_func ("/bitmap-simd/premult", test_premult);
+  g_test_add_func ("/bitmap-simd/2101010", test_2101010);
+  g_test_add_func ("/bitmap-simd/fp16", test_fp16);
+)
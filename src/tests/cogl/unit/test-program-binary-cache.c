@@ -0,0 +1,243 @@
+#include "cogl-config.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "cogl/cogl.h"
+#include "cogl/cogl-context-private.h"
+#include "cogl/cogl-private.h"
+#include "cogl/driver/gl/cogl-pipeline-fragend-glsl-private.h"
+#include "cogl/driver/gl/cogl-pipeline-vertend-glsl-private.h"
+#include "cogl/driver/gl/cogl-program-binary-cache-private.h"
+#include "tests/cogl-test-utils.h"
+
+/* The tests run with XDG_CACHE_HOME pointing into the build directory */
+static char *
+get_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "mutter",
+                           "program-binaries",
+                           NULL);
+}
+
+static void
+clear_cache (void)
+{
+  g_autofree char *cache_path = get_cache_path ();
+  g_autoptr (GDir) dir = NULL;
+  const char *name;
+
+  dir = g_dir_open (cache_path, 0, NULL);
+  if (!dir)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      g_autofree char *path = NULL;
+
+      path = g_build_filename (cache_path, name, NULL);
+      g_unlink (path);
+    }
+}
+
+static CoglPipeline *
+create_pipeline (void)
+{
+  CoglPipeline *pipeline;
+  CoglSnippet *snippet;
+
+  snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_FRAGMENT,
+                              NULL,
+                              "  cogl_color_out = vec4 (0.0, 1.0, 0.0, 1.0);\n");
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_add_snippet (pipeline, snippet);
+  g_object_unref (snippet);
+
+  /* Drawing compiles the shaders of the pipeline */
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline, -1, -1, 1, 1);
+  cogl_framebuffer_finish (test_fb);
+
+  return pipeline;
+}
+
+/*
+ * Links a new program with the shaders of @pipeline the way the GLSL
+ * progend does, returning whether the program was loaded from @cache
+ * rather than compiled.
+ */
+static gboolean
+link_program (CoglProgramBinaryCache  *cache,
+              CoglPipeline            *pipeline,
+              char                   **key_out)
+{
+  g_autofree char *key = NULL;
+  GLint link_status = GL_FALSE;
+  gboolean loaded;
+  GLuint program;
+
+  program = test_ctx->glCreateProgram ();
+  test_ctx->glAttachShader (program,
+                            _cogl_pipeline_fragend_glsl_get_shader (pipeline));
+  test_ctx->glAttachShader (program,
+                            _cogl_pipeline_vertend_glsl_get_shader (pipeline));
+  test_ctx->glBindAttribLocation (program, 0, "cogl_position_in");
+
+  loaded = _cogl_program_binary_cache_load (cache, program, &key);
+  if (!loaded)
+    {
+      g_assert_nonnull (key);
+
+      test_ctx->glLinkProgram (program);
+      _cogl_program_binary_cache_save (cache, program, key);
+    }
+  else
+    {
+      g_assert_null (key);
+    }
+
+  test_ctx->glGetProgramiv (program, GL_LINK_STATUS, &link_status);
+  g_assert_true (link_status);
+
+  test_ctx->glDeleteProgram (program);
+
+  if (key_out)
+    *key_out = g_steal_pointer (&key);
+
+  return loaded;
+}
+
+static char *
+store_program (CoglProgramBinaryCache *cache,
+               CoglPipeline           *pipeline)
+{
+  g_autofree char *cache_path = get_cache_path ();
+  g_autofree char *key = NULL;
+  char *path;
+
+  g_assert_false (link_program (cache, pipeline, &key));
+
+  path = g_build_filename (cache_path, key, NULL);
+  g_assert_true (g_file_test (path, G_FILE_TEST_IS_REGULAR));
+
+  return path;
+}
+
+static gboolean
+check_program_binary_support (void)
+{
+  if (!_cogl_has_private_feature (test_ctx,
+                                  COGL_PRIVATE_FEATURE_PROGRAM_BINARY))
+    {
+      g_test_skip ("Program binaries not supported");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+test_program_binary_cache_reuse (void)
+{
+  CoglProgramBinaryCache *cache;
+  CoglPipeline *pipeline;
+  g_autofree char *path = NULL;
+
+  if (!check_program_binary_support ())
+    return;
+
+  clear_cache ();
+  pipeline = create_pipeline ();
+
+  cache = _cogl_program_binary_cache_new (test_ctx);
+  g_assert_nonnull (cache);
+
+  /* The first link compiles the program and stores its binary */
+  path = store_program (cache, pipeline);
+
+  /* Linking it again loads the stored binary */
+  g_assert_true (link_program (cache, pipeline, NULL));
+  _cogl_program_binary_cache_free (cache);
+
+  /* So does a cache created later on, e.g. in the next session */
+  cache = _cogl_program_binary_cache_new (test_ctx);
+  g_assert_true (link_program (cache, pipeline, NULL));
+  _cogl_program_binary_cache_free (cache);
+
+  g_object_unref (pipeline);
+}
+
+static void
+test_program_binary_cache_corrupt (void)
+{
+  CoglProgramBinaryCache *cache;
+  CoglPipeline *pipeline;
+  g_autofree char *path = NULL;
+  g_autoptr (GError) error = NULL;
+
+  if (!check_program_binary_support ())
+    return;
+
+  clear_cache ();
+  pipeline = create_pipeline ();
+  cache = _cogl_program_binary_cache_new (test_ctx);
+
+  path = store_program (cache, pipeline);
+  g_file_set_contents (path, "not a program binary", -1, &error);
+  g_assert_no_error (error);
+
+  /* A corrupt binary is discarded and the program compiled again */
+  g_assert_false (link_program (cache, pipeline, NULL));
+  g_assert_true (link_program (cache, pipeline, NULL));
+
+  _cogl_program_binary_cache_free (cache);
+  g_object_unref (pipeline);
+}
+
+static void
+test_program_binary_cache_stale (void)
+{
+  CoglProgramBinaryCache *cache;
+  CoglPipeline *pipeline;
+  g_autofree char *path = NULL;
+  g_autofree char *contents = NULL;
+  g_autoptr (GError) error = NULL;
+  uint32_t version;
+  gsize length;
+
+  if (!check_program_binary_support ())
+    return;
+
+  clear_cache ();
+  pipeline = create_pipeline ();
+  cache = _cogl_program_binary_cache_new (test_ctx);
+
+  path = store_program (cache, pipeline);
+
+  /* The version follows the magic number at the start of the file */
+  g_file_get_contents (path, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (length, >, 2 * sizeof (uint32_t));
+  memcpy (&version, contents + sizeof (uint32_t), sizeof (version));
+  version++;
+  memcpy (contents + sizeof (uint32_t), &version, sizeof (version));
+  g_file_set_contents (path, contents, length, &error);
+  g_assert_no_error (error);
+
+  /* A binary stored by another version is discarded */
+  g_assert_false (link_program (cache, pipeline, NULL));
+  g_assert_true (link_program (cache, pipeline, NULL));
+
+  _cogl_program_binary_cache_free (cache);
+  g_object_unref (pipeline);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/program-binary-cache/reuse",
+                   test_program_binary_cache_reuse);
+  g_test_add_func ("/program-binary-cache/corrupt",
+                   test_program_binary_cache_corrupt);
+  g_test_add_func ("/program-binary-cache/stale",
+                   test_program_binary_cache_stale);
+)
@@ -0,0 +1,257 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "backends/meta-backend-private.h"
+#include "core/meta-context-private.h"
+#include "meta-test/meta-context-test.h"
+
+#define FRAME_TIMINGS_DBUS_SERVICE "org.gnome.Mutter.FrameTimings"
+#define FRAME_TIMINGS_DBUS_PATH "/org/gnome/Mutter/FrameTimings"
+#define FRAME_TIMINGS_DBUS_INTERFACE "org.gnome.Mutter.FrameTimings"
+
+static MetaContext *test_context;
+
+/* The service lives in the same process, so calls have to be made
+ * asynchronously while the main loop keeps running. */
+static void
+on_call_finished (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GAsyncResult **result_out = user_data;
+
+  *result_out = g_object_ref (result);
+}
+
+static GVariant *
+call_frame_timings (const char  *method,
+                    GError     **error)
+{
+  g_autoptr (GDBusConnection) connection = NULL;
+  g_autoptr (GAsyncResult) result = NULL;
+
+  connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+  g_assert_nonnull (connection);
+
+  g_dbus_connection_call (connection,
+                          FRAME_TIMINGS_DBUS_SERVICE,
+                          FRAME_TIMINGS_DBUS_PATH,
+                          FRAME_TIMINGS_DBUS_INTERFACE,
+                          method,
+                          NULL, NULL,
+                          G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                          -1, NULL,
+                          on_call_finished, &result);
+  while (!result)
+    g_main_context_iteration (NULL, TRUE);
+
+  return g_dbus_connection_call_finish (connection, result, error);
+}
+
+static void
+on_name_appeared (GDBusConnection *connection,
+                  const char      *name,
+                  const char      *name_owner,
+                  gpointer         user_data)
+{
+  gboolean *appeared = user_data;
+
+  *appeared = TRUE;
+}
+
+static void
+wait_for_service (void)
+{
+  gboolean appeared = FALSE;
+  guint watch_id;
+
+  watch_id = g_bus_watch_name (G_BUS_TYPE_SESSION,
+                               FRAME_TIMINGS_DBUS_SERVICE,
+                               G_BUS_NAME_WATCHER_FLAGS_NONE,
+                               on_name_appeared,
+                               NULL,
+                               &appeared,
+                               NULL);
+  while (!appeared)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_bus_unwatch_name (watch_id);
+}
+
+static void
+on_presented (ClutterStage     *stage,
+              ClutterStageView *view,
+              ClutterFrameInfo *frame_info,
+              int              *frames_left)
+{
+  if (--(*frames_left) > 0)
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+}
+
+static void
+present_frames (int n_frames)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  int frames_left = n_frames;
+  gulong handler_id;
+
+  handler_id = g_signal_connect (stage, "presented",
+                                 G_CALLBACK (on_presented), &frames_left);
+  clutter_actor_queue_redraw (stage);
+  while (frames_left > 0)
+    g_main_context_iteration (NULL, TRUE);
+  g_signal_handler_disconnect (stage, handler_id);
+}
+
+static unsigned int
+get_n_dispatch_lateness_samples (GVariant *frame_timings)
+{
+  const char *other_timings[] = {
+    "update-duration",
+    "gpu-render-time",
+    "presentation-delta",
+    "missed-vblanks",
+  };
+  g_autoptr (GVariant) views = NULL;
+  g_autoptr (GVariant) view = NULL;
+  g_autoptr (GVariant) stats = NULL;
+  g_autoptr (GVariant) histogram = NULL;
+  uint32_t n_samples;
+  uint32_t n_histogram_samples = 0;
+  const uint32_t *buckets;
+  gsize n_buckets;
+  gsize i;
+
+  views = g_variant_get_child_value (frame_timings, 0);
+  g_assert_cmpuint (g_variant_n_children (views), ==, 1);
+  view = g_variant_get_child_value (views, 0);
+
+  g_assert_true (g_variant_lookup (view, "name", "&s", NULL));
+  g_assert_true (g_variant_lookup (view, "refresh-rate", "d", NULL));
+
+  stats = g_variant_lookup_value (view, "dispatch-lateness",
+                                  G_VARIANT_TYPE ("a{sv}"));
+  g_assert_nonnull (stats);
+  g_assert_true (g_variant_lookup (stats, "samples", "u", &n_samples));
+  g_assert_true (g_variant_lookup (stats, "p99", "x", NULL));
+
+  histogram = g_variant_lookup_value (stats, "histogram",
+                                      G_VARIANT_TYPE ("au"));
+  g_assert_nonnull (histogram);
+  buckets = g_variant_get_fixed_array (histogram, &n_buckets,
+                                       sizeof (uint32_t));
+  g_assert_cmpuint (n_buckets, ==, CLUTTER_FRAME_TIMING_N_BUCKETS);
+  for (i = 0; i < n_buckets; i++)
+    n_histogram_samples += buckets[i];
+  g_assert_cmpuint (n_histogram_samples, ==, n_samples);
+
+  for (i = 0; i < G_N_ELEMENTS (other_timings); i++)
+    {
+      g_autoptr (GVariant) other_stats = NULL;
+
+      other_stats = g_variant_lookup_value (view, other_timings[i],
+                                            G_VARIANT_TYPE ("a{sv}"));
+      g_assert_nonnull (other_stats);
+    }
+
+  return n_samples;
+}
+
+static void
+meta_test_frame_timings_get (void)
+{
+  g_autoptr (GVariant) frame_timings = NULL;
+  g_autoptr (GError) error = NULL;
+
+  present_frames (10);
+
+  frame_timings = call_frame_timings ("GetFrameTimings", &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (get_n_dispatch_lateness_samples (frame_timings),
+                    >=, 10);
+}
+
+static void
+meta_test_frame_timings_reset (void)
+{
+  g_autoptr (GVariant) frame_timings = NULL;
+  g_autoptr (GVariant) reply = NULL;
+  g_autoptr (GError) error = NULL;
+
+  present_frames (2);
+
+  meta_context_set_unsafe_mode (test_context, FALSE);
+  reply = call_frame_timings ("Reset", &error);
+  g_assert_null (reply);
+  g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED);
+  g_clear_error (&error);
+
+  frame_timings = call_frame_timings ("GetFrameTimings", &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (get_n_dispatch_lateness_samples (frame_timings),
+                    >, 0);
+  g_clear_pointer (&frame_timings, g_variant_unref);
+
+  meta_context_set_unsafe_mode (test_context, TRUE);
+  reply = call_frame_timings ("Reset", &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (reply);
+  meta_context_set_unsafe_mode (test_context, FALSE);
+
+  frame_timings = call_frame_timings ("GetFrameTimings", &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (get_n_dispatch_lateness_samples (frame_timings),
+                    ==, 0);
+}
+
+static void
+on_before_tests (MetaContext *context)
+{
+  wait_for_service ();
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/backends/frame-timings/get",
+                   meta_test_frame_timings_get);
+  g_test_add_func ("/backends/frame-timings/reset",
+                   meta_test_frame_timings_reset);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_NESTED,
+                                      META_CONTEXT_TEST_FLAG_NO_X11);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  test_context = context;
+
+  init_tests ();
+
+  g_signal_connect (context, "before-tests",
+                    G_CALLBACK (on_before_tests), NULL);
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
@@ -246,6 +246,54 @@ meta_test_kms_update_fixed16 (void)
   g_assert_cmpint (meta_fixed_16_to_int (-809041920), ==, -12345);
 }
 
+static void
+meta_test_kms_deadline_evasion (void)
+{
+  MetaKmsDeadlineEvasion deadline_evasion;
+  int i;
+
+  meta_kms_deadline_evasion_init (&deadline_evasion, 800);
+
+  /* Too few samples to adapt */
+  for (i = 0; i < 15; i++)
+    g_assert_false (meta_kms_deadline_evasion_add_commit_latency (&deadline_evasion, 100));
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 800);
+  g_assert_cmpint (meta_kms_deadline_evasion_get_commit_latency_us (&deadline_evasion),
+                   ==, 0);
+
+  /* Fast commits only lower the deadline evasion after a while */
+  for (i = 0; i < 104; i++)
+    meta_kms_deadline_evasion_add_commit_latency (&deadline_evasion, 100);
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 800);
+  g_assert_true (meta_kms_deadline_evasion_add_commit_latency (&deadline_evasion, 100));
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 300);
+
+  /* Outliers below the percentile are ignored */
+  for (i = 0; i < 3; i++)
+    meta_kms_deadline_evasion_add_commit_latency (&deadline_evasion, 5000);
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 300);
+
+  /* Slow commits raise it right away */
+  for (i = 0; i < 10; i++)
+    meta_kms_deadline_evasion_add_commit_latency (&deadline_evasion, 1000);
+  g_assert_cmpint (meta_kms_deadline_evasion_get_commit_latency_us (&deadline_evasion),
+                   ==, 1000);
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 1200);
+
+  /* Small changes are not followed */
+  for (i = 0; i < META_KMS_DEADLINE_EVASION_N_SAMPLES * 3; i++)
+    meta_kms_deadline_evasion_add_commit_latency (&deadline_evasion, 950);
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 1200);
+
+  /* Missed deadlines raise it up to a limit */
+  g_assert_true (meta_kms_deadline_evasion_add_missed_deadline (&deadline_evasion));
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 1450);
+  for (i = 0; i < 20; i++)
+    meta_kms_deadline_evasion_add_missed_deadline (&deadline_evasion);
+  g_assert_cmpint (deadline_evasion.evasion_us, ==, 4000);
+  g_assert_false (meta_kms_deadline_evasion_add_missed_deadline (&deadline_evasion));
+}
+
 static void
 init_kms_utils_tests (void)
 {
@@ -253,6 +301,8 @@ init_kms_utils_tests (void)
                    meta_test_kms_refresh_rate);
   g_test_add_func ("/backends/native/kms/vblank-duration",
                    meta_test_kms_vblank_duration);
+  g_test_add_func ("/backends/native/kms/deadline-evasion",
+                   meta_test_kms_deadline_evasion);
   g_test_add_func ("/backends/native/kms/update/fixed16",
                    meta_test_kms_update_fixed16);
 }
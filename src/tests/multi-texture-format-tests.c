@@ -0,0 +1,379 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "backends/meta-backend-private.h"
+#include "compositor/meta-multi-texture-format-private.h"
+#include "meta-test/meta-context-test.h"
+
+#define FRAME_SIZE 4
+
+static MetaContext *test_context;
+
+static void
+meta_test_multi_texture_format_packed_layout (void)
+{
+  struct {
+    MetaMultiTextureFormat format;
+    int width;
+    int height;
+
+    int expected_packed_width;
+    int expected_packed_height;
+    int expected_plane_offsets[COGL_PIXEL_FORMAT_MAX_PLANES];
+    int expected_plane_strides[COGL_PIXEL_FORMAT_MAX_PLANES];
+  } test_cases[] = {
+    {
+      .format = META_MULTI_TEXTURE_FORMAT_NV12,
+      .width = 1920,
+      .height = 1080,
+      .expected_packed_width = 2048,
+      .expected_packed_height = 1620,
+      .expected_plane_offsets = { 0, 2048 * 1080 },
+      .expected_plane_strides = { 2048, 2048 },
+    },
+    {
+      .format = META_MULTI_TEXTURE_FORMAT_NV12,
+      .width = 641,
+      .height = 361,
+      .expected_packed_width = 768,
+      .expected_packed_height = 542,
+      .expected_plane_offsets = { 0, 768 * 361 },
+      .expected_plane_strides = { 768, 768 },
+    },
+    {
+      .format = META_MULTI_TEXTURE_FORMAT_YUV420,
+      .width = 1920,
+      .height = 1080,
+      .expected_packed_width = 2048,
+      .expected_packed_height = 1620,
+      .expected_plane_offsets = {
+        0,
+        2048 * 1080,
+        2048 * 1080 + 1024 * 540,
+      },
+      .expected_plane_strides = { 2048, 1024, 1024 },
+    },
+    {
+      /* An odd number of chroma rows makes the V-plane start in the
+       * middle of a row of the buffer */
+      .format = META_MULTI_TEXTURE_FORMAT_YUV420,
+      .width = 641,
+      .height = 361,
+      .expected_packed_width = 768,
+      .expected_packed_height = 542,
+      .expected_plane_offsets = {
+        0,
+        768 * 361,
+        768 * 361 + 384 * 181,
+      },
+      .expected_plane_strides = { 768, 384, 384 },
+    },
+  };
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (test_cases); i++)
+    {
+      int n_planes = meta_multi_texture_format_get_n_planes (test_cases[i].format);
+      uint8_t horizontal_factors[COGL_PIXEL_FORMAT_MAX_PLANES];
+      uint8_t vertical_factors[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int plane_offsets[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int plane_strides[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int packed_width, packed_height;
+      int j;
+
+      g_test_message ("Packing %s %dx%d",
+                      meta_multi_texture_format_to_string (test_cases[i].format),
+                      test_cases[i].width, test_cases[i].height);
+
+      g_assert_true (meta_multi_texture_format_get_packed_layout (test_cases[i].format,
+                                                                  test_cases[i].width,
+                                                                  test_cases[i].height,
+                                                                  &packed_width,
+                                                                  &packed_height,
+                                                                  plane_offsets,
+                                                                  plane_strides));
+      g_assert_cmpint (packed_width, ==, test_cases[i].expected_packed_width);
+      g_assert_cmpint (packed_height, ==, test_cases[i].expected_packed_height);
+
+      meta_multi_texture_format_get_subsampling_factors (test_cases[i].format,
+                                                         horizontal_factors,
+                                                         vertical_factors);
+
+      for (j = 0; j < n_planes; j++)
+        {
+          int plane_height = ((test_cases[i].height + vertical_factors[j] - 1) /
+                              vertical_factors[j]);
+          int plane_end = plane_offsets[j] + plane_strides[j] * plane_height;
+
+          g_assert_cmpint (plane_offsets[j], ==,
+                           test_cases[i].expected_plane_offsets[j]);
+          g_assert_cmpint (plane_strides[j], ==,
+                           test_cases[i].expected_plane_strides[j]);
+
+          /* Planes must neither overlap nor exceed the buffer */
+          if (j + 1 < n_planes)
+            g_assert_cmpint (plane_end, <=, plane_offsets[j + 1]);
+          else
+            g_assert_cmpint (plane_end, <=, packed_width * packed_height);
+        }
+    }
+}
+
+static void
+meta_test_multi_texture_format_packed_layout_unsupported (void)
+{
+  MetaMultiTextureFormat formats[] = {
+    META_MULTI_TEXTURE_FORMAT_SIMPLE,
+    META_MULTI_TEXTURE_FORMAT_P010,
+  };
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      int plane_offsets[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int plane_strides[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int packed_width, packed_height;
+
+      g_assert_false (meta_multi_texture_format_get_packed_layout (formats[i],
+                                                                   1920, 1080,
+                                                                   &packed_width,
+                                                                   &packed_height,
+                                                                   plane_offsets,
+                                                                   plane_strides));
+    }
+}
+
+static uint8_t
+rgb_to_yuv_component (const uint8_t *rgb,
+                      int            component)
+{
+  /* BT.601 limited range, as converted by the packed shaders */
+  static const float coefficients[3][4] = {
+    { 0.06274510f, 0.25678824f, 0.50412941f, 0.09790588f },
+    { 0.50196078f, -0.14822290f, -0.29099279f, 0.43921569f },
+    { 0.50196078f, 0.43921569f, -0.36778831f, -0.07142737f },
+  };
+  const float *c = coefficients[component];
+  float value;
+
+  value = (c[0] +
+           c[1] * rgb[0] / 255.0f +
+           c[2] * rgb[1] / 255.0f +
+           c[3] * rgb[2] / 255.0f);
+
+  return (uint8_t) (value * 255.0f + 0.5f);
+}
+
+static const uint8_t *
+get_block_color (int x,
+                 int y)
+{
+  /* Each 2x2 block of the frame has its own color, so that subsampling
+   * doesn't mix colors */
+  static const uint8_t colors[2][2][3] = {
+    { { 0xff, 0x00, 0x00 }, { 0x00, 0xff, 0x00 } },
+    { { 0x00, 0x00, 0xff }, { 0xff, 0xff, 0xff } },
+  };
+
+  return colors[y / 2][x / 2];
+}
+
+static void
+assert_byte_near (uint8_t value,
+                  uint8_t expected)
+{
+  g_assert_cmpint (ABS ((int) value - (int) expected), <=, 1);
+}
+
+static void
+meta_test_multi_texture_format_packed_render (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+  CoglContext *cogl_context =
+    clutter_backend_get_cogl_context (clutter_backend);
+  MetaMultiTextureFormat formats[] = {
+    META_MULTI_TEXTURE_FORMAT_NV12,
+    META_MULTI_TEXTURE_FORMAT_YUV420,
+  };
+  uint8_t frame_data[FRAME_SIZE * FRAME_SIZE * 4];
+  g_autoptr (CoglTexture) frame_texture = NULL;
+  g_autoptr (GError) error = NULL;
+  int x, y;
+  int i;
+
+  for (y = 0; y < FRAME_SIZE; y++)
+    {
+      for (x = 0; x < FRAME_SIZE; x++)
+        {
+          uint8_t *pixel = &frame_data[(y * FRAME_SIZE + x) * 4];
+
+          memcpy (pixel, get_block_color (x, y), 3);
+          pixel[3] = 0xff;
+        }
+    }
+
+  frame_texture = cogl_texture_2d_new_from_data (cogl_context,
+                                                 FRAME_SIZE, FRAME_SIZE,
+                                                 COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                 FRAME_SIZE * 4,
+                                                 frame_data,
+                                                 &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      g_autoptr (CoglSnippet) globals_snippet = NULL;
+      g_autoptr (CoglSnippet) fragment_snippet = NULL;
+      g_autoptr (CoglTexture) packed_texture = NULL;
+      g_autoptr (CoglOffscreen) offscreen = NULL;
+      g_autoptr (CoglPipeline) pipeline = NULL;
+      g_autofree uint8_t *packed_data = NULL;
+      uint8_t horizontal_factors[COGL_PIXEL_FORMAT_MAX_PLANES];
+      uint8_t vertical_factors[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int plane_offsets[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int plane_strides[COGL_PIXEL_FORMAT_MAX_PLANES];
+      int packed_width, packed_height;
+      float frame_size[2] = { FRAME_SIZE, FRAME_SIZE };
+      float packed_size[2];
+      graphene_matrix_t projection;
+      CoglFramebuffer *framebuffer;
+      int n_planes;
+      int j;
+
+      g_test_message ("Rendering %s",
+                      meta_multi_texture_format_to_string (formats[i]));
+
+      g_assert_true (meta_multi_texture_format_get_packed_layout (formats[i],
+                                                                  FRAME_SIZE,
+                                                                  FRAME_SIZE,
+                                                                  &packed_width,
+                                                                  &packed_height,
+                                                                  plane_offsets,
+                                                                  plane_strides));
+      packed_size[0] = packed_width;
+      packed_size[1] = packed_height;
+
+      packed_texture = cogl_texture_2d_new_with_size (cogl_context,
+                                                      packed_width,
+                                                      packed_height);
+      offscreen = cogl_offscreen_new_with_texture (packed_texture);
+      framebuffer = COGL_FRAMEBUFFER (offscreen);
+      cogl_framebuffer_allocate (framebuffer, &error);
+      g_assert_no_error (error);
+
+      pipeline = cogl_pipeline_new (cogl_context);
+      cogl_pipeline_set_layer_texture (pipeline, 0, frame_texture);
+      cogl_pipeline_set_layer_filters (pipeline, 0,
+                                       COGL_PIPELINE_FILTER_LINEAR,
+                                       COGL_PIPELINE_FILTER_LINEAR);
+      cogl_pipeline_set_layer_wrap_mode (pipeline, 0,
+                                         COGL_PIPELINE_WRAP_MODE_CLAMP_TO_EDGE);
+      g_assert_true (meta_multi_texture_format_get_packed_snippets (formats[i],
+                                                                    &globals_snippet,
+                                                                    &fragment_snippet));
+      cogl_pipeline_add_snippet (pipeline, globals_snippet);
+      cogl_pipeline_add_snippet (pipeline, fragment_snippet);
+      cogl_pipeline_set_uniform_float (pipeline,
+                                       cogl_pipeline_get_uniform_location (pipeline,
+                                                                           "frame_size"),
+                                       2, 1, frame_size);
+      cogl_pipeline_set_uniform_float (pipeline,
+                                       cogl_pipeline_get_uniform_location (pipeline,
+                                                                           "packed_size"),
+                                       2, 1, packed_size);
+
+      graphene_matrix_init_identity (&projection);
+      cogl_framebuffer_set_projection_matrix (framebuffer, &projection);
+      cogl_framebuffer_draw_rectangle (framebuffer, pipeline, -1, 1, 1, -1);
+
+      /* Every component of the buffer holds the packed value */
+      packed_data = g_malloc (packed_width * packed_height * 4);
+      cogl_framebuffer_read_pixels (framebuffer, 0, 0,
+                                    packed_width, packed_height,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                    packed_data);
+
+      n_planes = meta_multi_texture_format_get_n_planes (formats[i]);
+      meta_multi_texture_format_get_subsampling_factors (formats[i],
+                                                         horizontal_factors,
+                                                         vertical_factors);
+
+      for (j = 0; j < n_planes; j++)
+        {
+          int plane_width = FRAME_SIZE / horizontal_factors[j];
+          int plane_height = FRAME_SIZE / vertical_factors[j];
+          /* Only NV12 interleaves the U and V components in one plane */
+          int n_components = n_planes == 2 && j == 1 ? 2 : 1;
+
+          for (y = 0; y < plane_height; y++)
+            {
+              for (x = 0; x < plane_width; x++)
+                {
+                  const uint8_t *color =
+                    get_block_color (x * horizontal_factors[j],
+                                     y * vertical_factors[j]);
+                  int k;
+
+                  for (k = 0; k < n_components; k++)
+                    {
+                      int offset = (plane_offsets[j] +
+                                    y * plane_strides[j] +
+                                    x * n_components + k);
+                      int component = j == 0 ? 0 : j + k;
+
+                      assert_byte_near (packed_data[offset * 4],
+                                        rgb_to_yuv_component (color,
+                                                              component));
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/compositor/multi-texture-format/packed-layout",
+                   meta_test_multi_texture_format_packed_layout);
+  g_test_add_func ("/compositor/multi-texture-format/packed-layout-unsupported",
+                   meta_test_multi_texture_format_packed_layout_unsupported);
+  g_test_add_func ("/compositor/multi-texture-format/packed-render",
+                   meta_test_multi_texture_format_packed_render);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NO_X11);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  test_context = context;
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
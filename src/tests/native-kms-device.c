@@ -22,13 +22,14 @@
 #include "backends/native/meta-device-pool.h"
 #include "backends/native/meta-input-thread.h"
 #include "backends/native/meta-kms-connector.h"
-#include "backends/native/meta-kms-crtc.h"
+#include "backends/native/meta-kms-crtc-private.h"
 #include "backends/native/meta-kms-cursor-manager.h"
 #include "backends/native/meta-kms-device.h"
 #include "backends/native/meta-kms-device-private.h"
+#include "backends/native/meta-kms-impl-device-atomic.h"
 #include "backends/native/meta-kms-impl-device-simple.h"
 #include "backends/native/meta-kms-mode-private.h"
-#include "backends/native/meta-kms-plane.h"
+#include "backends/native/meta-kms-plane-private.h"
 #include "backends/native/meta-kms-private.h"
 #include "backends/native/meta-kms-update.h"
 #include "backends/native/meta-seat-native.h"
@@ -316,6 +317,253 @@ meta_test_kms_device_mode_set (void)
   release_connector_state (&connector_state);
 }
 
+typedef struct
+{
+  MetaKmsImplDevice *impl_device;
+  uint32_t object_id;
+  uint32_t prop_id;
+} PropLookup;
+
+static gpointer
+was_prop_updated_in_impl (MetaThreadImpl  *thread_impl,
+                          gpointer         user_data,
+                          GError         **error)
+{
+  PropLookup *lookup = user_data;
+  MetaKmsImplDeviceAtomic *impl_device_atomic =
+    META_KMS_IMPL_DEVICE_ATOMIC (lookup->impl_device);
+
+  return GINT_TO_POINTER (meta_kms_impl_device_atomic_was_prop_updated (impl_device_atomic,
+                                                                        lookup->object_id,
+                                                                        lookup->prop_id));
+}
+
+static void
+assert_plane_props_updated (MetaKmsDevice    *device,
+                            MetaKmsPlane     *plane,
+                            MetaKmsPlaneProp  first_prop,
+                            MetaKmsPlaneProp  last_prop,
+                            gboolean          expect_updated)
+{
+  MetaKms *kms = meta_kms_device_get_kms (device);
+  MetaKmsPlaneProp prop;
+
+  for (prop = first_prop; prop <= last_prop; prop++)
+    {
+      PropLookup lookup = {
+        .impl_device = meta_kms_device_get_impl_device (device),
+        .object_id = meta_kms_plane_get_id (plane),
+        .prop_id = meta_kms_plane_get_prop_id (plane, prop),
+      };
+      gpointer updated;
+
+      updated = meta_thread_run_impl_task_sync (META_THREAD (kms),
+                                                was_prop_updated_in_impl,
+                                                &lookup,
+                                                NULL);
+      g_assert_cmpint (GPOINTER_TO_INT (updated), ==, expect_updated);
+    }
+}
+
+static uint64_t
+get_drm_crtc_prop_value (MetaDeviceFile  *device_file,
+                         MetaKmsCrtc     *crtc,
+                         MetaKmsCrtcProp  prop)
+{
+  drmModeObjectProperties *drm_props;
+  uint32_t prop_id;
+  uint64_t value = 0;
+  gboolean found = FALSE;
+  unsigned int i;
+
+  prop_id = meta_kms_crtc_get_prop_id (crtc, prop);
+  g_assert_cmpuint (prop_id, !=, 0);
+
+  drm_props = drmModeObjectGetProperties (meta_device_file_get_fd (device_file),
+                                          meta_kms_crtc_get_id (crtc),
+                                          DRM_MODE_OBJECT_CRTC);
+  g_assert_nonnull (drm_props);
+
+  for (i = 0; i < drm_props->count_props; i++)
+    {
+      if (drm_props->props[i] == prop_id)
+        {
+          value = drm_props->prop_values[i];
+          found = TRUE;
+          break;
+        }
+    }
+
+  drmModeFreeObjectProperties (drm_props);
+
+  g_assert_true (found);
+  return value;
+}
+
+static MetaGammaLut *
+create_linear_gamma_lut (int size)
+{
+  g_autofree uint16_t *ramp = NULL;
+  int i;
+
+  ramp = g_new0 (uint16_t, size);
+  for (i = 0; i < size; i++)
+    ramp[i] = (uint16_t) (i * 0xffff / MAX (size - 1, 1));
+
+  return meta_gamma_lut_new (size, ramp, ramp, ramp);
+}
+
+static void
+meta_test_kms_device_repeated_update (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaBackendNative *backend_native = META_BACKEND_NATIVE (backend);
+  MetaDevicePool *device_pool;
+  MetaDeviceFile *device_file;
+  MetaKmsDevice *device;
+  MetaKmsUpdate *update;
+  MetaKmsCrtc *crtc;
+  MetaKmsConnector *connector;
+  MetaKmsMode *mode;
+  MetaKmsPlane *primary_plane;
+  g_autoptr (MetaDrmBuffer) primary_buffer1 = NULL;
+  g_autoptr (MetaDrmBuffer) primary_buffer2 = NULL;
+  const MetaKmsCrtcState *crtc_state;
+  MtkRectangle mode_rect;
+  MetaKmsFeedback *feedback;
+  gboolean is_atomic;
+  gboolean has_gamma;
+  int gamma_size = 0;
+  uint64_t mode_blob_ids[2] = { 0 };
+  uint64_t gamma_blob_ids[2] = { 0 };
+  GError *error = NULL;
+  int i;
+
+  device = meta_get_test_kms_device (test_context);
+  crtc = meta_get_test_kms_crtc (device);
+  connector = meta_get_test_kms_connector (device);
+  mode = meta_kms_connector_get_preferred_mode (connector);
+  primary_plane = meta_kms_device_get_primary_plane_for (device, crtc);
+  primary_buffer1 = meta_create_test_mode_dumb_buffer (device, mode);
+  primary_buffer2 = meta_create_test_mode_dumb_buffer (device, mode);
+
+  /* Only atomic mode setting keeps blobs and properties in effect */
+  is_atomic =
+    META_IS_KMS_IMPL_DEVICE_ATOMIC (meta_kms_device_get_impl_device (device));
+
+  device_pool = meta_backend_native_get_device_pool (backend_native);
+  device_file = meta_device_pool_open (device_pool,
+                                       meta_kms_device_get_path (device),
+                                       META_DEVICE_FILE_FLAG_TAKE_CONTROL,
+                                       &error);
+  if (!device_file)
+    g_error ("Failed to open KMS device: %s", error->message);
+
+  crtc_state = meta_kms_crtc_get_current_state (crtc);
+  has_gamma = (crtc_state &&
+               crtc_state->gamma.supported &&
+               crtc_state->gamma.size > 0 &&
+               meta_kms_crtc_get_prop_id (crtc, META_KMS_CRTC_PROP_GAMMA_LUT));
+  if (has_gamma)
+    gamma_size = crtc_state->gamma.size;
+
+  /*
+   * Mode set twice, reusing the mode blob, then flip between buffers with
+   * plane properties already in effect.
+   */
+
+  for (i = 0; i < 2; i++)
+    {
+      update = meta_kms_update_new (device);
+      meta_kms_update_mode_set (update, crtc,
+                                g_list_append (NULL, connector),
+                                mode);
+      meta_kms_update_assign_plane (update,
+                                    crtc,
+                                    primary_plane,
+                                    primary_buffer1,
+                                    meta_get_mode_fixed_rect_16 (mode),
+                                    meta_get_mode_rect (mode),
+                                    META_KMS_ASSIGN_PLANE_FLAG_NONE);
+      if (has_gamma)
+        {
+          g_autoptr (MetaGammaLut) lut = NULL;
+
+          /* A new but identical gamma ramp each time */
+          lut = create_linear_gamma_lut (gamma_size);
+          meta_kms_update_set_crtc_gamma (update, crtc, lut);
+        }
+      feedback =
+        meta_kms_device_process_update_sync (device, update,
+                                             META_KMS_UPDATE_FLAG_MODE_SET);
+      g_assert_cmpint (meta_kms_feedback_get_result (feedback),
+                       ==,
+                       META_KMS_FEEDBACK_PASSED);
+      meta_kms_feedback_unref (feedback);
+
+      if (!is_atomic)
+        continue;
+
+      /* Mode sets set every property again */
+      assert_plane_props_updated (device, primary_plane,
+                                  META_KMS_PLANE_PROP_SRC_X,
+                                  META_KMS_PLANE_PROP_CRTC_H,
+                                  TRUE);
+
+      mode_blob_ids[i] = get_drm_crtc_prop_value (device_file, crtc,
+                                                  META_KMS_CRTC_PROP_MODE_ID);
+      g_assert_cmpuint (mode_blob_ids[i], !=, 0);
+
+      if (has_gamma)
+        {
+          gamma_blob_ids[i] =
+            get_drm_crtc_prop_value (device_file, crtc,
+                                     META_KMS_CRTC_PROP_GAMMA_LUT);
+          g_assert_cmpuint (gamma_blob_ids[i], !=, 0);
+        }
+    }
+
+  /* The second mode set reused the blobs of the first one */
+  g_assert_cmpuint (mode_blob_ids[0], ==, mode_blob_ids[1]);
+  g_assert_cmpuint (gamma_blob_ids[0], ==, gamma_blob_ids[1]);
+
+  for (i = 0; i < 4; i++)
+    {
+      update = meta_kms_update_new (device);
+      meta_kms_update_assign_plane (update,
+                                    crtc,
+                                    primary_plane,
+                                    i % 2 ? primary_buffer1 : primary_buffer2,
+                                    meta_get_mode_fixed_rect_16 (mode),
+                                    meta_get_mode_rect (mode),
+                                    META_KMS_ASSIGN_PLANE_FLAG_NONE);
+      feedback = meta_kms_device_process_update_sync (device, update,
+                                                      META_KMS_UPDATE_FLAG_NONE);
+      g_assert_cmpint (meta_kms_feedback_get_result (feedback),
+                       ==,
+                       META_KMS_FEEDBACK_PASSED);
+      meta_kms_feedback_unref (feedback);
+
+      if (!is_atomic)
+        continue;
+
+      /* Only the framebuffer changes between flips */
+      assert_plane_props_updated (device, primary_plane,
+                                  META_KMS_PLANE_PROP_SRC_X,
+                                  META_KMS_PLANE_PROP_CRTC_H,
+                                  FALSE);
+    }
+
+  meta_device_file_release (device_file);
+
+  meta_kms_update_states_sync (meta_kms_device_get_kms (device), NULL);
+  crtc_state = meta_kms_crtc_get_current_state (crtc);
+  g_assert_nonnull (crtc_state);
+  g_assert_true (crtc_state->is_active);
+  mode_rect = meta_get_mode_rect (mode);
+  g_assert (mtk_rectangle_equal (&crtc_state->rect, &mode_rect));
+}
+
 static void
 meta_test_kms_device_power_save (void)
 {
@@ -717,6 +965,8 @@ init_tests (void)
                    meta_test_kms_device_sanity);
   g_test_add_func ("/backends/native/kms/device/mode-set",
                    meta_test_kms_device_mode_set);
+  g_test_add_func ("/backends/native/kms/device/repeated-update",
+                   meta_test_kms_device_repeated_update);
   g_test_add_func ("/backends/native/kms/device/power-save",
                    meta_test_kms_device_power_save);
   g_test_add_func ("/backends/native/kms/device/discard-disabled",
@@ -20,6 +20,7 @@
 
 #include <xf86drmMode.h>
 
+#include "backends/meta-settings-private.h"
 #include "backends/native/meta-backend-native-private.h"
 #include "backends/native/meta-crtc-kms.h"
 #include "backends/native/meta-device-pool.h"
@@ -31,6 +32,7 @@
 #include "backends/native/meta-kms-device.h"
 #include "backends/native/meta-kms-device-private.h"
 #include "backends/native/meta-kms-impl-device-atomic.h"
+#include "backends/native/meta-kms-plane.h"
 #include "core/display-private.h"
 #include "meta/meta-backend.h"
 #include "meta-test/meta-context-test.h"
@@ -57,6 +59,12 @@ typedef struct
     guint repaint_guard_id;
     ClutterStageView *scanout_failed_view;
   } scanout_fallback;
+
+  struct {
+    uint32_t plane_id;
+    gboolean expect_overlay;
+    gboolean sabotage;
+  } overlay;
 } KmsRenderingTest;
 
 static MetaContext *test_context;
@@ -472,6 +480,208 @@ meta_test_kms_render_client_scanout_fallback (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static void
+on_overlay_before_paint (ClutterStage     *stage,
+                         ClutterStageView *stage_view,
+                         ClutterFrame     *frame,
+                         KmsRenderingTest *test)
+{
+  if (!test->overlay.sabotage)
+    return;
+
+  drm_mock_queue_error (DRM_MOCK_CALL_ATOMIC_COMMIT, EINVAL);
+  test->overlay.sabotage = FALSE;
+}
+
+static void
+on_overlay_presented (ClutterStage     *stage,
+                      ClutterStageView *stage_view,
+                      ClutterFrameInfo *frame_info,
+                      KmsRenderingTest *test)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaBackendNative *backend_native = META_BACKEND_NATIVE (backend);
+  MetaDevicePool *device_pool;
+  CoglFramebuffer *fb;
+  MetaCrtc *crtc;
+  MetaKmsCrtc *kms_crtc;
+  MetaKmsDevice *kms_device;
+  MetaDeviceFile *device_file;
+  GError *error = NULL;
+  drmModeCrtc *drm_crtc;
+  drmModePlane *drm_plane;
+  uint32_t overlay_fb_id;
+
+  if (test->overlay.sabotage)
+    return;
+
+  device_pool = meta_backend_native_get_device_pool (backend_native);
+
+  fb = clutter_stage_view_get_onscreen (stage_view);
+  crtc = meta_onscreen_native_get_crtc (META_ONSCREEN_NATIVE (fb));
+  kms_crtc = meta_crtc_kms_get_kms_crtc (META_CRTC_KMS (crtc));
+  kms_device = meta_kms_crtc_get_device (kms_crtc);
+
+  device_file = meta_device_pool_open (device_pool,
+                                       meta_kms_device_get_path (kms_device),
+                                       META_DEVICE_FILE_FLAG_TAKE_CONTROL,
+                                       &error);
+  if (!device_file)
+    g_error ("Failed to open KMS device: %s", error->message);
+
+  drm_plane = drmModeGetPlane (meta_device_file_get_fd (device_file),
+                               test->overlay.plane_id);
+  g_assert_nonnull (drm_plane);
+  overlay_fb_id = drm_plane->fb_id;
+  drmModeFreePlane (drm_plane);
+
+  drm_crtc = drmModeGetCrtc (meta_device_file_get_fd (device_file),
+                             meta_kms_crtc_get_id (kms_crtc));
+  g_assert_nonnull (drm_crtc);
+  g_assert_cmpuint (drm_crtc->buffer_id, !=, 0);
+  if (overlay_fb_id != 0)
+    g_assert_cmpuint (drm_crtc->buffer_id, !=, overlay_fb_id);
+  drmModeFreeCrtc (drm_crtc);
+
+  meta_device_file_release (device_file);
+
+  if ((overlay_fb_id != 0) == test->overlay.expect_overlay)
+    g_main_loop_quit (test->loop);
+  else
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+}
+
+static void
+meta_test_kms_render_client_overlay_scanout (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaWaylandCompositor *wayland_compositor =
+    meta_context_get_wayland_compositor (test_context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  MetaKms *kms = meta_backend_native_get_kms (META_BACKEND_NATIVE (backend));
+  MetaKmsDevice *kms_device = meta_kms_get_devices (kms)->data;
+  ClutterStageView *stage_view;
+  CoglFramebuffer *fb;
+  MetaCrtc *crtc;
+  MetaKmsCrtc *kms_crtc;
+  MetaKmsPlane *overlay_plane;
+  KmsRenderingTest test;
+  MetaWaylandTestClient *wayland_test_client;
+  g_autoptr (MetaWaylandTestDriver) test_driver = NULL;
+  gulong before_paint_handler_id;
+  gulong presented_handler_id;
+  MetaWindow *window;
+  MtkRectangle view_rect;
+  ClutterActor *popup;
+
+  if (!is_atomic_mode_setting (kms_device))
+    {
+      g_test_skip ("Overlay planes need atomic mode setting");
+      return;
+    }
+
+  stage_view = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage))->data;
+  clutter_stage_view_get_layout (stage_view, &view_rect);
+  fb = clutter_stage_view_get_onscreen (stage_view);
+  crtc = meta_onscreen_native_get_crtc (META_ONSCREEN_NATIVE (fb));
+  kms_crtc = meta_crtc_kms_get_kms_crtc (META_CRTC_KMS (crtc));
+  overlay_plane = meta_kms_device_get_overlay_plane_for (kms_device, kms_crtc);
+  if (!overlay_plane)
+    {
+      g_test_skip ("No overlay plane available");
+      return;
+    }
+
+  test_driver = meta_wayland_test_driver_new (wayland_compositor);
+  meta_wayland_test_driver_set_property (test_driver,
+                                         "gpu-path",
+                                         meta_kms_device_get_path (kms_device));
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "dma-buf-scanout");
+  g_assert_nonnull (wayland_test_client);
+
+  test = (KmsRenderingTest) {
+    .loop = g_main_loop_new (NULL, FALSE),
+    .overlay = {
+      .plane_id = meta_kms_plane_get_id (overlay_plane),
+    },
+  };
+
+  meta_wayland_test_driver_wait_for_sync_point (test_driver,
+                                                SCANOUT_WINDOW_STATE_FULLSCREEN);
+  window = meta_find_window_from_title (test_context, "dma-buf-scanout-test");
+  meta_window_unmake_fullscreen (window);
+  meta_wayland_test_driver_wait_for_sync_point (test_driver,
+                                                SCANOUT_WINDOW_STATE_NONE);
+
+  g_debug ("Moving and resizing to a quarter of the view");
+  meta_window_move_resize_frame (window, TRUE, 10, 10,
+                                 view_rect.width / 2, view_rect.height / 2);
+  meta_wayland_test_driver_wait_for_sync_point (test_driver,
+                                                SCANOUT_WINDOW_STATE_NONE);
+
+  before_paint_handler_id =
+    g_signal_connect (stage, "before-paint",
+                      G_CALLBACK (on_overlay_before_paint), &test);
+  presented_handler_id =
+    g_signal_connect (stage, "presented",
+                      G_CALLBACK (on_overlay_presented), &test);
+
+  g_debug ("Check that overlay scanout is off without the experimental feature");
+  meta_settings_override_experimental_features (settings);
+  test.overlay.expect_overlay = FALSE;
+  clutter_actor_queue_redraw (stage);
+  g_main_loop_run (test.loop);
+
+  g_debug ("Wait for overlay plane assignment");
+  meta_settings_enable_experimental_feature (settings,
+                                             META_EXPERIMENTAL_FEATURE_OVERLAY_SCANOUT);
+  test.overlay.expect_overlay = TRUE;
+  clutter_actor_queue_redraw (stage);
+  g_main_loop_run (test.loop);
+
+  g_debug ("Cover the window with an actor painted above it");
+  popup = clutter_actor_new ();
+  clutter_actor_set_background_color (popup, CLUTTER_COLOR_Red);
+  clutter_actor_set_position (popup, 20, 20);
+  clutter_actor_set_size (popup, 50, 50);
+  clutter_actor_add_child (stage, popup);
+
+  test.overlay.expect_overlay = FALSE;
+  clutter_actor_queue_redraw (stage);
+  g_main_loop_run (test.loop);
+
+  g_debug ("Uncover the window");
+  clutter_actor_destroy (popup);
+
+  test.overlay.expect_overlay = TRUE;
+  clutter_actor_queue_redraw (stage);
+  g_main_loop_run (test.loop);
+
+  g_debug ("Fail the page flip with the overlay plane assigned");
+  g_test_expect_message ("libmutter", G_LOG_LEVEL_WARNING,
+                         "*Page flip failed*");
+
+  test.overlay.sabotage = TRUE;
+  test.overlay.expect_overlay = FALSE;
+  clutter_actor_queue_redraw (stage);
+  g_main_loop_run (test.loop);
+
+  g_test_assert_expected_messages ();
+
+  g_signal_handler_disconnect (stage, before_paint_handler_id);
+  g_signal_handler_disconnect (stage, presented_handler_id);
+
+  meta_settings_disable_experimental_feature (settings,
+                                              META_EXPERIMENTAL_FEATURE_OVERLAY_SCANOUT);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+  g_main_loop_unref (test.loop);
+}
+
 static void
 meta_test_kms_render_empty_config (void)
 {
@@ -509,6 +719,8 @@ init_tests (void)
                    meta_test_kms_render_client_scanout);
   g_test_add_func ("/backends/native/kms/render/client-scanout-fallabck",
                    meta_test_kms_render_client_scanout_fallback);
+  g_test_add_func ("/backends/native/kms/render/client-overlay-scanout",
+                   meta_test_kms_render_client_overlay_scanout);
   g_test_add_func ("/backends/native/kms/render/empty-config",
                    meta_test_kms_render_empty_config);
 }
@@ -0,0 +1,117 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "backends/meta-screen-cast-buffer-damage.h"
+
+static void
+assert_damage (MetaScreenCastBufferDamage *buffer_damage,
+               int                         fd,
+               const MtkRegion            *expected)
+{
+  MtkRegion *damage;
+
+  damage = meta_screen_cast_buffer_damage_get (buffer_damage, fd);
+  g_assert_nonnull (damage);
+  g_assert_true (mtk_region_equal (damage, expected));
+}
+
+static void
+meta_test_screen_cast_buffer_damage_accumulate (void)
+{
+  MetaScreenCastBufferDamage *buffer_damage;
+  g_autoptr (MtkRegion) empty = NULL;
+  g_autoptr (MtkRegion) damage1 = NULL;
+  g_autoptr (MtkRegion) damage2 = NULL;
+  g_autoptr (MtkRegion) both = NULL;
+
+  empty = mtk_region_create ();
+  damage1 = mtk_region_create_rectangle (&MTK_RECTANGLE_INIT (0, 0, 10, 10));
+  damage2 = mtk_region_create_rectangle (&MTK_RECTANGLE_INIT (20, 5, 10, 10));
+  both = mtk_region_copy (damage1);
+  mtk_region_union (both, damage2);
+
+  buffer_damage = meta_screen_cast_buffer_damage_new ();
+
+  /* Buffers never filled need to be filled completely */
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 3));
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 4));
+
+  meta_screen_cast_buffer_damage_mark_filled (buffer_damage, 3);
+  assert_damage (buffer_damage, 3, empty);
+
+  meta_screen_cast_buffer_damage_add (buffer_damage, damage1);
+  assert_damage (buffer_damage, 3, damage1);
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 4));
+
+  /* Each buffer accumulates the damage since it was last filled */
+  meta_screen_cast_buffer_damage_mark_filled (buffer_damage, 4);
+  meta_screen_cast_buffer_damage_add (buffer_damage, damage2);
+  assert_damage (buffer_damage, 3, both);
+  assert_damage (buffer_damage, 4, damage2);
+
+  meta_screen_cast_buffer_damage_mark_filled (buffer_damage, 3);
+  assert_damage (buffer_damage, 3, empty);
+  assert_damage (buffer_damage, 4, damage2);
+
+  /* Unknown damage requires filling every buffer completely */
+  meta_screen_cast_buffer_damage_add (buffer_damage, NULL);
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 3));
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 4));
+
+  meta_screen_cast_buffer_damage_free (buffer_damage);
+}
+
+static void
+meta_test_screen_cast_buffer_damage_forget (void)
+{
+  MetaScreenCastBufferDamage *buffer_damage;
+  g_autoptr (MtkRegion) damage = NULL;
+
+  damage = mtk_region_create_rectangle (&MTK_RECTANGLE_INIT (0, 0, 10, 10));
+
+  buffer_damage = meta_screen_cast_buffer_damage_new ();
+
+  meta_screen_cast_buffer_damage_mark_filled (buffer_damage, 3);
+  meta_screen_cast_buffer_damage_mark_filled (buffer_damage, 4);
+  meta_screen_cast_buffer_damage_add (buffer_damage, damage);
+
+  /* A removed buffer, or one that failed to be filled, starts over, even
+   * if its fd is reused */
+  meta_screen_cast_buffer_damage_forget (buffer_damage, 3);
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 3));
+  assert_damage (buffer_damage, 4, damage);
+
+  meta_screen_cast_buffer_damage_add (buffer_damage, damage);
+  g_assert_null (meta_screen_cast_buffer_damage_get (buffer_damage, 3));
+
+  meta_screen_cast_buffer_damage_free (buffer_damage);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/backends/screen-cast/buffer-damage/accumulate",
+                   meta_test_screen_cast_buffer_damage_accumulate);
+  g_test_add_func ("/backends/screen-cast/buffer-damage/forget",
+                   meta_test_screen_cast_buffer_damage_forget);
+
+  return g_test_run ();
+}
@@ -460,6 +460,40 @@ stream_wait_for_render (Stream *stream)
     g_main_context_iteration (NULL, TRUE);
 }
 
+static uint64_t
+stream_get_statistic (Stream     *stream,
+                      const char *name)
+{
+  GVariant *statistics;
+  uint64_t value = 0;
+
+  statistics = meta_dbus_screen_cast_stream_get_statistics (stream->proxy);
+  if (statistics)
+    g_variant_lookup (statistics, name, "t", &value);
+
+  return value;
+}
+
+static double
+stream_get_cursor_frame_rate (Stream *stream)
+{
+  GVariant *statistics;
+  double frame_rate = 0.0;
+
+  statistics = meta_dbus_screen_cast_stream_get_statistics (stream->proxy);
+  if (statistics)
+    g_variant_lookup (statistics, "cursor-frame-rate", "d", &frame_rate);
+
+  return frame_rate;
+}
+
+static void
+stream_wait_for_statistics (Stream *stream)
+{
+  while (stream_get_statistic (stream, "frames") == 0)
+    g_main_context_iteration (NULL, TRUE);
+}
+
 static void
 stream_resize (Stream *stream,
                int     width,
@@ -750,6 +784,7 @@ main (int    argc,
   ScreenCast *screen_cast;
   Session *session;
   Stream *stream;
+  int i;
 
   g_debug ("Initializing PipeWire");
   init_pipewire ();
@@ -780,6 +815,21 @@ main (int    argc,
   g_assert_cmpint (stream->spa_format.size.width, ==, 50);
   g_assert_cmpint (stream->spa_format.size.height, ==, 40);
 
+  /* Check that frame statistics are reported */
+  g_debug ("Waiting for statistics");
+  stream_wait_for_statistics (stream);
+
+  /* Check that a moving pointer over static content keeps a smooth rate */
+  g_debug ("Moving pointer over static content");
+  for (i = 0; i < 100; i++)
+    {
+      session_notify_absolute_pointer (session, stream, 7 + i % 30, 7 + i % 20);
+      stream_wait_for_cursor_position (stream, 7 + i % 30, 7 + i % 20);
+    }
+  while (stream_get_statistic (stream, "cursor-frames") < 60)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpfloat (stream_get_cursor_frame_rate (stream), >=, 30.0);
+
   /* Check that resizing works */
   g_debug ("Resizing stream");
   stream_resize (stream, 70, 60);
@@ -0,0 +1,253 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "compositor/meta-shadow-factory-private.h"
+#include "compositor/region-utils.h"
+
+/* The reference is the straightforward blur the shadow factory used to
+ * do: box filters dividing each sum, with the columns blurred as rows of
+ * the transposed buffer.
+ */
+
+static int
+get_box_filter_size (int radius)
+{
+  return (int) (0.5 + radius * (0.75 * sqrt (2 * M_PI)));
+}
+
+static int
+get_shadow_spread (int radius)
+{
+  int d;
+
+  if (radius == 0)
+    return 0;
+
+  d = get_box_filter_size (radius);
+
+  if (d % 2 == 1)
+    return 3 * (d / 2);
+  else
+    return 3 * (d / 2) - 1;
+}
+
+static void
+reference_blur_xspan (guchar *row,
+                      guchar *tmp_buffer,
+                      int     row_width,
+                      int     x0,
+                      int     x1,
+                      int     d,
+                      int     shift)
+{
+  int offset;
+  int sum = 0;
+  int i;
+
+  if (d % 2 == 1)
+    offset = d / 2;
+  else
+    offset = (d - shift) / 2;
+
+  for (i = x0 - d + offset; i < x1 + offset; i++)
+    {
+      if (i >= 0 && i < row_width)
+        sum += row[i];
+
+      if (i >= x0 + offset)
+        {
+          if (i >= d)
+            sum -= row[i - d];
+
+          tmp_buffer[i - offset] = (sum + d / 2) / d;
+        }
+    }
+
+  memcpy (row + x0, tmp_buffer + x0, x1 - x0);
+}
+
+static void
+reference_blur_rows (MtkRegion *convolve_region,
+                     int        x_offset,
+                     int        y_offset,
+                     guchar    *buffer,
+                     int        buffer_width,
+                     int        d)
+{
+  g_autofree guchar *tmp_buffer = NULL;
+  int n_rectangles;
+  int i, j;
+
+  tmp_buffer = g_malloc (buffer_width);
+
+  n_rectangles = mtk_region_num_rectangles (convolve_region);
+  for (i = 0; i < n_rectangles; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (convolve_region, i);
+
+      for (j = y_offset + rect.y; j < y_offset + rect.y + rect.height; j++)
+        {
+          guchar *row = buffer + j * buffer_width;
+          int x0 = x_offset + rect.x;
+          int x1 = x0 + rect.width;
+
+          if (d % 2 == 1)
+            {
+              reference_blur_xspan (row, tmp_buffer, buffer_width,
+                                    x0, x1, d, 0);
+              reference_blur_xspan (row, tmp_buffer, buffer_width,
+                                    x0, x1, d, 0);
+              reference_blur_xspan (row, tmp_buffer, buffer_width,
+                                    x0, x1, d, 0);
+            }
+          else
+            {
+              reference_blur_xspan (row, tmp_buffer, buffer_width,
+                                    x0, x1, d, 1);
+              reference_blur_xspan (row, tmp_buffer, buffer_width,
+                                    x0, x1, d, -1);
+              reference_blur_xspan (row, tmp_buffer, buffer_width,
+                                    x0, x1, d + 1, 0);
+            }
+        }
+    }
+}
+
+static guchar *
+transpose_buffer (guchar *buffer,
+                  int     width,
+                  int     height)
+{
+  guchar *new_buffer;
+  int x, y;
+
+  new_buffer = g_malloc (width * height);
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        new_buffer[x * height + y] = buffer[y * width + x];
+    }
+
+  g_free (buffer);
+
+  return new_buffer;
+}
+
+static guchar *
+reference_blur_region (MtkRegion *region,
+                       int        radius,
+                       int        buffer_width,
+                       int        buffer_height)
+{
+  int d = get_box_filter_size (radius);
+  int spread = get_shadow_spread (radius);
+  g_autoptr (MtkRegion) row_convolve_region = NULL;
+  g_autoptr (MtkRegion) column_convolve_region = NULL;
+  guchar *buffer;
+  int n_rectangles, j, k;
+
+  buffer = g_malloc0 (buffer_width * buffer_height);
+
+  row_convolve_region = meta_make_border_region (region, spread, spread, FALSE);
+  column_convolve_region = meta_make_border_region (region, 0, spread, TRUE);
+
+  n_rectangles = mtk_region_num_rectangles (region);
+  for (k = 0; k < n_rectangles; k++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, k);
+
+      for (j = spread + rect.y; j < spread + rect.y + rect.height; j++)
+        memset (buffer + buffer_width * j + spread + rect.x, 255, rect.width);
+    }
+
+  buffer = transpose_buffer (buffer, buffer_width, buffer_height);
+  reference_blur_rows (column_convolve_region, spread, spread,
+                       buffer, buffer_height, d);
+  buffer = transpose_buffer (buffer, buffer_height, buffer_width);
+
+  reference_blur_rows (row_convolve_region, spread, spread,
+                       buffer, buffer_width, d);
+
+  return buffer;
+}
+
+static MtkRegion *
+create_test_region (void)
+{
+  MtkRegion *region;
+
+  /* A window with rounded top corners and a part sticking out at the
+   * bottom, so that the convolve regions consist of several rectangles */
+  region = mtk_region_create_rectangle (&MTK_RECTANGLE_INIT (4, 0, 232, 1));
+  mtk_region_union_rectangle (region, &MTK_RECTANGLE_INIT (2, 1, 236, 1));
+  mtk_region_union_rectangle (region, &MTK_RECTANGLE_INIT (1, 2, 238, 2));
+  mtk_region_union_rectangle (region, &MTK_RECTANGLE_INIT (0, 4, 240, 156));
+  mtk_region_union_rectangle (region, &MTK_RECTANGLE_INIT (60, 160, 50, 31));
+
+  return region;
+}
+
+static void
+meta_test_shadow_blur_reference (void)
+{
+  /* Both odd and even filter sizes, and sizes on either side of the
+   * largest one divided in fixed point */
+  int radii[] = { 1, 2, 3, 4, 5, 10, 12, 20, 40, 96, 97 };
+  g_autoptr (MtkRegion) region = NULL;
+  MtkRectangle extents;
+  int i;
+
+  region = create_test_region ();
+  extents = mtk_region_get_extents (region);
+
+  for (i = 0; i < G_N_ELEMENTS (radii); i++)
+    {
+      g_autofree guchar *buffer = NULL;
+      g_autofree guchar *reference = NULL;
+      int spread = get_shadow_spread (radii[i]);
+      int buffer_width, buffer_height;
+
+      g_test_message ("Blurring with radius %d", radii[i]);
+
+      buffer = meta_shadow_factory_blur_region (region, radii[i],
+                                                &buffer_width,
+                                                &buffer_height);
+      g_assert_cmpint (buffer_width, >=, extents.width + 2 * spread);
+      g_assert_cmpint (buffer_height, ==, extents.height + 2 * spread);
+
+      reference = reference_blur_region (region, radii[i],
+                                         buffer_width, buffer_height);
+      g_assert_cmpmem (buffer, buffer_width * buffer_height,
+                       reference, buffer_width * buffer_height);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/compositor/shadow/blur-reference",
+                   meta_test_shadow_blur_reference);
+
+  return g_test_run ();
+}
@@ -1013,6 +1013,37 @@ test_case_do (TestCase    *test,
           return FALSE;
         }
     }
+  else if (strcmp (argv[0], "assert_move_resize_queued") == 0)
+    {
+      MetaWindow *window;
+      gboolean expected;
+
+      if (argc != 3 || !str_to_bool (argv[2], &expected))
+        {
+          BAD_COMMAND("usage: %s <client-id>/<window-id> [true|false]",
+                      argv[0]);
+        }
+
+      MetaTestClient *client;
+      const char *window_id;
+      if (!test_case_parse_window_id (test, argv[1], &client, &window_id, error))
+        return FALSE;
+
+      window = meta_test_client_find_window (client, window_id, error);
+      if (!window)
+        return FALSE;
+
+      gboolean queued = meta_window_is_queued (window, META_QUEUE_MOVE_RESIZE);
+      if (queued != expected)
+        {
+          g_set_error (error,
+                       META_TEST_CLIENT_ERROR,
+                       META_TEST_CLIENT_ERROR_ASSERTION_FAILED,
+                       "Expected window %s to %sbe queued for move/resize",
+                       argv[1], expected ? "" : "not ");
+          return FALSE;
+        }
+    }
   else if (strcmp (argv[0], "stop_after_next") == 0 ||
            strcmp (argv[0], "continue") == 0)
     {
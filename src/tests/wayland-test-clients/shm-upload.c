@@ -0,0 +1,190 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+/* Large enough for the damage to be copied on a worker thread */
+#define BUFFER_SIZE 800
+#define DAMAGE_X 100
+#define DAMAGE_Y 100
+#define DAMAGE_SIZE 600
+
+typedef enum _State
+{
+  STATE_INIT = 0,
+  STATE_WAIT_FOR_CONFIGURE_1,
+  STATE_WAIT_FOR_FRAME_1,
+  STATE_WAIT_FOR_FRAME_2,
+} State;
+
+static WaylandDisplay *display;
+
+static struct wl_surface *surface;
+static struct xdg_surface *xdg_surface;
+static struct xdg_toplevel *xdg_toplevel;
+
+static struct wl_callback *frame_callback;
+
+static gboolean running;
+
+static State state;
+
+static void
+init_surface (void)
+{
+  xdg_toplevel_set_title (xdg_toplevel, "shm-upload-test");
+  wl_surface_commit (surface);
+}
+
+static void
+draw_main (void)
+{
+  draw_surface (display, surface, BUFFER_SIZE, BUFFER_SIZE, 0xffff0000);
+  wl_surface_damage_buffer (surface, 0, 0, BUFFER_SIZE, BUFFER_SIZE);
+}
+
+static void
+draw_damage (void)
+{
+  /* The whole new buffer is blue, but only the damaged part of it should
+   * end up in the texture reused from the previous buffer. */
+  draw_surface (display, surface, BUFFER_SIZE, BUFFER_SIZE, 0xff0000ff);
+  wl_surface_damage_buffer (surface,
+                            DAMAGE_X, DAMAGE_Y,
+                            DAMAGE_SIZE, DAMAGE_SIZE);
+}
+
+static const struct wl_callback_listener frame_listener;
+
+static void
+handle_frame_callback (void               *data,
+                       struct wl_callback *callback,
+                       uint32_t            time)
+{
+  wl_callback_destroy (callback);
+
+  switch (state)
+    {
+    case STATE_WAIT_FOR_FRAME_1:
+      draw_damage ();
+      state = STATE_WAIT_FOR_FRAME_2;
+      frame_callback = wl_surface_frame (surface);
+      wl_callback_add_listener (frame_callback, &frame_listener, NULL);
+      wl_surface_commit (surface);
+      wl_display_flush (display->display);
+      break;
+    case STATE_WAIT_FOR_FRAME_2:
+      test_driver_sync_point (display->test_driver, 0, NULL);
+      break;
+    case STATE_INIT:
+    case STATE_WAIT_FOR_CONFIGURE_1:
+      g_assert_not_reached ();
+    }
+}
+
+static const struct wl_callback_listener frame_listener = {
+  handle_frame_callback,
+};
+
+static void
+handle_xdg_toplevel_configure (void                *data,
+                               struct xdg_toplevel *xdg_toplevel,
+                               int32_t              width,
+                               int32_t              height,
+                               struct wl_array     *state)
+{
+}
+
+static void
+handle_xdg_toplevel_close (void                *data,
+                           struct xdg_toplevel *xdg_toplevel)
+{
+  g_assert_not_reached ();
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+  handle_xdg_toplevel_configure,
+  handle_xdg_toplevel_close,
+};
+
+static void
+handle_xdg_surface_configure (void               *data,
+                              struct xdg_surface *xdg_surface,
+                              uint32_t            serial)
+{
+  switch (state)
+    {
+    case STATE_INIT:
+      g_assert_not_reached ();
+    case STATE_WAIT_FOR_CONFIGURE_1:
+      draw_main ();
+      state = STATE_WAIT_FOR_FRAME_1;
+      break;
+    case STATE_WAIT_FOR_FRAME_1:
+    case STATE_WAIT_FOR_FRAME_2:
+      /* ignore */
+      return;
+    }
+
+  xdg_surface_ack_configure (xdg_surface, serial);
+  frame_callback = wl_surface_frame (surface);
+  wl_callback_add_listener (frame_callback, &frame_listener, NULL);
+  wl_surface_commit (surface);
+  wl_display_flush (display->display);
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+  handle_xdg_surface_configure,
+};
+
+static void
+on_sync_event (WaylandDisplay *display,
+               uint32_t        serial)
+{
+  g_assert (serial == 0);
+
+  exit (EXIT_SUCCESS);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  g_signal_connect (display, "sync-event", G_CALLBACK (on_sync_event), NULL);
+
+  surface = wl_compositor_create_surface (display->compositor);
+  xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base, surface);
+  xdg_surface_add_listener (xdg_surface, &xdg_surface_listener, NULL);
+  xdg_toplevel = xdg_surface_get_toplevel (xdg_surface);
+  xdg_toplevel_add_listener (xdg_toplevel, &xdg_toplevel_listener, NULL);
+
+  init_surface ();
+  state = STATE_WAIT_FOR_CONFIGURE_1;
+
+  running = TRUE;
+  while (running)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
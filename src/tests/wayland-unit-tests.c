@@ -19,12 +19,14 @@
 
 #include <gio/gio.h>
 
+#include "backends/meta-settings-private.h"
 #include "backends/meta-virtual-monitor.h"
 #include "compositor/meta-window-actor-private.h"
 #include "core/display-private.h"
 #include "core/window-private.h"
 #include "meta-test/meta-context-test.h"
 #include "meta/meta-later.h"
+#include "meta/meta-multi-texture.h"
 #include "meta/meta-workspace-manager.h"
 #include "tests/meta-test-utils.h"
 #include "tests/meta-wayland-test-driver.h"
@@ -77,6 +79,74 @@ single_pixel_buffer (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static uint32_t
+get_texture_pixel (CoglTexture *texture,
+                   int          x,
+                   int          y)
+{
+  int width = cogl_texture_get_width (texture);
+  int height = cogl_texture_get_height (texture);
+  g_autofree uint32_t *pixels = NULL;
+
+  pixels = g_new0 (uint32_t, width * height);
+  cogl_texture_get_data (texture,
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+                         COGL_PIXEL_FORMAT_BGRA_8888_PRE,
+#else
+                         COGL_PIXEL_FORMAT_ARGB_8888_PRE,
+#endif
+                         width * sizeof (uint32_t),
+                         (uint8_t *) pixels);
+
+  return pixels[y * width + x];
+}
+
+static void
+shm_async_upload (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+  MetaWaylandTestClient *wayland_test_client;
+  MetaWindow *window;
+  MetaWaylandSurface *surface;
+  CoglTexture *texture;
+
+  meta_settings_enable_experimental_feature (
+    settings,
+    META_EXPERIMENTAL_FEATURE_ASYNC_SHM_UPLOAD);
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "shm-upload");
+
+  wait_for_sync_point (0);
+
+  window = find_client_window ("shm-upload-test");
+  g_assert_nonnull (window);
+  surface = meta_window_get_wayland_surface (window);
+  texture =
+    meta_multi_texture_get_plane (meta_wayland_surface_get_texture (surface),
+                                  0);
+  g_assert_cmpint (cogl_texture_get_width (texture), ==, 800);
+  g_assert_cmpint (cogl_texture_get_height (texture), ==, 800);
+
+  /* Inside the damage copied by the worker thread */
+  g_assert_cmphex (get_texture_pixel (texture, 100, 100), ==, 0xff0000ff);
+  g_assert_cmphex (get_texture_pixel (texture, 699, 699), ==, 0xff0000ff);
+  g_assert_cmphex (get_texture_pixel (texture, 400, 400), ==, 0xff0000ff);
+
+  /* Outside of it, the previous buffer content is retained */
+  g_assert_cmphex (get_texture_pixel (texture, 99, 99), ==, 0xffff0000);
+  g_assert_cmphex (get_texture_pixel (texture, 700, 700), ==, 0xffff0000);
+  g_assert_cmphex (get_texture_pixel (texture, 400, 50), ==, 0xffff0000);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  meta_settings_disable_experimental_feature (
+    settings,
+    META_EXPERIMENTAL_FEATURE_ASYNC_SHM_UPLOAD);
+}
+
 static void
 subsurface_corner_cases (void)
 {
@@ -855,6 +925,8 @@ init_tests (void)
                    buffer_transform);
   g_test_add_func ("/wayland/buffer/single_pixel_buffer",
                    single_pixel_buffer);
+  g_test_add_func ("/wayland/buffer/shm-async-upload",
+                   shm_async_upload);
   g_test_add_func ("/wayland/subsurface/remap-toplevel",
                    subsurface_remap_toplevel);
   g_test_add_func ("/wayland/subsurface/reparent",
@@ -51,11 +51,13 @@
 #include <drm_fourcc.h>
 
 #include "backends/meta-backend-private.h"
+#include "backends/meta-settings-private.h"
 #include "clutter/clutter.h"
 #include "cogl/cogl-egl.h"
 #include "meta/util.h"
 #include "wayland/meta-wayland-dma-buf.h"
 #include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-shm-upload.h"
 
 #ifdef HAVE_NATIVE_BACKEND
 #include "backends/native/meta-drm-buffer-gbm.h"
@@ -75,6 +77,19 @@ guint signals[LAST_SIGNAL];
 
 G_DEFINE_TYPE (MetaWaylandBuffer, meta_wayland_buffer, G_TYPE_OBJECT);
 
+static void
+clear_shm_copy (MetaWaylandBuffer *buffer)
+{
+  if (!buffer->shm.copy)
+    return;
+
+  /* The client may reuse or free the shm buffer once it is no longer in use
+   * by us, so any worker still reading from it must be done first.
+   */
+  meta_wayland_shm_copy_wait (buffer->shm.copy);
+  g_clear_pointer (&buffer->shm.copy, meta_wayland_shm_copy_unref);
+}
+
 static void
 meta_wayland_buffer_destroy_handler (struct wl_listener *listener,
                                      void               *data)
@@ -82,6 +97,8 @@ meta_wayland_buffer_destroy_handler (struct wl_listener *listener,
   MetaWaylandBuffer *buffer =
     wl_container_of (listener, buffer, destroy_listener);
 
+  clear_shm_copy (buffer);
+
   buffer->resource = NULL;
   wl_list_remove (&buffer->destroy_listener.link);
   g_signal_emit (buffer, signals[RESOURCE_DESTROYED], 0);
@@ -662,6 +679,9 @@ meta_wayland_buffer_dec_use_count (MetaWaylandBuffer *buffer)
 
   buffer->use_count--;
 
+  if (buffer->use_count == 0)
+    clear_shm_copy (buffer);
+
   if (buffer->use_count == 0 && buffer->resource)
     wl_buffer_send_release (buffer->resource);
 }
@@ -678,49 +698,39 @@ process_shm_buffer_damage (MetaWaylandBuffer *buffer,
                            MtkRegion         *region,
                            GError           **error)
 {
+  g_autoptr (MetaWaylandShmCopy) copy = NULL;
+  MetaWaylandShmUploader *shm_uploader;
   struct wl_shm_buffer *shm_buffer;
-  int i, n_rectangles;
-  gboolean set_texture_failed = FALSE;
+  gboolean set_texture_succeeded;
   CoglPixelFormat format;
   CoglTexture *cogl_texture;
 
-  n_rectangles = mtk_region_num_rectangles (region);
-
   shm_buffer = wl_shm_buffer_get (buffer->resource);
 
   shm_buffer_get_cogl_pixel_format (buffer, shm_buffer, &format);
   g_return_val_if_fail (cogl_pixel_format_get_n_planes (format) == 1, FALSE);
   cogl_texture = meta_multi_texture_get_plane (texture, 0);
 
-  wl_shm_buffer_begin_access (shm_buffer);
+  copy = g_steal_pointer (&buffer->shm.copy);
+  if (copy && meta_wayland_shm_copy_covers (copy, region))
+    return meta_wayland_shm_copy_upload (copy, cogl_texture, error);
 
-  for (i = 0; i < n_rectangles; i++)
-    {
-      const uint8_t *data = wl_shm_buffer_get_data (shm_buffer);
-      int32_t stride = wl_shm_buffer_get_stride (shm_buffer);
-      MtkRectangle rect;
-      int bpp;
+  shm_uploader = meta_wayland_compositor_get_shm_uploader (buffer->compositor);
 
-      bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
-      rect = mtk_region_get_rectangle (region, i);
+  wl_shm_buffer_begin_access (shm_buffer);
 
-      if (!_cogl_texture_set_region (cogl_texture,
-                                     rect.width, rect.height,
-                                     format,
-                                     stride,
-                                     data + rect.x * bpp + rect.y * stride,
-                                     rect.x, rect.y,
-                                     0,
-                                     error))
-        {
-          set_texture_failed = TRUE;
-          break;
-        }
-    }
+  set_texture_succeeded =
+    meta_wayland_shm_uploader_upload (shm_uploader,
+                                      cogl_texture,
+                                      format,
+                                      wl_shm_buffer_get_data (shm_buffer),
+                                      wl_shm_buffer_get_stride (shm_buffer),
+                                      region,
+                                      error);
 
   wl_shm_buffer_end_access (shm_buffer);
 
-  return !set_texture_failed;
+  return set_texture_succeeded;
 }
 
 void
@@ -761,6 +771,114 @@ meta_wayland_buffer_process_damage (MetaWaylandBuffer *buffer,
     }
 }
 
+typedef struct
+{
+  MetaWaylandBuffer *buffer;
+  MetaWaylandBufferSourceDispatch dispatch;
+  gpointer user_data;
+  gboolean dispatched;
+} ShmCopySourceClosure;
+
+static gboolean
+shm_copy_source_cb (gpointer user_data)
+{
+  ShmCopySourceClosure *closure = user_data;
+
+  closure->dispatched = TRUE;
+  closure->dispatch (closure->buffer, closure->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+shm_copy_source_closure_free (ShmCopySourceClosure *closure)
+{
+  /* A copy nobody waited for is not going to be applied. */
+  if (!closure->dispatched)
+    clear_shm_copy (closure->buffer);
+
+  g_object_unref (closure->buffer);
+  g_free (closure);
+}
+
+/**
+ * meta_wayland_buffer_create_shm_copy_source:
+ * @buffer: A #MetaWaylandBuffer object
+ * @region: The damaged region in buffer coordinates
+ * @dispatch: Callback
+ * @user_data: User data for the callback
+ *
+ * If enabled, starts copying the damaged region of a shm buffer on a worker
+ * thread, and creates a GSource which will call the specified dispatch
+ * callback when the copy is ready to be uploaded. The copy is used by the
+ * next meta_wayland_buffer_process_damage() covered by it.
+ *
+ * Returns: The new GSource (or %NULL if @buffer is not a shm buffer, or the
+ * damage is not worth copying asynchronously)
+ */
+GSource *
+meta_wayland_buffer_create_shm_copy_source (MetaWaylandBuffer               *buffer,
+                                            const MtkRegion                 *region,
+                                            MetaWaylandBufferSourceDispatch  dispatch,
+                                            gpointer                         user_data)
+{
+  MetaContext *context =
+    meta_wayland_compositor_get_context (buffer->compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+  g_autoptr (MtkRegion) buffer_region = NULL;
+  MetaWaylandShmUploader *shm_uploader;
+  struct wl_shm_buffer *shm_buffer;
+  ShmCopySourceClosure *closure;
+  CoglPixelFormat format;
+  MtkRectangle buffer_rect;
+  GSource *source;
+
+  if (buffer->type != META_WAYLAND_BUFFER_TYPE_SHM || !buffer->resource)
+    return NULL;
+
+  if (buffer->shm.copy)
+    return NULL;
+
+  if (!meta_settings_is_experimental_feature_enabled (settings,
+                                                      META_EXPERIMENTAL_FEATURE_ASYNC_SHM_UPLOAD))
+    return NULL;
+
+  shm_buffer = wl_shm_buffer_get (buffer->resource);
+  if (!shm_buffer_get_cogl_pixel_format (buffer, shm_buffer, &format) ||
+      cogl_pixel_format_get_n_planes (format) != 1)
+    return NULL;
+
+  buffer_rect = (MtkRectangle) {
+    .width = wl_shm_buffer_get_width (shm_buffer),
+    .height = wl_shm_buffer_get_height (shm_buffer),
+  };
+
+  buffer_region = mtk_region_copy (region);
+  mtk_region_intersect_rectangle (buffer_region, &buffer_rect);
+
+  shm_uploader = meta_wayland_compositor_get_shm_uploader (buffer->compositor);
+  buffer->shm.copy = meta_wayland_shm_uploader_copy_async (shm_uploader,
+                                                           shm_buffer,
+                                                           format,
+                                                           buffer_region);
+  if (!buffer->shm.copy)
+    return NULL;
+
+  closure = g_new0 (ShmCopySourceClosure, 1);
+  closure->buffer = g_object_ref (buffer);
+  closure->dispatch = dispatch;
+  closure->user_data = user_data;
+
+  source = meta_wayland_shm_copy_create_source (buffer->shm.copy);
+  g_source_set_callback (source,
+                         shm_copy_source_cb,
+                         closure,
+                         (GDestroyNotify) shm_copy_source_closure_free);
+
+  return source;
+}
+
 static CoglScanout *
 try_acquire_egl_image_scanout (MetaWaylandBuffer *buffer,
                                CoglOnscreen      *onscreen)
@@ -863,6 +981,47 @@ meta_wayland_buffer_try_acquire_scanout (MetaWaylandBuffer *buffer,
   return scanout;
 }
 
+CoglScanout *
+meta_wayland_buffer_try_acquire_overlay_scanout (MetaWaylandBuffer     *buffer,
+                                                 CoglOnscreen          *onscreen,
+                                                 const graphene_rect_t *src_rect,
+                                                 const MtkRectangle    *dst_rect)
+{
+  MetaWaylandDmaBufBuffer *dma_buf;
+  CoglScanout *scanout;
+
+  COGL_TRACE_BEGIN_SCOPED (MetaWaylandBufferTryOverlayScanout,
+                           "WaylandBuffer (try overlay scanout)");
+
+  if (buffer->tainted_scanout_onscreens &&
+      g_hash_table_lookup (buffer->tainted_scanout_onscreens, onscreen))
+    {
+      meta_topic (META_DEBUG_RENDER, "Buffer scanout capability tainted");
+      return NULL;
+    }
+
+  if (buffer->type != META_WAYLAND_BUFFER_TYPE_DMA_BUF)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "Buffer type not overlay scanout compatible");
+      return NULL;
+    }
+
+  dma_buf = meta_wayland_dma_buf_from_buffer (buffer);
+  if (!dma_buf)
+    return NULL;
+
+  scanout = meta_wayland_dma_buf_try_acquire_overlay_scanout (dma_buf,
+                                                              onscreen,
+                                                              src_rect,
+                                                              dst_rect);
+  if (scanout)
+    g_signal_connect (scanout, "scanout-failed",
+                      G_CALLBACK (on_scanout_failed), buffer);
+
+  return scanout;
+}
+
 static void
 meta_wayland_buffer_finalize (GObject *object)
 {
@@ -873,6 +1032,7 @@ meta_wayland_buffer_finalize (GObject *object)
   clear_tainted_scanout_onscreens (buffer);
   g_clear_pointer (&buffer->tainted_scanout_onscreens, g_hash_table_unref);
 
+  g_clear_pointer (&buffer->shm.copy, meta_wayland_shm_copy_unref);
   g_clear_object (&buffer->egl_image.texture);
 #ifdef HAVE_WAYLAND_EGLSTREAM
   g_clear_object (&buffer->egl_stream.texture);
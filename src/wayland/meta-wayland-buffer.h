@@ -29,6 +29,7 @@
 #include "wayland/meta-wayland-types.h"
 #include "wayland/meta-wayland-egl-stream.h"
 #include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-shm-upload.h"
 #include "wayland/meta-wayland-single-pixel-buffer.h"
 
 typedef enum _MetaWaylandBufferType
@@ -57,6 +58,10 @@ struct _MetaWaylandBuffer
 
   MetaWaylandBufferType type;
 
+  struct {
+    MetaWaylandShmCopy *copy;
+  } shm;
+
   struct {
     MetaMultiTexture *texture;
   } egl_image;
@@ -81,6 +86,9 @@ struct _MetaWaylandBuffer
   GHashTable *tainted_scanout_onscreens;
 };
 
+typedef void (*MetaWaylandBufferSourceDispatch) (MetaWaylandBuffer *buffer,
+                                                 gpointer           user_data);
+
 #define META_TYPE_WAYLAND_BUFFER (meta_wayland_buffer_get_type ())
 G_DECLARE_FINAL_TYPE (MetaWaylandBuffer, meta_wayland_buffer,
                       META, WAYLAND_BUFFER, GObject);
@@ -100,7 +108,15 @@ gboolean                meta_wayland_buffer_is_y_inverted       (MetaWaylandBuff
 void                    meta_wayland_buffer_process_damage      (MetaWaylandBuffer     *buffer,
                                                                  MetaMultiTexture      *texture,
                                                                  MtkRegion             *region);
+GSource *               meta_wayland_buffer_create_shm_copy_source (MetaWaylandBuffer               *buffer,
+                                                                    const MtkRegion                 *region,
+                                                                    MetaWaylandBufferSourceDispatch  dispatch,
+                                                                    gpointer                         user_data);
 CoglScanout *           meta_wayland_buffer_try_acquire_scanout (MetaWaylandBuffer     *buffer,
                                                                  CoglOnscreen          *onscreen);
+CoglScanout *           meta_wayland_buffer_try_acquire_overlay_scanout (MetaWaylandBuffer     *buffer,
+                                                                         CoglOnscreen          *onscreen,
+                                                                         const graphene_rect_t *src_rect,
+                                                                         const MtkRectangle    *dst_rect);
 
 void meta_wayland_init_shm (MetaWaylandCompositor *compositor);
@@ -137,6 +137,14 @@ struct _MetaWaylandDmaBufBuffer
   int fds[META_WAYLAND_DMA_BUF_MAX_FDS];
   uint32_t offsets[META_WAYLAND_DMA_BUF_MAX_FDS];
   uint32_t strides[META_WAYLAND_DMA_BUF_MAX_FDS];
+
+  /* Result of the last overlay plane TEST_ONLY commit */
+  struct {
+    CoglOnscreen *onscreen;
+    graphene_rect_t src_rect;
+    MtkRectangle dst_rect;
+    gboolean is_compatible;
+  } overlay_test;
 };
 
 G_DEFINE_TYPE (MetaWaylandDmaBufBuffer, meta_wayland_dma_buf_buffer, G_TYPE_OBJECT);
@@ -604,11 +612,10 @@ import_scanout_gbm_bo (MetaWaylandDmaBufBuffer  *dma_buf,
 }
 #endif
 
-CoglScanout *
-meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
-                                          CoglOnscreen            *onscreen)
-{
 #ifdef HAVE_NATIVE_BACKEND
+static MetaDrmBufferGbm *
+import_scanout_fb (MetaWaylandDmaBufBuffer *dma_buf)
+{
   MetaContext *context =
     meta_wayland_compositor_get_context (dma_buf->manager->compositor);
   MetaBackend *backend = meta_context_get_backend (context);
@@ -621,7 +628,7 @@ meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
   gboolean use_modifier;
   g_autoptr (GError) error = NULL;
   MetaDrmBufferFlags flags;
-  g_autoptr (MetaDrmBufferGbm) fb = NULL;
+  MetaDrmBufferGbm *fb;
 
   for (n_planes = 0; n_planes < META_WAYLAND_DMA_BUF_MAX_FDS; n_planes++)
     {
@@ -653,6 +660,21 @@ meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
       return NULL;
     }
 
+  return fb;
+}
+#endif
+
+CoglScanout *
+meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
+                                          CoglOnscreen            *onscreen)
+{
+#ifdef HAVE_NATIVE_BACKEND
+  g_autoptr (MetaDrmBufferGbm) fb = NULL;
+
+  fb = import_scanout_fb (dma_buf);
+  if (!fb)
+    return NULL;
+
   if (!meta_onscreen_native_is_buffer_scanout_compatible (onscreen,
                                                           META_DRM_BUFFER (fb)))
     {
@@ -667,6 +689,60 @@ meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
 #endif
 }
 
+CoglScanout *
+meta_wayland_dma_buf_try_acquire_overlay_scanout (MetaWaylandDmaBufBuffer *dma_buf,
+                                                  CoglOnscreen            *onscreen,
+                                                  const graphene_rect_t   *src_rect,
+                                                  const MtkRectangle      *dst_rect)
+{
+#ifdef HAVE_NATIVE_BACKEND
+  g_autoptr (MetaDrmBufferGbm) fb = NULL;
+  gboolean has_test_result;
+
+  /* Clients cycle through a small set of buffers with the same geometry,
+   * so avoid a synchronous TEST_ONLY commit for each of their frames. */
+  has_test_result =
+    dma_buf->overlay_test.onscreen == onscreen &&
+    graphene_rect_equal (&dma_buf->overlay_test.src_rect, src_rect) &&
+    mtk_rectangle_equal (&dma_buf->overlay_test.dst_rect, dst_rect);
+
+  if (has_test_result && !dma_buf->overlay_test.is_compatible)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "Buffer not overlay scanout compatible (cached)");
+      return NULL;
+    }
+
+  fb = import_scanout_fb (dma_buf);
+  if (!fb)
+    return NULL;
+
+  if (!has_test_result)
+    {
+      g_set_weak_pointer (&dma_buf->overlay_test.onscreen, onscreen);
+      dma_buf->overlay_test.src_rect = *src_rect;
+      dma_buf->overlay_test.dst_rect = *dst_rect;
+      dma_buf->overlay_test.is_compatible =
+        meta_onscreen_native_is_buffer_overlay_compatible (onscreen,
+                                                           META_DRM_BUFFER (fb),
+                                                           src_rect,
+                                                           dst_rect);
+    }
+
+  if (!dma_buf->overlay_test.is_compatible)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "Buffer not overlay scanout compatible (see also KMS debug "
+                  "topic)");
+      return NULL;
+    }
+
+  return COGL_SCANOUT (g_steal_pointer (&fb));
+#else
+  return NULL;
+#endif
+}
+
 static void
 buffer_params_add (struct wl_client   *client,
                    struct wl_resource *resource,
@@ -1841,6 +1917,8 @@ meta_wayland_dma_buf_buffer_finalize (GObject *object)
   for (i = 0; i < META_WAYLAND_DMA_BUF_MAX_FDS; i++)
     g_clear_fd (&dma_buf->fds[i], NULL);
 
+  g_clear_weak_pointer (&dma_buf->overlay_test.onscreen);
+
   G_OBJECT_CLASS (meta_wayland_dma_buf_buffer_parent_class)->finalize (object);
 }
 
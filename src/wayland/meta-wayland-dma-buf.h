@@ -66,3 +66,9 @@ meta_wayland_dma_buf_create_source (MetaWaylandBuffer               *buffer,
 CoglScanout *
 meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
                                           CoglOnscreen            *onscreen);
+
+CoglScanout *
+meta_wayland_dma_buf_try_acquire_overlay_scanout (MetaWaylandDmaBufBuffer *dma_buf,
+                                                  CoglOnscreen            *onscreen,
+                                                  const graphene_rect_t   *src_rect,
+                                                  const MtkRectangle      *dst_rect);
@@ -32,8 +32,16 @@ typedef struct _MetaWaylandPresentationFeedback
   struct wl_resource *resource;
 
   MetaWaylandSurface *surface;
+
+  /* For tracing input latency, if input was sent to the surface before the
+   * commit this feedback is for. Otherwise 0. */
+  int64_t input_time_us;
+  int64_t input_sent_time_us;
+  int64_t commit_time_us;
 } MetaWaylandPresentationFeedback;
 
+typedef struct _MetaWaylandInputLatency MetaWaylandInputLatency;
+
 typedef struct _MetaWaylandPresentationTime
 {
   GList *feedback_surfaces;
@@ -44,6 +52,8 @@ typedef struct _MetaWaylandPresentationTime
    * that are scheduled to be presented.
    */
   GHashTable *feedbacks;
+
+  MetaWaylandInputLatency *input_latency;
 } MetaWaylandPresentationTime;
 
 void meta_wayland_presentation_time_finalize (MetaWaylandCompositor *compositor);
@@ -59,6 +69,12 @@ void meta_wayland_presentation_feedback_present (MetaWaylandPresentationFeedback
 struct wl_list * meta_wayland_presentation_time_ensure_feedbacks (MetaWaylandPresentationTime *presentation_time,
                                                                   ClutterStageView            *stage_view);
 
+void meta_wayland_presentation_time_input_sent (MetaWaylandSurface *surface,
+                                               const ClutterEvent *event);
+
+void meta_wayland_presentation_time_surface_committed (MetaWaylandSurface      *surface,
+                                                       MetaWaylandSurfaceState *pending);
+
 void meta_wayland_presentation_time_cursor_painted (MetaWaylandPresentationTime *presentation_time,
                                                     ClutterStageView            *stage_view,
                                                     MetaWaylandCursorSurface    *cursor_surface);
@@ -21,8 +21,11 @@
 #include "config.h"
 
 #include <glib.h>
+#include <string.h>
 
+#include "cogl/cogl.h"
 #include "compositor/meta-surface-actor-wayland.h"
+#include "core/util-private.h"
 #include "wayland/meta-wayland-cursor-surface.h"
 #include "wayland/meta-wayland-presentation-time-private.h"
 #include "wayland/meta-wayland-private.h"
@@ -32,6 +35,58 @@
 
 #include "presentation-time-server-protocol.h"
 
+#define INPUT_LATENCY_N_SAMPLES 128
+#define INPUT_LATENCY_REPORT_INTERVAL_US (G_USEC_PER_SEC)
+/* Input not followed by a commit within this time most likely didn't cause
+ * the client to redraw at all */
+#define INPUT_LATENCY_MAX_US (G_USEC_PER_SEC)
+
+typedef enum _InputLatencyStage
+{
+  /* From the kernel to the client */
+  INPUT_LATENCY_STAGE_COMPOSITOR,
+  /* From the client receiving the input to it committing a new buffer */
+  INPUT_LATENCY_STAGE_CLIENT,
+  /* From the commit to the buffer being on screen */
+  INPUT_LATENCY_STAGE_OUTPUT,
+  INPUT_LATENCY_STAGE_TOTAL,
+
+  N_INPUT_LATENCY_STAGES
+} InputLatencyStage;
+
+struct _MetaWaylandInputLatency
+{
+  /* Ring of the most recent samples for each stage */
+  int64_t samples[N_INPUT_LATENCY_STAGES][INPUT_LATENCY_N_SAMPLES];
+  int n_samples;
+  int next_sample;
+
+  int64_t last_report_time_us;
+};
+
+#ifdef COGL_HAS_TRACING
+static const int input_latency_percentiles[] = { 50, 99 };
+
+static const CoglTraceCounter input_latency_counters[N_INPUT_LATENCY_STAGES][2] = {
+  [INPUT_LATENCY_STAGE_COMPOSITOR] = {
+    { "Input latency", "Compositor p50 (us)", "Input event until sent to the client" },
+    { "Input latency", "Compositor p99 (us)", "Input event until sent to the client" },
+  },
+  [INPUT_LATENCY_STAGE_CLIENT] = {
+    { "Input latency", "Client p50 (us)", "Input sent to the client until committed" },
+    { "Input latency", "Client p99 (us)", "Input sent to the client until committed" },
+  },
+  [INPUT_LATENCY_STAGE_OUTPUT] = {
+    { "Input latency", "Output p50 (us)", "Client commit until presented" },
+    { "Input latency", "Output p99 (us)", "Client commit until presented" },
+  },
+  [INPUT_LATENCY_STAGE_TOTAL] = {
+    { "Input latency", "Total p50 (us)", "Input event until presented" },
+    { "Input latency", "Total p99 (us)", "Input event until presented" },
+  },
+};
+#endif
+
 static void
 wp_presentation_feedback_destructor (struct wl_resource *resource)
 {
@@ -214,6 +269,7 @@ meta_wayland_presentation_time_finalize (MetaWaylandCompositor *compositor)
     meta_backend_get_monitor_manager (backend);
 
   g_hash_table_destroy (compositor->presentation_time.feedbacks);
+  g_clear_pointer (&compositor->presentation_time.input_latency, g_free);
 
   g_signal_handlers_disconnect_by_func (monitor_manager, on_monitors_changed,
                                         compositor);
@@ -232,6 +288,8 @@ meta_wayland_init_presentation_time (MetaWaylandCompositor *compositor)
 
   compositor->presentation_time.feedbacks =
     g_hash_table_new_full (NULL, NULL, NULL, destroy_feedback_list);
+  compositor->presentation_time.input_latency =
+    g_new0 (MetaWaylandInputLatency, 1);
 
   g_signal_connect (monitor_manager, "monitors-changed-internal",
                     G_CALLBACK (on_monitors_changed), compositor);
@@ -310,6 +368,77 @@ invalid_sequence:
   surface->presentation_time.is_last_output_sequence_valid = FALSE;
 }
 
+static void
+report_input_latency (MetaWaylandInputLatency *input_latency)
+{
+#ifdef COGL_HAS_TRACING
+  int64_t sorted[INPUT_LATENCY_N_SAMPLES];
+  int n_samples = input_latency->n_samples;
+  int stage;
+  size_t i;
+
+  if (!cogl_is_tracing_enabled ())
+    return;
+
+  for (stage = 0; stage < N_INPUT_LATENCY_STAGES; stage++)
+    {
+      memcpy (sorted, input_latency->samples[stage],
+              n_samples * sizeof (int64_t));
+
+      for (i = 0; i < G_N_ELEMENTS (input_latency_percentiles); i++)
+        {
+          int64_t value;
+
+          value =
+            meta_sort_samples_get_percentile (sorted, n_samples,
+                                              input_latency_percentiles[i]);
+          cogl_trace_set_counter (&input_latency_counters[stage][i], value);
+        }
+    }
+#endif
+}
+
+static void
+record_input_latency (MetaWaylandPresentationTime     *presentation_time,
+                      MetaWaylandPresentationFeedback *feedback,
+                      int64_t                          presentation_time_us)
+{
+  MetaWaylandInputLatency *input_latency = presentation_time->input_latency;
+  int64_t now_us;
+  int i;
+
+  /* Presentation time is not always known */
+  if (presentation_time_us < feedback->commit_time_us)
+    return;
+
+  COGL_TRACE_MARK ("Input (to presentation)",
+                   feedback->input_time_us,
+                   presentation_time_us,
+                   NULL);
+
+  i = input_latency->next_sample;
+  input_latency->samples[INPUT_LATENCY_STAGE_COMPOSITOR][i] =
+    feedback->input_sent_time_us - feedback->input_time_us;
+  input_latency->samples[INPUT_LATENCY_STAGE_CLIENT][i] =
+    feedback->commit_time_us - feedback->input_sent_time_us;
+  input_latency->samples[INPUT_LATENCY_STAGE_OUTPUT][i] =
+    presentation_time_us - feedback->commit_time_us;
+  input_latency->samples[INPUT_LATENCY_STAGE_TOTAL][i] =
+    presentation_time_us - feedback->input_time_us;
+
+  input_latency->next_sample = (i + 1) % INPUT_LATENCY_N_SAMPLES;
+  input_latency->n_samples = MIN (input_latency->n_samples + 1,
+                                  INPUT_LATENCY_N_SAMPLES);
+
+  now_us = g_get_monotonic_time ();
+  if (now_us - input_latency->last_report_time_us <
+      INPUT_LATENCY_REPORT_INTERVAL_US)
+    return;
+
+  input_latency->last_report_time_us = now_us;
+  report_input_latency (input_latency);
+}
+
 void
 meta_wayland_presentation_feedback_present (MetaWaylandPresentationFeedback *feedback,
                                             ClutterFrameInfo                *frame_info,
@@ -375,6 +504,12 @@ meta_wayland_presentation_feedback_present (MetaWaylandPresentationFeedback *fee
                                            seq_lo,
                                            flags);
 
+  if (feedback->input_time_us)
+    {
+      record_input_latency (&surface->compositor->presentation_time,
+                            feedback, time_us);
+    }
+
   wl_resource_destroy (feedback->resource);
 }
 
@@ -396,6 +531,71 @@ meta_wayland_presentation_time_ensure_feedbacks (MetaWaylandPresentationTime *pr
   return g_hash_table_lookup (presentation_time->feedbacks, stage_view);
 }
 
+/*
+ * Notes that @event was sent to the client of @surface, for tracing the time
+ * until the client presents its response to it.
+ */
+void
+meta_wayland_presentation_time_input_sent (MetaWaylandSurface *surface,
+                                           const ClutterEvent *event)
+{
+  MetaWaylandSurface *toplevel;
+  int64_t input_time_us;
+  int64_t now_us;
+
+  if (clutter_event_get_flags (event) & CLUTTER_EVENT_FLAG_SYNTHETIC)
+    return;
+
+  input_time_us = clutter_event_get_time_us (event);
+  if (input_time_us <= 0)
+    return;
+
+  /* Clients usually respond to input by redrawing their main surface */
+  toplevel = meta_wayland_surface_get_toplevel (surface);
+  if (!toplevel)
+    toplevel = surface;
+
+  now_us = g_get_monotonic_time ();
+
+  /* Only the oldest input the client didn't respond to yet matters */
+  if (toplevel->presentation_time.input_time_us &&
+      now_us - toplevel->presentation_time.input_sent_time_us <
+      INPUT_LATENCY_MAX_US)
+    return;
+
+  toplevel->presentation_time.input_time_us = input_time_us;
+  toplevel->presentation_time.input_sent_time_us = now_us;
+}
+
+void
+meta_wayland_presentation_time_surface_committed (MetaWaylandSurface      *surface,
+                                                  MetaWaylandSurfaceState *pending)
+{
+  MetaWaylandPresentationFeedback *feedback;
+  int64_t input_time_us = surface->presentation_time.input_time_us;
+  int64_t input_sent_time_us = surface->presentation_time.input_sent_time_us;
+  int64_t now_us;
+
+  if (!input_time_us || !pending->newly_attached)
+    return;
+
+  surface->presentation_time.input_time_us = 0;
+  surface->presentation_time.input_sent_time_us = 0;
+
+  now_us = g_get_monotonic_time ();
+  if (now_us - input_sent_time_us >= INPUT_LATENCY_MAX_US)
+    return;
+
+  COGL_TRACE_MARK ("Input (to client commit)", input_time_us, now_us, NULL);
+
+  wl_list_for_each (feedback, &pending->presentation_feedback_list, link)
+    {
+      feedback->input_time_us = input_time_us;
+      feedback->input_sent_time_us = input_sent_time_us;
+      feedback->commit_time_us = now_us;
+    }
+}
+
 void
 meta_wayland_presentation_time_cursor_painted (MetaWaylandPresentationTime *presentation_time,
                                                ClutterStageView            *stage_view,
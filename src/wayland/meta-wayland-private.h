@@ -27,6 +27,7 @@
 #include "wayland/meta-wayland-pointer-gestures.h"
 #include "wayland/meta-wayland-presentation-time-private.h"
 #include "wayland/meta-wayland-seat.h"
+#include "wayland/meta-wayland-shm-upload.h"
 #include "wayland/meta-wayland-surface-private.h"
 #include "wayland/meta-wayland-tablet-manager.h"
 #include "wayland/meta-wayland-versions.h"
@@ -114,3 +115,5 @@ struct _MetaWaylandCompositor
 };
 
 gboolean meta_wayland_compositor_is_egl_display_bound (MetaWaylandCompositor *compositor);
+
+MetaWaylandShmUploader * meta_wayland_compositor_get_shm_uploader (MetaWaylandCompositor *compositor);
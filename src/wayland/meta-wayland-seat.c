@@ -356,6 +356,45 @@ meta_wayland_seat_update (MetaWaylandSeat    *seat,
     }
 }
 
+#ifdef COGL_HAS_TRACING
+static void
+note_input_sent (MetaWaylandSeat    *seat,
+                 const ClutterEvent *event)
+{
+  MetaWaylandSurface *surface = NULL;
+
+  switch (clutter_event_type (event))
+    {
+    case CLUTTER_MOTION:
+    case CLUTTER_BUTTON_PRESS:
+    case CLUTTER_BUTTON_RELEASE:
+    case CLUTTER_SCROLL:
+      if (meta_wayland_seat_has_pointer (seat))
+        surface = seat->pointer->focus_surface;
+      break;
+    case CLUTTER_KEY_PRESS:
+    case CLUTTER_KEY_RELEASE:
+      if (meta_wayland_seat_has_keyboard (seat))
+        surface = seat->keyboard->focus_surface;
+      break;
+    case CLUTTER_TOUCH_BEGIN:
+    case CLUTTER_TOUCH_UPDATE:
+      if (meta_wayland_seat_has_touch (seat))
+        {
+          surface =
+            meta_wayland_touch_get_surface (seat->touch,
+                                            clutter_event_get_event_sequence (event));
+        }
+      break;
+    default:
+      break;
+    }
+
+  if (surface)
+    meta_wayland_presentation_time_input_sent (surface, event);
+}
+#endif
+
 gboolean
 meta_wayland_seat_handle_event (MetaWaylandSeat *seat,
                                 const ClutterEvent *event)
@@ -368,6 +407,11 @@ meta_wayland_seat_handle_event (MetaWaylandSeat *seat,
 
   event_type = clutter_event_type (event);
 
+#ifdef COGL_HAS_TRACING
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    note_input_sent (seat, event);
+#endif
+
   if (event_type == CLUTTER_BUTTON_PRESS ||
       event_type == CLUTTER_TOUCH_BEGIN)
     {
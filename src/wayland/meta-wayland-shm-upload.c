@@ -0,0 +1,795 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Uploads damaged regions of wl_shm buffers to textures.
+ *
+ * Damage rectangles are first coalesced into row spans, so that e.g. the
+ * individually damaged glyphs of a terminal line turn into a single upload.
+ * When pixel buffer objects are available, the spans are then packed into
+ * one of a small ring of pixel buffers, and uploaded from there, letting the
+ * driver do the transfer asynchronously instead of stalling on
+ * glTexSubImage2D() reading from client memory.
+ *
+ * Large damaged regions can also be copied into a dedicated pixel buffer on a
+ * worker thread ahead of time (see meta_wayland_shm_uploader_copy_async()),
+ * so that the compositor thread only has to issue the upload itself.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-shm-upload.h"
+
+#include <string.h>
+#include <wayland-server.h>
+
+#include "cogl/cogl.h"
+
+#define SHM_UPLOAD_RING_LENGTH 3
+#define SHM_UPLOAD_MIN_BUFFER_SIZE (1024 * 1024)
+#define SHM_UPLOAD_MAX_BUFFER_SIZE (64 * 1024 * 1024)
+#define SHM_UPLOAD_ROWSTRIDE_ALIGNMENT 4
+#define SHM_UPLOAD_OFFSET_ALIGNMENT 64
+
+/* Damage rectangles on the same row closer than this are uploaded as one
+ * span, as the cost of an upload is dominated by its setup for small
+ * rectangles.
+ */
+#define SHM_UPLOAD_MAX_SPAN_GAP 64
+
+/* Copies smaller than this are not worth the round trip through a worker
+ * thread.
+ */
+#define SHM_UPLOAD_ASYNC_MIN_SIZE (1024 * 1024)
+#define SHM_UPLOAD_MAX_COPY_THREADS 2
+
+struct _MetaWaylandShmUploader
+{
+  CoglContext *cogl_context;
+
+  gboolean use_pixel_buffers;
+
+  CoglPixelBuffer *pixel_buffers[SHM_UPLOAD_RING_LENGTH];
+  int next_pixel_buffer;
+
+  GThreadPool *copy_pool;
+  GAsyncQueue *finished_copies;
+  GSource *finished_copies_source;
+};
+
+struct _MetaWaylandShmCopy
+{
+  gatomicrefcount ref_count;
+
+  CoglPixelFormat format;
+  MtkRegion *region;
+  GArray *spans;
+
+  CoglPixelBuffer *pixel_buffer;
+  uint8_t *map;
+
+  struct wl_shm_buffer *shm_buffer;
+  struct wl_shm_pool *shm_pool;
+  const uint8_t *data;
+  int stride;
+
+  GMutex mutex;
+  GCond cond;
+  gboolean copied;
+
+  /* Only accessed from the main thread. */
+  gboolean done;
+  GSource *source;
+};
+
+typedef struct _MetaWaylandShmCopySource
+{
+  GSource base;
+
+  MetaWaylandShmCopy *copy;
+} MetaWaylandShmCopySource;
+
+typedef struct _MetaWaylandShmFinishedCopiesSource
+{
+  GSource base;
+
+  MetaWaylandShmUploader *uploader;
+} MetaWaylandShmFinishedCopiesSource;
+
+static size_t
+align_up (size_t value,
+          size_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static void
+append_span (GArray             *spans,
+             const MtkRectangle *span)
+{
+  int i;
+
+  /* Merge with a span ending right above it covering the same columns, which
+   * is the common case for e.g. a damaged text paragraph. Spans are appended
+   * band by band, so stop at the first one ending further up.
+   */
+  for (i = (int) spans->len - 1; i >= 0; i--)
+    {
+      MtkRectangle *other = &g_array_index (spans, MtkRectangle, i);
+
+      if (other->y + other->height < span->y)
+        break;
+
+      if (other->y + other->height == span->y &&
+          other->x == span->x &&
+          other->width == span->width)
+        {
+          other->height += span->height;
+          return;
+        }
+    }
+
+  g_array_append_vals (spans, span, 1);
+}
+
+static GArray *
+coalesce_damage_spans (const MtkRegion *region)
+{
+  GArray *spans;
+  MtkRectangle extents;
+  MtkRectangle span;
+  int64_t damaged_area = 0;
+  int n_rectangles;
+  int i;
+
+  spans = g_array_new (FALSE, FALSE, sizeof (MtkRectangle));
+
+  n_rectangles = mtk_region_num_rectangles (region);
+  if (n_rectangles == 0)
+    return spans;
+
+  extents = mtk_region_get_extents (region);
+
+  for (i = 0; i < n_rectangles; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, i);
+
+      damaged_area += (int64_t) rect.width * rect.height;
+    }
+
+  /* Uploading a few undamaged pixels is cheaper than many uploads. */
+  if (damaged_area * 4 >= (int64_t) extents.width * extents.height * 3)
+    {
+      g_array_append_val (spans, extents);
+      return spans;
+    }
+
+  /* Rectangles of a region are sorted in bands of equal y and height, each
+   * sorted by x, so merging within a row only needs to look at the previous
+   * rectangle.
+   */
+  span = mtk_region_get_rectangle (region, 0);
+  for (i = 1; i < n_rectangles; i++)
+    {
+      MtkRectangle rect = mtk_region_get_rectangle (region, i);
+
+      if (rect.y == span.y &&
+          rect.height == span.height &&
+          rect.x - (span.x + span.width) <= SHM_UPLOAD_MAX_SPAN_GAP)
+        {
+          span.width = rect.x + rect.width - span.x;
+          continue;
+        }
+
+      append_span (spans, &span);
+      span = rect;
+    }
+  append_span (spans, &span);
+
+  return spans;
+}
+
+static gboolean
+upload_spans_direct (CoglTexture      *texture,
+                     CoglPixelFormat   format,
+                     const uint8_t    *data,
+                     int               stride,
+                     GArray           *spans,
+                     GError          **error)
+{
+  int bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  unsigned int i;
+
+  for (i = 0; i < spans->len; i++)
+    {
+      MtkRectangle *span = &g_array_index (spans, MtkRectangle, i);
+
+      if (!_cogl_texture_set_region (texture,
+                                     span->width, span->height,
+                                     format,
+                                     stride,
+                                     data + span->x * bpp + span->y * stride,
+                                     span->x, span->y,
+                                     0,
+                                     error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static CoglPixelBuffer *
+acquire_pixel_buffer (MetaWaylandShmUploader *uploader,
+                      size_t                  size)
+{
+  CoglPixelBuffer **pixel_buffer;
+
+  pixel_buffer = &uploader->pixel_buffers[uploader->next_pixel_buffer];
+  uploader->next_pixel_buffer =
+    (uploader->next_pixel_buffer + 1) % SHM_UPLOAD_RING_LENGTH;
+
+  if (*pixel_buffer &&
+      cogl_buffer_get_size (COGL_BUFFER (*pixel_buffer)) < size)
+    g_clear_object (pixel_buffer);
+
+  if (!*pixel_buffer)
+    {
+      size_t buffer_size;
+
+      buffer_size = MAX ((size_t) 1 << g_bit_storage (size - 1),
+                         SHM_UPLOAD_MIN_BUFFER_SIZE);
+
+      *pixel_buffer = cogl_pixel_buffer_new (uploader->cogl_context,
+                                             buffer_size,
+                                             NULL);
+      cogl_buffer_set_update_hint (COGL_BUFFER (*pixel_buffer),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+    }
+
+  return *pixel_buffer;
+}
+
+static int
+get_span_rowstride (const MtkRectangle *span,
+                    int                 bpp)
+{
+  return align_up (span->width * bpp, SHM_UPLOAD_ROWSTRIDE_ALIGNMENT);
+}
+
+static size_t
+get_spans_size (GArray *spans,
+                int     bpp)
+{
+  size_t size = 0;
+  unsigned int i;
+
+  for (i = 0; i < spans->len; i++)
+    {
+      MtkRectangle *span = &g_array_index (spans, MtkRectangle, i);
+
+      size = align_up (size + span->height * get_span_rowstride (span, bpp),
+                       SHM_UPLOAD_OFFSET_ALIGNMENT);
+    }
+
+  return size;
+}
+
+static void
+pack_spans (uint8_t       *map,
+            const uint8_t *data,
+            int            stride,
+            int            bpp,
+            GArray        *spans)
+{
+  size_t offset = 0;
+  unsigned int i;
+
+  for (i = 0; i < spans->len; i++)
+    {
+      MtkRectangle *span = &g_array_index (spans, MtkRectangle, i);
+      int rowstride = get_span_rowstride (span, bpp);
+      const uint8_t *src;
+      int y;
+
+      src = data + span->x * bpp + span->y * stride;
+      for (y = 0; y < span->height; y++)
+        {
+          memcpy (map + offset + y * rowstride,
+                  src + y * stride,
+                  span->width * bpp);
+        }
+
+      offset = align_up (offset + span->height * rowstride,
+                         SHM_UPLOAD_OFFSET_ALIGNMENT);
+    }
+}
+
+static gboolean
+upload_spans_from_pixel_buffer (CoglPixelBuffer  *pixel_buffer,
+                                CoglTexture      *texture,
+                                CoglPixelFormat   format,
+                                GArray           *spans,
+                                GError          **error)
+{
+  int bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  size_t offset = 0;
+  unsigned int i;
+
+  for (i = 0; i < spans->len; i++)
+    {
+      MtkRectangle *span = &g_array_index (spans, MtkRectangle, i);
+      int rowstride = get_span_rowstride (span, bpp);
+      g_autoptr (CoglBitmap) bitmap = NULL;
+
+      bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (pixel_buffer),
+                                            format,
+                                            span->width, span->height,
+                                            rowstride,
+                                            offset);
+      if (!cogl_texture_set_region_from_bitmap (texture,
+                                                0, 0,
+                                                span->x, span->y,
+                                                span->width, span->height,
+                                                bitmap))
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       "Failed to upload %dx%d region from pixel buffer",
+                       span->width, span->height);
+          return FALSE;
+        }
+
+      offset = align_up (offset + span->height * rowstride,
+                         SHM_UPLOAD_OFFSET_ALIGNMENT);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+upload_spans_via_pixel_buffer (MetaWaylandShmUploader  *uploader,
+                               CoglTexture             *texture,
+                               CoglPixelFormat          format,
+                               const uint8_t           *data,
+                               int                      stride,
+                               GArray                  *spans,
+                               size_t                   size,
+                               GError                 **error)
+{
+  int bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  CoglPixelBuffer *pixel_buffer;
+  CoglBuffer *buffer;
+  uint8_t *map;
+
+  pixel_buffer = acquire_pixel_buffer (uploader, size);
+  buffer = COGL_BUFFER (pixel_buffer);
+
+  map = cogl_buffer_map_range (buffer, 0, size,
+                               COGL_BUFFER_ACCESS_WRITE,
+                               COGL_BUFFER_MAP_HINT_DISCARD,
+                               error);
+  if (!map)
+    return FALSE;
+
+  pack_spans (map, data, stride, bpp, spans);
+
+  cogl_buffer_unmap (buffer);
+
+  return upload_spans_from_pixel_buffer (pixel_buffer, texture, format,
+                                         spans, error);
+}
+
+gboolean
+meta_wayland_shm_uploader_upload (MetaWaylandShmUploader  *uploader,
+                                  CoglTexture             *texture,
+                                  CoglPixelFormat          format,
+                                  const uint8_t           *data,
+                                  int                      stride,
+                                  const MtkRegion         *region,
+                                  GError                 **error)
+{
+  g_autoptr (GArray) spans = NULL;
+  int bpp;
+  size_t size;
+
+  COGL_TRACE_BEGIN_SCOPED (MetaWaylandShmUpload, "WaylandShm (upload)");
+
+  spans = coalesce_damage_spans (region);
+  if (spans->len == 0)
+    return TRUE;
+
+  if (!uploader->use_pixel_buffers)
+    return upload_spans_direct (texture, format, data, stride, spans, error);
+
+  bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  size = get_spans_size (spans, bpp);
+
+  if (size > SHM_UPLOAD_MAX_BUFFER_SIZE)
+    return upload_spans_direct (texture, format, data, stride, spans, error);
+
+  return upload_spans_via_pixel_buffer (uploader, texture, format,
+                                        data, stride, spans, size,
+                                        error);
+}
+
+MetaWaylandShmCopy *
+meta_wayland_shm_copy_ref (MetaWaylandShmCopy *copy)
+{
+  g_atomic_ref_count_inc (&copy->ref_count);
+  return copy;
+}
+
+void
+meta_wayland_shm_copy_unref (MetaWaylandShmCopy *copy)
+{
+  if (!g_atomic_ref_count_dec (&copy->ref_count))
+    return;
+
+  g_warn_if_fail (!copy->map);
+  g_warn_if_fail (!copy->source);
+
+  g_mutex_clear (&copy->mutex);
+  g_cond_clear (&copy->cond);
+  g_clear_object (&copy->pixel_buffer);
+  g_clear_pointer (&copy->spans, g_array_unref);
+  g_clear_pointer (&copy->region, mtk_region_unref);
+  g_free (copy);
+}
+
+static void
+finish_copy (MetaWaylandShmCopy *copy)
+{
+  cogl_buffer_unmap (COGL_BUFFER (copy->pixel_buffer));
+  copy->map = NULL;
+
+  g_clear_pointer (&copy->shm_pool, wl_shm_pool_unref);
+  copy->shm_buffer = NULL;
+  copy->data = NULL;
+
+  copy->done = TRUE;
+  if (copy->source)
+    g_source_set_ready_time (copy->source, 0);
+}
+
+static void
+finish_copies (MetaWaylandShmUploader *uploader)
+{
+  MetaWaylandShmCopy *copy;
+
+  while ((copy = g_async_queue_try_pop (uploader->finished_copies)))
+    {
+      finish_copy (copy);
+      meta_wayland_shm_copy_unref (copy);
+    }
+}
+
+static gboolean
+finished_copies_source_prepare (GSource *base,
+                                int     *timeout)
+{
+  MetaWaylandShmFinishedCopiesSource *source =
+    (MetaWaylandShmFinishedCopiesSource *) base;
+
+  *timeout = -1;
+
+  return g_async_queue_length (source->uploader->finished_copies) > 0;
+}
+
+static gboolean
+finished_copies_source_check (GSource *base)
+{
+  MetaWaylandShmFinishedCopiesSource *source =
+    (MetaWaylandShmFinishedCopiesSource *) base;
+
+  return g_async_queue_length (source->uploader->finished_copies) > 0;
+}
+
+static gboolean
+finished_copies_source_dispatch (GSource     *base,
+                                 GSourceFunc  callback,
+                                 gpointer     user_data)
+{
+  MetaWaylandShmFinishedCopiesSource *source =
+    (MetaWaylandShmFinishedCopiesSource *) base;
+
+  finish_copies (source->uploader);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs finished_copies_source_funcs = {
+  .prepare = finished_copies_source_prepare,
+  .check = finished_copies_source_check,
+  .dispatch = finished_copies_source_dispatch,
+};
+
+static void
+copy_job_func (gpointer data,
+               gpointer user_data)
+{
+  MetaWaylandShmCopy *copy = data;
+  MetaWaylandShmUploader *uploader = user_data;
+  int bpp = cogl_pixel_format_get_bytes_per_pixel (copy->format, 0);
+
+  wl_shm_buffer_begin_access (copy->shm_buffer);
+  pack_spans (copy->map, copy->data, copy->stride, bpp, copy->spans);
+  wl_shm_buffer_end_access (copy->shm_buffer);
+
+  g_mutex_lock (&copy->mutex);
+  copy->copied = TRUE;
+  g_cond_signal (&copy->cond);
+  g_mutex_unlock (&copy->mutex);
+
+  /* The pixel buffer can only be unmapped, and the last reference only be
+   * dropped, on the thread owning the GL context. The queue is owned by the
+   * uploader rather than the main context, so that it can be drained when
+   * the uploader is freed.
+   */
+  g_async_queue_push (uploader->finished_copies, copy);
+  g_main_context_wakeup (NULL);
+}
+
+/**
+ * meta_wayland_shm_uploader_copy_async:
+ * @uploader: A #MetaWaylandShmUploader
+ * @shm_buffer: The shm buffer to copy from
+ * @format: The pixel format of @shm_buffer
+ * @region: The region of @shm_buffer to copy
+ *
+ * Starts copying @region of @shm_buffer into a staging pixel buffer on a
+ * worker thread. The shm buffer must not be destroyed before the copy
+ * completed, see meta_wayland_shm_copy_wait().
+ *
+ * Returns: (nullable): A new #MetaWaylandShmCopy, or %NULL if pixel buffer
+ *   objects are not available, or the region is too small or too large to be
+ *   worth copying asynchronously.
+ */
+MetaWaylandShmCopy *
+meta_wayland_shm_uploader_copy_async (MetaWaylandShmUploader *uploader,
+                                      struct wl_shm_buffer   *shm_buffer,
+                                      CoglPixelFormat         format,
+                                      const MtkRegion        *region)
+{
+  g_autoptr (GArray) spans = NULL;
+  g_autoptr (GError) error = NULL;
+  CoglPixelBuffer *pixel_buffer;
+  MetaWaylandShmCopy *copy;
+  uint8_t *map;
+  size_t size;
+  int bpp;
+
+  /* Without pixel buffer objects, the staging buffer would just be more
+   * client memory for the upload to read from.
+   */
+  if (!uploader->use_pixel_buffers)
+    return NULL;
+
+  spans = coalesce_damage_spans (region);
+  if (spans->len == 0)
+    return NULL;
+
+  bpp = cogl_pixel_format_get_bytes_per_pixel (format, 0);
+  size = get_spans_size (spans, bpp);
+  if (size < SHM_UPLOAD_ASYNC_MIN_SIZE || size > SHM_UPLOAD_MAX_BUFFER_SIZE)
+    return NULL;
+
+  pixel_buffer = cogl_pixel_buffer_new (uploader->cogl_context, size, NULL);
+  cogl_buffer_set_update_hint (COGL_BUFFER (pixel_buffer),
+                               COGL_BUFFER_UPDATE_HINT_STREAM);
+
+  map = cogl_buffer_map_range (COGL_BUFFER (pixel_buffer), 0, size,
+                               COGL_BUFFER_ACCESS_WRITE,
+                               COGL_BUFFER_MAP_HINT_DISCARD,
+                               &error);
+  if (!map)
+    {
+      g_warning ("Failed to map staging buffer for shm copy: %s",
+                 error->message);
+      g_object_unref (pixel_buffer);
+      return NULL;
+    }
+
+  copy = g_new0 (MetaWaylandShmCopy, 1);
+  g_atomic_ref_count_init (&copy->ref_count);
+  copy->format = format;
+  copy->region = mtk_region_copy (region);
+  copy->spans = g_steal_pointer (&spans);
+  copy->pixel_buffer = pixel_buffer;
+  copy->map = map;
+  copy->shm_buffer = shm_buffer;
+  copy->shm_pool = wl_shm_buffer_ref_pool (shm_buffer);
+  copy->data = wl_shm_buffer_get_data (shm_buffer);
+  copy->stride = wl_shm_buffer_get_stride (shm_buffer);
+  g_mutex_init (&copy->mutex);
+  g_cond_init (&copy->cond);
+
+  if (!uploader->copy_pool)
+    {
+      MetaWaylandShmFinishedCopiesSource *source;
+
+      uploader->copy_pool = g_thread_pool_new (copy_job_func,
+                                               uploader,
+                                               SHM_UPLOAD_MAX_COPY_THREADS,
+                                               FALSE,
+                                               NULL);
+      uploader->finished_copies = g_async_queue_new ();
+
+      source = (MetaWaylandShmFinishedCopiesSource *)
+        g_source_new (&finished_copies_source_funcs, sizeof (*source));
+      g_source_set_name (&source->base, "[mutter] Wayland shm finished copies");
+      source->uploader = uploader;
+      uploader->finished_copies_source = &source->base;
+      g_source_attach (uploader->finished_copies_source, NULL);
+    }
+
+  g_thread_pool_push (uploader->copy_pool,
+                      meta_wayland_shm_copy_ref (copy),
+                      NULL);
+
+  return copy;
+}
+
+/**
+ * meta_wayland_shm_copy_wait:
+ * @copy: A #MetaWaylandShmCopy
+ *
+ * Blocks until the worker thread is done accessing the shm buffer.
+ */
+void
+meta_wayland_shm_copy_wait (MetaWaylandShmCopy *copy)
+{
+  g_mutex_lock (&copy->mutex);
+  while (!copy->copied)
+    g_cond_wait (&copy->cond, &copy->mutex);
+  g_mutex_unlock (&copy->mutex);
+
+  copy->shm_buffer = NULL;
+}
+
+static gboolean
+meta_wayland_shm_copy_source_dispatch (GSource     *base,
+                                       GSourceFunc  callback,
+                                       gpointer     user_data)
+{
+  MetaWaylandShmCopySource *source = (MetaWaylandShmCopySource *) base;
+
+  if (!source->copy->done)
+    {
+      g_source_set_ready_time (base, -1);
+      return G_SOURCE_CONTINUE;
+    }
+
+  if (callback)
+    callback (user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+meta_wayland_shm_copy_source_finalize (GSource *base)
+{
+  MetaWaylandShmCopySource *source = (MetaWaylandShmCopySource *) base;
+
+  if (source->copy->source == base)
+    source->copy->source = NULL;
+  g_clear_pointer (&source->copy, meta_wayland_shm_copy_unref);
+}
+
+static GSourceFuncs meta_wayland_shm_copy_source_funcs = {
+  .dispatch = meta_wayland_shm_copy_source_dispatch,
+  .finalize = meta_wayland_shm_copy_source_finalize,
+};
+
+/**
+ * meta_wayland_shm_copy_create_source:
+ * @copy: A #MetaWaylandShmCopy
+ *
+ * Creates a GSource which dispatches its callback once @copy is ready to be
+ * uploaded with meta_wayland_shm_copy_upload().
+ *
+ * Returns: The new GSource
+ */
+GSource *
+meta_wayland_shm_copy_create_source (MetaWaylandShmCopy *copy)
+{
+  MetaWaylandShmCopySource *source;
+
+  g_return_val_if_fail (!copy->source, NULL);
+
+  source =
+    (MetaWaylandShmCopySource *) g_source_new (&meta_wayland_shm_copy_source_funcs,
+                                               sizeof (*source));
+  g_source_set_name (&source->base, "[mutter] Wayland shm copy");
+  source->copy = meta_wayland_shm_copy_ref (copy);
+  copy->source = &source->base;
+
+  if (copy->done)
+    g_source_set_ready_time (&source->base, 0);
+
+  return &source->base;
+}
+
+/**
+ * meta_wayland_shm_copy_covers:
+ * @copy: A #MetaWaylandShmCopy
+ * @region: A region in buffer coordinates
+ *
+ * Returns: %TRUE if @copy is complete and contains all of @region.
+ */
+gboolean
+meta_wayland_shm_copy_covers (MetaWaylandShmCopy *copy,
+                              const MtkRegion    *region)
+{
+  g_autoptr (MtkRegion) uncovered = NULL;
+
+  if (!copy->done)
+    return FALSE;
+
+  uncovered = mtk_region_copy (region);
+  mtk_region_subtract (uncovered, copy->region);
+
+  return mtk_region_is_empty (uncovered);
+}
+
+gboolean
+meta_wayland_shm_copy_upload (MetaWaylandShmCopy  *copy,
+                              CoglTexture         *texture,
+                              GError             **error)
+{
+  COGL_TRACE_BEGIN_SCOPED (MetaWaylandShmCopyUpload,
+                           "WaylandShm (upload staged copy)");
+
+  g_return_val_if_fail (copy->done, FALSE);
+
+  return upload_spans_from_pixel_buffer (copy->pixel_buffer, texture,
+                                         copy->format, copy->spans,
+                                         error);
+}
+
+MetaWaylandShmUploader *
+meta_wayland_shm_uploader_new (CoglContext *cogl_context)
+{
+  MetaWaylandShmUploader *uploader;
+
+  uploader = g_new0 (MetaWaylandShmUploader, 1);
+  uploader->cogl_context = cogl_context;
+  uploader->use_pixel_buffers =
+    cogl_has_feature (cogl_context, COGL_FEATURE_ID_PIXEL_BUFFER_OBJECT);
+
+  return uploader;
+}
+
+void
+meta_wayland_shm_uploader_free (MetaWaylandShmUploader *uploader)
+{
+  int i;
+
+  if (uploader->copy_pool)
+    {
+      /* Wait for copies still in flight, then release them here, as the
+       * main loop won't get to it anymore.
+       */
+      g_thread_pool_free (uploader->copy_pool, FALSE, TRUE);
+      finish_copies (uploader);
+
+      g_source_destroy (uploader->finished_copies_source);
+      g_source_unref (uploader->finished_copies_source);
+      g_async_queue_unref (uploader->finished_copies);
+    }
+
+  for (i = 0; i < SHM_UPLOAD_RING_LENGTH; i++)
+    g_clear_object (&uploader->pixel_buffers[i]);
+
+  g_free (uploader);
+}
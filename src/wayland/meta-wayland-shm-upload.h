@@ -0,0 +1,60 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdint.h>
+#include <wayland-server.h>
+
+#include "cogl/cogl.h"
+#include "mtk/mtk.h"
+
+typedef struct _MetaWaylandShmUploader MetaWaylandShmUploader;
+typedef struct _MetaWaylandShmCopy MetaWaylandShmCopy;
+
+MetaWaylandShmUploader * meta_wayland_shm_uploader_new (CoglContext *cogl_context);
+
+void meta_wayland_shm_uploader_free (MetaWaylandShmUploader *uploader);
+
+gboolean meta_wayland_shm_uploader_upload (MetaWaylandShmUploader  *uploader,
+                                           CoglTexture             *texture,
+                                           CoglPixelFormat          format,
+                                           const uint8_t           *data,
+                                           int                      stride,
+                                           const MtkRegion         *region,
+                                           GError                 **error);
+
+MetaWaylandShmCopy * meta_wayland_shm_uploader_copy_async (MetaWaylandShmUploader *uploader,
+                                                           struct wl_shm_buffer   *shm_buffer,
+                                                           CoglPixelFormat         format,
+                                                           const MtkRegion        *region);
+
+MetaWaylandShmCopy * meta_wayland_shm_copy_ref (MetaWaylandShmCopy *copy);
+
+void meta_wayland_shm_copy_unref (MetaWaylandShmCopy *copy);
+
+void meta_wayland_shm_copy_wait (MetaWaylandShmCopy *copy);
+
+GSource * meta_wayland_shm_copy_create_source (MetaWaylandShmCopy *copy);
+
+gboolean meta_wayland_shm_copy_covers (MetaWaylandShmCopy *copy,
+                                       const MtkRegion    *region);
+
+gboolean meta_wayland_shm_copy_upload (MetaWaylandShmCopy  *copy,
+                                       CoglTexture         *texture,
+                                       GError             **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaWaylandShmCopy, meta_wayland_shm_copy_unref)
@@ -251,6 +251,13 @@ struct _MetaWaylandSurface
      * delta to update our own 64-bit sequence.
      */
     uint64_t sequence;
+
+    /*
+     * Oldest input event sent to the client since the last commit, and when
+     * it was sent, for tracing input latency.
+     */
+    int64_t input_time_us;
+    int64_t input_sent_time_us;
   } presentation_time;
 
   /* dma-buf feedback */
@@ -386,6 +393,14 @@ int                 meta_wayland_surface_get_buffer_height (MetaWaylandSurface *
 CoglScanout *       meta_wayland_surface_try_acquire_scanout (MetaWaylandSurface *surface,
                                                               CoglOnscreen       *onscreen);
 
+gboolean            meta_wayland_surface_get_overlay_src_rect (MetaWaylandSurface *surface,
+                                                               graphene_rect_t    *src_rect);
+
+CoglScanout *       meta_wayland_surface_try_acquire_overlay_scanout (MetaWaylandSurface    *surface,
+                                                                      CoglOnscreen          *onscreen,
+                                                                      const graphene_rect_t *src_rect,
+                                                                      const MtkRectangle    *dst_rect);
+
 MetaCrtc * meta_wayland_surface_get_scanout_candidate (MetaWaylandSurface *surface);
 
 void meta_wayland_surface_set_scanout_candidate (MetaWaylandSurface *surface,
@@ -918,6 +918,8 @@ meta_wayland_surface_commit (MetaWaylandSurface *surface)
   COGL_TRACE_BEGIN_SCOPED (MetaWaylandSurfaceCommit,
                            "WaylandSurface (commit)");
 
+  meta_wayland_presentation_time_surface_committed (surface, pending);
+
   if (buffer)
     {
       g_autoptr (GError) error = NULL;
@@ -2245,6 +2247,67 @@ meta_wayland_surface_try_acquire_scanout (MetaWaylandSurface *surface,
   return scanout;
 }
 
+gboolean
+meta_wayland_surface_get_overlay_src_rect (MetaWaylandSurface *surface,
+                                           graphene_rect_t    *src_rect)
+{
+  if (!surface->buffer)
+    return FALSE;
+
+  if (surface->buffer_transform != META_MONITOR_TRANSFORM_NORMAL)
+    {
+      meta_topic (META_DEBUG_RENDER,
+                  "Surface can not be scanned out on an overlay: buffer is "
+                  "transformed");
+      return FALSE;
+    }
+
+  if (surface->viewport.has_src_rect)
+    {
+      graphene_rect_scale (&surface->viewport.src_rect,
+                           surface->scale, surface->scale,
+                           src_rect);
+    }
+  else
+    {
+      graphene_rect_init (src_rect,
+                          0, 0,
+                          meta_wayland_surface_get_buffer_width (surface),
+                          meta_wayland_surface_get_buffer_height (surface));
+    }
+
+  return TRUE;
+}
+
+CoglScanout *
+meta_wayland_surface_try_acquire_overlay_scanout (MetaWaylandSurface    *surface,
+                                                  CoglOnscreen          *onscreen,
+                                                  const graphene_rect_t *src_rect,
+                                                  const MtkRectangle    *dst_rect)
+{
+  CoglScanout *scanout;
+  MetaWaylandBuffer *buffer;
+
+  if (!surface->buffer)
+    return NULL;
+
+  if (surface->buffer->use_count == 0)
+    return NULL;
+
+  scanout = meta_wayland_buffer_try_acquire_overlay_scanout (surface->buffer,
+                                                             onscreen,
+                                                             src_rect,
+                                                             dst_rect);
+  if (!scanout)
+    return NULL;
+
+  buffer = g_object_ref (surface->buffer);
+  meta_wayland_buffer_inc_use_count (buffer);
+  g_object_weak_ref (G_OBJECT (scanout), scanout_destroyed, buffer);
+
+  return scanout;
+}
+
 MetaCrtc *
 meta_wayland_surface_get_scanout_candidate (MetaWaylandSurface *surface)
 {
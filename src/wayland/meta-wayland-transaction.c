@@ -302,8 +302,8 @@ meta_wayland_transaction_maybe_apply (MetaWaylandTransaction *transaction)
 }
 
 static void
-meta_wayland_transaction_dma_buf_dispatch (MetaWaylandBuffer *buffer,
-                                           gpointer           user_data)
+meta_wayland_transaction_buf_dispatch (MetaWaylandBuffer *buffer,
+                                       gpointer           user_data)
 {
   MetaWaylandTransaction *transaction = user_data;
 
@@ -314,6 +314,23 @@ meta_wayland_transaction_dma_buf_dispatch (MetaWaylandBuffer *buffer,
   meta_wayland_transaction_maybe_apply (transaction);
 }
 
+static void
+meta_wayland_transaction_add_buf_source (MetaWaylandTransaction *transaction,
+                                         MetaWaylandBuffer      *buffer,
+                                         GSource                *source)
+{
+  if (!transaction->buf_sources)
+    {
+      transaction->buf_sources =
+        g_hash_table_new_full (NULL, NULL, NULL,
+                               (GDestroyNotify) g_source_destroy);
+    }
+
+  g_hash_table_insert (transaction->buf_sources, buffer, source);
+  g_source_attach (source, NULL);
+  g_source_unref (source);
+}
+
 static gboolean
 meta_wayland_transaction_add_dma_buf_source (MetaWaylandTransaction *transaction,
                                              MetaWaylandBuffer      *buffer)
@@ -325,21 +342,43 @@ meta_wayland_transaction_add_dma_buf_source (MetaWaylandTransaction *transaction
     return FALSE;
 
   source = meta_wayland_dma_buf_create_source (buffer,
-                                               meta_wayland_transaction_dma_buf_dispatch,
+                                               meta_wayland_transaction_buf_dispatch,
                                                transaction);
   if (!source)
     return FALSE;
 
-  if (!transaction->buf_sources)
-    {
-      transaction->buf_sources =
-        g_hash_table_new_full (NULL, NULL, NULL,
-                               (GDestroyNotify) g_source_destroy);
-    }
+  meta_wayland_transaction_add_buf_source (transaction, buffer, source);
 
-  g_hash_table_insert (transaction->buf_sources, buffer, source);
-  g_source_attach (source, NULL);
-  g_source_unref (source);
+  return TRUE;
+}
+
+static gboolean
+meta_wayland_transaction_add_shm_copy_source (MetaWaylandTransaction  *transaction,
+                                              MetaWaylandSurfaceState *state)
+{
+  MetaWaylandBuffer *buffer = state->buffer;
+  GSource *source;
+
+  if (transaction->buf_sources &&
+      g_hash_table_contains (transaction->buf_sources, buffer))
+    return FALSE;
+
+  /* Surface damage can only be translated to buffer coordinates once the
+   * state is applied, and copying the whole buffer instead would make the
+   * upload itself more expensive, so only buffer damage is handled.
+   */
+  if (!mtk_region_is_empty (state->surface_damage) ||
+      mtk_region_is_empty (state->buffer_damage))
+    return FALSE;
+
+  source = meta_wayland_buffer_create_shm_copy_source (buffer,
+                                                      state->buffer_damage,
+                                                      meta_wayland_transaction_buf_dispatch,
+                                                      transaction);
+  if (!source)
+    return FALSE;
+
+  meta_wayland_transaction_add_buf_source (transaction, buffer, source);
 
   return TRUE;
 }
@@ -383,7 +422,10 @@ meta_wayland_transaction_commit (MetaWaylandTransaction *transaction)
           MetaWaylandBuffer *buffer = entry->state->buffer;
 
           if (buffer &&
-              meta_wayland_transaction_add_dma_buf_source (transaction, buffer))
+              (meta_wayland_transaction_add_dma_buf_source (transaction,
+                                                            buffer) ||
+               meta_wayland_transaction_add_shm_copy_source (transaction,
+                                                             entry->state)))
             maybe_apply = FALSE;
 
           if (entry->state->subsurface_placement_ops)
@@ -46,6 +46,7 @@
 #include "wayland/meta-wayland-private.h"
 #include "wayland/meta-wayland-region.h"
 #include "wayland/meta-wayland-seat.h"
+#include "wayland/meta-wayland-shm-upload.h"
 #include "wayland/meta-wayland-subsurface.h"
 #include "wayland/meta-wayland-tablet-manager.h"
 #include "wayland/meta-wayland-transaction.h"
@@ -80,6 +81,8 @@ typedef struct _MetaWaylandCompositorPrivate
 
   MetaWaylandFilterManager *filter_manager;
   GHashTable *frame_callback_sources;
+
+  MetaWaylandShmUploader *shm_uploader;
 } MetaWaylandCompositorPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MetaWaylandCompositor, meta_wayland_compositor,
@@ -637,6 +640,7 @@ meta_wayland_compositor_finalize (GObject *object)
 
   g_clear_pointer (&priv->filter_manager, meta_wayland_filter_manager_free);
   g_clear_pointer (&priv->frame_callback_sources, g_hash_table_destroy);
+  g_clear_pointer (&priv->shm_uploader, meta_wayland_shm_uploader_free);
 
   g_clear_pointer (&compositor->display_name, g_free);
   g_clear_pointer (&compositor->wayland_display, wl_display_destroy);
@@ -1065,6 +1069,26 @@ meta_wayland_compositor_get_filter_manager (MetaWaylandCompositor *compositor)
   return priv->filter_manager;
 }
 
+MetaWaylandShmUploader *
+meta_wayland_compositor_get_shm_uploader (MetaWaylandCompositor *compositor)
+{
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (compositor);
+
+  if (!priv->shm_uploader)
+    {
+      MetaBackend *backend = meta_context_get_backend (compositor->context);
+      ClutterBackend *clutter_backend =
+        meta_backend_get_clutter_backend (backend);
+      CoglContext *cogl_context =
+        clutter_backend_get_cogl_context (clutter_backend);
+
+      priv->shm_uploader = meta_wayland_shm_uploader_new (cogl_context);
+    }
+
+  return priv->shm_uploader;
+}
+
 MetaWaylandTextInput *
 meta_wayland_compositor_get_text_input (MetaWaylandCompositor *compositor)
 {